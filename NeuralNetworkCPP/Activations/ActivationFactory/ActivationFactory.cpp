@@ -0,0 +1,34 @@
+/**
+ * C++ neural network library
+ *
+ * ActivationFactory.cpp
+ */
+
+#include "ActivationFactory.hpp"
+#include "../Activations.hpp"
+#include <stdexcept>
+
+namespace nn
+{
+    std::unique_ptr<Activation> createActivation(const e_activation activationID)
+    {
+        // Initialize the activation function based on the provided ID
+        switch (activationID)
+        {
+        case RELU:
+            return std::make_unique<ReLU>();
+
+        case SIGMOID:
+            return std::make_unique<Sigmoid>();
+
+        case SOFTMAX:
+            return std::make_unique<Softmax>();
+
+        case NONE:
+            return nullptr;
+
+        default:
+            throw std::runtime_error("Invalid activation function ID.");
+        }
+    }
+}
\ No newline at end of file
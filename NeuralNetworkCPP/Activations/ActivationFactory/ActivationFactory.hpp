@@ -0,0 +1,25 @@
+/**
+ * C++ neural network library
+ *
+ * ActivationFactory.hpp
+ */
+
+#ifndef ACTIVATIONFACTORY_HPP
+#define ACTIVATIONFACTORY_HPP
+
+#include "../Common/Activation.hpp"
+#include <memory>
+
+namespace nn
+{
+    /**
+     * @brief Creates the activation function of a layer.
+     *
+     * @param activationID Activation function ID.
+     * @return The activation function, nullptr for NONE.
+     * @throws std::runtime_error If the provided function ID is incorrect.
+     */
+    std::unique_ptr<Activation> createActivation(const e_activation activationID);
+}
+
+#endif
\ No newline at end of file
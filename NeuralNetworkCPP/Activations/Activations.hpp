@@ -15,5 +15,6 @@
 #include "ReLU/ReLU.hpp"
 #include "Sigmoid/Sigmoid.hpp"
 #include "Softmax/Softmax.hpp"
+#include "ActivationFactory/ActivationFactory.hpp"
 
 #endif
\ No newline at end of file
@@ -8,9 +8,15 @@
 #define ACTIVATION_HPP
 
 #include "../../Matrix/Matrix.hpp"
+#include "../../FastMath/FastMath.hpp"
 
 namespace nn
 {
+    /**
+     * @brief Enum with avaible activation functions
+     */
+    enum e_activation { RELU, SIGMOID, SOFTMAX, NONE };
+
     /**
      * @class Activation
      * @brief Abstract base class for activation functions.
@@ -18,7 +24,9 @@ namespace nn
     class Activation
     {
     protected:
-        Matrix m_output; ///< Stores the output of the forward pass for use in the backward pass.
+        Matrix m_output;                           ///< Stores the output of the forward pass for use in the backward pass.
+        e_mathPolicy m_mathPolicy = STANDARD_MATH; ///< Implementation of exp used by the forward pass.
+        e_layout m_layout = FEATURE_MAJOR;         ///< Layout of the samples in the input.
 
     public:
         /**
@@ -36,6 +44,35 @@ namespace nn
          * @return The gradient of the loss with respect to the input.
          */
         virtual Matrix backward(const Matrix &gradient) = 0;
+
+        /**
+         * @brief Applies the activation function in place to the features of a single sample.
+         *
+         * Used for single-sample inference, nothing is stored for the backward pass, so it may be
+         * called concurrently.
+         *
+         * @param values Features of the sample.
+         * @param count Number of features.
+         */
+        virtual void applyToSample(double *values, const int count) const = 0;
+
+        /**
+         * @brief Selects the implementation of the transcendental functions.
+         *
+         * Activations without transcendental functions ignore the policy.
+         *
+         * @param policy STANDARD_MATH or FAST_MATH.
+         */
+        void setMathPolicy(const e_mathPolicy policy) { m_mathPolicy = policy; }
+
+        /**
+         * @brief Sets the layout of the samples in the input.
+         *
+         * Only activations normalising over the features of a sample depend on the layout.
+         *
+         * @param layout FEATURE_MAJOR or SAMPLE_MAJOR.
+         */
+        void setLayout(const e_layout layout) { m_layout = layout; }
     };
 }
 
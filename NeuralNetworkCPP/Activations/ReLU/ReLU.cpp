@@ -11,11 +11,17 @@ namespace nn
     Matrix ReLU::forward(const Matrix &input)
     {
         // Apply ReLU element-wise: output = max(0, input)
-        return input.map([](double x) { return std::max(0.0, x); });
+        return input.map([](double x) { return (x > 0.0) ? x : 0.0; });
     }
 
     Matrix ReLU::backward(const Matrix &gradient)
     {
         return gradient.map([](double x) { return (x > 0) ? 1.0 : 0.0; });
     }
+
+    void ReLU::applyToSample(double *values, const int count) const
+    {
+        for (int i = 0; i < count; i++)
+            values[i] = (values[i] > 0.0) ? values[i] : 0.0;
+    }
 }
\ No newline at end of file
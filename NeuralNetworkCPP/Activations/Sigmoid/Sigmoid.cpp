@@ -11,11 +11,21 @@ namespace nn
 {
     Matrix Sigmoid::forward(const Matrix &input)
     {
+        // The fast kernel clamps its argument itself
+        if (m_mathPolicy == FAST_MATH)
+        {
+            m_output = Matrix(input.getRows(), input.getCols());
+            applyInParallel(fastSigmoid, input.getDataPtr(), m_output.getDataPtr(), input.getSize());
+            return m_output;
+        }
+
         double expLimit = 700; // To avoid overflow/underflow in exp
 
         m_output = input.map([expLimit](double x) {
-            // Clip input values to avoid overflow/underflow in exp
-            return 1.0 / (1.0 + std::exp(std::max(-expLimit, std::min(-x, expLimit))));
+            // Clip input values to avoid overflow/underflow in exp, selects keep the loop vectorisable
+            double argument = (-x > expLimit) ? expLimit : -x;
+            argument = (argument < -expLimit) ? -expLimit : argument;
+            return 1.0 / (1.0 + std::exp(argument));
         });
 
         return m_output;
@@ -26,4 +36,22 @@ namespace nn
         // Compute gradient of Sigmoid: (sigmoid(x) * (1 - sigmoid(x)))
         return m_output.map([](double x) { return x * (1 - x); });
     }
+
+    void Sigmoid::applyToSample(double *values, const int count) const
+    {
+        if (m_mathPolicy == FAST_MATH)
+        {
+            fastSigmoid(values, values, count);
+            return;
+        }
+
+        double expLimit = 700; // To avoid overflow/underflow in exp
+
+        for (int i = 0; i < count; i++)
+        {
+            double argument = (-values[i] > expLimit) ? expLimit : -values[i];
+            argument = (argument < -expLimit) ? -expLimit : argument;
+            values[i] = 1.0 / (1.0 + std::exp(argument));
+        }
+    }
 }
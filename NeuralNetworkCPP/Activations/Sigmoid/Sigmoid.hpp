@@ -35,6 +35,14 @@ namespace nn
          * @return The gradient of the loss with respect to the input.
          */
         Matrix backward(const Matrix &gradient) override;
+
+        /**
+         * @brief Applies the Sigmoid function in place to the features of a single sample.
+         *
+         * @param values Features of the sample.
+         * @param count Number of features.
+         */
+        void applyToSample(double *values, const int count) const override;
     };
 }
 
@@ -5,26 +5,131 @@
  */
 
 #include "Softmax.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
 #include <cmath>
 
 namespace nn
 {
+    // Number of samples (columns) processed by a single task
+    constexpr int SOFTMAX_BLOCK_SIZE = 64;
+
+    // Softmax of the contiguous features of one sample, `y` may be `x` itself
+    static void softmaxSample(const double *x, double *y, const int count, const e_mathPolicy mathPolicy)
+    {
+        // Find the maximum to avoid overflow in exp
+        double maxValue = x[0];
+        for (int j = 1; j < count; j++)
+            maxValue = (x[j] > maxValue) ? x[j] : maxValue;
+
+        // Write the shifted exponentials and sum them
+        for (int j = 0; j < count; j++)
+            y[j] = x[j] - maxValue;
+
+        if (mathPolicy == FAST_MATH)
+            fastExp(y, y, count);
+        else
+            for (int j = 0; j < count; j++)
+                y[j] = std::exp(y[j]);
+
+        double sumExp = 0.0;
+        for (int j = 0; j < count; j++)
+            sumExp += y[j];
+
+        // Normalise the sample
+        double invSum = 1.0 / sumExp;
+        for (int j = 0; j < count; j++)
+            y[j] *= invSum;
+    }
+
     Matrix Softmax::forward(const Matrix &input)
     {
-        // Shift input values by subtracting the maximum value to avoid overflow in exp
-        // and then apply softmax
-        Matrix expVals = (input.rowWise() - input.colWise().maxCoeff()).map([](double x) {
-            return std::exp(x);
+        if (m_layout == SAMPLE_MAJOR)
+            return forwardSampleMajor(input);
+
+        int rows = input.getRows();
+        int cols = input.getCols();
+        int numBlocks = (cols + SOFTMAX_BLOCK_SIZE - 1) / SOFTMAX_BLOCK_SIZE;
+        m_output = Matrix(rows, cols);
+
+        // Each task handles a block of samples, its rows stay in cache for all passes
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int start = block * SOFTMAX_BLOCK_SIZE;
+            int width = std::min(cols, start + SOFTMAX_BLOCK_SIZE) - start;
+            double maxValue[SOFTMAX_BLOCK_SIZE];
+            double sumExp[SOFTMAX_BLOCK_SIZE];
+
+            // Find the maximum of each sample to avoid overflow in exp
+            const double *firstRow = input.getDataPtr() + start;
+            for (int j = 0; j < width; j++)
+                maxValue[j] = firstRow[j];
+
+            for (int i = 1; i < rows; i++)
+            {
+                const double *x = input.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                for (int j = 0; j < width; j++)
+                    maxValue[j] = (x[j] > maxValue[j]) ? x[j] : maxValue[j];
+            }
+
+            // Write the shifted exponentials into the output and sum them per sample
+            std::fill(sumExp, sumExp + width, 0.0);
+            for (int i = 0; i < rows; i++)
+            {
+                const double *x = input.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                double *y = m_output.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+
+                for (int j = 0; j < width; j++)
+                    y[j] = x[j] - maxValue[j];
+
+                if (m_mathPolicy == FAST_MATH)
+                    fastExp(y, y, width);
+                else
+                    for (int j = 0; j < width; j++)
+                        y[j] = std::exp(y[j]);
+
+                for (int j = 0; j < width; j++)
+                    sumExp[j] += y[j];
+            }
+
+            // Normalise each sample
+            for (int j = 0; j < width; j++)
+                sumExp[j] = 1.0 / sumExp[j];
+
+            for (int i = 0; i < rows; i++)
+            {
+                double *y = m_output.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                for (int j = 0; j < width; j++)
+                    y[j] *= sumExp[j];
+            }
         });
 
-        m_output = expVals.rowWise() / expVals.colWise().sum();
+        return m_output;
+    }
+
+    Matrix Softmax::forwardSampleMajor(const Matrix &input)
+    {
+        int rows = input.getRows();
+        int cols = input.getCols();
+        m_output = Matrix(rows, cols);
+
+        // Each sample is a contiguous row, so every pass is a unit-stride loop
+        getGlobalThreadPool().parallelFor(0, rows, [&](int sample) {
+            const double *x = input.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+            double *y = m_output.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+            softmaxSample(x, y, cols, m_mathPolicy);
+        });
 
         return m_output;
     }
 
+    void Softmax::applyToSample(double *values, const int count) const
+    {
+        softmaxSample(values, values, count, m_mathPolicy);
+    }
+
     Matrix Softmax::backward(const Matrix &gradient)
     {
         // Compute the gradient of softmax
         return m_output.map([](double x) { return x * (1 - x); });
     }
-}
\ No newline at end of file
+}
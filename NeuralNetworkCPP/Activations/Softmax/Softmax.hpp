@@ -35,6 +35,23 @@ namespace nn
          * @return The gradient of the loss with respect to the input.
          */
         Matrix backward(const Matrix &gradient) override;
+
+        /**
+         * @brief Applies the Softmax function in place to the features of a single sample.
+         *
+         * @param values Features of the sample.
+         * @param count Number of features.
+         */
+        void applyToSample(double *values, const int count) const override;
+
+    private:
+        /**
+         * @brief Applies the Softmax function to each row of a sample-major input.
+         *
+         * @param input The input matrix, one sample per row.
+         * @return The output matrix after applying Softmax.
+         */
+        Matrix forwardSampleMajor(const Matrix &input);
     };
 }
 
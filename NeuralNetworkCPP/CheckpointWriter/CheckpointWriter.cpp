@@ -0,0 +1,108 @@
+/**
+ * C++ neural network library
+ *
+ * CheckpointWriter.cpp
+ */
+
+#include "CheckpointWriter.hpp"
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+
+namespace nn
+{
+    CheckpointWriter::CheckpointWriter()
+    {
+        m_thread = std::thread(&CheckpointWriter::run, this);
+    }
+
+    CheckpointWriter::~CheckpointWriter()
+    {
+        // Let the thread write the pending snapshot and exit
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_condition.notify_one();
+        m_thread.join();
+    }
+
+    void CheckpointWriter::write(const std::string &filename, std::function<void(std::ostream &)> snapshot)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            rethrowError();
+
+            // Replace the pending snapshot, only the latest one matters
+            m_pendingFilename = filename;
+            m_pendingSnapshot = std::move(snapshot);
+            m_hasPending = true;
+        }
+        m_condition.notify_one();
+    }
+
+    void CheckpointWriter::wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_idle.wait(lock, [this] { return !m_hasPending && !m_isWriting; });
+        rethrowError();
+    }
+
+    void CheckpointWriter::run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            m_condition.wait(lock, [this] { return m_hasPending || m_stop; });
+
+            if (!m_hasPending)
+                return;
+
+            // Take the snapshot and write it without holding the lock
+            std::string filename = std::move(m_pendingFilename);
+            std::function<void(std::ostream &)> snapshot = std::move(m_pendingSnapshot);
+            m_hasPending = false;
+            m_isWriting = true;
+            lock.unlock();
+
+            try
+            {
+                // Write to a temporary file first so an interrupted write never corrupts the checkpoint
+                std::string tempFilename = filename + ".tmp";
+                {
+                    std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+                    if (!file.is_open())
+                        throw std::runtime_error("Failed to open checkpoint file for writing.");
+
+                    snapshot(file);
+                    file.flush();
+                    if (!file.good())
+                        throw std::runtime_error("Failed to write checkpoint to the file.");
+                }
+                std::filesystem::rename(tempFilename, filename);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> errorLock(m_mutex);
+                if (!m_error)
+                    m_error = std::current_exception();
+            }
+
+            lock.lock();
+            m_isWriting = false;
+            if (!m_hasPending)
+                m_idle.notify_all();
+        }
+    }
+
+    void CheckpointWriter::rethrowError()
+    {
+        if (m_error)
+        {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+}
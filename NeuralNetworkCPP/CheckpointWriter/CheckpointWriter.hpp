@@ -0,0 +1,84 @@
+/**
+ * C++ neural network library
+ *
+ * CheckpointWriter.hpp
+ */
+
+#ifndef CHECKPOINTWRITER_HPP
+#define CHECKPOINTWRITER_HPP
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace nn
+{
+    /**
+     * @class CheckpointWriter
+     * @brief Writes serialized checkpoints to disk on a background thread.
+     *
+     * The caller hands over a snapshot, a function writing copies of the state it needs, and
+     * continues immediately: serializing and writing happen on the thread. Only the most recent
+     * snapshot is kept: if a new one arrives before the previous one was written, the previous one
+     * is dropped. Files are written next to the target and renamed, so a checkpoint on disk is
+     * always complete.
+     */
+    class CheckpointWriter
+    {
+    private:
+        std::thread m_thread;                                  ///< Background I/O thread.
+        std::mutex m_mutex;                                    ///< Mutex protecting the pending snapshot and the flags.
+        std::condition_variable m_condition;                   ///< Signals a new snapshot or the stop request.
+        std::condition_variable m_idle;                        ///< Signals that all snapshots have been written.
+        std::string m_pendingFilename;                         ///< Target file of the pending snapshot.
+        std::function<void(std::ostream &)> m_pendingSnapshot; ///< Pending snapshot.
+        bool m_hasPending = false;                             ///< True if a snapshot waits to be written.
+        bool m_isWriting = false;                              ///< True while the thread writes a snapshot.
+        bool m_stop = false;                                   ///< True once the writer is being destroyed.
+        std::exception_ptr m_error;                            ///< First error raised by the thread, rethrown to the caller.
+
+    public:
+        /**
+         * @brief Starts the background I/O thread.
+         */
+        CheckpointWriter();
+
+        /**
+         * @brief Destructor. Writes the pending snapshot and joins the thread.
+         */
+        ~CheckpointWriter();
+
+        /**
+         * @brief Schedules a snapshot to be written, replacing a snapshot which has not been written yet.
+         *
+         * @param filename Path to the checkpoint file.
+         * @param snapshot Function serializing the checkpoint, called on the background thread.
+         * @throws std::runtime_error If a previous write failed.
+         */
+        void write(const std::string &filename, std::function<void(std::ostream &)> snapshot);
+
+        /**
+         * @brief Blocks until all scheduled snapshots have been written.
+         *
+         * @throws std::runtime_error If a write failed.
+         */
+        void wait();
+
+    private:
+        /**
+         * @brief Main loop of the background thread.
+         */
+        void run();
+
+        /**
+         * @brief Rethrows the error of the background thread, if any. Expects the mutex to be held.
+         */
+        void rethrowError();
+    };
+}
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * C++ neural network library
+ *
+ * LibSVMReader.cpp
+ */
+
+#include "LibSVMReader.hpp"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace nn
+{
+    LibSVMReader::LibSVMReader(const std::string &filename, const int numFeatures, const bool zeroBased)
+        : m_filename(filename), m_numFeatures(numFeatures), m_zeroBased(zeroBased)
+    {
+        if (numFeatures < 0)
+            throw std::invalid_argument("Number of features must be non-negative.");
+    }
+
+    void LibSVMReader::read()
+    {
+        // Open the file
+        std::ifstream file(m_filename);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file: " + m_filename);
+
+        std::vector<int> rowOffsets = {0};
+        std::vector<int> colIndices;
+        std::vector<double> values;
+        std::vector<std::pair<int, double>> features;
+        int maxIndex = -1;
+        m_labels.clear();
+
+        std::string line;
+
+        // Read file line by line
+        while (std::getline(file, line))
+        {
+            // Drop the comment and skip empty lines
+            line = line.substr(0, line.find('#'));
+            std::istringstream tokenStream(line);
+            std::string token;
+            if (!(tokenStream >> token))
+                continue;
+
+            // The first token is the label
+            try
+            {
+                m_labels.push_back({std::stod(token)});
+            }
+            catch (const std::exception &)
+            {
+                throw std::runtime_error("Invalid label in libsvm file: " + token);
+            }
+
+            // The remaining tokens are index:value pairs
+            features.clear();
+            while (tokenStream >> token)
+            {
+                std::size_t separator = token.find(':');
+                if (separator == std::string::npos)
+                    throw std::runtime_error("Invalid feature in libsvm file: " + token);
+
+                if (token.compare(0, separator, "qid") == 0)
+                    continue;
+
+                int index;
+                double value;
+                try
+                {
+                    index = std::stoi(token.substr(0, separator)) - (m_zeroBased ? 0 : 1);
+                    value = std::stod(token.substr(separator + 1));
+                }
+                catch (const std::exception &)
+                {
+                    throw std::runtime_error("Invalid feature in libsvm file: " + token);
+                }
+
+                if (index < 0 || (m_numFeatures > 0 && index >= m_numFeatures))
+                    throw std::runtime_error("Feature index out of range in libsvm file: " + token);
+
+                if (value != 0.0)
+                    features.emplace_back(index, value);
+            }
+
+            // Store the features of the sample sorted by index
+            std::sort(features.begin(), features.end());
+            for (std::size_t i = 0; i < features.size(); i++)
+            {
+                if (i > 0 && features[i].first == features[i - 1].first)
+                    throw std::runtime_error("Duplicate feature index in libsvm file: " + line);
+
+                colIndices.push_back(features[i].first);
+                values.push_back(features[i].second);
+            }
+
+            if (!features.empty())
+                maxIndex = std::max(maxIndex, features.back().first);
+            rowOffsets.push_back(colIndices.size());
+        }
+
+        // Build the sparse matrix of all samples
+        int numFeatures = (m_numFeatures > 0) ? m_numFeatures : maxIndex + 1;
+        m_data = SparseMatrix(m_labels.size(), numFeatures, std::move(rowOffsets), std::move(colIndices), values);
+    }
+}
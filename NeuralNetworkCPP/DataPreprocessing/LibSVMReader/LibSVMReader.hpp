@@ -0,0 +1,66 @@
+/**
+ * C++ neural network library
+ *
+ * LibSVMReader.hpp
+ */
+
+#ifndef LIBSVMREADER_HPP
+#define LIBSVMREADER_HPP
+
+#include "../../Matrix/SparseMatrix/SparseMatrix.hpp"
+#include <string>
+#include <vector>
+
+namespace nn
+{
+    /**
+     * @class LibSVMReader
+     * @brief Reads sparse data in the libsvm/svmlight format.
+     *
+     * Each line holds a label followed by `index:value` pairs of the non-zero features, e.g.
+     * `1 3:0.5 17:1`. Comments after `#` and `qid:` pairs are ignored. The features are stored
+     * as a sparse matrix with one sample per row, so high-dimensional data never gets expanded.
+     */
+    class LibSVMReader
+    {
+    private:
+        std::string m_filename;                    ///< Path to the libsvm file.
+        int m_numFeatures;                         ///< Number of features (0: inferred from the largest index).
+        bool m_zeroBased;                          ///< If true, feature indices start at 0; otherwise, at 1.
+        SparseMatrix m_data;                       ///< Stores the feature data from the file.
+        std::vector<std::vector<double>> m_labels; ///< Stores the labels from the file.
+
+    public:
+        /**
+         * @brief Constructs a LibSVMReader object.
+         *
+         * @param filename Path to the libsvm file.
+         * @param numFeatures Number of features, set it to read files that do not contain the largest index (default: 0, inferred).
+         * @param zeroBased If true, feature indices start at 0 (default: false).
+         */
+        LibSVMReader(const std::string &filename, const int numFeatures = 0, const bool zeroBased = false);
+
+        /**
+         * @brief Reads the file and stores the data and labels.
+         *
+         * @throws std::runtime_error If the file cannot be opened or contains invalid data.
+         */
+        void read();
+
+        /**
+         * @brief Returns the feature data from the file.
+         *
+         * @return The sparse feature data, one sample per row.
+         */
+        const SparseMatrix &getData() const { return m_data; };
+
+        /**
+         * @brief Returns the labels from the file.
+         *
+         * @return std::vector<std::vector<double>> The labels.
+         */
+        std::vector<std::vector<double>> getLabels() const { return m_labels; };
+    };
+}
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * C++ neural network library
+ *
+ * FastMath.cpp
+ */
+
+#include "FastMath.hpp"
+#include "../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cstdint>
+
+namespace nn
+{
+    // Number of elements processed by a single task of applyInParallel
+    constexpr std::size_t FAST_MATH_CHUNK_SIZE = 4096;
+
+    // ln(2) split into a part with trailing zero bits (n * LN2_HI is exact) and the rest
+    constexpr double LN2_HI = 6.93147180369123816490e-01;
+    constexpr double LN2_LO = 1.90821492927058770002e-10;
+    constexpr double LOG2E = 1.44269504088896338700e+00;
+    constexpr double SQRT2 = 1.41421356237309514547e+00;
+
+    // Adding 1.5 * 2^52 rounds to an integer that ends up in the low bits of the mantissa
+    constexpr double ROUNDING_SHIFTER = 0x1.8p52;
+
+    // Range of exp arguments whose result and 2^n scale stay normal doubles
+    constexpr double EXP_MIN_ARGUMENT = -708.0;
+    constexpr double EXP_MAX_ARGUMENT = 709.0;
+
+    static inline double expKernel(double x)
+    {
+        // Clamp with plain selects, std::min and std::max keep GCC from vectorising the loop (see CMakeLists.txt)
+        x = (x < EXP_MIN_ARGUMENT) ? EXP_MIN_ARGUMENT : x;
+        x = (x > EXP_MAX_ARGUMENT) ? EXP_MAX_ARGUMENT : x;
+
+        // Reduce the argument: x = n * ln(2) + r with |r| <= ln(2) / 2
+        double shifted = x * LOG2E + ROUNDING_SHIFTER;
+        double n = shifted - ROUNDING_SHIFTER;
+        double r = (x - n * LN2_HI) - n * LN2_LO;
+
+        // e^r with the Taylor polynomial of degree 12 (truncation error below 2e-16)
+        double p = 1.0 / 479001600.0;
+        p = p * r + 1.0 / 39916800.0;
+        p = p * r + 1.0 / 3628800.0;
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+
+        // Multiply by 2^n by adding n to the exponent bits
+        std::uint64_t exponent = std::bit_cast<std::uint64_t>(shifted) - std::bit_cast<std::uint64_t>(ROUNDING_SHIFTER);
+        return std::bit_cast<double>(std::bit_cast<std::uint64_t>(p) + (exponent << 52));
+    }
+
+    static inline double logKernel(double x)
+    {
+        // Split x = 2^e * m with m in [1, 2)
+        x = (x < DBL_MIN) ? DBL_MIN : x;
+        std::uint64_t bits = std::bit_cast<std::uint64_t>(x);
+        double e = std::bit_cast<double>((bits >> 52) | 0x4330000000000000ULL) - (0x1p52 + 1023.0);
+        double m = std::bit_cast<double>((bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+
+        // Center m around 1: m in [sqrt(0.5), sqrt(2))
+        bool isLarge = m >= SQRT2;
+        m = isLarge ? m * 0.5 : m;
+        e = isLarge ? e + 1.0 : e;
+
+        // log(m) = 2 * atanh(f) = 2f * (1 + s/3 + s^2/5 + ...) with f = (m - 1) / (m + 1), s = f^2 <= 0.0295
+        double f = (m - 1.0) / (m + 1.0);
+        double s = f * f;
+        double p = 1.0 / 17.0;
+        p = p * s + 1.0 / 15.0;
+        p = p * s + 1.0 / 13.0;
+        p = p * s + 1.0 / 11.0;
+        p = p * s + 1.0 / 9.0;
+        p = p * s + 1.0 / 7.0;
+        p = p * s + 1.0 / 5.0;
+        p = p * s + 1.0 / 3.0;
+        p = p * s + 1.0;
+
+        return e * LN2_HI + (e * LN2_LO + 2.0 * f * p);
+    }
+
+    static inline double sigmoidKernel(double x)
+    {
+        return 1.0 / (1.0 + expKernel(-x));
+    }
+
+    template <typename Kernel>
+    static void applyKernel(const double *input, double *output, const std::size_t count, Kernel kernel)
+    {
+        // Separate loops for in-place and out-of-place calls, so neither needs an aliasing check
+        if (input == output)
+        {
+            double *values = output;
+            for (std::size_t i = 0; i < count; i++)
+                values[i] = kernel(values[i]);
+        }
+        else
+        {
+            const double *__restrict source = input;
+            double *__restrict target = output;
+            for (std::size_t i = 0; i < count; i++)
+                target[i] = kernel(source[i]);
+        }
+    }
+
+    void fastExp(const double *input, double *output, const std::size_t count)
+    {
+        applyKernel(input, output, count, [](double x) { return expKernel(x); });
+    }
+
+    void fastLog(const double *input, double *output, const std::size_t count)
+    {
+        applyKernel(input, output, count, [](double x) { return logKernel(x); });
+    }
+
+    void fastSigmoid(const double *input, double *output, const std::size_t count)
+    {
+        applyKernel(input, output, count, [](double x) { return sigmoidKernel(x); });
+    }
+
+    void applyInParallel(const FastMathKernel kernel, const double *input, double *output, const std::size_t count)
+    {
+        int numChunks = (count + FAST_MATH_CHUNK_SIZE - 1) / FAST_MATH_CHUNK_SIZE;
+
+        // Parallelize over chunks, each chunk runs the serial kernel
+        getGlobalThreadPool().parallelFor(0, numChunks, [kernel, input, output, count](int chunk) {
+            std::size_t start = chunk * FAST_MATH_CHUNK_SIZE;
+            std::size_t end = std::min(count, start + FAST_MATH_CHUNK_SIZE);
+            kernel(input + start, output + start, end - start);
+        });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+/**
+ * C++ neural network library
+ *
+ * FastMath.hpp
+ */
+
+#ifndef FASTMATH_HPP
+#define FASTMATH_HPP
+
+#include <cstddef>
+
+namespace nn
+{
+    /**
+     * @brief Enum with available implementations of the transcendental functions.
+     *
+     * STANDARD_MATH calls `std::exp` and `std::log` per element. FAST_MATH uses the polynomial
+     * kernels below, which vectorise and are accurate to a few ulp.
+     */
+    enum e_mathPolicy { STANDARD_MATH, FAST_MATH };
+
+    /// Signature of the kernels below, which run on the calling thread.
+    using FastMathKernel = void (*)(const double *input, double *output, const std::size_t count);
+
+    /**
+     * @brief Computes `exp(x)` for every element with a vectorisable polynomial approximation.
+     *
+     * The argument is reduced to `x = n * ln(2) + r` with `|r| <= ln(2) / 2`, `e^r` is evaluated
+     * with a degree 12 polynomial and scaled by `2^n` through the exponent bits. The relative
+     * error is below 1e-14 for `x` in [-708, 709], inputs outside are clamped to this range.
+     * NaN inputs give unspecified results.
+     *
+     * @param input Input values.
+     * @param output Output values, either `input` itself or a non-overlapping buffer.
+     * @param count Number of elements.
+     */
+    void fastExp(const double *input, double *output, const std::size_t count);
+
+    /**
+     * @brief Computes `log(x)` for every element with a vectorisable polynomial approximation.
+     *
+     * The argument is split into `x = 2^e * m` with `m` in [sqrt(0.5), sqrt(2)), `log(m)` is
+     * evaluated with the series of `2 * atanh((m - 1) / (m + 1))` up to the 17th power. The
+     * absolute error is below 1e-15 + 1e-15 * |log(x)|. Inputs below the smallest normal double
+     * (including zero and negative values) are treated as the smallest normal double.
+     *
+     * @param input Input values.
+     * @param output Output values, either `input` itself or a non-overlapping buffer.
+     * @param count Number of elements.
+     */
+    void fastLog(const double *input, double *output, const std::size_t count);
+
+    /**
+     * @brief Computes `1 / (1 + exp(-x))` for every element using `fastExp`.
+     *
+     * The relative error is below 1e-14 for `x` >= -708, below that the result stays at about 1e-308.
+     *
+     * @param input Input values.
+     * @param output Output values, either `input` itself or a non-overlapping buffer.
+     * @param count Number of elements.
+     */
+    void fastSigmoid(const double *input, double *output, const std::size_t count);
+
+    /**
+     * @brief Applies a kernel to chunks of the elements in parallel on the global thread pool.
+     *
+     * The kernels themselves are serial, so they can be called from tasks of the pool (e.g. per
+     * sample or per block). This is the parallel path for whole matrices and must not be called
+     * from a task of the pool.
+     *
+     * @param kernel `fastExp`, `fastLog` or `fastSigmoid`.
+     * @param input Input values.
+     * @param output Output values, either `input` itself or a non-overlapping buffer.
+     * @param count Number of elements.
+     */
+    void applyInParallel(const FastMathKernel kernel, const double *input, double *output, const std::size_t count);
+}
+
+#endif
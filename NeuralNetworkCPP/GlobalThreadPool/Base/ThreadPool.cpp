@@ -5,17 +5,65 @@
  */
 
 #include "ThreadPool.hpp"
+#include <algorithm>
 #include <utility>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace nn
 {
-    ThreadPool::ThreadPool(int numThreads)
+    std::vector<int> getAvailableCores()
+    {
+        std::vector<int> cores;
+
+#ifdef __linux__
+        // Cores of the affinity mask, which respects taskset and cgroup restrictions
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+            for (int core = 0; core < CPU_SETSIZE; core++)
+                if (CPU_ISSET(core, &set))
+                    cores.push_back(core);
+#endif
+
+        if (cores.empty())
+            for (int core = 0; core < static_cast<int>(std::max(1u, std::thread::hardware_concurrency())); core++)
+                cores.push_back(core);
+
+        return cores;
+    }
+
+    bool pinCurrentThread(const std::vector<int> &cores)
+    {
+        if (cores.empty())
+            return false;
+
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int core : cores)
+            if (core >= 0 && core < CPU_SETSIZE)
+                CPU_SET(core, &set);
+
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    ThreadPool::ThreadPool(int numThreads, const std::vector<int> &cores)
         : m_stop(false), m_numThreads(numThreads)
     {
         // Create worker threads.
         for (int i = 0; i < numThreads; i++)
         {
-            m_workers.emplace_back([this] {
+            m_workers.emplace_back([this, cores] {
+                // Keep the worker on its cores, if any were given.
+                pinCurrentThread(cores);
+
                 while (true)
                 {
                     std::function<void()> task;
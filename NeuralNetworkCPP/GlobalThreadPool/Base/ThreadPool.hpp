@@ -19,6 +19,23 @@
 
 namespace nn
 {
+    /**
+     * @brief Returns the CPU cores the process may run on.
+     *
+     * On Linux this is the affinity mask of the process, elsewhere cores 0 to hardware_concurrency - 1.
+     *
+     * @return The indices of the cores in ascending order.
+     */
+    std::vector<int> getAvailableCores();
+
+    /**
+     * @brief Restricts the calling thread to a set of CPU cores.
+     *
+     * @param cores Indices of the cores, an empty set leaves the thread unpinned.
+     * @return True if the thread was pinned, false if pinning is not supported (non-Linux) or failed.
+     */
+    bool pinCurrentThread(const std::vector<int> &cores);
+
     /**
      * @class ThreadPool
      * @brief A thread pool implementation for executing tasks in parallel.
@@ -42,8 +59,9 @@ namespace nn
          * @brief Constructs a ThreadPool with the specified number of threads.
          *
          * @param numThreads The number of threads in the pool.
+         * @param cores CPU cores the workers are pinned to, see `pinCurrentThread` (default: not pinned).
          */
-        ThreadPool(int numThreads);
+        ThreadPool(int numThreads, const std::vector<int> &cores = {});
 
         /**
          * @brief Destructor. Stops the thread pool and joins all worker threads.
@@ -11,6 +11,9 @@ namespace nn
     // Initialize the global thread pool to nullptr (uninitialized by default).
     std::unique_ptr<ThreadPool> globalThreadPool = nullptr;
 
+    // Pool overriding the global one on the current thread, see ThreadPoolScope
+    static thread_local ThreadPool *scopedThreadPool = nullptr;
+
     void initGlobalThreadPool(int numThreads)
     {
         // Check if the global thread pool is already initialized.
@@ -23,6 +26,10 @@ namespace nn
 
     ThreadPool &getGlobalThreadPool()
     {
+        // A scope of the current thread takes precedence
+        if (scopedThreadPool)
+            return *scopedThreadPool;
+
         // Throw an error if the thread pool is accessed before initialization.
         if (!globalThreadPool)
             throw std::runtime_error("Global thread pool not initialized.");
@@ -30,4 +37,15 @@ namespace nn
         // Return a reference to the global thread pool.
         return *globalThreadPool;
     }
+
+    ThreadPoolScope::ThreadPoolScope(ThreadPool &pool)
+        : m_previous(scopedThreadPool)
+    {
+        scopedThreadPool = &pool;
+    }
+
+    ThreadPoolScope::~ThreadPoolScope()
+    {
+        scopedThreadPool = m_previous;
+    }
 }
\ No newline at end of file
@@ -34,6 +34,33 @@ namespace nn
      * @throws std::runtime_error If the thread pool is not initialized.
      */
     ThreadPool &getGlobalThreadPool();
+
+    /**
+     * @class ThreadPoolScope
+     * @brief Makes `getGlobalThreadPool` return another pool on the current thread.
+     *
+     * Lets a thread run the parallel loops of the library on its own group of cores, e.g. a stage
+     * of a pipeline. The previous pool is restored when the scope is destroyed, scopes can be nested.
+     */
+    class ThreadPoolScope
+    {
+    private:
+        ThreadPool *m_previous; ///< Pool active before the scope.
+
+    public:
+        /**
+         * @brief Activates the pool on the current thread.
+         *
+         * @param pool The pool, must outlive the scope.
+         */
+        explicit ThreadPoolScope(ThreadPool &pool);
+
+        /** @brief Restores the previous pool. */
+        ~ThreadPoolScope();
+
+        ThreadPoolScope(const ThreadPoolScope &) = delete;
+        ThreadPoolScope &operator=(const ThreadPoolScope &) = delete;
+    };
 }
 
 #endif
\ No newline at end of file
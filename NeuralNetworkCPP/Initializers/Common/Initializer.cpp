@@ -0,0 +1,45 @@
+/**
+ * C++ neural network library
+ *
+ * Initializer.cpp
+ */
+
+#include "Initializer.hpp"
+#include <atomic>
+#include <random>
+
+namespace nn
+{
+    // Sequence of seeds shared by all threads
+    static std::atomic<bool> hasGlobalSeed{false};
+    static std::atomic<std::uint64_t> globalSeed{0};
+
+    // SplitMix64 finalizer, turns consecutive seeds into unrelated keys
+    static std::uint64_t mixSeed(std::uint64_t value)
+    {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+
+    void setInitializerSeed(const std::uint64_t seed)
+    {
+        globalSeed.store(seed);
+        hasGlobalSeed.store(true);
+    }
+
+    void clearInitializerSeed()
+    {
+        hasGlobalSeed.store(false);
+    }
+
+    std::uint64_t nextInitializerSeed()
+    {
+        if (hasGlobalSeed.load())
+            return mixSeed(globalSeed.fetch_add(1));
+
+        // Combine two draws, std::random_device returns 32 bits
+        std::random_device device;
+        return (static_cast<std::uint64_t>(device()) << 32) | device();
+    }
+}
@@ -7,45 +7,83 @@
 #ifndef INITIALIZER_HPP
 #define INITIALIZER_HPP
 
-#include <random>
+#include "Philox.hpp"
+#include <cstdint>
 
 namespace nn
 {
+    /**
+     * @brief Makes the seeds of the initializers created from now on reproducible.
+     *
+     * Each new initializer takes the next seed of a sequence starting at `seed`, so a model whose
+     * layers are created in the same order gets the same weights. Without a global seed every
+     * initializer is seeded from `std::random_device`.
+     *
+     * @param seed First seed of the sequence.
+     */
+    void setInitializerSeed(const std::uint64_t seed);
+
+    /** @brief Seeds the initializers created from now on from `std::random_device` again. */
+    void clearInitializerSeed();
+
+    /** @brief Returns the seed of the next initializer, see `setInitializerSeed`. */
+    std::uint64_t nextInitializerSeed();
+
     /**
      * @class Initializer
      * @brief Abstract base class for weight initializers in neural networks.
      *
      * This class provides a common interface for weight initialization strategies.
      * Derived classes implement specific initialization methods (e.g., He Normal, Xavier Uniform).
+     *
+     * Values are drawn from a counter-based generator (Philox4x32-10): the value of element `index`
+     * only depends on the seed and the index, so a matrix can be filled by many threads at once
+     * without shared state and gets the same values for any number of threads.
      */
     class Initializer
     {
     protected:
-        int m_inputs;       ///< Number of input neurons
-        int m_outputs;      ///< Number of output neurons
-        std::mt19937 m_gen; ///< Mersenne Twister random number generator.
+        int m_inputs;         ///< Number of input neurons
+        int m_outputs;        ///< Number of output neurons
+        std::uint64_t m_seed; ///< Key of the counter-based generator.
+        std::uint64_t m_next; ///< Index of the value returned by the next `getRandomNum` call.
 
     public:
         /**
          * @brief Constructor for the Initializer class.
          *
-         * Initializes the random number generator and stores the number of input and output neurons.
+         * Stores the seed of the generator and the number of input and output neurons.
          *
          * @param inputs Number of input neurons.
          * @param outputs Number of output neurons.
+         * @param seed Seed of the generator (default: the next seed, see `setInitializerSeed`).
          */
-        Initializer(const int inputs, const int outputs)
-            : m_inputs(inputs), m_outputs(outputs), m_gen(std::random_device{}()) {}
+        Initializer(const int inputs, const int outputs, const std::uint64_t seed = nextInitializerSeed())
+            : m_inputs(inputs), m_outputs(outputs), m_seed(seed), m_next(0) {}
+
+        virtual ~Initializer() = default;
 
         /**
-         * @brief Pure virtual function for generating a random number.
+         * @brief Pure virtual function for generating the value of an element.
          *
          * Derived classes must implement this method to provide specific initialization logic.
+         * It is a pure function of the seed and the index, so it may be called concurrently.
          *
-         * @return A randomly initialized value.
+         * @param index Index of the element.
+         * @return The randomly initialized value of the element.
          */
-        virtual double getRandomNum() = 0;
+        virtual double getValue(const std::uint64_t index) const = 0;
+
+        /**
+         * @brief Generates the next random number of the sequence.
+         *
+         * @return The value of the next index, see `getValue`.
+         */
+        double getRandomNum() { return getValue(m_next++); }
+
+        /** @brief Returns the seed of the generator. */
+        std::uint64_t getSeed() const { return m_seed; }
     };
 }
 
-#endif
\ No newline at end of file
+#endif
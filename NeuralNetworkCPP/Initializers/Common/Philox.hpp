@@ -0,0 +1,101 @@
+/**
+ * C++ neural network library
+ *
+ * Philox.hpp
+ */
+
+#ifndef PHILOX_HPP
+#define PHILOX_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+namespace nn
+{
+    /// Block of four 32-bit words produced by one evaluation of the generator.
+    using PhiloxBlock = std::array<std::uint32_t, 4>;
+
+    /**
+     * @brief Philox4x32-10 counter-based random number generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+     *
+     * The output is a pure function of the counter and the key, so every element of a matrix can
+     * draw its own numbers from its index without any shared state. Different threads never touch
+     * the same generator and the result does not depend on how the work is split between them.
+     *
+     * @param counter 128-bit counter, the position in the stream.
+     * @param key 64-bit key, the seed of the stream.
+     * @return Four random 32-bit words.
+     */
+    inline PhiloxBlock philox4x32(PhiloxBlock counter, std::array<std::uint32_t, 2> key)
+    {
+        constexpr std::uint64_t MULTIPLIER_0 = 0xD2511F53;
+        constexpr std::uint64_t MULTIPLIER_1 = 0xCD9E8D57;
+        constexpr std::uint32_t WEYL_0 = 0x9E3779B9;
+        constexpr std::uint32_t WEYL_1 = 0xBB67AE85;
+
+        for (int round = 0; round < 10; round++)
+        {
+            // Multiply two words into their high and low halves
+            std::uint64_t product0 = MULTIPLIER_0 * counter[0];
+            std::uint64_t product1 = MULTIPLIER_1 * counter[2];
+
+            // Mix the halves with the other words and the key
+            counter = {static_cast<std::uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<std::uint32_t>(product1),
+                       static_cast<std::uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<std::uint32_t>(product0)};
+
+            // Bump the key for the next round
+            key[0] += WEYL_0;
+            key[1] += WEYL_1;
+        }
+
+        return counter;
+    }
+
+    /**
+     * @brief Returns the block of position `index` of the stream with key `seed`.
+     *
+     * @param seed Key of the stream.
+     * @param index Position in the stream.
+     * @return Four random 32-bit words.
+     */
+    inline PhiloxBlock philox4x32(const std::uint64_t seed, const std::uint64_t index)
+    {
+        return philox4x32({static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(index >> 32), 0, 0},
+                          {static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)});
+    }
+
+    /** @brief Converts two 32-bit words to a double in [0, 1) with 53 random bits. */
+    inline double wordsToUniform(const std::uint32_t high, const std::uint32_t low)
+    {
+        std::uint64_t bits = (static_cast<std::uint64_t>(high) << 32) | low;
+        return static_cast<double>(bits >> 11) * 0x1.0p-53;
+    }
+
+    /**
+     * @brief Returns a uniform number in [0, 1) for position `index` of the stream with key `seed`.
+     */
+    inline double philoxUniform(const std::uint64_t seed, const std::uint64_t index)
+    {
+        PhiloxBlock block = philox4x32(seed, index);
+        return wordsToUniform(block[0], block[1]);
+    }
+
+    /**
+     * @brief Returns a standard normal number for position `index` of the stream with key `seed`.
+     *
+     * Uses the Box-Muller transform on the two uniform numbers of one block.
+     */
+    inline double philoxNormal(const std::uint64_t seed, const std::uint64_t index)
+    {
+        PhiloxBlock block = philox4x32(seed, index);
+
+        // The first number lies in (0, 1], so its logarithm is finite
+        double radius = 1.0 - wordsToUniform(block[0], block[1]);
+        double angle = wordsToUniform(block[2], block[3]);
+        return std::sqrt(-2.0 * std::log(radius)) * std::cos(2.0 * std::numbers::pi * angle);
+    }
+}
+
+#endif
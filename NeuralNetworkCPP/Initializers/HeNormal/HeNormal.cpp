@@ -8,20 +8,17 @@
 
 namespace nn
 {
-    HeNormal::HeNormal(const int inputs, const int outputs)
-        : Initializer(inputs, outputs)
+    HeNormal::HeNormal(const int inputs, const int outputs, const std::uint64_t seed)
+        : Initializer(inputs, outputs, seed)
     {
         // Compute the standard deviation for He Normal initialization.
         // Formula: sigma = sqrt(2.0 / fan-in), where fan-in is the number of input neurons.
-        double sigma = std::sqrt(2.0 / m_inputs);
-
-        // Initialize the normal distribution with mean 0 and computed standard deviation.
-        m_dist = std::normal_distribution<double>(0, sigma);
+        m_sigma = std::sqrt(2.0 / m_inputs);
     }
 
-    double HeNormal::getRandomNum()
+    double HeNormal::getValue(const std::uint64_t index) const
     {
-        // Generate a random number from the predefined normal distribution.
-        return m_dist(m_gen);
+        // Scale a standard normal number of the element.
+        return m_sigma * philoxNormal(m_seed, index);
     }
 }
\ No newline at end of file
@@ -8,20 +8,17 @@
 
 namespace nn
 {
-    HeUniform::HeUniform(const int inputs, const int outputs)
-        : Initializer(inputs, outputs)
+    HeUniform::HeUniform(const int inputs, const int outputs, const std::uint64_t seed)
+        : Initializer(inputs, outputs, seed)
     {
         // Compute the range limit for He Uniform initialization.
         // Formula: limit = sqrt(6.0 / fan-in), where fan-in is the number of input neurons.
-        double limit = std::sqrt(6.0 / inputs);
-
-        // Initialize the uniform distribution within the range [-limit, limit]
-        m_dist = std::uniform_real_distribution<double>(-limit, limit);
+        m_limit = std::sqrt(6.0 / inputs);
     }
 
-    double HeUniform::getRandomNum()
+    double HeUniform::getValue(const std::uint64_t index) const
     {
-        // Generate a random number from the predefined uniform distribution.
-        return m_dist(m_gen);
+        // Map a uniform number of the element from [0, 1) to [-limit, limit).
+        return m_limit * (2.0 * philoxUniform(m_seed, index) - 1.0);
     }
 }
\ No newline at end of file
@@ -8,20 +8,17 @@
 
 namespace nn
 {
-    XavierNormal::XavierNormal(const int inputs, const int outputs)
-        : Initializer(inputs, outputs)
+    XavierNormal::XavierNormal(const int inputs, const int outputs, const std::uint64_t seed)
+        : Initializer(inputs, outputs, seed)
     {
         // Compute the standard deviation for Xavier Normal initialization.
         // Formula: sigma = sqrt(2.0 / (fan-in + fan-out)), where fan-in and fan-out are input and output neurons.
-        double sigma = std::sqrt(2.0 / (m_inputs + m_outputs));
-
-        // Initialize the normal distribution with mean 0 and computed standard deviation.
-        m_dist = std::normal_distribution<double>(0, sigma);
+        m_sigma = std::sqrt(2.0 / (m_inputs + m_outputs));
     }
 
-    double XavierNormal::getRandomNum()
+    double XavierNormal::getValue(const std::uint64_t index) const
     {
-        // Generate a random number from the predefined normal distribution.
-        return m_dist(m_gen);
+        // Scale a standard normal number of the element.
+        return m_sigma * philoxNormal(m_seed, index);
     }
 }
\ No newline at end of file
@@ -22,25 +22,27 @@ namespace nn
     class XavierNormal : public Initializer
     {
     private:
-        std::normal_distribution<double> m_dist; ///< Normal distribution for weight initialization
+        double m_sigma; ///< Standard deviation of the normal distribution
 
     public:
         /**
          * @brief Constructor for XavierNormal initializer.
          *
-         * Initializes the normal distribution with a standard deviation of sqrt(2 / (fan-in + fan-out)).
+         * Computes a standard deviation of sqrt(2 / (fan-in + fan-out)).
          *
          * @param inputs Number of input neurons (fan-in).
          * @param outputs Number of output neurons (fan-out).
+         * @param seed Seed of the generator (default: the next seed, see `setInitializerSeed`).
          */
-        XavierNormal(const int inputs, const int outputs);
+        XavierNormal(const int inputs, const int outputs, const std::uint64_t seed = nextInitializerSeed());
 
         /**
-         * @brief Generates a random number following Xavier normal distribution.
+         * @brief Generates the value of an element following Xavier normal distribution.
          *
+         * @param index Index of the element.
          * @return A randomly initialized value drawn from the normal distribution.
          */
-        double getRandomNum() override;
+        double getValue(const std::uint64_t index) const override;
     };
 }
 
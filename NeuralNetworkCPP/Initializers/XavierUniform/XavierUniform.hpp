@@ -22,26 +22,28 @@ namespace nn
     class XavierUniform : public Initializer
     {
     private:
-        std::uniform_real_distribution<double> m_dist; ///< Uniform distribution for weight initialization
+        double m_limit; ///< Bound of the uniform distribution [-limit, limit]
 
     public:
         /**
          * @brief Constructor for XavierUniform initializer.
          *
-         * Initializes the uniform distribution within the range [-limit, limit],
+         * Computes the range [-limit, limit],
          * where limit = sqrt(6 / (fan-in + fan-out)).
          *
          * @param inputs Number of input neurons (fan-in).
          * @param outputs Number of output neurons (fan-out).
+         * @param seed Seed of the generator (default: the next seed, see `setInitializerSeed`).
          */
-        XavierUniform(const int inputs, const int outputs);
+        XavierUniform(const int inputs, const int outputs, const std::uint64_t seed = nextInitializerSeed());
 
         /**
-         * @brief Generates a random number following Xavier uniform distribution.
+         * @brief Generates the value of an element following Xavier uniform distribution.
          *
+         * @param index Index of the element.
          * @return A randomly initialized value drawn from the uniform distribution.
          */
-        double getRandomNum() override;
+        double getValue(const std::uint64_t index) const override;
     };
 }
 
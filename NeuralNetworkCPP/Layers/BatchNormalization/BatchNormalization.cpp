@@ -5,24 +5,35 @@
  */
 
 #include "BatchNormalization.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 namespace nn
 {
+    // Number of samples per block of the Welford statistics, a block stays in cache for its two passes
+    constexpr int BATCH_NORM_BLOCK_SIZE = 256;
+
+    // Number of adjacent features handled together in the sample-major layout, a row segment fills a few cache lines
+    constexpr int BATCH_NORM_FEATURE_BLOCK_SIZE = 64;
+
     BatchNormalization::BatchNormalization(const int numFeatures, const double momentum, const double epsilon)
-        : m_momentum(momentum), m_epsilon(epsilon), m_isTraining(true)
+        : m_momentum(momentum), m_epsilon(epsilon), m_isTraining(true), m_isRecomputing(false), m_layout(FEATURE_MAJOR)
     {
         m_gamma = Matrix(numFeatures, 1, 1.0);
         m_beta = Matrix(numFeatures, 1, 0.0);
         m_runningMean = Matrix(numFeatures, 1, 0.0);
         m_runningVar = Matrix(numFeatures, 1, 0.0);
+        m_gradGamma = Matrix(numFeatures, 1, 0.0);
+        m_gradBeta = Matrix(numFeatures, 1, 0.0);
     }
 
-    BatchNormalization::BatchNormalization(std::ifstream &file)
-        : m_isTraining(true)
+    BatchNormalization::BatchNormalization(std::istream &file)
+        : m_isTraining(true), m_isRecomputing(false), m_layout(FEATURE_MAJOR)
     {
-        // Check if the file is open and readable
-        if (!file.is_open())
+        // Check if the stream is readable
+        if (!file.good())
             throw std::runtime_error("File is not open for reading");
 
         // Read momentum
@@ -39,6 +50,10 @@ namespace nn
         m_gamma = Matrix(file);
         m_beta = Matrix(file);
 
+        // Start with empty gradient accumulators
+        m_gradGamma = Matrix(m_gamma.getRows(), 1, 0.0);
+        m_gradBeta = Matrix(m_beta.getRows(), 1, 0.0);
+
         // Check if reading was successful
         if (!file.good())
             throw std::runtime_error("Failed to read layer from the file.");
@@ -46,77 +61,369 @@ namespace nn
 
     Matrix BatchNormalization::forward(const Matrix &input)
     {
-        // Store the input
-        m_input = input;
+        if (m_layout == SAMPLE_MAJOR)
+            return forwardSampleMajor(input);
+
+        // Validate the number of features
+        if (input.getRows() != m_gamma.getRows())
+            throw std::invalid_argument("Number of input rows must match the number of features of the layer.");
 
-        if (m_isTraining)
+        int numFeatures = input.getRows();
+        int batchSize = input.getCols();
+        Matrix output(numFeatures, batchSize);
+
+        if (!m_isTraining)
         {
-            // Training mode: use batch statistics
-            // Calculate mean and standard deviation
-            m_mean = m_input.rowWise().sum() / input.getCols();
-            Matrix diff = m_input.colWise() - m_mean;
-            m_stddev = diff.cwiseProduct(diff).rowWise().sum() / m_input.getCols();
-
-            // Update running mean and variance
-            m_runningMean = m_momentum * m_runningMean + (1.0 - m_momentum) * m_mean;
-            m_runningVar = m_momentum * m_runningVar + (1.0 - m_momentum) * m_stddev;
-
-            // Normalize the input
-            m_normalized = diff.colWise() / (m_stddev + m_epsilon).map([](double x) { return std::sqrt(x); });
+            // Inference mode: normalise with the running statistics
+            getGlobalThreadPool().parallelFor(0, numFeatures, [&](int feature) {
+                double mean = m_runningMean(feature, 0);
+                double scale = m_gamma(feature, 0) / std::sqrt(m_runningVar(feature, 0) + m_epsilon);
+                double shift = m_beta(feature, 0);
+                const double *x = input.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+                double *y = output.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+
+                for (int i = 0; i < batchSize; i++)
+                    y[i] = (x[i] - mean) * scale + shift;
+            });
+
+            return output;
         }
-        else
+
+        // Training mode: use batch statistics, each feature is a contiguous row
+        m_normalized = Matrix(numFeatures, batchSize);
+        m_invStddev = Matrix(numFeatures, 1);
+
+        getGlobalThreadPool().parallelFor(0, numFeatures, [&](int feature) {
+            const double *x = input.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+            double *normalized = m_normalized.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+            double *y = output.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+
+            // Welford's algorithm over blocks: the exact statistics of each cached block are merged into the running ones
+            double mean = 0.0;
+            double m2 = 0.0;
+            for (int start = 0; start < batchSize; start += BATCH_NORM_BLOCK_SIZE)
+            {
+                int count = std::min(batchSize - start, BATCH_NORM_BLOCK_SIZE);
+
+                double blockSum = 0.0;
+                for (int i = start; i < start + count; i++)
+                    blockSum += x[i];
+                double blockMean = blockSum / count;
+
+                double blockM2 = 0.0;
+                for (int i = start; i < start + count; i++)
+                    blockM2 += (x[i] - blockMean) * (x[i] - blockMean);
+
+                double delta = blockMean - mean;
+                double merged = start + count;
+                mean += delta * count / merged;
+                m2 += blockM2 + delta * delta * start * count / merged;
+            }
+            double variance = m2 / batchSize;
+
+            // Update running mean and variance, unless the batch is only recomputed
+            if (!m_isRecomputing)
+            {
+                m_runningMean(feature, 0) = m_momentum * m_runningMean(feature, 0) + (1.0 - m_momentum) * mean;
+                m_runningVar(feature, 0) = m_momentum * m_runningVar(feature, 0) + (1.0 - m_momentum) * variance;
+            }
+
+            // Normalize, scale and shift in one pass
+            double invStddev = 1.0 / std::sqrt(variance + m_epsilon);
+            double gamma = m_gamma(feature, 0);
+            double beta = m_beta(feature, 0);
+            m_invStddev(feature, 0) = invStddev;
+
+            for (int i = 0; i < batchSize; i++)
+            {
+                normalized[i] = (x[i] - mean) * invStddev;
+                y[i] = normalized[i] * gamma + beta;
+            }
+        });
+
+        return output;
+    }
+
+    Matrix BatchNormalization::accumulateGradients(const Matrix &gradient)
+    {
+        if (m_layout == SAMPLE_MAJOR)
+            return accumulateGradientsSampleMajor(gradient);
+
+        // Validate that the gradient matches the last training batch
+        if (gradient.getRows() != m_normalized.getRows() || gradient.getCols() != m_normalized.getCols())
+            throw std::invalid_argument("Gradient dimensions must match the last training batch.");
+
+        int numFeatures = gradient.getRows();
+        int batchSize = gradient.getCols();
+        Matrix gradInput(numFeatures, batchSize);
+
+        getGlobalThreadPool().parallelFor(0, numFeatures, [&](int feature) {
+            const double *g = gradient.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+            const double *normalized = m_normalized.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+            double *gradX = gradInput.getDataPtr() + static_cast<std::size_t>(feature) * batchSize;
+
+            // Sum of dL/dy and of dL/dy * x_hat in one sweep
+            double sumGrad = 0.0;
+            double sumGradNormalized = 0.0;
+            for (int i = 0; i < batchSize; i++)
+            {
+                sumGrad += g[i];
+                sumGradNormalized += g[i] * normalized[i];
+            }
+
+            // dL/dx = gamma / (m * sigma) * (m * dL/dy - sum(dL/dy) - x_hat * sum(dL/dy * x_hat))
+            double scale = m_gamma(feature, 0) * m_invStddev(feature, 0) / batchSize;
+            for (int i = 0; i < batchSize; i++)
+                gradX[i] = scale * (batchSize * g[i] - sumGrad - normalized[i] * sumGradNormalized);
+
+            // Accumulate gradients for gamma and beta
+            m_gradGamma(feature, 0) += sumGradNormalized;
+            m_gradBeta(feature, 0) += sumGrad;
+        });
+
+        return gradInput;
+    }
+
+    int BatchNormalization::getSampleOutputSize(const int inputSize) const
+    {
+        if (inputSize != m_gamma.getRows())
+            throw std::invalid_argument("Number of input features must match the number of features of the layer.");
+
+        return inputSize;
+    }
+
+    void BatchNormalization::predictSample(const double *input, double *output) const
+    {
+        const double *mean = m_runningMean.getDataPtr();
+        const double *var = m_runningVar.getDataPtr();
+        const double *gamma = m_gamma.getDataPtr();
+        const double *beta = m_beta.getDataPtr();
+
+        // Normalise with the running statistics, then scale and shift
+        for (int feature = 0; feature < m_gamma.getRows(); feature++)
+            output[feature] = (input[feature] - mean[feature]) * (gamma[feature] / std::sqrt(var[feature] + m_epsilon)) + beta[feature];
+    }
+
+    Matrix BatchNormalization::forwardSampleMajor(const Matrix &input)
+    {
+        // Validate the number of features
+        if (input.getCols() != m_gamma.getRows())
+            throw std::invalid_argument("Number of input columns must match the number of features of the layer.");
+
+        int batchSize = input.getRows();
+        int numFeatures = input.getCols();
+        Matrix output(batchSize, numFeatures);
+
+        if (!m_isTraining)
         {
-            // Inference mode: use running statistics
-            Matrix diff = m_input.colWise() - m_runningMean;
-            m_normalized = diff.colWise() / (m_runningVar + m_epsilon).map([](double x) { return std::sqrt(x); });
+            // Inference mode: fold the running statistics into a scale and a shift per feature
+            std::vector<double> means(numFeatures);
+            std::vector<double> scales(numFeatures);
+            for (int feature = 0; feature < numFeatures; feature++)
+            {
+                means[feature] = m_runningMean(feature, 0);
+                scales[feature] = m_gamma(feature, 0) / std::sqrt(m_runningVar(feature, 0) + m_epsilon);
+            }
+
+            // Normalise each sample along its contiguous row
+            getGlobalThreadPool().parallelFor(0, batchSize, [&](int sample) {
+                const double *x = input.getDataPtr() + static_cast<std::size_t>(sample) * numFeatures;
+                double *y = output.getDataPtr() + static_cast<std::size_t>(sample) * numFeatures;
+
+                for (int j = 0; j < numFeatures; j++)
+                    y[j] = (x[j] - means[j]) * scales[j] + m_beta(j, 0);
+            });
+
+            return output;
         }
 
-        // Scale and shift
-        return (m_normalized.colWise() * m_gamma).colWise() + m_beta;
+        // Training mode: each task gathers the statistics of a block of features over the rows
+        m_normalized = Matrix(batchSize, numFeatures);
+        m_invStddev = Matrix(numFeatures, 1);
+        int numBlocks = (numFeatures + BATCH_NORM_FEATURE_BLOCK_SIZE - 1) / BATCH_NORM_FEATURE_BLOCK_SIZE;
+
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int first = block * BATCH_NORM_FEATURE_BLOCK_SIZE;
+            int width = std::min(numFeatures - first, BATCH_NORM_FEATURE_BLOCK_SIZE);
+            const double *x = input.getDataPtr() + first;
+            double *normalized = m_normalized.getDataPtr() + first;
+            double *y = output.getDataPtr() + first;
+
+            // Welford's algorithm over blocks of samples, with the same arithmetic as the feature-major kernel
+            double mean[BATCH_NORM_FEATURE_BLOCK_SIZE] = {};
+            double m2[BATCH_NORM_FEATURE_BLOCK_SIZE] = {};
+            double blockMean[BATCH_NORM_FEATURE_BLOCK_SIZE];
+            double blockM2[BATCH_NORM_FEATURE_BLOCK_SIZE];
+            for (int start = 0; start < batchSize; start += BATCH_NORM_BLOCK_SIZE)
+            {
+                int count = std::min(batchSize - start, BATCH_NORM_BLOCK_SIZE);
+
+                std::fill(blockMean, blockMean + width, 0.0);
+                for (int i = start; i < start + count; i++)
+                    for (int j = 0; j < width; j++)
+                        blockMean[j] += x[static_cast<std::size_t>(i) * numFeatures + j];
+                for (int j = 0; j < width; j++)
+                    blockMean[j] /= count;
+
+                std::fill(blockM2, blockM2 + width, 0.0);
+                for (int i = start; i < start + count; i++)
+                    for (int j = 0; j < width; j++)
+                    {
+                        double deviation = x[static_cast<std::size_t>(i) * numFeatures + j] - blockMean[j];
+                        blockM2[j] += deviation * deviation;
+                    }
+
+                double merged = start + count;
+                for (int j = 0; j < width; j++)
+                {
+                    double delta = blockMean[j] - mean[j];
+                    mean[j] += delta * count / merged;
+                    m2[j] += blockM2[j] + delta * delta * start * count / merged;
+                }
+            }
+
+            // Update running mean and variance, keep the inverse standard deviation for the backward pass
+            double invStddev[BATCH_NORM_FEATURE_BLOCK_SIZE];
+            for (int j = 0; j < width; j++)
+            {
+                int feature = first + j;
+                double variance = m2[j] / batchSize;
+                if (!m_isRecomputing)
+                {
+                    m_runningMean(feature, 0) = m_momentum * m_runningMean(feature, 0) + (1.0 - m_momentum) * mean[j];
+                    m_runningVar(feature, 0) = m_momentum * m_runningVar(feature, 0) + (1.0 - m_momentum) * variance;
+                }
+                invStddev[j] = 1.0 / std::sqrt(variance + m_epsilon);
+                m_invStddev(feature, 0) = invStddev[j];
+            }
+
+            // Normalize, scale and shift in one pass
+            for (int i = 0; i < batchSize; i++)
+            {
+                std::size_t offset = static_cast<std::size_t>(i) * numFeatures;
+                for (int j = 0; j < width; j++)
+                {
+                    normalized[offset + j] = (x[offset + j] - mean[j]) * invStddev[j];
+                    y[offset + j] = normalized[offset + j] * m_gamma(first + j, 0) + m_beta(first + j, 0);
+                }
+            }
+        });
+
+        return output;
     }
 
-    Matrix BatchNormalization::backward(const Matrix &gradient, Optimizer &optimizer)
+    Matrix BatchNormalization::accumulateGradientsSampleMajor(const Matrix &gradient)
     {
-        int m = m_input.getCols();
-        Matrix t = (m_stddev + m_epsilon).map([](double x) { return 1.0 / std::sqrt(x); }); // 1 / sigma
-        Matrix diff = m_input.colWise() - m_mean;                                           // (x_i - mu)
-        Matrix gradDiff = diff.cwiseProduct(gradient);                                      // (dL/dy_i) * (x_i - mu)
+        // Validate that the gradient matches the last training batch
+        if (gradient.getRows() != m_normalized.getRows() || gradient.getCols() != m_normalized.getCols())
+            throw std::invalid_argument("Gradient dimensions must match the last training batch.");
 
-        // Sum of gradients
-        Matrix sumGrad = gradient.rowWise().sum(); // sum(dL/dy_j)
+        int batchSize = gradient.getRows();
+        int numFeatures = gradient.getCols();
+        Matrix gradInput(batchSize, numFeatures);
+        int numBlocks = (numFeatures + BATCH_NORM_FEATURE_BLOCK_SIZE - 1) / BATCH_NORM_FEATURE_BLOCK_SIZE;
 
-        // Compute input gradient
-        Matrix gradInput = (((m * gradient).colWise() - sumGrad) - ((diff.colWise() * t.cwiseProduct(t)).colWise() * gradDiff.rowWise().sum())).colWise() * (m_gamma.cwiseProduct(t) / m);
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int first = block * BATCH_NORM_FEATURE_BLOCK_SIZE;
+            int width = std::min(numFeatures - first, BATCH_NORM_FEATURE_BLOCK_SIZE);
+            const double *g = gradient.getDataPtr() + first;
+            const double *normalized = m_normalized.getDataPtr() + first;
+            double *gradX = gradInput.getDataPtr() + first;
 
-        // Compute gradients for gamma and beta
-        Matrix gradGamma = gradient.cwiseProduct(m_normalized).rowWise().sum();
-        Matrix gradBeta = sumGrad;
+            // Sum of dL/dy and of dL/dy * x_hat over the rows in one sweep
+            double sumGrad[BATCH_NORM_FEATURE_BLOCK_SIZE] = {};
+            double sumGradNormalized[BATCH_NORM_FEATURE_BLOCK_SIZE] = {};
+            for (int i = 0; i < batchSize; i++)
+            {
+                std::size_t offset = static_cast<std::size_t>(i) * numFeatures;
+                for (int j = 0; j < width; j++)
+                {
+                    sumGrad[j] += g[offset + j];
+                    sumGradNormalized[j] += g[offset + j] * normalized[offset + j];
+                }
+            }
 
-        // Update gamma and beta
-        optimizer.update(m_gamma, m_beta, gradGamma, gradBeta);
+            // dL/dx = gamma / (m * sigma) * (m * dL/dy - sum(dL/dy) - x_hat * sum(dL/dy * x_hat))
+            double scale[BATCH_NORM_FEATURE_BLOCK_SIZE];
+            for (int j = 0; j < width; j++)
+                scale[j] = m_gamma(first + j, 0) * m_invStddev(first + j, 0) / batchSize;
+
+            for (int i = 0; i < batchSize; i++)
+            {
+                std::size_t offset = static_cast<std::size_t>(i) * numFeatures;
+                for (int j = 0; j < width; j++)
+                    gradX[offset + j] = scale[j] * (batchSize * g[offset + j] - sumGrad[j] - normalized[offset + j] * sumGradNormalized[j]);
+            }
+
+            // Accumulate gradients for gamma and beta
+            for (int j = 0; j < width; j++)
+            {
+                m_gradGamma(first + j, 0) += sumGradNormalized[j];
+                m_gradBeta(first + j, 0) += sumGrad[j];
+            }
+        });
 
         return gradInput;
     }
 
-    void BatchNormalization::save(std::ofstream &file) const
+    void BatchNormalization::setLayout(const e_layout layout)
     {
-        // Check if the file is open and writable
-        if (!file.is_open())
+        // Drop the batch stored in the previous layout
+        m_layout = layout;
+        m_normalized = Matrix();
+        m_invStddev = Matrix();
+    }
+
+    void BatchNormalization::applyGradients(Optimizer &optimizer)
+    {
+        // Update gamma and beta
+        optimizer.update(m_gamma, m_beta, m_gradGamma, m_gradBeta, m_slots);
+
+        // Reset the accumulators for the next batch
+        m_gradGamma = Matrix(m_gamma.getRows(), 1, 0.0);
+        m_gradBeta = Matrix(m_beta.getRows(), 1, 0.0);
+    }
+
+    void BatchNormalization::registerParameters(ParameterRegistry &registry)
+    {
+        // Register gamma and beta, their gradients are accumulated during backward propagation
+        registry.add(m_gamma, &m_gradGamma);
+        registry.add(m_beta, &m_gradBeta);
+    }
+
+    void BatchNormalization::save(std::ostream &file) const
+    {
+        writeState(file, m_momentum, m_epsilon, m_runningMean, m_runningVar, m_gamma, m_beta);
+    }
+
+    std::function<void(std::ostream &)> BatchNormalization::snapshot() const
+    {
+        return [momentum = m_momentum, epsilon = m_epsilon, runningMean = m_runningMean, runningVar = m_runningVar,
+                gamma = m_gamma, beta = m_beta](std::ostream &file) {
+            writeState(file, momentum, epsilon, runningMean, runningVar, gamma, beta);
+        };
+    }
+
+    void BatchNormalization::writeState(std::ostream &file, const double momentum, const double epsilon, const Matrix &runningMean,
+                                        const Matrix &runningVar, const Matrix &gamma, const Matrix &beta)
+    {
+        // Check if the stream is writable
+        if (!file.good())
             throw std::runtime_error("File is not open for writing.");
 
         // Save momentum
-        file.write(reinterpret_cast<const char *>(&m_momentum), sizeof(m_momentum));
+        file.write(reinterpret_cast<const char *>(&momentum), sizeof(momentum));
 
         // Save epsilon
-        file.write(reinterpret_cast<const char *>(&m_epsilon), sizeof(m_epsilon));
+        file.write(reinterpret_cast<const char *>(&epsilon), sizeof(epsilon));
 
         // Save running mean and running variance
-        m_runningMean.save(file);
-        m_runningVar.save(file);
+        runningMean.save(file);
+        runningVar.save(file);
 
         // Save gamma and beta
-        m_gamma.save(file);
-        m_beta.save(file);
+        gamma.save(file);
+        beta.save(file);
 
         // Check if writing was successful
         if (!file.good())
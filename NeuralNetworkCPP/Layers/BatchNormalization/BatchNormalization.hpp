@@ -21,17 +21,20 @@ namespace nn
     class BatchNormalization : public Layer
     {
     private:
-        Matrix m_input;       ///< Layer input
-        Matrix m_gamma;       ///< Scale parameter (learnable).
-        Matrix m_beta;        ///< Shift parameter (learnable).
-        Matrix m_normalized;  ///< Normalized input.
-        Matrix m_mean;        ///< Mean of the input
-        Matrix m_stddev;      ///< Standard deviation of the input
-        Matrix m_runningMean; ///< Running mean (used during inference).
-        Matrix m_runningVar;  ///< Running variance (used during inference).
-        double m_epsilon;     ///< Small constant for numerical stability.
-        double m_momentum;    ///< Momentum for updating running mean and variance.
-        bool m_isTraining;    ///< Flag to indicate whether the layer is in training mode.
+        Matrix m_gamma;         ///< Scale parameter (learnable).
+        Matrix m_beta;          ///< Shift parameter (learnable).
+        Matrix m_gradGamma;     ///< Accumulated gradient of gamma.
+        Matrix m_gradBeta;      ///< Accumulated gradient of beta.
+        ParameterSlots m_slots; ///< Slots of gamma and beta in the optimizer.
+        Matrix m_normalized;    ///< Normalized input of the last training batch (stored for backward pass).
+        Matrix m_invStddev;     ///< Inverse standard deviation of the last training batch (stored for backward pass).
+        Matrix m_runningMean;   ///< Running mean (used during inference).
+        Matrix m_runningVar;    ///< Running variance (used during inference).
+        double m_epsilon;       ///< Small constant for numerical stability.
+        double m_momentum;      ///< Momentum for updating running mean and variance.
+        bool m_isTraining;      ///< Flag to indicate whether the layer is in training mode.
+        bool m_isRecomputing;   ///< True while forward passes only restore the state of an earlier batch.
+        e_layout m_layout;      ///< Layout of the samples in the inputs, outputs and gradients.
 
     public:
         /**
@@ -46,35 +49,88 @@ namespace nn
         /**
          * @brief Constructs a BatchNormalization layer from a file.
          *
-         * @param file Input file stream (must be opened in binary mode).
-         * @throws std::runtime_error If the file is not open or reading fails.
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
          */
-        BatchNormalization(std::ifstream &file);
+        BatchNormalization(std::istream &file);
 
         /**
          * @brief Performs forward propagation.
          *
+         * In training mode the mean and variance of each feature are computed in one pass with
+         * Welford's algorithm, then the input is normalised, scaled and shifted in a second pass.
+         *
          * @param input The input matrix.
          * @return The output matrix after applying BatchNormalization.
          */
         Matrix forward(const Matrix &input) override;
 
         /**
-         * @brief Performs backward propagation.
+         * @brief Performs backward propagation and accumulates the gamma and beta gradients.
+         *
+         * Reuses the normalized input and the inverse standard deviation of the last training
+         * batch, the sums over the batch are computed in one sweep per feature.
          *
          * @param gradient The gradient of the loss with respect to the output.
-         * @param optimizer The optimizer to use for weights and biases updates.
          * @return The gradient of the loss with respect to the input.
          */
-        Matrix backward(const Matrix &gradient, Optimizer &optimizer) override;
+        Matrix accumulateGradients(const Matrix &gradient) override;
+
+        /**
+         * @brief Returns the output size of a single sample, which is the number of features.
+         *
+         * @param inputSize Number of input features of the sample.
+         * @return The number of features.
+         * @throws std::invalid_argument If the number of features does not match the layer.
+         */
+        int getSampleOutputSize(const int inputSize) const override;
+
+        /**
+         * @brief Normalises a single sample with the running statistics, independent of the training mode.
+         *
+         * @param input Features of the sample.
+         * @param output Buffer for the normalised features.
+         */
+        void predictSample(const double *input, double *output) const override;
+
+        /**
+         * @brief Sets the layout of the samples.
+         *
+         * With SAMPLE_MAJOR the statistics are gathered over the rows for blocks of adjacent
+         * features, which gives the same results as the feature-major kernels.
+         *
+         * @param layout FEATURE_MAJOR or SAMPLE_MAJOR.
+         */
+        void setLayout(const e_layout layout) override;
+
+        /**
+         * @brief Updates gamma and beta with the accumulated gradients and resets them.
+         *
+         * @param optimizer The optimizer to use for gamma and beta updates.
+         */
+        void applyGradients(Optimizer &optimizer) override;
+
+        /**
+         * @brief Registers gamma and beta together with their gradients.
+         *
+         * @param registry The registry to add the parameters to.
+         */
+        void registerParameters(ParameterRegistry &registry) override;
 
         /**
          * @brief Saves the layer's state to a binary file.
          *
-         * @param file Output file stream (must be opened in binary mode).
-         * @throws std::runtime_error If the file is not open or reading fails.
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
+         */
+        void save(std::ostream &file) const override;
+
+        /**
+         * @brief Copies the parameters and running statistics, they are written by the returned function as `save` would.
+         *
+         * @return Function writing the copied state.
          */
-        void save(std::ofstream &file) const override;
+        std::function<void(std::ostream &)> snapshot() const override;
 
         /**
          * @brief Returns the type of the layer.
@@ -89,6 +145,38 @@ namespace nn
          * @param isTraining True for training, false for inference.
          */
         void setTrainingMode(const bool isTrainging) { m_isTraining = isTrainging; };
+
+        /** @brief Returns true if the layer normalizes with the statistics of the batch. */
+        bool isTrainingMode() const { return m_isTraining; }
+
+        /**
+         * @brief Leaves the running statistics unchanged while a batch is recomputed.
+         *
+         * @param isRecomputing True while forward passes repeat an earlier batch.
+         */
+        void setRecomputing(const bool isRecomputing) override { m_isRecomputing = isRecomputing; }
+
+    private:
+        /** @brief Forward propagation of a sample-major batch (batch size x features). */
+        Matrix forwardSampleMajor(const Matrix &input);
+
+        /** @brief Backward propagation of a sample-major gradient (batch size x features). */
+        Matrix accumulateGradientsSampleMajor(const Matrix &gradient);
+
+        /**
+         * @brief Writes the state of a layer in the format read by the stream constructor.
+         *
+         * @param file Output binary stream.
+         * @param momentum Momentum of the running statistics.
+         * @param epsilon Constant for numerical stability.
+         * @param runningMean Running mean.
+         * @param runningVar Running variance.
+         * @param gamma Scale parameter.
+         * @param beta Shift parameter.
+         * @throws std::runtime_error If the stream is not usable or writing fails.
+         */
+        static void writeState(std::ostream &file, const double momentum, const double epsilon, const Matrix &runningMean,
+                               const Matrix &runningVar, const Matrix &gamma, const Matrix &beta);
     };
 }
 
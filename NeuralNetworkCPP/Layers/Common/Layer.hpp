@@ -8,26 +8,26 @@
 #define LAYER_HPP
 
 #include "../../Matrix/Matrix.hpp"
+#include "../../Matrix/HalfMatrix/HalfMatrix.hpp"
+#include "../../Activations/Common/Activation.hpp"
 #include "../../Optimizers/Common/Optimizer.hpp"
+#include "../../FastMath/FastMath.hpp"
 #include <fstream>
+#include <functional>
+#include <sstream>
 
 namespace nn
 {
     /**
      * @brief Enum with available layer types.
      */
-    enum e_layerType { DENSE, BATCH_NORM };
+    enum e_layerType { DENSE, BATCH_NORM, QUANTIZED_DENSE, SPARSE_DENSE, EMBEDDING };
 
     /**
      * @brief Enum with avaible initializers
      */
     enum e_initializer { HE_NORMAL, HE_UNIFORM, XAVIER_NORMAL, XAVIER_UNIFORM };
 
-    /**
-     * @brief Enum with avaible activation functions
-     */
-    enum e_activation { RELU, SIGMOID, SOFTMAX, NONE };
-
     /**
      * @class Layer
      * @brief Abstract base class for neural network layers.
@@ -47,20 +47,130 @@ namespace nn
         virtual Matrix forward(const Matrix &input) = 0;
 
         /**
-         * @brief Performs backward propagation.
+         * @brief Performs backward propagation and immediately updates the parameters.
          *
          * @param gradient The gradient of the loss with respect to the output.
          * @param optimizer The optimizer to use for weights and biases updates.
          * @return The gradient of the loss with respect to the input.
          */
-        virtual Matrix backward(const Matrix &gradient, Optimizer &optimizer) = 0;
+        virtual Matrix backward(const Matrix &gradient, Optimizer &optimizer)
+        {
+            Matrix gradInput = accumulateGradients(gradient);
+            applyGradients(optimizer);
+            return gradInput;
+        }
+
+        /**
+         * @brief Performs backward propagation without updating the parameters.
+         *
+         * The gradients of the layer's parameters are added to the gradients accumulated
+         * so far, so several micro-batches can contribute to a single update.
+         *
+         * @param gradient The gradient of the loss with respect to the output.
+         * @return The gradient of the loss with respect to the input.
+         */
+        virtual Matrix accumulateGradients(const Matrix &gradient) = 0;
+
+        /**
+         * @brief Updates the parameters with the accumulated gradients and resets them.
+         *
+         * @param optimizer The optimizer to use for weights and biases updates.
+         */
+        virtual void applyGradients(Optimizer &optimizer) = 0;
+
+        /**
+         * @brief Registers the trainable parameters of the layer and their gradients.
+         *
+         * @param registry The registry to add the parameters to.
+         */
+        virtual void registerParameters(ParameterRegistry &registry) = 0;
+
+        /**
+         * @brief Sets the precision of the weight copy and the activations used in forward and backward passes.
+         *
+         * Layers without a reduced-precision path keep computing in double precision.
+         *
+         * @param precision The storage precision.
+         */
+        virtual void setPrecision([[maybe_unused]] const e_precision precision) {}
+
+        /**
+         * @brief Selects the implementation of the transcendental functions of the activation.
+         *
+         * Layers without such an activation ignore the policy.
+         *
+         * @param policy STANDARD_MATH or FAST_MATH.
+         */
+        virtual void setMathPolicy([[maybe_unused]] const e_mathPolicy policy) {}
+
+        /**
+         * @brief Sets the layout of the samples in the inputs, outputs and gradients of the layer.
+         *
+         * @param layout FEATURE_MAJOR or SAMPLE_MAJOR.
+         * @throws std::invalid_argument If the layer only supports FEATURE_MAJOR.
+         */
+        virtual void setLayout(const e_layout layout)
+        {
+            if (layout != FEATURE_MAJOR)
+                throw std::invalid_argument("The layer only supports the feature-major layout.");
+        }
+
+        /**
+         * @brief Marks forward passes which only restore the state of an earlier batch for its backward pass.
+         *
+         * A pipeline keeps the inputs of its micro-batches and repeats their forward passes before
+         * the backward passes. Layers with effects beyond the state stored for the backward pass
+         * (e.g. running statistics) skip them while recomputing.
+         *
+         * @param isRecomputing True while forward passes repeat an earlier batch.
+         */
+        virtual void setRecomputing([[maybe_unused]] const bool isRecomputing) {}
+
+        /**
+         * @brief Returns the number of outputs of a single sample, or 0 if the layer has no single-sample path.
+         *
+         * @param inputSize Number of input features of the sample.
+         * @return The number of outputs written by `predictSample`, 0 to use `forward` instead.
+         * @throws std::invalid_argument If the input size does not match the layer.
+         */
+        virtual int getSampleOutputSize([[maybe_unused]] const int inputSize) const { return 0; }
+
+        /**
+         * @brief Performs inference on a single sample without building matrices.
+         *
+         * Batch-dependent layers use their inference statistics and nothing is stored for the
+         * backward pass, so it may be called concurrently. Only called if `getSampleOutputSize`
+         * returned a size.
+         *
+         * @param input Features of the sample.
+         * @param output Buffer for `getSampleOutputSize` outputs, must not overlap the input.
+         */
+        virtual void predictSample([[maybe_unused]] const double *input, [[maybe_unused]] double *output) const
+        {
+            throw std::logic_error("The layer has no single-sample path.");
+        }
 
         /**
          * @brief Saves the layer's state to a binary file.
          *
-         * @param file Output file stream (must be opened in binary mode).
+         * @param file Output binary stream (a file or an in-memory buffer).
+         */
+        virtual void save(std::ostream &file) const = 0;
+
+        /**
+         * @brief Copies everything `save` writes, so the layer can be saved later on another thread.
+         *
+         * The default serializes the layer right away. Layers whose parameters change during
+         * training copy their buffers instead and leave the serialization to the returned function.
+         *
+         * @return Function writing the copied state in the format of `save`.
          */
-        virtual void save(std::ofstream &file) const = 0;
+        virtual std::function<void(std::ostream &)> snapshot() const
+        {
+            std::ostringstream stream(std::ios::binary);
+            save(stream);
+            return [data = std::move(stream).str()](std::ostream &file) { file.write(data.data(), data.size()); };
+        }
 
         /**
          * @brief Returns the type of the layer.
@@ -7,9 +7,41 @@
 #include "DenseLayer.hpp"
 #include "../../Initializers/Initializers.hpp"
 #include "../../Activations/Activations.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include "../../Matrix/Gemv/Gemv.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
 
 namespace nn
 {
+    // Adds the bias column to each sample (row) of a sample-major batch
+    static void addBiasesToRows(Matrix &output, const Matrix &biases)
+    {
+        int cols = output.getCols();
+        const double *b = biases.getDataPtr();
+
+        getGlobalThreadPool().parallelFor(0, output.getRows(), [&output, b, cols](int sample) {
+            double *y = output.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+            for (int j = 0; j < cols; j++)
+                y[j] += b[j];
+        });
+    }
+
+    // Accumulates the sum over the samples (rows) of a sample-major batch into a column
+    static void addColumnSums(Matrix &target, const Matrix &batch)
+    {
+        int cols = batch.getCols();
+        double *sums = target.getDataPtr();
+
+        for (int sample = 0; sample < batch.getRows(); sample++)
+        {
+            const double *g = batch.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+            for (int j = 0; j < cols; j++)
+                sums[j] += g[j];
+        }
+    }
+
     DenseLayer::DenseLayer(const int inputSize, const int outputSize, e_initializer initializerID, e_activation activationID)
     {
         // Validate input and output sizes
@@ -20,25 +52,30 @@ namespace nn
         initWeights(inputSize, outputSize, initializerID);
 
         // Initialize activation function
-        initActivationFunction(activationID);
+        m_activationID = activationID;
+        m_activation = createActivation(activationID);
     }
 
-    DenseLayer::DenseLayer(std::ifstream &file)
+    DenseLayer::DenseLayer(std::istream &file)
     {
-        // Check if the file is open and readable
-        if (!file.is_open())
+        // Check if the stream is readable
+        if (!file.good())
             throw std::runtime_error("File is not open for reading");
 
         // Read the activation function ID
         file.read(reinterpret_cast<char *>(&m_activationID), sizeof(m_activationID));
 
         // Initialize the activation function based on the ID
-        initActivationFunction(m_activationID);
+        m_activation = createActivation(m_activationID);
 
         // Read weights and biases from the file
         m_weights = Matrix(file);
         m_biases = Matrix(file);
 
+        // Start with empty gradient accumulators
+        m_gradWeights = Matrix(m_weights.getRows(), m_weights.getCols(), 0.0);
+        m_gradBiases = Matrix(m_biases.getRows(), m_biases.getCols(), 0.0);
+
         // Check if reading was successful
         if (!file.good())
             throw std::runtime_error("Failed to read layer from the file.");
@@ -46,51 +83,276 @@ namespace nn
 
     Matrix DenseLayer::forward(const Matrix &input)
     {
+        m_isSparseInput = false;
+        if (m_precision != FLOAT64)
+            return forwardHalf(input);
+
         // Store the input for use in the backward pass
         m_input = input;
 
+        // Compute the linear transformation, sample-major rows are multiplied by the weight rows
+        if (m_layout == SAMPLE_MAJOR)
+            return activate(multiplyTransposed(m_input, m_weights));
+
         // Compute the linear transformation: output = input * weights + biases
-        m_output = (m_weights * m_input).colWise() + m_biases;
+        return activate(m_weights * m_input);
+    }
 
-        // Apply the activation function if it exists
-        Matrix output = m_output;
-        if (m_activation)
+    Matrix DenseLayer::forward(const SparseMatrix &input)
+    {
+        // Validate the number of features
+        if (input.getCols() != m_weights.getCols())
+            throw std::invalid_argument("Number of sparse input features must match the input size of the layer.");
+        if (m_layout != FEATURE_MAJOR)
+            throw std::invalid_argument("Sparse input requires the feature-major layout.");
+
+        // Store the input for use in the backward pass
+        m_sparseInput = input;
+        m_isSparseInput = true;
+
+        // Compute the linear transformation, the samples are the rows of the sparse input
+        return activate(multiplyTransposed(m_weights, m_sparseInput));
+    }
+
+    Matrix DenseLayer::forward(const MatrixView &input)
+    {
+        if (m_precision != FLOAT64)
+            return forwardHalf(input.toMatrix());
+
+        // Compute the linear transformation directly on the viewed memory
+        if (m_layout == SAMPLE_MAJOR)
+            return activate(multiplyTransposed(input, m_weights));
+
+        return activate(multiply(m_weights, input));
+    }
+
+    int DenseLayer::getSampleOutputSize(const int inputSize) const
+    {
+        if (inputSize != m_weights.getCols())
+            throw std::invalid_argument("Number of input features must match the input size of the layer.");
+
+        return (m_precision == FLOAT64) ? m_weights.getRows() : 0;
+    }
+
+    void DenseLayer::predictSample(const double *input, double *output) const
+    {
+        // Compute the linear transformation with the biases added by the kernel
+        multiplyVector(m_weights.getDataPtr(), m_weights.getRows(), m_weights.getCols(), input, m_biases.getDataPtr(), output);
+
+        // Apply the activation function while the outputs are still in cache
+        if (m_activation && !m_isOutputLogits)
+            m_activation->applyToSample(output, m_weights.getRows());
+    }
+
+    Matrix DenseLayer::activate(Matrix linearOutput)
+    {
+        // Add the biases and store the result for the backward pass
+        if (m_layout == SAMPLE_MAJOR)
+        {
+            addBiasesToRows(linearOutput, m_biases);
+            m_output = std::move(linearOutput);
+        }
+        else
+        {
+            m_output = linearOutput.colWise() + m_biases;
+        }
+
+        // Apply the activation function if it exists and is not fused into the loss
+        if (m_activation && !m_isOutputLogits)
+            return m_activation->forward(m_output);
+
+        return m_output;
+    }
+
+    Matrix DenseLayer::accumulateGradients(const Matrix &gradient)
+    {
+        // Sparse input is always processed in double precision
+        if (m_precision != FLOAT64 && !m_isSparseInput)
+            return accumulateGradientsHalf(gradient);
+
+        // Compute the gradient with respect to the output, the incoming gradient is used as is without an activation
+        bool hasActivation = m_activation && !m_isOutputLogits;
+        Matrix activationGrad = hasActivation ? gradient.cwiseProduct(m_activation->backward(m_output)) : Matrix();
+        const Matrix &gradOutput = hasActivation ? activationGrad : gradient;
+
+        // Sparse input only contributes to the weight columns of its features, there is no layer to pass a gradient to
+        if (m_isSparseInput)
+        {
+            addProduct(m_gradWeights, gradOutput, m_sparseInput);
+            m_gradBiases += gradOutput.rowWise().sum();
+            return Matrix();
+        }
+
+        // Accumulate gradients, in the sample-major layout without transposing the stored batch
+        if (m_layout == SAMPLE_MAJOR)
+        {
+            m_gradWeights += multiply(MatrixView(gradOutput).transpose(), m_input);
+            addColumnSums(m_gradBiases, gradOutput);
+
+            return multiply(gradOutput, m_weights);
+        }
+
+        m_gradWeights += gradOutput * m_input.transpose();
+        m_gradBiases += gradOutput.rowWise().sum();
+
+        // Compute the gradient with respect to the input
+        return m_weights.transpose() * gradOutput;
+    }
+
+    Matrix DenseLayer::forwardHalf(const Matrix &input)
+    {
+        // Refresh the 16-bit weight copies after the master weights were updated
+        if (m_isHalfWeightsStale)
+        {
+            m_halfWeights = HalfMatrix(m_weights, m_precision);
+            m_halfWeightsT = HalfMatrix(m_weights, m_precision, true);
+            m_isHalfWeightsStale = false;
+        }
+
+        // Store the input transposed, so each sample is a contiguous row for the product
+        m_halfInput = HalfMatrix(input, m_precision, true);
+
+        // Compute the linear transformation with float accumulation
+        Matrix output = multiplyTransposed(m_halfWeights, m_halfInput).colWise() + m_biases;
+        m_halfOutput = HalfMatrix(output, m_precision);
+
+        // Apply the activation function if it exists and is not fused into the loss
+        if (m_activation && !m_isOutputLogits)
             output = m_activation->forward(output);
 
         return output;
     }
 
-    Matrix DenseLayer::backward(const Matrix &gradient, Optimizer &optimizer)
+    Matrix DenseLayer::accumulateGradientsHalf(const Matrix &gradient)
     {
-        // Compute the gradient with respect to the output
-        Matrix gradOutput = m_activation ? m_activation->backward(m_output) : Matrix(m_output.getRows(), m_output.getCols(), 1.0);
-        gradOutput = gradient.cwiseProduct(gradOutput);
+        // Compute the gradient with respect to the output, the incoming gradient is used as is without an activation
+        bool hasActivation = m_activation && !m_isOutputLogits;
+        Matrix activationGrad = hasActivation ? gradient.cwiseProduct(m_activation->backward(m_halfOutput.toMatrix())) : Matrix();
+        const Matrix &gradOutput = hasActivation ? activationGrad : gradient;
+        HalfMatrix halfGradOutput(gradOutput, m_precision);
+
+        // Accumulate gradients, the 16-bit products are accumulated in float
+        m_gradWeights += multiplyTransposed(halfGradOutput, m_halfInput.transpose());
+        m_gradBiases += gradOutput.rowWise().sum();
 
-        // Accumulate gradients
-        Matrix gradWeights = gradOutput * m_input.transpose();
-        Matrix gradBiases = gradOutput.rowWise().sum();
+        // The optimizer will change the master weights
+        m_isHalfWeightsStale = true;
 
         // Compute the gradient with respect to the input
-        Matrix gradInput = m_weights.transpose() * gradOutput;
+        return multiplyTransposed(m_halfWeightsT, halfGradOutput.transpose());
+    }
 
+    void DenseLayer::setPrecision(const e_precision precision)
+    {
+        if (precision != FLOAT64 && m_layout != FEATURE_MAJOR)
+            throw std::invalid_argument("Mixed precision requires the feature-major layout.");
+
+        m_precision = precision;
+        m_isHalfWeightsStale = true;
+
+        // Drop activations stored in the previous precision
+        m_input = Matrix();
+        m_sparseInput = SparseMatrix();
+        m_output = Matrix();
+        m_halfInput = HalfMatrix();
+        m_halfOutput = HalfMatrix();
+    }
+
+    void DenseLayer::setMathPolicy(const e_mathPolicy policy)
+    {
+        // Only the activation evaluates transcendental functions
+        if (m_activation)
+            m_activation->setMathPolicy(policy);
+    }
+
+    void DenseLayer::setLayout(const e_layout layout)
+    {
+        if (layout != FEATURE_MAJOR && m_precision != FLOAT64)
+            throw std::invalid_argument("Mixed precision requires the feature-major layout.");
+
+        // The activation normalises over the features of each sample
+        m_layout = layout;
+        if (m_activation)
+            m_activation->setLayout(layout);
+
+        // Drop activations stored in the previous layout
+        m_input = Matrix();
+        m_output = Matrix();
+    }
+
+    void DenseLayer::applyGradients(Optimizer &optimizer)
+    {
         // Update weights and biases
-        optimizer.update(m_weights, m_biases, gradWeights, gradBiases);
+        optimizer.update(m_weights, m_biases, m_gradWeights, m_gradBiases, m_slots);
 
-        return gradInput;
+        // Reset the accumulators for the next batch
+        m_gradWeights = Matrix(m_weights.getRows(), m_weights.getCols(), 0.0);
+        m_gradBiases = Matrix(m_biases.getRows(), m_biases.getCols(), 0.0);
     }
 
-    void DenseLayer::save(std::ofstream &file) const
+    void DenseLayer::registerParameters(ParameterRegistry &registry)
     {
-        // Check if the file is open and writable
-        if (!file.is_open())
+        // Register weights and biases, their gradients are accumulated during backward propagation
+        registry.add(m_weights, &m_gradWeights);
+        registry.add(m_biases, &m_gradBiases);
+    }
+
+    void DenseLayer::prune(const double sparsity)
+    {
+        if (sparsity < 0.0 || sparsity >= 1.0)
+            throw std::invalid_argument("Sparsity must be in [0, 1).");
+
+        int size = m_weights.getSize();
+        int numPruned = static_cast<int>(sparsity * size);
+        if (numPruned == 0)
+            return;
+
+        // Find the weights with the smallest magnitude
+        double *weights = m_weights.getDataPtr();
+        std::vector<int> order(size);
+        std::iota(order.begin(), order.end(), 0);
+        std::nth_element(order.begin(), order.begin() + numPruned - 1, order.end(), [weights](int a, int b) {
+            return std::abs(weights[a]) < std::abs(weights[b]);
+        });
+
+        // Prune them
+        for (int i = 0; i < numPruned; i++)
+            weights[order[i]] = 0.0;
+
+        m_isHalfWeightsStale = true;
+    }
+
+    double DenseLayer::getSparsity() const
+    {
+        const double *weights = m_weights.getDataPtr();
+        int numZeros = std::count(weights, weights + m_weights.getSize(), 0.0);
+        return static_cast<double>(numZeros) / m_weights.getSize();
+    }
+
+    void DenseLayer::save(std::ostream &file) const
+    {
+        writeState(file, m_activationID, m_weights, m_biases);
+    }
+
+    std::function<void(std::ostream &)> DenseLayer::snapshot() const
+    {
+        return [activationID = m_activationID, weights = m_weights, biases = m_biases](std::ostream &file) {
+            writeState(file, activationID, weights, biases);
+        };
+    }
+
+    void DenseLayer::writeState(std::ostream &file, const e_activation activationID, const Matrix &weights, const Matrix &biases)
+    {
+        // Check if the stream is writable
+        if (!file.good())
             throw std::runtime_error("File is not open for writing.");
 
         // Write the activation function ID to the file
-        file.write(reinterpret_cast<const char *>(&m_activationID), sizeof(m_activationID));
+        file.write(reinterpret_cast<const char *>(&activationID), sizeof(activationID));
 
         // Save weights and biases to the file
-        m_weights.save(file);
-        m_biases.save(file);
+        weights.save(file);
+        biases.save(file);
 
         // Check if writing was successful
         if (!file.good())
@@ -122,37 +384,11 @@ namespace nn
         }
 
         // Initialize weights using the initializer and biases to zero
-        m_weights = Matrix(outputSize, inputSize, [&init]() { return init->getRandomNum(); });
+        m_weights = Matrix(outputSize, inputSize, [&init](std::size_t index) { return init->getValue(index); });
         m_biases = Matrix(outputSize, 1, 0.0);
-    }
-
-    void DenseLayer::initActivationFunction(e_activation activationID)
-    {
-        // Initialize the activation function based on the provided ID
-        switch (activationID)
-        {
-        case RELU:
-            m_activationID = RELU;
-            m_activation = std::make_unique<ReLU>();
-            break;
 
-        case SIGMOID:
-            m_activationID = SIGMOID;
-            m_activation = std::make_unique<Sigmoid>();
-            break;
-
-        case SOFTMAX:
-            m_activationID = SOFTMAX;
-            m_activation = std::make_unique<Softmax>();
-            break;
-
-        case NONE:
-            m_activationID = NONE;
-            m_activation = nullptr;
-            break;
-        
-        default:
-            throw std::runtime_error("Invalid activation function ID.");
-        }
+        // Start with empty gradient accumulators
+        m_gradWeights = Matrix(outputSize, inputSize, 0.0);
+        m_gradBiases = Matrix(outputSize, 1, 0.0);
     }
 }
\ No newline at end of file
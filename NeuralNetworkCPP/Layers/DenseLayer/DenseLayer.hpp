@@ -9,6 +9,7 @@
 
 #include "../Common/Layer.hpp"
 #include "../../Activations/Common/Activation.hpp"
+#include "../../Matrix/SparseMatrix/SparseMatrix.hpp"
 #include <memory>
 
 namespace nn
@@ -25,10 +26,25 @@ namespace nn
     private:
         Matrix m_weights;                         ///< Weight matrix.
         Matrix m_biases;                          ///< Bias vector.
+        Matrix m_gradWeights;                     ///< Accumulated gradient of the weights.
+        Matrix m_gradBiases;                      ///< Accumulated gradient of the biases.
+        ParameterSlots m_slots;                   ///< Slots of the weights and biases in the optimizer.
         Matrix m_input;                           ///< Input to the layer (stored for backward pass).
+        SparseMatrix m_sparseInput;               ///< Sparse input to the layer, one sample per row (stored for backward pass).
+        bool m_isSparseInput = false;             ///< True if the last forward pass took a sparse input.
         Matrix m_output;                          ///< Output of the layer (stored for backward pass).
         std::unique_ptr<Activation> m_activation; ///< Optional activation function.
         e_activation m_activationID;              ///< Activation ID used when saving layer to the file
+        bool m_isOutputLogits = false;            ///< True if the activation is fused into the loss and skipped.
+        e_layout m_layout = FEATURE_MAJOR;        ///< Layout of the samples in the inputs, outputs and gradients.
+
+        // Mixed-precision state, the double weights above stay the master copy
+        e_precision m_precision = FLOAT64;        ///< Precision of the weight copy and activations.
+        HalfMatrix m_halfWeights;                 ///< 16-bit copy of the weights.
+        HalfMatrix m_halfWeightsT;                ///< 16-bit copy of the transposed weights.
+        HalfMatrix m_halfInput;                   ///< 16-bit transposed input (stored for backward pass).
+        HalfMatrix m_halfOutput;                  ///< 16-bit output before activation (stored for backward pass).
+        bool m_isHalfWeightsStale = true;         ///< True if the weights changed since the 16-bit copies were made.
 
     public:
         /**
@@ -44,10 +60,10 @@ namespace nn
         /**
          * @brief Constructs a dense layer from the file.
          *
-         * @param file Input file stream (must be opened in binary mode).
-         * @throws std::runtime_error If the file is not open or reading fails.
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
          */
-        DenseLayer(std::ifstream &file);
+        DenseLayer(std::istream &file);
 
         /**
          * @brief Performs forward propagation.
@@ -58,21 +74,134 @@ namespace nn
         Matrix forward(const Matrix &input) override;
 
         /**
-         * @brief Performs backward propagation.
+         * @brief Performs forward propagation on sparse input.
+         *
+         * The products only read the weight columns of the features present in the batch, so the
+         * layer can take very high-dimensional sparse features as the first layer of a model.
+         * Sparse input is always processed in double precision.
+         *
+         * @param input The sparse input, one sample per row (batch size x input size).
+         * @return The output matrix after applying the layer's transformation.
+         * @throws std::invalid_argument If the number of features does not match the input size
+         *                               or the layer uses the sample-major layout.
+         */
+        Matrix forward(const SparseMatrix &input);
+
+        /**
+         * @brief Performs inference on a view of the input without copying it.
+         *
+         * The input is not stored, so the pass cannot be followed by a backward pass. Views are
+         * copied into a matrix in half precision.
+         *
+         * @param input The input in the layout of the layer, with any strides.
+         * @return The output matrix after applying the layer's transformation.
+         * @throws std::invalid_argument If the number of features does not match the input size.
+         */
+        Matrix forward(const MatrixView &input);
+
+        /**
+         * @brief Returns the output size of a single sample, 0 with a 16-bit precision which has no single-sample path.
+         *
+         * @param inputSize Number of input features of the sample.
+         * @return The number of outputs of the layer.
+         * @throws std::invalid_argument If the number of features does not match the input size.
+         */
+        int getSampleOutputSize(const int inputSize) const override;
+
+        /**
+         * @brief Performs inference on a single sample.
+         *
+         * The weights are multiplied by the input with `multiplyVector`, which adds the biases,
+         * and the activation is applied to the result in place.
+         *
+         * @param input Features of the sample.
+         * @param output Buffer for the outputs of the layer.
+         */
+        void predictSample(const double *input, double *output) const override;
+
+        /**
+         * @brief Performs backward propagation and accumulates the weights and biases gradients.
+         *
+         * After a sparse forward pass only the weight columns of the features present in the batch
+         * are accumulated to, and no input gradient is computed.
          *
          * @param gradient The gradient of the loss with respect to the output.
+         * @return The gradient of the loss with respect to the input (empty after a sparse forward pass).
+         */
+        Matrix accumulateGradients(const Matrix &gradient) override;
+
+        /**
+         * @brief Updates weights and biases with the accumulated gradients and resets them.
+         *
          * @param optimizer The optimizer to use for weights and biases updates.
-         * @return The gradient of the loss with respect to the input.
          */
-        Matrix backward(const Matrix &gradient, Optimizer &optimizer) override;
+        void applyGradients(Optimizer &optimizer) override;
+
+        /**
+         * @brief Registers weights and biases together with their gradients.
+         *
+         * @param registry The registry to add the parameters to.
+         */
+        void registerParameters(ParameterRegistry &registry) override;
+
+        /**
+         * @brief Sets the precision of the weight copy and the activations.
+         *
+         * With BFLOAT16 or FLOAT16 the products run on 16-bit copies of the weights and the
+         * stored activations are 16-bit, accumulation and the master weights stay in higher precision.
+         *
+         * @param precision The storage precision.
+         * @throws std::invalid_argument If a 16-bit precision is combined with the sample-major layout.
+         */
+        void setPrecision(const e_precision precision) override;
+
+        /**
+         * @brief Selects the implementation of exp used by the activation.
+         *
+         * @param policy STANDARD_MATH or FAST_MATH.
+         */
+        void setMathPolicy(const e_mathPolicy policy) override;
+
+        /**
+         * @brief Sets the layout of the samples.
+         *
+         * With SAMPLE_MAJOR the forward product is `input * weights^T` on rows of both operands and
+         * the biases are added to each row, so batch-first data needs no transposes.
+         *
+         * @param layout FEATURE_MAJOR or SAMPLE_MAJOR.
+         * @throws std::invalid_argument If SAMPLE_MAJOR is combined with a 16-bit precision.
+         */
+        void setLayout(const e_layout layout) override;
+
+        /**
+         * @brief Sets the weights with the smallest magnitude to zero.
+         *
+         * @param sparsity Fraction of the weights to prune, in [0, 1).
+         * @throws std::invalid_argument If the sparsity is out of range.
+         */
+        void prune(const double sparsity);
+
+        /**
+         * @brief Returns the fraction of weights which are zero.
+         *
+         * @return The sparsity of the weights.
+         */
+        double getSparsity() const;
 
         /**
          * @brief Saves the layer's state to a binary file.
          *
-         * @param file Output file stream (must be opened in binary mode).
-         * @throws std::runtime_error If the file is not open or reading fails.
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
+         */
+        void save(std::ostream &file) const override;
+
+        /**
+         * @brief Copies the parameters, they are written by the returned function as `save` would.
+         *
+         * @return Function writing the copied state.
          */
-        void save(std::ofstream &file) const override;
+        std::function<void(std::ostream &)> snapshot() const override;
 
         /**
          * @brief Returns the type of the layer.
@@ -81,7 +210,62 @@ namespace nn
          */
         e_layerType getType() const override { return DENSE; }
 
+        /**
+         * @brief Returns the weight matrix.
+         *
+         * @return The weights (output size x input size).
+         */
+        const Matrix &getWeights() const { return m_weights; }
+
+        /**
+         * @brief Returns the bias vector.
+         *
+         * @return The biases (output size x 1).
+         */
+        const Matrix &getBiases() const { return m_biases; }
+
+        /**
+         * @brief Returns the ID of the activation function.
+         *
+         * @return The activation ID.
+         */
+        e_activation getActivationID() const { return m_activationID; }
+
+        /**
+         * @brief Skips the activation in forward and backward passes.
+         *
+         * Used by the trainer when the activation is fused into the loss, forward then returns
+         * the logits and accumulateGradients expects the gradient with respect to them.
+         *
+         * @param outputLogits True to skip the activation, false to apply it.
+         */
+        void setOutputLogits(const bool outputLogits) { m_isOutputLogits = outputLogits; }
+
     private:
+        /**
+         * @brief Performs forward propagation on the 16-bit weight copy.
+         *
+         * @param input The input matrix.
+         * @return The output matrix after applying the layer's transformation.
+         */
+        Matrix forwardHalf(const Matrix &input);
+
+        /**
+         * @brief Performs backward propagation on the 16-bit weight copy and activations.
+         *
+         * @param gradient The gradient of the loss with respect to the output.
+         * @return The gradient of the loss with respect to the input.
+         */
+        Matrix accumulateGradientsHalf(const Matrix &gradient);
+
+        /**
+         * @brief Applies the biases and the activation function to the linear part of the output.
+         *
+         * @param linearOutput The product of the weights and the input.
+         * @return The output matrix after applying the activation function.
+         */
+        Matrix activate(Matrix linearOutput);
+
         /**
          * @brief Initializes the weights matrix using the specified initializer.
          *
@@ -92,12 +276,15 @@ namespace nn
         void initWeights(const int inputSize, const int outputSize, e_initializer initializerID);
 
         /**
-         * @brief Initializes the activation function based on the provided activation ID.
+         * @brief Writes the state of a layer in the format read by the stream constructor.
          *
+         * @param file Output binary stream.
          * @param activationID Activation function ID.
-         * @throws std::runtime_error If the provided function ID is incorrect.
+         * @param weights Weight matrix.
+         * @param biases Bias vector.
+         * @throws std::runtime_error If the stream is not usable or writing fails.
          */
-        void initActivationFunction(e_activation activationID);
+        static void writeState(std::ostream &file, const e_activation activationID, const Matrix &weights, const Matrix &biases);
     };
 }
 
@@ -0,0 +1,162 @@
+/**
+ * C++ neural network library
+ *
+ * Embedding.cpp
+ */
+
+#include "Embedding.hpp"
+#include "../../Initializers/Initializers.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace nn
+{
+    Embedding::Embedding(const int vocabularySize, const int embeddingSize, const int numFields, e_initializer initializerID)
+        : m_numFields(numFields)
+    {
+        // Validate the sizes
+        if (vocabularySize <= 0 || embeddingSize <= 0 || numFields <= 0)
+            throw std::invalid_argument("Vocabulary size, embedding size and number of fields must be greater than zero.");
+
+        // Create the appropriate initializer based on the provided ID, each row is a vector of `embeddingSize` values
+        std::unique_ptr<Initializer> init;
+
+        switch (initializerID)
+        {
+        case HE_NORMAL:
+            init = std::make_unique<HeNormal>(embeddingSize, embeddingSize);
+            break;
+
+        case HE_UNIFORM:
+            init = std::make_unique<HeUniform>(embeddingSize, embeddingSize);
+            break;
+
+        case XAVIER_NORMAL:
+            init = std::make_unique<XavierNormal>(embeddingSize, embeddingSize);
+            break;
+
+        case XAVIER_UNIFORM:
+            init = std::make_unique<XavierUniform>(embeddingSize, embeddingSize);
+            break;
+        }
+
+        // Initialize the table and an empty gradient accumulator
+        m_table = Matrix(vocabularySize, embeddingSize, [&init](std::size_t index) { return init->getValue(index); });
+        m_gradTable = Matrix(vocabularySize, embeddingSize, 0.0);
+    }
+
+    Embedding::Embedding(std::istream &file)
+    {
+        // Check if the stream is readable
+        if (!file.good())
+            throw std::runtime_error("File is not open for reading");
+
+        // Read the number of fields and the table
+        file.read(reinterpret_cast<char *>(&m_numFields), sizeof(m_numFields));
+        m_table = Matrix(file);
+
+        // Check if reading was successful
+        if (!file.good() || m_numFields <= 0)
+            throw std::runtime_error("Failed to read layer from the file.");
+
+        // Start with an empty gradient accumulator
+        m_gradTable = Matrix(m_table.getRows(), m_table.getCols(), 0.0);
+    }
+
+    Matrix Embedding::forward(const Matrix &input)
+    {
+        // Validate the number of fields
+        if (input.getRows() != m_numFields)
+            throw std::invalid_argument("Number of input rows must match the number of fields of the embedding.");
+
+        int embeddingSize = m_table.getCols();
+        m_batchSize = input.getCols();
+        m_ids.resize(input.getSize());
+
+        // Convert and validate the IDs
+        const double *ids = input.getDataPtr();
+        for (int i = 0; i < input.getSize(); i++)
+        {
+            double id = std::round(ids[i]);
+            if (id < 0.0 || id >= m_table.getRows())
+                throw std::invalid_argument("Embedding ID out of range.");
+            m_ids[i] = static_cast<int>(id);
+        }
+
+        // Copy the embedding of each ID into the column of its sample
+        Matrix output(m_numFields * embeddingSize, m_batchSize, 0.0);
+        for (int field = 0; field < m_numFields; field++)
+        {
+            for (int sample = 0; sample < m_batchSize; sample++)
+            {
+                const double *embedding = m_table.getDataPtr() + static_cast<std::size_t>(m_ids[field * m_batchSize + sample]) * embeddingSize;
+                for (int k = 0; k < embeddingSize; k++)
+                    output(field * embeddingSize + k, sample) = embedding[k];
+            }
+        }
+
+        return output;
+    }
+
+    Matrix Embedding::accumulateGradients(const Matrix &gradient)
+    {
+        int embeddingSize = m_table.getCols();
+
+        // Validate that the gradient matches the last output
+        if (gradient.getRows() != m_numFields * embeddingSize || gradient.getCols() != m_batchSize)
+            throw std::invalid_argument("Gradient dimensions must match the output of the embedding.");
+
+        // Scatter the gradient of each sample into the row of its ID
+        for (int field = 0; field < m_numFields; field++)
+        {
+            for (int sample = 0; sample < m_batchSize; sample++)
+            {
+                int id = m_ids[field * m_batchSize + sample];
+                double *row = m_gradTable.getDataPtr() + static_cast<std::size_t>(id) * embeddingSize;
+                for (int k = 0; k < embeddingSize; k++)
+                    row[k] += gradient(field * embeddingSize + k, sample);
+                m_touchedRows.push_back(id);
+            }
+        }
+
+        return Matrix(m_numFields, m_batchSize, 0.0);
+    }
+
+    void Embedding::applyGradients(Optimizer &optimizer)
+    {
+        // Update the touched rows, the optimizer resets their gradients
+        optimizer.updateRows(m_table, m_gradTable, m_touchedRows, m_slots);
+    }
+
+    void Embedding::registerParameters(ParameterRegistry &registry)
+    {
+        // Register the table as row-sparse, only the touched rows are updated
+        registry.add(m_table, &m_gradTable, &m_touchedRows);
+    }
+
+    void Embedding::save(std::ostream &file) const
+    {
+        writeState(file, m_numFields, m_table);
+    }
+
+    std::function<void(std::ostream &)> Embedding::snapshot() const
+    {
+        return [numFields = m_numFields, table = m_table](std::ostream &file) { writeState(file, numFields, table); };
+    }
+
+    void Embedding::writeState(std::ostream &file, const int numFields, const Matrix &table)
+    {
+        // Check if the stream is writable
+        if (!file.good())
+            throw std::runtime_error("File is not open for writing.");
+
+        // Write the number of fields and the table
+        file.write(reinterpret_cast<const char *>(&numFields), sizeof(numFields));
+        table.save(file);
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write layer data to the file.");
+    }
+}
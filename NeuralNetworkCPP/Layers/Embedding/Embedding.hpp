@@ -0,0 +1,127 @@
+/**
+ * C++ neural network library
+ *
+ * Embedding.hpp
+ */
+
+#ifndef EMBEDDING_HPP
+#define EMBEDDING_HPP
+
+#include "../Common/Layer.hpp"
+
+namespace nn
+{
+    /**
+     * @class Embedding
+     * @brief Maps categorical IDs to learned dense vectors.
+     *
+     * Each input row is a categorical field (e.g. user ID, item ID) holding one ID per sample.
+     * The output stacks the embeddings of all fields, so the layer replaces one-hot vectors fed
+     * into a dense layer. Only the table rows of the IDs in a batch receive gradients and are
+     * updated by the optimizer.
+     */
+    class Embedding : public Layer
+    {
+    private:
+        Matrix m_table;                 ///< Embedding table (vocabulary size x embedding size).
+        Matrix m_gradTable;             ///< Accumulated gradient of the table, only the touched rows are non-zero.
+        std::vector<int> m_touchedRows; ///< Rows of the table with accumulated gradients.
+        ParameterSlots m_slots;         ///< Slot of the table in the optimizer.
+        std::vector<int> m_ids;         ///< IDs of the last input, field by field (stored for backward pass).
+        int m_numFields;                ///< Number of categorical fields per sample.
+        int m_batchSize = 0;            ///< Number of samples of the last input.
+
+    public:
+        /**
+         * @brief Constructs an embedding layer.
+         *
+         * @param vocabularySize Number of distinct IDs, inputs must be in [0, vocabularySize).
+         * @param embeddingSize Size of the vector of each ID.
+         * @param numFields Number of categorical fields per sample, all sharing the table (default: 1).
+         * @param initializerID Table initializer (default: XAVIER_UNIFORM).
+         * @throws std::invalid_argument If a size is not positive.
+         */
+        Embedding(const int vocabularySize, const int embeddingSize, const int numFields = 1, e_initializer initializerID = XAVIER_UNIFORM);
+
+        /**
+         * @brief Constructs an embedding layer from the file.
+         *
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
+         */
+        Embedding(std::istream &file);
+
+        /**
+         * @brief Looks up the embeddings of the IDs.
+         *
+         * @param input The IDs (number of fields x batch size).
+         * @return The stacked embeddings (number of fields * embedding size x batch size).
+         * @throws std::invalid_argument If the input shape is wrong or an ID is out of range.
+         */
+        Matrix forward(const Matrix &input) override;
+
+        /**
+         * @brief Scatters the gradient into the table rows of the last input.
+         *
+         * @param gradient The gradient of the loss with respect to the output.
+         * @return A zero gradient with respect to the IDs, they are not differentiable.
+         */
+        Matrix accumulateGradients(const Matrix &gradient) override;
+
+        /**
+         * @brief Updates the touched table rows with the accumulated gradients and resets them.
+         *
+         * @param optimizer The optimizer to use for the table update.
+         */
+        void applyGradients(Optimizer &optimizer) override;
+
+        /**
+         * @brief Registers the table as a row-sparse parameter.
+         *
+         * @param registry The registry to add the parameters to.
+         */
+        void registerParameters(ParameterRegistry &registry) override;
+
+        /**
+         * @brief Saves the layer's state to a binary file.
+         *
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or writing fails.
+         */
+        void save(std::ostream &file) const override;
+
+        /**
+         * @brief Copies the table, it is written by the returned function as `save` would.
+         *
+         * @return Function writing the copied state.
+         */
+        std::function<void(std::ostream &)> snapshot() const override;
+
+        /**
+         * @brief Returns the type of the layer.
+         *
+         * @return The layer type as an enum value.
+         */
+        e_layerType getType() const override { return EMBEDDING; }
+
+        /**
+         * @brief Returns the embedding table.
+         *
+         * @return The table (vocabulary size x embedding size).
+         */
+        const Matrix &getTable() const { return m_table; }
+
+    private:
+        /**
+         * @brief Writes the state of a layer in the format read by the stream constructor.
+         *
+         * @param file Output binary stream.
+         * @param numFields Number of categorical fields per sample.
+         * @param table Embedding table.
+         * @throws std::runtime_error If the stream is not usable or writing fails.
+         */
+        static void writeState(std::ostream &file, const int numFields, const Matrix &table);
+    };
+}
+
+#endif
@@ -14,5 +14,8 @@
 
 #include "DenseLayer/DenseLayer.hpp"
 #include "BatchNormalization/BatchNormalization.hpp"
+#include "QuantizedDenseLayer/QuantizedDenseLayer.hpp"
+#include "SparseDenseLayer/SparseDenseLayer.hpp"
+#include "Embedding/Embedding.hpp"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+/**
+ * C++ neural network library
+ *
+ * QuantizedDenseLayer.cpp
+ */
+
+#include "QuantizedDenseLayer.hpp"
+#include "../../Activations/Activations.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX512VNNI__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace nn
+{
+    // Row length multiple the weights and quantized inputs are padded to
+    constexpr int INT8_ROW_ALIGNMENT = 64;
+
+    // Largest quantized input, 7 bits keep the pair sums of vpmaddubsw within int16
+    constexpr int INPUT_QUANT_MAX = 127;
+
+    // Largest quantized weight magnitude
+    constexpr int WEIGHT_QUANT_MAX = 127;
+
+    // Dot product of unsigned and signed bytes, `count` is a multiple of INT8_ROW_ALIGNMENT
+    static std::int32_t dotInt8(const std::uint8_t *a, const std::int8_t *b, const int count)
+    {
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+        // vpdpbusd multiplies and sums 4 byte pairs into each int32 lane
+        __m512i acc = _mm512_setzero_si512();
+        for (int k = 0; k < count; k += 64)
+            acc = _mm512_dpbusd_epi32(acc, _mm512_loadu_si512(a + k), _mm512_loadu_si512(b + k));
+        return _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+        // vpmaddubsw sums byte pairs into int16, vpmaddwd widens the pairs of those into int32
+        const __m256i ones = _mm256_set1_epi16(1);
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = 0; k < count; k += 32)
+        {
+            __m256i products = _mm256_maddubs_epi16(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + k)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + k)));
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(products, ones));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_hadd_epi32(sum, sum);
+        sum = _mm_hadd_epi32(sum, sum);
+        return _mm_cvtsi128_si32(sum);
+#else
+        std::int32_t sum = 0;
+        for (int k = 0; k < count; k++)
+            sum += static_cast<std::int32_t>(a[k]) * static_cast<std::int32_t>(b[k]);
+        return sum;
+#endif
+    }
+
+    QuantizedDenseLayer::QuantizedDenseLayer(const DenseLayer &layer, const double inputMin, const double inputMax)
+    {
+        // Copy the activation and the biases, which stay in double precision
+        m_activationID = layer.getActivationID();
+        m_activation = createActivation(m_activationID);
+        m_biases = layer.getBiases();
+
+        // Map the calibrated range to the 7-bit input range, zero stays exactly representable
+        double low = std::min(inputMin, 0.0);
+        double high = std::max(inputMax, 0.0);
+        m_inputScale = (high > low) ? (high - low) / INPUT_QUANT_MAX : 1.0;
+        m_inputZeroPoint = static_cast<int>(std::nearbyint(-low / m_inputScale));
+
+        quantizeWeights(layer.getWeights());
+    }
+
+    QuantizedDenseLayer::QuantizedDenseLayer(std::istream &file)
+    {
+        // Check if the stream is readable
+        if (!file.good())
+            throw std::runtime_error("File is not open for reading");
+
+        // Read the activation function ID and the dimensions
+        file.read(reinterpret_cast<char *>(&m_activationID), sizeof(m_activationID));
+        file.read(reinterpret_cast<char *>(&m_inputSize), sizeof(m_inputSize));
+        file.read(reinterpret_cast<char *>(&m_outputSize), sizeof(m_outputSize));
+        file.read(reinterpret_cast<char *>(&m_inputScale), sizeof(m_inputScale));
+        file.read(reinterpret_cast<char *>(&m_inputZeroPoint), sizeof(m_inputZeroPoint));
+
+        if (!file.good() || m_inputSize <= 0 || m_outputSize <= 0 || m_inputZeroPoint < 0 || m_inputZeroPoint > INPUT_QUANT_MAX)
+            throw std::runtime_error("Failed to read layer from the file.");
+
+        m_activation = createActivation(m_activationID);
+
+        // Read the scales and the unpadded quantized weights
+        m_weightScales.resize(m_outputSize);
+        file.read(reinterpret_cast<char *>(m_weightScales.data()), sizeof(double) * m_outputSize);
+
+        m_paddedInputSize = (m_inputSize + INT8_ROW_ALIGNMENT - 1) / INT8_ROW_ALIGNMENT * INT8_ROW_ALIGNMENT;
+        m_weights.assign(m_outputSize * m_paddedInputSize, 0);
+        m_weightSums.assign(m_outputSize, 0);
+
+        for (int o = 0; o < m_outputSize; o++)
+        {
+            std::int8_t *row = m_weights.data() + o * m_paddedInputSize;
+            file.read(reinterpret_cast<char *>(row), m_inputSize);
+            for (int k = 0; k < m_inputSize; k++)
+                m_weightSums[o] += row[k];
+        }
+
+        // Read the biases
+        m_biases = Matrix(file);
+
+        // Check if reading was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to read layer from the file.");
+    }
+
+    Matrix QuantizedDenseLayer::forward(const Matrix &input)
+    {
+        if (input.getRows() != m_inputSize)
+            throw std::invalid_argument("Input size does not match the layer.");
+
+        int batchSize = input.getCols();
+        const double *source = input.getDataPtr();
+        double inverseScale = 1.0 / m_inputScale;
+
+        // Quantize the input transposed, so each sample is a contiguous padded row
+        AlignedVector<std::uint8_t> quantized(batchSize * m_paddedInputSize, 0);
+        for (int k = 0; k < m_inputSize; k++)
+        {
+            for (int b = 0; b < batchSize; b++)
+            {
+                double step = std::nearbyint(source[k * batchSize + b] * inverseScale) + m_inputZeroPoint;
+                quantized[b * m_paddedInputSize + k] = static_cast<std::uint8_t>(std::clamp(step, 0.0, static_cast<double>(INPUT_QUANT_MAX)));
+            }
+        }
+
+        Matrix output(m_outputSize, batchSize);
+        double *target = output.getDataPtr();
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize over the output channels, the zero point is removed with the weight sums
+        pool.parallelFor(0, m_outputSize, [this, &quantized, target, batchSize](int o) {
+            const std::int8_t *weights = m_weights.data() + o * m_paddedInputSize;
+            double scale = m_inputScale * m_weightScales[o];
+            std::int32_t zeroPointOffset = m_inputZeroPoint * m_weightSums[o];
+            double bias = m_biases(o, 0);
+
+            for (int b = 0; b < batchSize; b++)
+            {
+                std::int32_t acc = dotInt8(quantized.data() + b * m_paddedInputSize, weights, m_paddedInputSize);
+                target[o * batchSize + b] = (acc - zeroPointOffset) * scale + bias;
+            }
+        });
+
+        // Apply the activation function if it exists
+        if (m_activation)
+            output = m_activation->forward(output);
+
+        return output;
+    }
+
+    Matrix QuantizedDenseLayer::accumulateGradients(const Matrix &)
+    {
+        throw std::runtime_error("Quantized layers support inference only.");
+    }
+
+    void QuantizedDenseLayer::applyGradients(Optimizer &)
+    {
+        throw std::runtime_error("Quantized layers support inference only.");
+    }
+
+    void QuantizedDenseLayer::setMathPolicy(const e_mathPolicy policy)
+    {
+        if (m_activation)
+            m_activation->setMathPolicy(policy);
+    }
+
+    void QuantizedDenseLayer::save(std::ostream &file) const
+    {
+        // Check if the stream is writable
+        if (!file.good())
+            throw std::runtime_error("File is not open for writing.");
+
+        // Write the activation function ID, the dimensions and the scales
+        file.write(reinterpret_cast<const char *>(&m_activationID), sizeof(m_activationID));
+        file.write(reinterpret_cast<const char *>(&m_inputSize), sizeof(m_inputSize));
+        file.write(reinterpret_cast<const char *>(&m_outputSize), sizeof(m_outputSize));
+        file.write(reinterpret_cast<const char *>(&m_inputScale), sizeof(m_inputScale));
+        file.write(reinterpret_cast<const char *>(&m_inputZeroPoint), sizeof(m_inputZeroPoint));
+        file.write(reinterpret_cast<const char *>(m_weightScales.data()), sizeof(double) * m_outputSize);
+
+        // Write the quantized weights without padding
+        for (int o = 0; o < m_outputSize; o++)
+            file.write(reinterpret_cast<const char *>(m_weights.data() + o * m_paddedInputSize), m_inputSize);
+
+        // Save the biases
+        m_biases.save(file);
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write layer data to the file.");
+    }
+
+    void QuantizedDenseLayer::quantizeWeights(const Matrix &weights)
+    {
+        m_outputSize = weights.getRows();
+        m_inputSize = weights.getCols();
+        m_paddedInputSize = (m_inputSize + INT8_ROW_ALIGNMENT - 1) / INT8_ROW_ALIGNMENT * INT8_ROW_ALIGNMENT;
+        m_weightScales.assign(m_outputSize, 1.0);
+        m_weights.assign(m_outputSize * m_paddedInputSize, 0);
+        m_weightSums.assign(m_outputSize, 0);
+
+        for (int o = 0; o < m_outputSize; o++)
+        {
+            // Symmetric scale of the output channel
+            double maxAbs = 0.0;
+            for (int k = 0; k < m_inputSize; k++)
+                maxAbs = std::max(maxAbs, std::abs(weights(o, k)));
+            if (maxAbs > 0.0)
+                m_weightScales[o] = maxAbs / WEIGHT_QUANT_MAX;
+
+            // Round the weights of the channel
+            std::int8_t *row = m_weights.data() + o * m_paddedInputSize;
+            for (int k = 0; k < m_inputSize; k++)
+            {
+                double step = std::nearbyint(weights(o, k) / m_weightScales[o]);
+                row[k] = static_cast<std::int8_t>(std::clamp(step, -static_cast<double>(WEIGHT_QUANT_MAX), static_cast<double>(WEIGHT_QUANT_MAX)));
+                m_weightSums[o] += row[k];
+            }
+        }
+    }
+}
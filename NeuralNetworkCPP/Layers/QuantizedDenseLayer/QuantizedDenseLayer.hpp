@@ -0,0 +1,125 @@
+/**
+ * C++ neural network library
+ *
+ * QuantizedDenseLayer.hpp
+ */
+
+#ifndef QUANTIZEDDENSELAYER_HPP
+#define QUANTIZEDDENSELAYER_HPP
+
+#include "../DenseLayer/DenseLayer.hpp"
+#include "../../Memory/AlignedAllocator/AlignedAllocator.hpp"
+#include <cstdint>
+
+namespace nn
+{
+    /**
+     * @class QuantizedDenseLayer
+     * @brief Inference-only dense layer with int8 weights and int8 products.
+     *
+     * Weights are quantized symmetrically per output channel to [-127, 127]. Inputs are quantized
+     * per tensor and asymmetrically: the minimum and maximum calibrated on sample data (extended
+     * to include zero) map to [0, 127] with a zero point, so non-negative inputs such as ReLU
+     * outputs use all levels. Inputs stay below 128, so the u8 x s8 pair sums of `vpmaddubsw`
+     * can never saturate and every kernel (AVX-512 VNNI, AVX2 or scalar) gives bit-identical
+     * results. The products are accumulated in int32, the zero point is removed with the weight
+     * sums and the result is rescaled to double before the bias and the activation are applied.
+     */
+    class QuantizedDenseLayer : public Layer
+    {
+    private:
+        int m_inputSize;                          ///< Number of input neurons.
+        int m_outputSize;                         ///< Number of output neurons.
+        int m_paddedInputSize;                    ///< Row length of the weights, padded for the SIMD kernels.
+        double m_inputScale;                      ///< Value of one input quantization step.
+        int m_inputZeroPoint;                     ///< Quantized value of a zero input.
+        std::vector<double> m_weightScales;       ///< Value of one weight quantization step of each output channel.
+        AlignedVector<std::int8_t> m_weights;     ///< Quantized weights, one padded row per output channel.
+        std::vector<std::int32_t> m_weightSums;   ///< Sum of the quantized weights of each output channel.
+        Matrix m_biases;                          ///< Bias vector.
+        std::unique_ptr<Activation> m_activation; ///< Optional activation function.
+        e_activation m_activationID;              ///< Activation ID used when saving layer to the file
+
+    public:
+        /**
+         * @brief Quantizes a trained dense layer.
+         *
+         * @param layer The layer to quantize.
+         * @param inputMin Smallest input value observed during calibration.
+         * @param inputMax Largest input value observed during calibration.
+         */
+        QuantizedDenseLayer(const DenseLayer &layer, const double inputMin, const double inputMax);
+
+        /**
+         * @brief Constructs a quantized dense layer from the file.
+         *
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
+         */
+        QuantizedDenseLayer(std::istream &file);
+
+        /**
+         * @brief Performs forward propagation with int8 products.
+         *
+         * @param input The input matrix.
+         * @return The output matrix after applying the layer's transformation.
+         * @throws std::invalid_argument If the input size does not match the layer.
+         */
+        Matrix forward(const Matrix &input) override;
+
+        /**
+         * @brief Not supported, quantized layers are inference-only.
+         *
+         * @param gradient The gradient of the loss with respect to the output.
+         * @throws std::runtime_error Always.
+         */
+        Matrix accumulateGradients(const Matrix &gradient) override;
+
+        /**
+         * @brief Not supported, quantized layers are inference-only.
+         *
+         * @param optimizer The optimizer.
+         * @throws std::runtime_error Always.
+         */
+        void applyGradients(Optimizer &optimizer) override;
+
+        /**
+         * @brief Registers nothing, the layer has no trainable parameters.
+         *
+         * @param registry The registry to add the parameters to.
+         */
+        void registerParameters([[maybe_unused]] ParameterRegistry &registry) override {}
+
+        /**
+         * @brief Saves the layer's state to a binary file.
+         *
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or writing fails.
+         */
+        void save(std::ostream &file) const override;
+
+        /**
+         * @brief Selects the implementation of exp used by the activation.
+         *
+         * @param policy STANDARD_MATH or FAST_MATH.
+         */
+        void setMathPolicy(const e_mathPolicy policy) override;
+
+        /**
+         * @brief Returns the type of the layer.
+         *
+         * @return The layer type as an enum value.
+         */
+        e_layerType getType() const override { return QUANTIZED_DENSE; }
+
+    private:
+        /**
+         * @brief Quantizes the weights per output channel.
+         *
+         * @param weights The double precision weights.
+         */
+        void quantizeWeights(const Matrix &weights);
+    };
+}
+
+#endif
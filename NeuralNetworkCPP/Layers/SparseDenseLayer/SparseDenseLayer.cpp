@@ -0,0 +1,129 @@
+/**
+ * C++ neural network library
+ *
+ * SparseDenseLayer.cpp
+ */
+
+#include "SparseDenseLayer.hpp"
+#include "../../Activations/Activations.hpp"
+
+namespace nn
+{
+    SparseDenseLayer::SparseDenseLayer(const DenseLayer &layer)
+        : m_weights(layer.getWeights()), m_biases(layer.getBiases())
+    {
+        m_activationID = layer.getActivationID();
+        m_activation = createActivation(m_activationID);
+
+        // Start with empty gradient accumulators
+        m_gradValues = Matrix(m_weights.getNonZeros(), 1, 0.0);
+        m_gradBiases = Matrix(m_biases.getRows(), m_biases.getCols(), 0.0);
+    }
+
+    SparseDenseLayer::SparseDenseLayer(std::istream &file)
+    {
+        // Check if the stream is readable
+        if (!file.good())
+            throw std::runtime_error("File is not open for reading");
+
+        // Read the activation function ID
+        file.read(reinterpret_cast<char *>(&m_activationID), sizeof(m_activationID));
+
+        // Initialize the activation function based on the ID
+        m_activation = createActivation(m_activationID);
+
+        // Read weights and biases from the file
+        m_weights = SparseMatrix(file);
+        m_biases = Matrix(file);
+
+        // Start with empty gradient accumulators
+        m_gradValues = Matrix(m_weights.getNonZeros(), 1, 0.0);
+        m_gradBiases = Matrix(m_biases.getRows(), m_biases.getCols(), 0.0);
+
+        // Check if reading was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to read layer from the file.");
+    }
+
+    Matrix SparseDenseLayer::forward(const Matrix &input)
+    {
+        // Store the input for use in the backward pass
+        m_input = input;
+
+        // Compute the linear transformation with the sparse weights
+        m_output = (m_weights * m_input).colWise() + m_biases;
+
+        // Apply the activation function if it exists
+        if (m_activation)
+            return m_activation->forward(m_output);
+
+        return m_output;
+    }
+
+    Matrix SparseDenseLayer::accumulateGradients(const Matrix &gradient)
+    {
+        // Compute the gradient with respect to the output
+        Matrix gradOutput = m_activation ? m_activation->backward(m_output) : Matrix(m_output.getRows(), m_output.getCols(), 1.0);
+        gradOutput = gradient.cwiseProduct(gradOutput);
+
+        // Accumulate gradients, only at the positions of the remaining weights
+        m_gradValues += m_weights.sampledProduct(gradOutput, m_input);
+        m_gradBiases += gradOutput.rowWise().sum();
+
+        // Compute the gradient with respect to the input
+        return m_weights.transposeMultiply(gradOutput);
+    }
+
+    void SparseDenseLayer::applyGradients(Optimizer &optimizer)
+    {
+        // Update weights and biases
+        optimizer.update(m_weights.getValues(), m_biases, m_gradValues, m_gradBiases, m_slots);
+
+        // Reset the accumulators for the next batch
+        m_gradValues = Matrix(m_gradValues.getRows(), m_gradValues.getCols(), 0.0);
+        m_gradBiases = Matrix(m_biases.getRows(), m_biases.getCols(), 0.0);
+    }
+
+    void SparseDenseLayer::registerParameters(ParameterRegistry &registry)
+    {
+        // Register the remaining weights and the biases, their gradients are accumulated during backward propagation
+        registry.add(m_weights.getValues(), &m_gradValues);
+        registry.add(m_biases, &m_gradBiases);
+    }
+
+    void SparseDenseLayer::setMathPolicy(const e_mathPolicy policy)
+    {
+        if (m_activation)
+            m_activation->setMathPolicy(policy);
+    }
+
+    void SparseDenseLayer::save(std::ostream &file) const
+    {
+        writeState(file, m_activationID, m_weights, m_biases);
+    }
+
+    std::function<void(std::ostream &)> SparseDenseLayer::snapshot() const
+    {
+        return [activationID = m_activationID, weights = m_weights, biases = m_biases](std::ostream &file) {
+            writeState(file, activationID, weights, biases);
+        };
+    }
+
+    void SparseDenseLayer::writeState(std::ostream &file, const e_activation activationID, const SparseMatrix &weights, const Matrix &biases)
+    {
+        // Check if the stream is writable
+        if (!file.good())
+            throw std::runtime_error("File is not open for writing.");
+
+        // Write the activation function ID to the file
+        file.write(reinterpret_cast<const char *>(&activationID), sizeof(activationID));
+
+        // Save weights and biases to the file
+        weights.save(file);
+        biases.save(file);
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write layer data to the file.");
+    }
+}
@@ -0,0 +1,131 @@
+/**
+ * C++ neural network library
+ *
+ * SparseDenseLayer.hpp
+ */
+
+#ifndef SPARSEDENSELAYER_HPP
+#define SPARSEDENSELAYER_HPP
+
+#include "../DenseLayer/DenseLayer.hpp"
+#include "../../Matrix/SparseMatrix/SparseMatrix.hpp"
+
+namespace nn
+{
+    /**
+     * @class SparseDenseLayer
+     * @brief Fully connected layer with pruned weights stored in CSR format.
+     *
+     * Forward and backward passes only touch the remaining weights, which pays off once most
+     * weights have been pruned. Only the remaining weights are trained, so the sparsity is kept.
+     */
+    class SparseDenseLayer : public Layer
+    {
+    private:
+        SparseMatrix m_weights;                   ///< Remaining weights in CSR format.
+        Matrix m_biases;                          ///< Bias vector.
+        Matrix m_gradValues;                      ///< Accumulated gradient of the remaining weights.
+        Matrix m_gradBiases;                      ///< Accumulated gradient of the biases.
+        ParameterSlots m_slots;                   ///< Slots of the weights and biases in the optimizer.
+        Matrix m_input;                           ///< Input to the layer (stored for backward pass).
+        Matrix m_output;                          ///< Output of the layer (stored for backward pass).
+        std::unique_ptr<Activation> m_activation; ///< Optional activation function.
+        e_activation m_activationID;              ///< Activation ID used when saving layer to the file
+
+    public:
+        /**
+         * @brief Converts a pruned dense layer, every non-zero weight is kept.
+         *
+         * @param layer The dense layer to convert.
+         */
+        SparseDenseLayer(const DenseLayer &layer);
+
+        /**
+         * @brief Constructs a sparse dense layer from the file.
+         *
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
+         */
+        SparseDenseLayer(std::istream &file);
+
+        /**
+         * @brief Performs forward propagation.
+         *
+         * @param input The input matrix.
+         * @return The output matrix after applying the layer's transformation.
+         */
+        Matrix forward(const Matrix &input) override;
+
+        /**
+         * @brief Performs backward propagation and accumulates the gradients of the remaining weights and the biases.
+         *
+         * @param gradient The gradient of the loss with respect to the output.
+         * @return The gradient of the loss with respect to the input.
+         */
+        Matrix accumulateGradients(const Matrix &gradient) override;
+
+        /**
+         * @brief Updates weights and biases with the accumulated gradients and resets them.
+         *
+         * @param optimizer The optimizer to use for weights and biases updates.
+         */
+        void applyGradients(Optimizer &optimizer) override;
+
+        /**
+         * @brief Registers the remaining weights and the biases together with their gradients.
+         *
+         * @param registry The registry to add the parameters to.
+         */
+        void registerParameters(ParameterRegistry &registry) override;
+
+        /**
+         * @brief Saves the layer's state to a binary file.
+         *
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or writing fails.
+         */
+        void save(std::ostream &file) const override;
+
+        /**
+         * @brief Copies the parameters, they are written by the returned function as `save` would.
+         *
+         * @return Function writing the copied state.
+         */
+        std::function<void(std::ostream &)> snapshot() const override;
+
+        /**
+         * @brief Selects the implementation of exp used by the activation.
+         *
+         * @param policy STANDARD_MATH or FAST_MATH.
+         */
+        void setMathPolicy(const e_mathPolicy policy) override;
+
+        /**
+         * @brief Returns the type of the layer.
+         *
+         * @return The layer type as an enum value.
+         */
+        e_layerType getType() const override { return SPARSE_DENSE; }
+
+        /**
+         * @brief Returns the weights in CSR format.
+         *
+         * @return The sparse weight matrix.
+         */
+        const SparseMatrix &getWeights() const { return m_weights; }
+
+    private:
+        /**
+         * @brief Writes the state of a layer in the format read by the stream constructor.
+         *
+         * @param file Output binary stream.
+         * @param activationID Activation function ID.
+         * @param weights Weights in CSR format.
+         * @param biases Bias vector.
+         * @throws std::runtime_error If the stream is not usable or writing fails.
+         */
+        static void writeState(std::ostream &file, const e_activation activationID, const SparseMatrix &weights, const Matrix &biases);
+    };
+}
+
+#endif
@@ -5,6 +5,7 @@
  */
 
 #include "Logger.hpp"
+#include "../Pipeline/Pipeline.hpp"
 #include <iostream>
 #include <iomanip>
 #include <string>
@@ -94,6 +95,24 @@ namespace nn
         std::cout << " [" << std::string(progress, '=') << std::string(m_progressBarLength - progress, ' ') << "]";
     }
 
+    void Logger::logPipelineStats(const std::vector<PipelineStageStats> &stats)
+    {
+        for (std::size_t i = 0; i < stats.size(); i++)
+        {
+            const PipelineStageStats &stage = stats[i];
+
+            // Print the layers and cores of the stage
+            std::cout << "[    STAGE ] " << i << ": layers " << stage.firstLayer << "-" << (stage.firstLayer + stage.numLayers - 1);
+            std::cout << " on " << stage.cores.size() << (stage.cores.size() == 1 ? " core" : " cores");
+
+            // Print the throughput and the share of the time the stage was busy
+            std::cout << " - " << std::fixed << std::setprecision(1) << stage.getThroughput() << " samples/s";
+            std::cout << " - busy: " << (stage.getUtilization() * 100.0) << "%";
+            std::cout << " (recompute " << (stage.getBusySeconds() > 0.0 ? stage.recomputeSeconds / stage.getBusySeconds() * 100.0 : 0.0) << "%)";
+            std::cout << std::defaultfloat << std::setprecision(6) << std::endl;
+        }
+    }
+
     void Logger::logMetric(const e_metric metric, const std::vector<double> &computedMetrics)
     {
         // Print the logs depending on selected metric
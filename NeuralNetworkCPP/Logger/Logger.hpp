@@ -17,6 +17,8 @@ namespace nn
      */
     enum e_metric { ACCURACY_LOG, MAE_LOG };
 
+    struct PipelineStageStats;
+
     /**
      * @class Logger
      * @brief Handles logging of training progress and metrics.
@@ -78,6 +80,13 @@ namespace nn
          * @param totalBatches Total number of batches.
          */
         void logBatch(const int currentBatch, const int totalBatches);
+
+        /**
+         * @brief Logs the layers, cores, throughput and utilization of each pipeline stage.
+         *
+         * @param stats Statistics of the stages in model order.
+         */
+        void logPipelineStats(const std::vector<PipelineStageStats> &stats);
     
     private:
         /**
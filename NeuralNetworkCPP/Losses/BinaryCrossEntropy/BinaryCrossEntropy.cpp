@@ -5,19 +5,41 @@
  */
 
 #include "BinaryCrossEntropy.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 namespace nn
 {
+    // Number of elements processed by a single task of the fused kernel
+    constexpr int LOGITS_BLOCK_SIZE = 4096;
+
     double BinaryCrossEntropy::computeLoss(const Matrix &predictions, const Matrix &targets)
     {
         if (predictions.getRows() != targets.getRows() || predictions.getCols() != targets.getCols())
             throw std::invalid_argument("Predictions and targets must have the same dimensions.");
-        
-        Matrix logPred = predictions.map([this](double x) { return std::log(x + m_epsilon); });
-        Matrix logOneMinusPred = (1 - predictions).map([this](double x) { return std::log(x + m_epsilon); });
 
-        return ((targets.cwiseProduct(logPred) + (1 - targets).cwiseProduct(logOneMinusPred)).sum() * -1) / targets.getCols();
+        double epsilon = m_epsilon;
+
+        if (m_mathPolicy == FAST_MATH)
+        {
+            // Evaluate both logarithms with the vectorised kernel, then combine them
+            Matrix logPred = predictions.map([epsilon](double p) { return p + epsilon; });
+            Matrix logOneMinusPred = predictions.map([epsilon](double p) { return 1 - p + epsilon; });
+            applyInParallel(fastLog, logPred.getDataPtr(), logPred.getDataPtr(), logPred.getSize());
+            applyInParallel(fastLog, logOneMinusPred.getDataPtr(), logOneMinusPred.getDataPtr(), logOneMinusPred.getSize());
+
+            Matrix terms = targets.zipMap(logPred, [](double t, double logP) { return t * logP; });
+            terms += (1 - targets).cwiseProduct(logOneMinusPred);
+            return (terms.sum(m_summation) * -1) / getBatchSize(targets);
+        }
+
+        Matrix terms = targets.zipMap(predictions, [epsilon](double t, double p) {
+            return t * std::log(p + epsilon) + (1 - t) * std::log(1 - p + epsilon);
+        });
+
+        return (terms.sum(m_summation) * -1) / getBatchSize(targets);
     }
 
     Matrix BinaryCrossEntropy::computeGradient(const Matrix &predictions, const Matrix &targets)
@@ -25,6 +47,69 @@ namespace nn
         if (predictions.getRows() != targets.getRows() || predictions.getCols() != targets.getCols())
             throw std::invalid_argument("Predictions and targets must have the same dimensions.");
 
-        return (-1 * (targets / (predictions + m_epsilon))) + ((1 - targets) / (1 - predictions + m_epsilon));
+        double epsilon = m_epsilon;
+        return targets.zipMap(predictions, [epsilon](double t, double p) {
+            return (-1 * (t / (p + epsilon))) + ((1 - t) / (1 - p + epsilon));
+        });
+    }
+
+    double BinaryCrossEntropy::computeFromLogits(const Matrix &logits, const Matrix &targets, Matrix &gradient)
+    {
+        if (logits.getRows() != targets.getRows() || logits.getCols() != targets.getCols())
+            throw std::invalid_argument("Logits and targets must have the same dimensions.");
+
+        int size = logits.getSize();
+        int numBlocks = (size + LOGITS_BLOCK_SIZE - 1) / LOGITS_BLOCK_SIZE;
+        gradient = Matrix(logits.getRows(), logits.getCols());
+        std::vector<double> blockLoss(numBlocks, 0.0);
+
+        // Each task handles a block of elements while its logits are in cache
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int start = block * LOGITS_BLOCK_SIZE;
+            int count = std::min(size, start + LOGITS_BLOCK_SIZE) - start;
+            const double *z = logits.getDataPtr() + start;
+            const double *t = targets.getDataPtr() + start;
+            double *g = gradient.getDataPtr() + start;
+
+            // e^{-|z|} never overflows
+            for (int i = 0; i < count; i++)
+                g[i] = -std::abs(z[i]);
+
+            if (m_mathPolicy == FAST_MATH)
+                fastExp(g, g, count);
+            else
+                for (int i = 0; i < count; i++)
+                    g[i] = std::exp(g[i]);
+
+            // log(1 + e^{-|z|}) of each element
+            std::vector<double> softplus(count);
+            if (m_mathPolicy == FAST_MATH)
+            {
+                for (int i = 0; i < count; i++)
+                    softplus[i] = 1.0 + g[i];
+                fastLog(softplus.data(), softplus.data(), count);
+            }
+            else
+            {
+                for (int i = 0; i < count; i++)
+                    softplus[i] = std::log1p(g[i]);
+            }
+
+            // Loss: max(z, 0) - z * t + log(1 + e^{-|z|}), gradient: sigmoid(z) - t
+            double loss = 0.0;
+            for (int i = 0; i < count; i++)
+            {
+                loss += ((z[i] > 0.0) ? z[i] : 0.0) - z[i] * t[i] + softplus[i];
+                double sigmoid = ((z[i] >= 0.0) ? 1.0 : g[i]) / (1.0 + g[i]);
+                g[i] = sigmoid - t[i];
+            }
+
+            blockLoss[block] = loss;
+        });
+
+        // Sum the blocks with a fixed tree, so the loss does not depend on the thread schedule
+        double loss = sumElementsSerial(blockLoss.data(), blockLoss.size(), m_summation);
+
+        return loss / getBatchSize(logits);
     }
-}
\ No newline at end of file
+}
@@ -21,6 +21,13 @@ namespace nn
     class BinaryCrossEntropy : public Loss
     {
     public:
+        /**
+         * @brief Constructs the loss.
+         *
+         * @param policy Implementation of log used by computeLoss (default: STANDARD_MATH).
+         */
+        BinaryCrossEntropy(const e_mathPolicy policy = STANDARD_MATH) { m_mathPolicy = policy; }
+
         /**
          * @brief Computes the loss between predictions and targets using BCE formula.
          *
@@ -38,6 +45,20 @@ namespace nn
          * @return The gradient of the loss.
          */
         Matrix computeGradient(const Matrix &predictions, const Matrix &targets) override;
+
+        /**
+         * @brief Computes the loss and its gradient from the logits of a Sigmoid output layer.
+         *
+         * Uses `max(x, 0) - x * t + log(1 + e^{-|x|})`, so the loss stays finite for saturated
+         * outputs. The gradient is `sigmoid(logits) - targets`.
+         *
+         * @param logits Output of the last layer before Sigmoid.
+         * @param targets The target values.
+         * @param gradient Set to the gradient of the loss with respect to the logits.
+         * @return The computed loss.
+         * @throws std::invalid_argument If the dimensions of logits and targets differ.
+         */
+        double computeFromLogits(const Matrix &logits, const Matrix &targets, Matrix &gradient) override;
     };
 }
 
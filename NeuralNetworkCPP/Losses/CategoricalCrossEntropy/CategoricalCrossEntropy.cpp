@@ -5,19 +5,34 @@
  */
 
 #include "CategoricalCrossEntropy.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <vector>
 
 namespace nn
 {
+    // Number of samples (columns) processed by a single task of the fused kernel
+    constexpr int LOGITS_BLOCK_SIZE = 64;
+
     double CategoricalCrossEntropy::computeLoss(const Matrix &predictions, const Matrix &targets)
     {
         if (predictions.getRows() != targets.getRows() || predictions.getCols() != targets.getCols())
             throw std::invalid_argument("Predictions and targets must have the same dimensions.");
 
         // Add small number to avoid log(0)
-        Matrix logPred = predictions.map([this](double x) { return std::log(x + m_epsilon); });
+        double epsilon = m_epsilon;
+
+        if (m_mathPolicy == FAST_MATH)
+        {
+            Matrix logPred = predictions.map([epsilon](double p) { return p + epsilon; });
+            applyInParallel(fastLog, logPred.getDataPtr(), logPred.getDataPtr(), logPred.getSize());
+            return ((targets.cwiseProduct(logPred)).sum(m_summation) * -1) / getBatchSize(targets);
+        }
 
-        return ((targets.cwiseProduct(logPred)).sum() * -1) / targets.getCols();
+        Matrix terms = targets.zipMap(predictions, [epsilon](double t, double p) { return t * std::log(p + epsilon); });
+        return (terms.sum(m_summation) * -1) / getBatchSize(targets);
     }
 
     Matrix CategoricalCrossEntropy::computeGradient(const Matrix &predictions, const Matrix &targets)
@@ -28,4 +43,135 @@ namespace nn
         // return (targets * -1) / (predictions + m_epsilon); // Add small number to avoid division by zero
         return (predictions - targets);
     }
-}
\ No newline at end of file
+
+    double CategoricalCrossEntropy::computeFromLogits(const Matrix &logits, const Matrix &targets, Matrix &gradient)
+    {
+        if (logits.getRows() != targets.getRows() || logits.getCols() != targets.getCols())
+            throw std::invalid_argument("Logits and targets must have the same dimensions.");
+
+        if (m_layout == SAMPLE_MAJOR)
+            return computeFromLogitsSampleMajor(logits, targets, gradient);
+
+        int rows = logits.getRows();
+        int cols = logits.getCols();
+        int numBlocks = (cols + LOGITS_BLOCK_SIZE - 1) / LOGITS_BLOCK_SIZE;
+        gradient = Matrix(rows, cols);
+        std::vector<double> blockLoss(numBlocks, 0.0);
+
+        // Each task handles a block of samples while its logits are in cache
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int start = block * LOGITS_BLOCK_SIZE;
+            int width = std::min(cols, start + LOGITS_BLOCK_SIZE) - start;
+
+            std::vector<double> maxLogit(width, -std::numeric_limits<double>::infinity());
+            std::vector<double> sumExp(width, 0.0);
+            std::vector<double> targetSum(width, 0.0);
+            std::vector<double> targetDot(width, 0.0);
+
+            // Find the maximum logit of each sample
+            for (int i = 0; i < rows; i++)
+            {
+                const double *z = logits.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                for (int j = 0; j < width; j++)
+                    maxLogit[j] = (z[j] > maxLogit[j]) ? z[j] : maxLogit[j];
+            }
+
+            // Shift the logits, accumulate the target terms of the loss and exponentiate
+            for (int i = 0; i < rows; i++)
+            {
+                const double *z = logits.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                const double *t = targets.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                double *g = gradient.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+
+                for (int j = 0; j < width; j++)
+                {
+                    g[j] = z[j] - maxLogit[j];
+                    targetSum[j] += t[j];
+                    targetDot[j] += t[j] * g[j];
+                }
+
+                if (m_mathPolicy == FAST_MATH)
+                    fastExp(g, g, width);
+                else
+                    for (int j = 0; j < width; j++)
+                        g[j] = std::exp(g[j]);
+
+                for (int j = 0; j < width; j++)
+                    sumExp[j] += g[j];
+            }
+
+            // Loss of a sample: sum(t) * log(sum(exp(z - max))) - sum(t * (z - max))
+            for (int j = 0; j < width; j++)
+                blockLoss[block] += targetSum[j] * std::log(sumExp[j]) - targetDot[j];
+
+            // Gradient: softmax(z) * sum(t) - t
+            for (int j = 0; j < width; j++)
+                sumExp[j] = targetSum[j] / sumExp[j];
+
+            for (int i = 0; i < rows; i++)
+            {
+                const double *t = targets.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                double *g = gradient.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                for (int j = 0; j < width; j++)
+                    g[j] = g[j] * sumExp[j] - t[j];
+            }
+        });
+
+        // Sum the blocks with a fixed tree, so the loss does not depend on the thread schedule
+        double loss = sumElementsSerial(blockLoss.data(), blockLoss.size(), m_summation);
+
+        return loss / cols;
+    }
+
+    double CategoricalCrossEntropy::computeFromLogitsSampleMajor(const Matrix &logits, const Matrix &targets, Matrix &gradient)
+    {
+        int rows = logits.getRows();
+        int cols = logits.getCols();
+        gradient = Matrix(rows, cols);
+        std::vector<double> sampleLoss(rows, 0.0);
+
+        // Each sample is a contiguous row, so every pass is a unit-stride loop
+        getGlobalThreadPool().parallelFor(0, rows, [&](int sample) {
+            const double *z = logits.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+            const double *t = targets.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+            double *g = gradient.getDataPtr() + static_cast<std::size_t>(sample) * cols;
+
+            // Find the maximum logit
+            double maxLogit = -std::numeric_limits<double>::infinity();
+            for (int j = 0; j < cols; j++)
+                maxLogit = (z[j] > maxLogit) ? z[j] : maxLogit;
+
+            // Shift the logits, accumulate the target terms of the loss and exponentiate
+            double targetSum = 0.0;
+            double targetDot = 0.0;
+            for (int j = 0; j < cols; j++)
+            {
+                g[j] = z[j] - maxLogit;
+                targetSum += t[j];
+                targetDot += t[j] * g[j];
+            }
+
+            if (m_mathPolicy == FAST_MATH)
+                fastExp(g, g, cols);
+            else
+                for (int j = 0; j < cols; j++)
+                    g[j] = std::exp(g[j]);
+
+            double sumExp = 0.0;
+            for (int j = 0; j < cols; j++)
+                sumExp += g[j];
+
+            // Loss: sum(t) * log(sum(exp(z - max))) - sum(t * (z - max)), gradient: softmax(z) * sum(t) - t
+            sampleLoss[sample] = targetSum * std::log(sumExp) - targetDot;
+
+            double scale = targetSum / sumExp;
+            for (int j = 0; j < cols; j++)
+                g[j] = g[j] * scale - t[j];
+        });
+
+        // Sum the samples with a fixed tree, so the loss does not depend on the thread schedule
+        double loss = sumElementsSerial(sampleLoss.data(), sampleLoss.size(), m_summation);
+
+        return loss / rows;
+    }
+}
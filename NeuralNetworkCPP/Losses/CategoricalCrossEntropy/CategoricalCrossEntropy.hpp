@@ -21,6 +21,13 @@ namespace nn
     class CategoricalCrossEntropy : public Loss
     {
     public:
+        /**
+         * @brief Constructs the loss.
+         *
+         * @param policy Implementation of log used by computeLoss (default: STANDARD_MATH).
+         */
+        CategoricalCrossEntropy(const e_mathPolicy policy = STANDARD_MATH) { m_mathPolicy = policy; }
+
         /**
          * @brief Computes the loss between predictions and targets using CCE formula.
          *
@@ -38,6 +45,31 @@ namespace nn
          * @return The gradient of the loss.
          */
         Matrix computeGradient(const Matrix &predictions, const Matrix &targets) override;
+
+        /**
+         * @brief Computes the loss and its gradient from the logits of a Softmax output layer.
+         *
+         * Uses the log-sum-exp of each sample, so the loss stays finite for saturated outputs.
+         * The gradient is `softmax(logits) - targets` for one-hot targets.
+         *
+         * @param logits Output of the last layer before Softmax.
+         * @param targets The target values.
+         * @param gradient Set to the gradient of the loss with respect to the logits.
+         * @return The computed loss.
+         * @throws std::invalid_argument If the dimensions of logits and targets differ.
+         */
+        double computeFromLogits(const Matrix &logits, const Matrix &targets, Matrix &gradient) override;
+
+    private:
+        /**
+         * @brief Computes the loss and its gradient from sample-major logits, one sample per row.
+         *
+         * @param logits Output of the last layer before Softmax.
+         * @param targets The target values.
+         * @param gradient Set to the gradient of the loss with respect to the logits.
+         * @return The computed loss.
+         */
+        double computeFromLogitsSampleMajor(const Matrix &logits, const Matrix &targets, Matrix &gradient);
     };
 }
 
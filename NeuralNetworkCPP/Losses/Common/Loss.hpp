@@ -8,6 +8,8 @@
 #define LOSS_HPP
 
 #include "../../Matrix/Matrix.hpp"
+#include "../../FastMath/FastMath.hpp"
+#include <stdexcept>
 
 namespace nn
 {
@@ -20,7 +22,13 @@ namespace nn
     class Loss
     {
     protected:
-        double m_epsilon = 1e-15; ///< Small number for numerical stability
+        double m_epsilon = 1e-15;                  ///< Small number for numerical stability
+        e_mathPolicy m_mathPolicy = STANDARD_MATH; ///< Implementation of log used by the loss.
+        e_layout m_layout = FEATURE_MAJOR;         ///< Layout of the samples in the predictions and targets.
+        e_summation m_summation = PAIRWISE_SUMMATION; ///< Summation algorithm of the loss terms.
+
+        /** @brief Returns the number of samples of a batch in the layout of the loss. */
+        int getBatchSize(const Matrix &batch) const { return (m_layout == SAMPLE_MAJOR) ? batch.getRows() : batch.getCols(); }
 
     public:
         /**
@@ -40,6 +48,53 @@ namespace nn
          * @return The gradient of the loss.
          */
         virtual Matrix computeGradient(const Matrix &predictions, const Matrix &targets) = 0;
+
+        /**
+         * @brief Computes the loss and its gradient in one pass over the logits of the output activation.
+         *
+         * Fuses the activation that naturally precedes the loss into it, so the output layer
+         * skips its activation and the backward pass starts from the gradient of the logits.
+         *
+         * @param logits Output of the last layer before its activation.
+         * @param targets The target values.
+         * @param gradient Set to the gradient of the loss with respect to the logits.
+         * @return The computed loss.
+         * @throws std::logic_error If the loss has no fused output head.
+         */
+        virtual double computeFromLogits(
+            [[maybe_unused]] const Matrix &logits,
+            [[maybe_unused]] const Matrix &targets,
+            [[maybe_unused]] Matrix &gradient
+        )
+        {
+            throw std::logic_error("Loss has no fused output head.");
+        }
+
+        /**
+         * @brief Returns whether the gradient is averaged over the samples of the batch.
+         *
+         * Used to weight micro-batch gradients when they are accumulated into a single update.
+         *
+         * @return True if the gradient is divided by the batch size, false if it is summed.
+         */
+        virtual bool isGradientAveraged() const { return false; }
+
+        /**
+         * @brief Sets the layout of the samples in the predictions and targets.
+         *
+         * @param layout FEATURE_MAJOR or SAMPLE_MAJOR.
+         */
+        void setLayout(const e_layout layout) { m_layout = layout; }
+
+        /**
+         * @brief Selects how the terms of the loss are summed.
+         *
+         * KAHAN_SUMMATION keeps the loss of very large batches accurate to the last bits, at several
+         * times the cost of the default pairwise summation (still small next to the loss terms).
+         *
+         * @param summation PAIRWISE_SUMMATION or KAHAN_SUMMATION.
+         */
+        void setSummation(const e_summation summation) { m_summation = summation; }
     };
 }
 
@@ -14,11 +14,9 @@ namespace nn
         if (predictions.getRows() != targets.getRows() || predictions.getCols() != targets.getCols())
             throw std::invalid_argument("Predictions and targets must have the same dimensions.");
 
-        Matrix error = (targets - predictions).map([](double x) { 
-            return x * x; 
-        });
+        Matrix error = targets.zipMap(predictions, [](double t, double p) { return (t - p) * (t - p); });
 
-        return error.sum() / error.getCols();
+        return error.sum(m_summation) / getBatchSize(error);
     }
 
     Matrix MeanSquaredError::computeGradient(const Matrix &predictions, const Matrix &targets)
@@ -38,6 +38,13 @@ namespace nn
          * @return The gradient of the loss.
          */
         Matrix computeGradient(const Matrix &predictions, const Matrix &targets) override;
+
+        /**
+         * @brief Returns whether the gradient is averaged over the samples of the batch.
+         *
+         * @return Always true, MSE gradient is divided by the number of elements.
+         */
+        bool isGradientAveraged() const override { return true; }
     };
 }
 
@@ -6,31 +6,36 @@
 
 #include "ColWiseProxy.hpp"
 #include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
 #include <limits>
 
 namespace nn
 {
+    // Number of columns reduced by one task, a segment of a row is a few cache lines
+    constexpr int COLWISE_BLOCK_SIZE = 256;
+
     ColWiseProxy::ColWiseProxy(const Matrix &matrix)
         : m_matrix(matrix) {}
     
     Matrix ColWiseProxy::maxCoeff() const
     {
-        Matrix result(1, m_matrix.getCols(), 0.0);
-        auto &pool = getGlobalThreadPool();
-
-        // Iterate over each column
-        pool.parallelFor(0, m_matrix.getCols(), [this, &result](int col) {
-            double maxVal = std::numeric_limits<double>::lowest();
-
-            // Iterate over each row in the current column
-            for (int row = 0; row < m_matrix.getRows(); row++)
+        int rows = m_matrix.getRows();
+        int cols = m_matrix.getCols();
+        Matrix result(1, cols, std::numeric_limits<double>::lowest());
+        int numBlocks = (cols + COLWISE_BLOCK_SIZE - 1) / COLWISE_BLOCK_SIZE;
+
+        // Each task streams the rows over its block of columns, so every load is contiguous
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int start = block * COLWISE_BLOCK_SIZE;
+            int width = std::min(cols - start, COLWISE_BLOCK_SIZE);
+            double *maxima = result.getDataPtr() + start;
+
+            for (int i = 0; i < rows; i++)
             {
-                if (m_matrix[{row, col}] > maxVal)
-                    maxVal = m_matrix[{row, col}];
+                const double *row = m_matrix.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                for (int j = 0; j < width; j++)
+                    maxima[j] = (row[j] > maxima[j]) ? row[j] : maxima[j];
             }
-            
-            // Store the max value in the result row vector
-            result[{0, col}] = maxVal;
         });
 
         return result;
@@ -38,13 +43,23 @@ namespace nn
 
     Matrix ColWiseProxy::sum() const
     {
-        Matrix result(1, m_matrix.getCols(), 0.0);
-        auto &pool = getGlobalThreadPool();
-
-        // Parallelize the column-wise addition
-        pool.parallelFor(0, m_matrix.getCols(), [this, &result](int i) {
-            for (int j = 0; j < m_matrix.getRows(); j++)
-                result[{0, i}] += m_matrix[{j, i}];
+        int rows = m_matrix.getRows();
+        int cols = m_matrix.getCols();
+        Matrix result(1, cols, 0.0);
+        int numBlocks = (cols + COLWISE_BLOCK_SIZE - 1) / COLWISE_BLOCK_SIZE;
+
+        // Each task streams the rows over its block of columns, every column is summed in row order
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int start = block * COLWISE_BLOCK_SIZE;
+            int width = std::min(cols - start, COLWISE_BLOCK_SIZE);
+            double *sums = result.getDataPtr() + start;
+
+            for (int i = 0; i < rows; i++)
+            {
+                const double *row = m_matrix.getDataPtr() + static_cast<std::size_t>(i) * cols + start;
+                for (int j = 0; j < width; j++)
+                    sums[j] += row[j];
+            }
         });
 
         return result;
@@ -44,6 +44,8 @@ namespace nn
         /**
          * @brief Sums elements in each column.
          *
+         * The rows are streamed contiguously over blocks of columns, each column is summed in row order.
+         *
          * @return Row matrix with summed up columns.
          */
         Matrix sum() const;
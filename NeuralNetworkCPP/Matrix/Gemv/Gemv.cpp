@@ -0,0 +1,85 @@
+/**
+ * C++ neural network library
+ *
+ * Gemv.cpp
+ */
+
+#include "Gemv.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+
+namespace nn
+{
+    // Independent accumulators of a row, one AVX-256 register or two SSE registers
+    constexpr int GEMV_LANES = 4;
+
+    // Number of rows sharing the loads of the vector
+    constexpr int GEMV_ROW_GROUP = 4;
+
+    // Sums the lanes of an accumulator in a fixed order
+    static inline double sumLanes(const double *lanes)
+    {
+        return (lanes[0] + lanes[2]) + (lanes[1] + lanes[3]);
+    }
+
+    // Computes rows [first, last) of the product
+    static void multiplyRows(const double *matrix, const int first, const int last, const int cols, const double *vector, const double *bias, double *result)
+    {
+        int vectorCols = cols / GEMV_LANES * GEMV_LANES;
+        int row = first;
+
+        for (; row + GEMV_ROW_GROUP <= last; row += GEMV_ROW_GROUP)
+        {
+            const double *m = matrix + static_cast<std::size_t>(row) * cols;
+            double lanes[GEMV_ROW_GROUP][GEMV_LANES] = {};
+
+            // Each chunk of the vector is loaded once for the four rows
+            int k = 0;
+            for (; k < vectorCols; k += GEMV_LANES)
+                for (int r = 0; r < GEMV_ROW_GROUP; r++)
+                    for (int lane = 0; lane < GEMV_LANES; lane++)
+                        lanes[r][lane] += m[r * cols + k + lane] * vector[k + lane];
+
+            for (int r = 0; r < GEMV_ROW_GROUP; r++)
+            {
+                double sum = sumLanes(lanes[r]);
+                for (int j = k; j < cols; j++)
+                    sum += m[r * cols + j] * vector[j];
+                result[row + r] = bias ? sum + bias[row + r] : sum;
+            }
+        }
+
+        // Remaining rows one at a time
+        for (; row < last; row++)
+        {
+            const double *m = matrix + static_cast<std::size_t>(row) * cols;
+            double lanes[GEMV_LANES] = {};
+
+            int k = 0;
+            for (; k < vectorCols; k += GEMV_LANES)
+                for (int lane = 0; lane < GEMV_LANES; lane++)
+                    lanes[lane] += m[k + lane] * vector[k + lane];
+
+            double sum = sumLanes(lanes);
+            for (; k < cols; k++)
+                sum += m[k] * vector[k];
+            result[row] = bias ? sum + bias[row] : sum;
+        }
+    }
+
+    void multiplyVector(const double *matrix, const int rows, const int cols, const double *vector, const double *bias, double *result)
+    {
+        // Small products are not worth waking up the pool
+        if (static_cast<std::size_t>(rows) * cols < GEMV_PARALLEL_THRESHOLD)
+        {
+            multiplyRows(matrix, 0, rows, cols, vector, bias, result);
+            return;
+        }
+
+        int numBlocks = (rows + GEMV_BLOCK_ROWS - 1) / GEMV_BLOCK_ROWS;
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            int first = block * GEMV_BLOCK_ROWS;
+            multiplyRows(matrix, first, std::min(rows, first + GEMV_BLOCK_ROWS), cols, vector, bias, result);
+        });
+    }
+}
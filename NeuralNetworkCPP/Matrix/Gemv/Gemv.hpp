@@ -0,0 +1,38 @@
+/**
+ * C++ neural network library
+ *
+ * Gemv.hpp
+ */
+
+#ifndef GEMV_HPP
+#define GEMV_HPP
+
+#include <cstddef>
+
+namespace nn
+{
+    /// Number of multiply-adds from which a matrix-vector product is split between the threads of the pool.
+    constexpr std::size_t GEMV_PARALLEL_THRESHOLD = 1 << 17;
+
+    /// Number of matrix rows computed by one task of a parallel matrix-vector product.
+    constexpr int GEMV_BLOCK_ROWS = 64;
+
+    /**
+     * @brief Multiplies a row-major matrix by a vector and adds a bias, the kernel of single-sample inference.
+     *
+     * Four rows share every load of the vector and each row is accumulated in independent lanes,
+     * so the inner loop vectorises. Products of at least `GEMV_PARALLEL_THRESHOLD` multiply-adds
+     * are split into blocks of `GEMV_BLOCK_ROWS` rows between the threads of the pool, smaller
+     * ones run on the calling thread without any synchronisation.
+     *
+     * @param matrix Address of element (0, 0) of the matrix, rows are `cols` elements apart.
+     * @param rows Number of rows of the matrix and elements of the result.
+     * @param cols Number of columns of the matrix and elements of the vector.
+     * @param vector Address of the vector.
+     * @param bias Address of the bias added to the result, nullptr for none.
+     * @param result Address of the result, must not overlap the other arrays.
+     */
+    void multiplyVector(const double *matrix, const int rows, const int cols, const double *vector, const double *bias, double *result);
+}
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * C++ neural network library
+ *
+ * HalfMatrix.cpp
+ */
+
+#include "HalfMatrix.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <bit>
+#include <stdexcept>
+
+#if defined(__AVX512BF16__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace nn
+{
+    std::uint16_t toBFloat16(const float value)
+    {
+        std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+
+        // Keep NaN a quiet NaN instead of rounding it to infinity
+        if ((bits & 0x7FFFFFFF) > 0x7F800000)
+            return static_cast<std::uint16_t>((bits >> 16) | 0x0040);
+
+        // Round to nearest even on the 16 dropped bits
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        return static_cast<std::uint16_t>(bits >> 16);
+    }
+
+    float fromBFloat16(const std::uint16_t value)
+    {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(value) << 16);
+    }
+
+    std::uint16_t toFloat16(const float value)
+    {
+        std::uint32_t bits = std::bit_cast<std::uint32_t>(value);
+        std::uint32_t sign = (bits >> 16) & 0x8000;
+        std::uint32_t exponent = (bits >> 23) & 0xFF;
+        std::uint32_t mantissa = bits & 0x7FFFFF;
+
+        // Infinity and NaN
+        if (exponent == 0xFF)
+            return static_cast<std::uint16_t>(sign | 0x7C00 | (mantissa ? 0x0200 : 0));
+
+        int halfExponent = static_cast<int>(exponent) - 127 + 15;
+
+        // Too large for half precision
+        if (halfExponent >= 31)
+            return static_cast<std::uint16_t>(sign | 0x7C00);
+
+        // Subnormal half precision values, or zero if even the smallest one is too large
+        if (halfExponent <= 0)
+        {
+            if (halfExponent < -10)
+                return static_cast<std::uint16_t>(sign);
+
+            mantissa |= 0x800000;
+            int shift = 14 - halfExponent;
+            std::uint32_t half = mantissa >> shift;
+            std::uint32_t remainder = mantissa & ((1u << shift) - 1);
+            std::uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (half & 1)))
+                half++;
+            return static_cast<std::uint16_t>(sign | half);
+        }
+
+        // Normal values, a carry out of the mantissa correctly rounds up the exponent
+        std::uint32_t half = (static_cast<std::uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+        std::uint32_t remainder = mantissa & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            half++;
+        return static_cast<std::uint16_t>(sign | half);
+    }
+
+    float fromFloat16(const std::uint16_t value)
+    {
+        std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000) << 16;
+        std::uint32_t exponent = (value >> 10) & 0x1F;
+        std::uint32_t mantissa = value & 0x3FF;
+
+        // Zero and subnormal values (mantissa * 2^-24)
+        if (exponent == 0)
+        {
+            float magnitude = static_cast<float>(mantissa) * 5.9604644775390625e-8f;
+            return sign ? -magnitude : magnitude;
+        }
+
+        // Infinity and NaN
+        if (exponent == 0x1F)
+            return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+
+        return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+    }
+
+    HalfMatrix::HalfMatrix() : m_rows(0), m_cols(0), m_precision(BFLOAT16) {}
+
+    HalfMatrix::HalfMatrix(const Matrix &matrix, const e_precision precision, const bool transpose)
+        : m_precision(precision)
+    {
+        if (precision != BFLOAT16 && precision != FLOAT16)
+            throw std::invalid_argument("HalfMatrix requires a 16-bit precision.");
+
+        m_rows = transpose ? matrix.getCols() : matrix.getRows();
+        m_cols = transpose ? matrix.getRows() : matrix.getCols();
+        m_data.resize(m_rows * m_cols);
+
+        const double *source = matrix.getDataPtr();
+        int sourceCols = matrix.getCols();
+        auto &pool = getGlobalThreadPool();
+
+        // Round every element, reading the source column-wise when transposing
+        pool.parallelFor(0, m_rows, [this, source, sourceCols, transpose](int i) {
+            std::uint16_t *row = m_data.data() + i * m_cols;
+            for (int j = 0; j < m_cols; j++)
+            {
+                float value = static_cast<float>(transpose ? source[j * sourceCols + i] : source[i * sourceCols + j]);
+                row[j] = (m_precision == BFLOAT16) ? toBFloat16(value) : toFloat16(value);
+            }
+        });
+    }
+
+    Matrix HalfMatrix::toMatrix() const
+    {
+        Matrix result(m_rows, m_cols);
+        double *target = result.getDataPtr();
+
+        // Widen every element
+        for (int i = 0; i < m_rows * m_cols; i++)
+            target[i] = (m_precision == BFLOAT16) ? fromBFloat16(m_data[i]) : fromFloat16(m_data[i]);
+
+        return result;
+    }
+
+    HalfMatrix HalfMatrix::transpose() const
+    {
+        HalfMatrix result;
+        result.m_rows = m_cols;
+        result.m_cols = m_rows;
+        result.m_precision = m_precision;
+        result.m_data.resize(m_data.size());
+
+        // Copy the bit patterns to their transposed positions
+        for (int i = 0; i < m_rows; i++)
+        {
+            for (int j = 0; j < m_cols; j++)
+                result.m_data[j * m_rows + i] = m_data[i * m_cols + j];
+        }
+
+        return result;
+    }
+
+    // Dot product of two bfloat16 vectors with float accumulation
+    static float dotBFloat16(const std::uint16_t *a, const std::uint16_t *b, const int count)
+    {
+        float sum = 0.0f;
+        int k = 0;
+
+#ifdef __AVX512BF16__
+        // 32 products per instruction, accumulated pairwise into 16 float lanes
+        __m512 acc = _mm512_setzero_ps();
+        for (; k + 32 <= count; k += 32)
+        {
+            __m512bh va = (__m512bh)_mm512_loadu_si512(a + k);
+            __m512bh vb = (__m512bh)_mm512_loadu_si512(b + k);
+            acc = _mm512_dpbf16_ps(acc, va, vb);
+        }
+        sum = _mm512_reduce_add_ps(acc);
+#endif
+
+        // Eight partial sums, so the fallback loop vectorises without reassociating the sum
+        float partial[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        for (; k + 8 <= count; k += 8)
+            for (int lane = 0; lane < 8; lane++)
+                partial[lane] += fromBFloat16(a[k + lane]) * fromBFloat16(b[k + lane]);
+        sum += ((partial[0] + partial[1]) + (partial[2] + partial[3])) + ((partial[4] + partial[5]) + (partial[6] + partial[7]));
+
+        for (; k < count; k++)
+            sum += fromBFloat16(a[k]) * fromBFloat16(b[k]);
+
+        return sum;
+    }
+
+    // Dot product of two half precision vectors with float accumulation
+    static float dotFloat16(const std::uint16_t *a, const std::uint16_t *b, const int count)
+    {
+        float sum = 0.0f;
+        int k = 0;
+
+#ifdef __F16C__
+        // Hardware conversion of 8 elements at a time
+        __m256 acc = _mm256_setzero_ps();
+        for (; k + 8 <= count; k += 8)
+        {
+            __m256 va = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + k)));
+            __m256 vb = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + k)));
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(va, vb));
+        }
+        __m128 low = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        low = _mm_hadd_ps(low, low);
+        low = _mm_hadd_ps(low, low);
+        sum = _mm_cvtss_f32(low);
+#endif
+
+        // Software conversion of the remaining elements
+        for (; k < count; k++)
+            sum += fromFloat16(a[k]) * fromFloat16(b[k]);
+
+        return sum;
+    }
+
+    Matrix multiplyTransposed(const HalfMatrix &left, const HalfMatrix &rightTransposed)
+    {
+        // Validate that the matrices have compatible dimensions and formats.
+        if (left.m_cols != rightTransposed.m_cols)
+            throw std::invalid_argument("Invalid matrix multiplication: A(m x k) * B^T(n x k) requires matching k.");
+        if (left.m_precision != rightTransposed.m_precision)
+            throw std::invalid_argument("Both operands must have the same precision.");
+
+        Matrix result(left.m_rows, rightTransposed.m_rows);
+        double *target = result.getDataPtr();
+        int inner = left.m_cols;
+        int cols = rightTransposed.m_rows;
+        bool isBFloat16 = (left.m_precision == BFLOAT16);
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize over the rows of the result, each element is a contiguous dot product
+        pool.parallelFor(0, left.m_rows, [&left, &rightTransposed, target, inner, cols, isBFloat16](int i) {
+            const std::uint16_t *a = left.m_data.data() + i * inner;
+            for (int j = 0; j < cols; j++)
+            {
+                const std::uint16_t *b = rightTransposed.m_data.data() + j * inner;
+                target[i * cols + j] = isBFloat16 ? dotBFloat16(a, b, inner) : dotFloat16(a, b, inner);
+            }
+        });
+
+        return result;
+    }
+}
@@ -0,0 +1,137 @@
+/**
+ * C++ neural network library
+ *
+ * HalfMatrix.hpp
+ */
+
+#ifndef HALFMATRIX_HPP
+#define HALFMATRIX_HPP
+
+#include "../Matrix.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace nn
+{
+    /**
+     * @brief Enum with available storage precisions.
+     */
+    enum e_precision { FLOAT64, BFLOAT16, FLOAT16 };
+
+    /**
+     * @brief Converts a float to bfloat16 (round to nearest even).
+     *
+     * @param value The value to convert.
+     * @return The bfloat16 bit pattern.
+     */
+    std::uint16_t toBFloat16(const float value);
+
+    /**
+     * @brief Converts a bfloat16 bit pattern to float.
+     *
+     * @param value The bfloat16 bit pattern.
+     * @return The converted value.
+     */
+    float fromBFloat16(const std::uint16_t value);
+
+    /**
+     * @brief Converts a float to IEEE half precision (round to nearest even, overflows to infinity).
+     *
+     * @param value The value to convert.
+     * @return The half precision bit pattern.
+     */
+    std::uint16_t toFloat16(const float value);
+
+    /**
+     * @brief Converts an IEEE half precision bit pattern to float.
+     *
+     * @param value The half precision bit pattern.
+     * @return The converted value.
+     */
+    float fromFloat16(const std::uint16_t value);
+
+    /**
+     * @class HalfMatrix
+     * @brief Row-major matrix stored with 16 bits per element (bfloat16 or half precision).
+     *
+     * Used for the copies of weights and activations of mixed-precision layers, it halves the
+     * memory traffic compared to a float and quarters it compared to a Matrix. Products are
+     * accumulated in float and returned as a Matrix.
+     */
+    class HalfMatrix
+    {
+    private:
+        int m_rows;                        ///< Number of rows in the matrix.
+        int m_cols;                        ///< Number of columns in the matrix.
+        e_precision m_precision;           ///< Format of the elements (BFLOAT16 or FLOAT16).
+        std::vector<std::uint16_t> m_data; ///< Bit patterns of the elements.
+
+    public:
+        /**
+         * @brief Constructs an empty matrix.
+         */
+        HalfMatrix();
+
+        /**
+         * @brief Rounds a matrix to 16-bit precision.
+         *
+         * @param matrix The matrix to convert.
+         * @param precision Format of the elements (BFLOAT16 or FLOAT16).
+         * @param transpose If true, the transpose of the matrix is stored.
+         * @throws std::invalid_argument If the precision is not a 16-bit format.
+         */
+        HalfMatrix(const Matrix &matrix, const e_precision precision, const bool transpose = false);
+
+        /**
+         * @brief Converts the matrix back to double precision.
+         *
+         * @return The converted matrix.
+         */
+        Matrix toMatrix() const;
+
+        /**
+         * @brief Returns the transpose of the matrix.
+         *
+         * @return The transposed matrix.
+         */
+        HalfMatrix transpose() const;
+
+        /**
+         * @brief Returns the number of rows.
+         *
+         * @return The number of rows.
+         */
+        int getRows() const { return m_rows; }
+
+        /**
+         * @brief Returns the number of columns.
+         *
+         * @return The number of columns.
+         */
+        int getCols() const { return m_cols; }
+
+        /**
+         * @brief Returns the format of the elements.
+         *
+         * @return The precision of the matrix.
+         */
+        e_precision getPrecision() const { return m_precision; }
+
+        /**
+         * @brief Computes `left * rightTransposed^T` with float accumulation.
+         *
+         * Both operands are read along their rows, so every output element is a contiguous dot
+         * product. On CPUs with AVX-512 BF16 the bfloat16 dot products use `vdpbf16ps`.
+         *
+         * @param left Left operand (m x k).
+         * @param rightTransposed Transpose of the right operand (n x k).
+         * @return The product (m x n).
+         * @throws std::invalid_argument If the dimensions or precisions do not match.
+         */
+        friend Matrix multiplyTransposed(const HalfMatrix &left, const HalfMatrix &rightTransposed);
+    };
+
+    Matrix multiplyTransposed(const HalfMatrix &left, const HalfMatrix &rightTransposed);
+}
+
+#endif
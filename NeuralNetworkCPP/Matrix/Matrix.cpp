@@ -6,34 +6,74 @@
 
 #include "Matrix.hpp"
 #include "../GlobalThreadPool/GlobalThreadPool.hpp"
+#include "Transpose/Transpose.hpp"
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <limits>
 #include <numeric>
 
 namespace nn
 {
+    // Counters of buffer allocations and copies, only updated when built with NN_COUNT_ALLOCATIONS
+    static std::atomic<std::size_t> allocationCount{0};
+    static std::atomic<std::size_t> allocatedByteCount{0};
+    static std::atomic<std::size_t> copyCount{0};
+    static std::atomic<std::size_t> copiedByteCount{0};
+
+    static inline void countAllocation([[maybe_unused]] const MatrixStorage &data, [[maybe_unused]] const bool isCopy)
+    {
+#ifdef NN_COUNT_ALLOCATIONS
+        std::size_t numElements = data.size();
+        if (!data.isInline())
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            allocatedByteCount.fetch_add(numElements * sizeof(double), std::memory_order_relaxed);
+        }
+        if (isCopy)
+        {
+            copyCount.fetch_add(1, std::memory_order_relaxed);
+            copiedByteCount.fetch_add(numElements * sizeof(double), std::memory_order_relaxed);
+        }
+#endif
+    }
+
     Matrix::Matrix()
-        : m_rows(0), m_cols(0), m_data({}) {}
+        : m_rows(0), m_cols(0) {}
 
     Matrix::Matrix(const Matrix &matrix)
-        : m_rows(matrix.m_rows), m_cols(matrix.m_cols), m_data(matrix.m_data) {}
+        : m_rows(matrix.m_rows), m_cols(matrix.m_cols), m_data(matrix.m_data)
+    {
+        countAllocation(m_data, true);
+    }
 
-    Matrix::Matrix(Matrix &&matrix)
-        : m_rows(matrix.m_rows), m_cols(matrix.m_cols), m_data(std::move(matrix.m_data)) {}
+    Matrix::Matrix(Matrix &&matrix) noexcept
+        : m_rows(matrix.m_rows), m_cols(matrix.m_cols), m_data(std::move(matrix.m_data))
+    {
+        matrix.m_rows = 0;
+        matrix.m_cols = 0;
+    }
 
     Matrix::Matrix(const int rows, const int cols, double initVal)
-        : m_rows(rows), m_cols(cols), m_data(rows * cols, initVal) {}
+        : m_rows(rows), m_cols(cols), m_data(rows * cols, initVal)
+    {
+        countAllocation(m_data, false);
+    }
 
     Matrix::Matrix(const int rows, const int cols, const std::vector<double> &data)
-        : m_rows(rows), m_cols(cols), m_data(data)
+        : m_rows(rows), m_cols(cols), m_data(data.begin(), data.end())
     {
         if (data.size() != rows * cols)
             throw std::invalid_argument("Data size does not match matrix dimensions.");
+
+        countAllocation(m_data, false);
     }
 
     Matrix::Matrix(const std::vector<std::vector<double>> &data)
         : m_rows(data.size()), m_cols(data[0].size()), m_data(data.size() * data[0].size(), 0.0)
     {
+        countAllocation(m_data, false);
+
         // Use the global thread pool to parallelize the initialization.
         auto &pool = getGlobalThreadPool();
 
@@ -46,18 +86,29 @@ namespace nn
     Matrix::Matrix(const int rows, const int cols, std::function<double()> func)
         : m_rows(rows), m_cols(cols), m_data(rows * cols)
     {
-        // Use the global thread pool to parallelize the initialization.
-        auto &pool = getGlobalThreadPool();
+        countAllocation(m_data, false);
+
+        // Call the generator in element order on this thread, it may keep state between calls
+        std::generate(m_data.begin(), m_data.end(), func);
+    }
 
-        pool.parallelFor(0, rows * cols, [this, &func](int i) {
-            m_data[i] = func();
+    Matrix::Matrix(const int rows, const int cols, std::function<double(std::size_t)> func)
+        : m_rows(rows), m_cols(cols), m_data(rows * cols)
+    {
+        countAllocation(m_data, false);
+
+        // Fill whole rows per task, every element only depends on its own index
+        getGlobalThreadPool().parallelFor(0, rows, [this, &func](int row) {
+            std::size_t start = static_cast<std::size_t>(row) * m_cols;
+            for (int col = 0; col < m_cols; col++)
+                m_data[start + col] = func(start + col);
         });
     }
 
-    Matrix::Matrix(std::ifstream &file)
+    Matrix::Matrix(std::istream &file)
     {
-        // Check if the file is open and readable
-        if (!file.is_open())
+        // Check if the stream is readable
+        if (!file.good())
             throw std::runtime_error("File is not open for reading");
 
         // Read the number of rows and columns from the file
@@ -65,11 +116,11 @@ namespace nn
         file.read(reinterpret_cast<char *>(&m_cols), sizeof(m_cols));
 
         // Check if the dimensions are valid
-        if (m_rows <= 0 || m_cols <= 0)
+        if (!file.good() || m_rows <= 0 || m_cols <= 0)
             throw std::runtime_error("Invalid matrix dimensions in file.");
 
         // Allocate temporary storage for the matrix data
-        std::vector<double> temp(m_rows * m_cols);
+        MatrixStorage temp(m_rows * m_cols);
 
         // Read the matrix data from the file
         file.read(reinterpret_cast<char *>(temp.data()), sizeof(double) * m_rows * m_cols);
@@ -80,6 +131,17 @@ namespace nn
 
         // Move the data into the member variable
         m_data = std::move(temp);
+        countAllocation(m_data, false);
+    }
+
+    void Matrix::setMemoryConfig(const MemoryConfig &config)
+    {
+        if (getMemoryConfig() == config)
+            return;
+
+        // Copy the elements into a buffer with the new configuration, the assignment takes over the configuration as well
+        MatrixStorage data(m_data.begin(), m_data.end(), config);
+        m_data = std::move(data);
     }
 
     double &Matrix::operator[](const std::pair<int, int> &index)
@@ -102,10 +164,10 @@ namespace nn
         return m_data[row * m_cols + col];
     }
 
-    void Matrix::save(std::ofstream &file) const
+    void Matrix::save(std::ostream &file) const
     {
-        // Check if the file is open and writable
-        if (!file.is_open())
+        // Check if the stream is writable
+        if (!file.good())
             throw std::runtime_error("File is not open for writing.");
         
         // Write the number of rows and columns to the file
@@ -122,22 +184,12 @@ namespace nn
 
     double Matrix::maxCoeff() const
     {
-        // Initialize maximum value to the smallest possible double
-        double maxVal =std::numeric_limits<double>::lowest();
-
-        // Find the max value
-        for (int i = 0; i < m_rows * m_cols; i++)
-        {
-            if (m_data[i] > maxVal)
-                maxVal = m_data[i];
-        }
-
-        return maxVal;
+        return maxElement(m_data.data(), m_data.size());
     }
 
-    double Matrix::sum() const
+    double Matrix::sum(const e_summation summation) const
     {
-        return std::accumulate(m_data.begin(), m_data.end(), 0.0);
+        return sumElements(m_data.data(), m_data.size(), summation);
     }
 
     RowWiseProxy Matrix::rowWise()
@@ -177,31 +229,43 @@ namespace nn
         return result;
     }
 
-    Matrix Matrix::transpose()
+    Matrix Matrix::transpose() const
     {
-        Matrix result(m_cols, m_rows, 0.0);
-        auto &pool = getGlobalThreadPool();
+        Matrix result(m_cols, m_rows);
 
-        // Parallelize the transposition.
-        pool.parallelFor(0, m_rows, [this, &result](int i) {
-            for (int j = 0; j < m_cols; j++)
-                result[{j, i}] = (*this)[{i, j}];
-        });
+        // Transpose tile by tile, so reads and writes stay within a few cache lines and pages
+        transposeElements(m_data.data(), m_rows, m_cols, m_cols, result.m_data.data(), m_rows);
 
         return result;
     }
 
-    Matrix Matrix::map(std::function<double(double)> func) const
+    void Matrix::transposeInPlace()
     {
-        Matrix result(m_rows, m_cols, 0.0);
-        auto &pool = getGlobalThreadPool();
+        if (m_rows != m_cols)
+        {
+            *this = transpose();
+            return;
+        }
 
-        // Parallelize the mapping operation.
-        pool.parallelFor(0, m_rows * m_cols, [this, &result, &func](int i) {
-            result.m_data[i] = func(m_data[i]);
-        });
+        transposeElementsInPlace(m_data.data(), m_rows);
+    }
 
-        return result;
+    MatrixAllocationStats Matrix::getAllocationStats()
+    {
+        MatrixAllocationStats stats;
+        stats.allocations = allocationCount.load(std::memory_order_relaxed);
+        stats.allocatedBytes = allocatedByteCount.load(std::memory_order_relaxed);
+        stats.copies = copyCount.load(std::memory_order_relaxed);
+        stats.copiedBytes = copiedByteCount.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void Matrix::resetAllocationStats()
+    {
+        allocationCount.store(0, std::memory_order_relaxed);
+        allocatedByteCount.store(0, std::memory_order_relaxed);
+        copyCount.store(0, std::memory_order_relaxed);
+        copiedByteCount.store(0, std::memory_order_relaxed);
     }
 
     Matrix Matrix::identity(int size)
@@ -230,6 +294,23 @@ namespace nn
         m_rows = other.m_rows;
         m_cols = other.m_cols;
         m_data = other.m_data;
+        countAllocation(m_data, true);
+
+        return *this;
+    }
+
+    Matrix &Matrix::operator=(Matrix &&other) noexcept
+    {
+        // Check for self-assignment.
+        if (this == &other)
+            return *this;
+
+        // Take over the buffer and leave the other matrix empty.
+        m_rows = other.m_rows;
+        m_cols = other.m_cols;
+        m_data = std::move(other.m_data);
+        other.m_rows = 0;
+        other.m_cols = 0;
 
         return *this;
     }
@@ -391,32 +472,12 @@ namespace nn
 
     Matrix operator*(const Matrix &left, const Matrix &right)
     {
-        // Validate that the matrices have compatible dimensions.
-        if (left.m_cols != right.m_rows)
-            throw std::invalid_argument("Invalid matrix multiplication: A(m x k) * B(k x n) requires A.cols == B.rows.");
-        
-        Matrix result(left.m_rows, right.m_cols, 0.0);
-        auto &pool = getGlobalThreadPool();
-
-        // Parallelize the multiplication.
-        pool.parallelFor(0, left.m_rows, [&result, &left, &right](int i) {
-            for (int j = 0; j < right.m_cols; j++)
-            {
-                double sum = 0.0;
-                for (int k = 0; k < left.m_cols; k++)
-                    sum += left[{i, k}] * right[{k, j}];
-                result[{i, j}] = sum;
-            }
-        });
-
-        return result;
+        return multiply(left, right);
     }
 
     Matrix operator*(const double scalar, const Matrix &right)
     {
-        Matrix result = right;
-        result *= scalar;
-        return result;
+        return right.map([scalar](double x) { return scalar * x; });
     }
 
     Matrix operator*(const Matrix &left, const double scalar)
@@ -426,16 +487,16 @@ namespace nn
 
     Matrix operator+(const Matrix &left, const Matrix &right)
     {
-        Matrix result = left;
-        result += right;
-        return result;
+        // Validate that the matrices have the same dimensions.
+        if (left.m_rows != right.m_rows || left.m_cols != right.m_cols)
+            throw std::invalid_argument("Matrix dimensions must match for addition.");
+
+        return left.zipMap(right, [](double a, double b) { return a + b; });
     }
 
     Matrix operator+(const double scalar, const Matrix &right)
     {
-        Matrix result = right;
-        result += scalar;
-        return result;
+        return right.map([scalar](double x) { return scalar + x; });
     }
 
     Matrix operator+(const Matrix &left, const double scalar)
@@ -445,29 +506,21 @@ namespace nn
 
     Matrix operator-(const Matrix &left, const Matrix &right)
     {
-        Matrix result = left;
-        result -= right;
-        return result;
+        // Validate that the matrices have the same dimensions.
+        if (left.m_rows != right.m_rows || left.m_cols != right.m_cols)
+            throw std::invalid_argument("Matrix dimensions must match for subtraction.");
+
+        return left.zipMap(right, [](double a, double b) { return a - b; });
     }
 
     Matrix operator-(const Matrix &right, const double scalar)
     {
-        Matrix result = right;
-        result -= scalar;
-        return result;
+        return right.map([scalar](double x) { return x - scalar; });
     }
 
     Matrix operator-(const double scalar, const Matrix &right)
     {
-        Matrix result = right;
-        auto &pool = getGlobalThreadPool();
-
-        // Parallelize the subtraction.
-        pool.parallelFor(0, result.m_rows * result.m_cols, [&result, scalar](int i) {
-            result.m_data[i] = scalar - result.m_data[i];
-        });
-
-        return result;
+        return right.map([scalar](double x) { return scalar - x; });
     }
 
     Matrix operator/(const Matrix &left, const Matrix &right)
@@ -484,6 +537,66 @@ namespace nn
         return result;
     }
 
+    Matrix operator*(const double scalar, Matrix &&right)
+    {
+        right *= scalar;
+        return std::move(right);
+    }
+
+    Matrix operator*(Matrix &&left, const double scalar)
+    {
+        left *= scalar;
+        return std::move(left);
+    }
+
+    Matrix operator+(Matrix &&left, const Matrix &right)
+    {
+        left += right;
+        return std::move(left);
+    }
+
+    Matrix operator+(const double scalar, Matrix &&right)
+    {
+        right += scalar;
+        return std::move(right);
+    }
+
+    Matrix operator+(Matrix &&left, const double scalar)
+    {
+        left += scalar;
+        return std::move(left);
+    }
+
+    Matrix operator-(Matrix &&left, const Matrix &right)
+    {
+        left -= right;
+        return std::move(left);
+    }
+
+    Matrix operator-(Matrix &&left, const double scalar)
+    {
+        left -= scalar;
+        return std::move(left);
+    }
+
+    Matrix operator-(const double scalar, Matrix &&right)
+    {
+        right.mapInPlace([scalar](double x) { return scalar - x; });
+        return std::move(right);
+    }
+
+    Matrix operator/(Matrix &&left, const Matrix &right)
+    {
+        left /= right;
+        return std::move(left);
+    }
+
+    Matrix operator/(Matrix &&left, const double scalar)
+    {
+        left /= scalar;
+        return std::move(left);
+    }
+
     bool operator==(const Matrix &left, const Matrix &right)
     {
         if (left.m_rows != right.m_rows || left.m_cols != right.m_cols)
@@ -7,12 +7,17 @@
 #ifndef MATRIX_HPP
 #define MATRIX_HPP
 
+#include <cstddef>
 #include <vector>
+#include <span>
 #include <functional>
 #include <iostream>
 #include <fstream>
 #include "RowWiseProxy/RowWiseProxy.hpp"
 #include "ColWiseProxy/ColWiseProxy.hpp"
+#include "MatrixStorage/MatrixStorage.hpp"
+#include "MatrixView/MatrixView.hpp"
+#include "Reduction/Reduction.hpp"
 
 namespace nn
 {
@@ -20,20 +25,45 @@ namespace nn
     class ColWiseProxy;
     class RowWiseProxy;
 
+    /**
+     * @brief Matrix buffers allocated and copied since the last reset.
+     *
+     * Only collected when the library is built with NN_COUNT_ALLOCATIONS, otherwise all zero.
+     */
+    struct MatrixAllocationStats
+    {
+        std::size_t allocations = 0;    ///< Heap buffers created by constructors, including copies (inline buffers are not counted).
+        std::size_t allocatedBytes = 0; ///< Bytes of the created heap buffers.
+        std::size_t copies = 0;         ///< Buffers copied by copy construction or copy assignment.
+        std::size_t copiedBytes = 0;    ///< Bytes copied by copy construction or copy assignment.
+    };
+
+    /**
+     * @brief Enum with the ways a batch of samples is laid out in a matrix.
+     *
+     * FEATURE_MAJOR stores each sample as a column (features x batch size). SAMPLE_MAJOR stores each
+     * sample as a contiguous row (batch size x features), the layout of the data passed to a model.
+     */
+    enum e_layout { FEATURE_MAJOR, SAMPLE_MAJOR };
+
     /**
      * @class Matrix
      * @brief Represents a mathematical matrix with element-wise operations.
      *
      * This class provides functionality for matrix operations such as addition,
      * subtraction, multiplication, division, and element-wise operations.
-     * It also supports parallel execution using a global thread pool.
+     * It also supports parallel execution using a global thread pool. The elements are stored
+     * in a buffer aligned to 64 bytes, large buffers can be backed by huge pages (see `MemoryConfig`)
+     * and matrices of up to 32 elements are stored inline without a heap allocation.
      */
     class Matrix
     {
     private:
-        int m_rows;                 ///< Number of rows in the matrix.
-        int m_cols;                 ///< Number of columns in the matrix
-        std::vector<double> m_data; ///< Matrix data stored in a 1D vector
+        int m_rows;           ///< Number of rows in the matrix.
+        int m_cols;           ///< Number of columns in the matrix
+        MatrixStorage m_data; ///< Matrix data stored in a 1D vector
+
+        static constexpr int MAP_CHUNK_SIZE = 4096; ///< Number of elements mapped by a single task.
 
     public:
         /** @brief Default constructor, creates an empty matrix. */
@@ -42,8 +72,8 @@ namespace nn
         /** @brief Copy constructor. */
         Matrix(const Matrix &matrix);
 
-        /** @brief Move constructor. */
-        Matrix(Matrix &&matrix);
+        /** @brief Move constructor, leaves the moved-from matrix empty. */
+        Matrix(Matrix &&matrix) noexcept;
 
         /**
          * @brief Constructs a matrix with given dimensions and an initial value.
@@ -74,19 +104,36 @@ namespace nn
         /**
          * @brief Constructs a matrix with values generated by a function.
          *
+         * `func` is called once per element in row-major order on the calling thread, so it may be
+         * stateful (e.g. `Initializer::getRandomNum`). Use the index-based constructor to fill large
+         * matrices in parallel.
+         *
          * @param rows Number of rows.
          * @param cols Number of columns.
          * @param func Function that generates values for each element.
          */
         Matrix(const int rows, const int cols, std::function<double()> func);
 
+        /**
+         * @brief Constructs a matrix with values computed from the element indices.
+         *
+         * The rows are filled in parallel, `func` receives the row-major index of each element and
+         * must be safe to call concurrently. A pure function of the index, such as
+         * `Initializer::getValue`, gives the same matrix for any number of threads.
+         *
+         * @param rows Number of rows.
+         * @param cols Number of columns.
+         * @param func Function that computes the value of the element with the given index.
+         */
+        Matrix(const int rows, const int cols, std::function<double(std::size_t)> func);
+
         /**
          * @brief Constructs a matrix from a binary file.
          *
-         * @param file Input file stream (must be opened in binary mode).
-         * @throws std::runtime_error If the file is not open or reading fails.
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or reading fails.
          */
-        Matrix(std::ifstream &file);
+        Matrix(std::istream &file);
 
         /** @brief Destructor (default). */
         ~Matrix() = default;
@@ -97,20 +144,45 @@ namespace nn
         /** @brief Returns the number of columns. */
         int getCols() const { return m_cols; }
 
-        /** @brief Returns the matrix data as a vector. */
-        std::vector<double> getData() const { return m_data; }
+        /** @brief Returns a copy of the matrix data as a vector, `getSpan` gives access without a copy. */
+        std::vector<double> getData() const { return std::vector<double>(m_data.begin(), m_data.end()); }
+
+        /** @brief Returns a view of the row-major matrix data. */
+        std::span<double> getSpan() { return m_data; }
+        std::span<const double> getSpan() const { return m_data; }
+
+        /** @brief Returns the number of elements in the matrix. */
+        int getSize() const { return m_rows * m_cols; }
+
+        /** @brief Returns a pointer to the row-major matrix data. */
+        double *getDataPtr() { return m_data.data(); }
+        const double *getDataPtr() const { return m_data.data(); }
+
+        /** @brief Returns the memory configuration of the matrix buffer. */
+        MemoryConfig getMemoryConfig() const { return m_data.getConfig(); }
+
+        /**
+         * @brief Moves the elements into a buffer allocated with another memory configuration.
+         *
+         * Does nothing if the matrix already uses the configuration.
+         *
+         * @param config The new memory configuration.
+         */
+        void setMemoryConfig(const MemoryConfig &config);
 
         /**
          * @brief Saves the matrix to a binary file.
          *
-         * @param file Output file stream (must be opened in binary mode).
-         * @throws std::runtime_error If the file is not open or writing fails.
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable or writing fails.
          */
-        void save(std::ofstream &file) const;
+        void save(std::ostream &file) const;
 
         /**
          * @brief Returns the maximum coefficient in the matrix.
          *
+         * Large matrices are reduced in parallel blocks, see `maxElement`.
+         *
          * @return The maximum coefficient in the matrix.
          */
         double maxCoeff() const;
@@ -118,9 +190,13 @@ namespace nn
         /**
          * @brief Returns the sum of all elements in the matrix.
          *
+         * The reduction tree is fixed (see `sumElements`), so the result is bitwise identical for
+         * any number of threads.
+         *
+         * @param summation Summation algorithm (default: PAIRWISE_SUMMATION).
          * @return The sum of all elements in the matrix.
          */
-        double sum() const;
+        double sum(const e_summation summation = PAIRWISE_SUMMATION) const;
 
         /**
          * @brief Returns a RowWiseProxy to enable row-wise operations.
@@ -153,11 +229,56 @@ namespace nn
         /** @brief Performs element-wise multiplication (Hadamard product). */
         Matrix cwiseProduct(const Matrix &other) const;
 
-        /** @brief Returns the transposed matrix. */
-        Matrix transpose();
+        /** @brief Returns the transposed matrix, see `transposeElements`. */
+        Matrix transpose() const;
 
-        /** @brief Applies a function to each matrix element. */
-        Matrix map(std::function<double(double)> func) const;
+        /**
+         * @brief Transposes the matrix in place.
+         *
+         * Square matrices are transposed without a second buffer, other matrices are replaced by `transpose()`.
+         */
+        void transposeInPlace();
+
+        /**
+         * @brief Applies a function to each matrix element.
+         *
+         * The callable is a template parameter, so it is inlined into the loop and the loop
+         * can be vectorised.
+         *
+         * @param func Callable taking and returning a double.
+         * @return The matrix of the mapped elements.
+         */
+        template <typename Func>
+        Matrix map(Func func) const;
+
+        /**
+         * @brief Applies a function to each matrix element in place.
+         *
+         * @param func Callable taking and returning a double.
+         */
+        template <typename Func>
+        void mapInPlace(Func func);
+
+        /**
+         * @brief Applies a function to the pairs of elements at the same position of two matrices.
+         *
+         * @param other The matrix providing the second argument.
+         * @param func Callable taking two doubles (this element, other element) and returning a double.
+         * @return The matrix of the mapped elements.
+         * @throws std::invalid_argument If the dimensions of the matrices differ.
+         */
+        template <typename Func>
+        Matrix zipMap(const Matrix &other, Func func) const;
+
+        /**
+         * @brief Returns the allocations and copies of matrix buffers since the last reset.
+         *
+         * @return The counters, all zero unless built with NN_COUNT_ALLOCATIONS.
+         */
+        static MatrixAllocationStats getAllocationStats();
+
+        /** @brief Resets the allocation and copy counters. */
+        static void resetAllocationStats();
 
         /**
          * @brief Creates an identity matrix of the specified size.
@@ -169,6 +290,9 @@ namespace nn
 
         Matrix &operator=(const Matrix &other);
 
+        /** @brief Move assignment, leaves the moved-from matrix empty. */
+        Matrix &operator=(Matrix &&other) noexcept;
+
         /** @brief Accesses elements using [{row, column}] pair notation. */
         double &operator[](const std::pair<int, int> &index);
         const double &operator[](const std::pair<int, int> &index) const;
@@ -203,10 +327,34 @@ namespace nn
         friend Matrix operator/(const Matrix &left, const Matrix &right);
         friend Matrix operator/(const Matrix &left, const double scalar);
 
+        /** @brief Arithmetic operations on a temporary, which reuse its buffer for the result. */
+        friend Matrix operator*(const double scalar, Matrix &&right);
+        friend Matrix operator*(Matrix &&left, const double scalar);
+        friend Matrix operator+(Matrix &&left, const Matrix &right);
+        friend Matrix operator+(const double scalar, Matrix &&right);
+        friend Matrix operator+(Matrix &&left, const double scalar);
+        friend Matrix operator-(Matrix &&left, const Matrix &right);
+        friend Matrix operator-(Matrix &&left, const double scalar);
+        friend Matrix operator-(const double scalar, Matrix &&right);
+        friend Matrix operator/(Matrix &&left, const Matrix &right);
+        friend Matrix operator/(Matrix &&left, const double scalar);
+
         /** @brief Comparison operators. */
         friend bool operator==(const Matrix &left, const Matrix &right);
         friend bool operator!=(const Matrix &left, const Matrix &right);
+
+    private:
+        /**
+         * @brief Splits a range of elements into chunks processed in parallel.
+         *
+         * @param size Number of elements.
+         * @param func Callable taking the start and end index of a chunk.
+         */
+        template <typename Func>
+        static void forEachChunk(const int size, Func func);
     };
 }
 
+#include "Matrix.tpp"
+
 #endif
\ No newline at end of file
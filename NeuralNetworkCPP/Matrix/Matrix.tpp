@@ -0,0 +1,117 @@
+/**
+ * C++ neural network library
+ *
+ * Matrix.tpp
+ */
+
+#ifndef MATRIX_TPP
+#define MATRIX_TPP
+
+#include "Matrix.hpp"
+#include "../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace nn
+{
+    template <typename Func>
+    Matrix Matrix::map(Func func) const
+    {
+        Matrix result(m_rows, m_cols);
+        const double *__restrict source = m_data.data();
+        double *__restrict target = result.m_data.data();
+
+        // Parallelize over chunks, the loop over a chunk is inlined and vectorised
+        forEachChunk(getSize(), [source, target, &func](int start, int end) {
+            for (int i = start; i < end; i++)
+                target[i] = func(source[i]);
+        });
+
+        return result;
+    }
+
+    template <typename Func>
+    void Matrix::mapInPlace(Func func)
+    {
+        double *values = m_data.data();
+
+        // Parallelize over chunks, the loop over a chunk is inlined and vectorised
+        forEachChunk(getSize(), [values, &func](int start, int end) {
+            for (int i = start; i < end; i++)
+                values[i] = func(values[i]);
+        });
+    }
+
+    template <typename Func>
+    Matrix Matrix::zipMap(const Matrix &other, Func func) const
+    {
+        // Validate that the matrices have the same dimensions
+        if (m_rows != other.m_rows || m_cols != other.m_cols)
+            throw std::invalid_argument("Matrix dimensions must match for element-wise mapping.");
+
+        Matrix result(m_rows, m_cols);
+        const double *__restrict left = m_data.data();
+        const double *__restrict right = other.m_data.data();
+        double *__restrict target = result.m_data.data();
+
+        // Parallelize over chunks, the loop over a chunk is inlined and vectorised
+        forEachChunk(getSize(), [left, right, target, &func](int start, int end) {
+            for (int i = start; i < end; i++)
+                target[i] = func(left[i], right[i]);
+        });
+
+        return result;
+    }
+
+    template <typename Func>
+    Matrix MatrixView::map(Func func) const
+    {
+        Matrix result(m_rows, m_cols);
+        double *target = result.getDataPtr();
+
+        // Parallelize over the rows, the loop over a row is inlined and vectorises for row-major views
+        getGlobalThreadPool().parallelFor(0, m_rows, [this, target, &func](int i) {
+            const double *__restrict source = m_data + i * m_rowStride;
+            double *__restrict row = target + static_cast<std::size_t>(i) * m_cols;
+            for (int j = 0; j < m_cols; j++)
+                row[j] = func(source[j * m_colStride]);
+        });
+
+        return result;
+    }
+
+    template <typename Func>
+    Matrix MatrixView::zipMap(const MatrixView &other, Func func) const
+    {
+        // Validate that the views have the same dimensions
+        if (m_rows != other.m_rows || m_cols != other.m_cols)
+            throw std::invalid_argument("Matrix dimensions must match for element-wise mapping.");
+
+        Matrix result(m_rows, m_cols);
+        double *target = result.getDataPtr();
+
+        // Parallelize over the rows, the loop over a row is inlined and vectorises for row-major views
+        getGlobalThreadPool().parallelFor(0, m_rows, [this, &other, target, &func](int i) {
+            const double *__restrict left = m_data + i * m_rowStride;
+            const double *__restrict right = other.m_data + i * other.m_rowStride;
+            double *__restrict row = target + static_cast<std::size_t>(i) * m_cols;
+            for (int j = 0; j < m_cols; j++)
+                row[j] = func(left[j * m_colStride], right[j * other.m_colStride]);
+        });
+
+        return result;
+    }
+
+    template <typename Func>
+    void Matrix::forEachChunk(const int size, Func func)
+    {
+        int numChunks = (size + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE;
+
+        getGlobalThreadPool().parallelFor(0, numChunks, [size, &func](int chunk) {
+            int start = chunk * MAP_CHUNK_SIZE;
+            func(start, std::min(size, start + MAP_CHUNK_SIZE));
+        });
+    }
+}
+
+#endif
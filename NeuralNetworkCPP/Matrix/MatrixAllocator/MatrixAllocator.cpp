@@ -0,0 +1,100 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixAllocator.cpp
+ */
+
+#include "MatrixAllocator.hpp"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace nn
+{
+    // Configuration of new matrices, overridden per thread by MemoryConfigScope
+    static MemoryConfig defaultConfig;
+    static thread_local const MemoryConfig *scopedConfig = nullptr;
+
+    void setDefaultMemoryConfig(const MemoryConfig &config)
+    {
+        defaultConfig = config;
+    }
+
+    const MemoryConfig &getCurrentMemoryConfig()
+    {
+        return scopedConfig ? *scopedConfig : defaultConfig;
+    }
+
+    MemoryConfigScope::MemoryConfigScope(const MemoryConfig &config)
+        : m_previous(scopedConfig)
+    {
+        scopedConfig = &config;
+    }
+
+    MemoryConfigScope::~MemoryConfigScope()
+    {
+        scopedConfig = m_previous;
+    }
+
+    // Checks if a buffer is mapped directly instead of allocated from the heap
+    static inline bool isPageMapped(const std::size_t bytes, const MemoryConfig &config)
+    {
+#if defined(__linux__)
+        return config.pagePolicy != DEFAULT_PAGES && bytes > 0 && bytes >= config.hugePageThreshold;
+#else
+        return false;
+#endif
+    }
+
+    // Rounds the size of a mapped buffer up to whole huge pages
+    static inline std::size_t getMappedSize(const std::size_t bytes)
+    {
+        return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+
+    void *allocateMatrixStorage(const std::size_t bytes, const MemoryConfig &config)
+    {
+        // Small buffers and the default policy use the aligned heap, possibly through the pool
+        if (!isPageMapped(bytes, config))
+            return config.usePool ? acquirePooledBuffer(bytes) : ::operator new(bytes, std::align_val_t(MATRIX_ALIGNMENT));
+
+#if defined(__linux__)
+        std::size_t mappedSize = getMappedSize(bytes);
+
+        // Try the reserved huge page pool first
+        if (config.pagePolicy == EXPLICIT_HUGE_PAGES)
+        {
+            void *pointer = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (pointer != MAP_FAILED)
+                return pointer;
+        }
+
+        // Map regular pages and let the kernel promote them to transparent huge pages, mappings are page aligned
+        void *pointer = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pointer == MAP_FAILED)
+            throw std::bad_alloc();
+
+        madvise(pointer, mappedSize, MADV_HUGEPAGE);
+        return pointer;
+#else
+        return nullptr;
+#endif
+    }
+
+    void deallocateMatrixStorage(void *pointer, const std::size_t bytes, const MemoryConfig &config) noexcept
+    {
+        if (!isPageMapped(bytes, config))
+        {
+            if (config.usePool)
+                releasePooledBuffer(pointer, bytes);
+            else
+                ::operator delete(pointer, std::align_val_t(MATRIX_ALIGNMENT));
+            return;
+        }
+
+#if defined(__linux__)
+        munmap(pointer, getMappedSize(bytes));
+#endif
+    }
+}
@@ -0,0 +1,106 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixAllocator.hpp
+ */
+
+#ifndef MATRIXALLOCATOR_HPP
+#define MATRIXALLOCATOR_HPP
+
+#include "../MatrixPool/MatrixPool.hpp"
+#include <cstddef>
+#include <new>
+
+namespace nn
+{
+    /// Alignment of all matrix buffers in bytes (one cache line, a full AVX-512 register).
+    constexpr std::size_t MATRIX_ALIGNMENT = 64;
+
+    /// Size of the huge pages the page-mapped buffers are rounded to.
+    constexpr std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    /**
+     * @brief Enum with the ways large matrix buffers can be backed by memory pages.
+     *
+     * DEFAULT_PAGES allocates every buffer from the heap. TRANSPARENT_HUGE_PAGES maps large buffers
+     * directly and asks the kernel to back them with transparent huge pages (`MADV_HUGEPAGE`).
+     * EXPLICIT_HUGE_PAGES maps large buffers from the reserved huge page pool (`MAP_HUGETLB`) and
+     * falls back to transparent huge pages when the pool is exhausted. Huge pages are only used on
+     * Linux, other platforms always allocate from the heap.
+     */
+    enum e_pagePolicy { DEFAULT_PAGES, TRANSPARENT_HUGE_PAGES, EXPLICIT_HUGE_PAGES };
+
+    /**
+     * @brief Settings of the memory backing matrix buffers.
+     */
+    struct MemoryConfig
+    {
+        e_pagePolicy pagePolicy = DEFAULT_PAGES;         ///< Pages backing the buffers of at least `hugePageThreshold` bytes.
+        std::size_t hugePageThreshold = HUGE_PAGE_SIZE;  ///< Size from which buffers are mapped with the page policy.
+        bool usePool = false;                            ///< Recycle the heap buffers through the matrix buffer pool.
+
+        bool operator==(const MemoryConfig &other) const = default;
+    };
+
+    /**
+     * @brief Sets the memory configuration used by matrices created from now on.
+     *
+     * Matrices keep the configuration they were created with, a `MemoryConfigScope` overrides the
+     * default on the current thread. Should be called before matrices are created concurrently.
+     *
+     * @param config The new default configuration.
+     */
+    void setDefaultMemoryConfig(const MemoryConfig &config);
+
+    /** @brief Returns the configuration used by new matrices on the current thread. */
+    const MemoryConfig &getCurrentMemoryConfig();
+
+    /**
+     * @class MemoryConfigScope
+     * @brief Overrides the memory configuration of the matrices created by the current thread.
+     *
+     * The previous configuration is restored when the scope is destroyed, scopes can be nested.
+     */
+    class MemoryConfigScope
+    {
+    private:
+        const MemoryConfig *m_previous; ///< Configuration active before the scope.
+
+    public:
+        /**
+         * @brief Activates the configuration on the current thread.
+         *
+         * @param config The configuration, must outlive the scope.
+         */
+        explicit MemoryConfigScope(const MemoryConfig &config);
+
+        /** @brief Restores the previous configuration. */
+        ~MemoryConfigScope();
+
+        MemoryConfigScope(const MemoryConfigScope &) = delete;
+        MemoryConfigScope &operator=(const MemoryConfigScope &) = delete;
+    };
+
+    /**
+     * @brief Allocates a buffer aligned to `MATRIX_ALIGNMENT` following the configuration.
+     *
+     * Heap buffers of a configuration with `usePool` are taken from the matrix buffer pool.
+     *
+     * @param bytes Size of the buffer.
+     * @param config Memory configuration, `deallocateMatrixStorage` must get the same one.
+     * @return Pointer to the buffer.
+     * @throws std::bad_alloc If the memory cannot be allocated.
+     */
+    void *allocateMatrixStorage(const std::size_t bytes, const MemoryConfig &config);
+
+    /**
+     * @brief Releases a buffer returned by `allocateMatrixStorage`.
+     *
+     * @param pointer Pointer to the buffer.
+     * @param bytes Size the buffer was allocated with.
+     * @param config Configuration the buffer was allocated with.
+     */
+    void deallocateMatrixStorage(void *pointer, const std::size_t bytes, const MemoryConfig &config) noexcept;
+}
+
+#endif
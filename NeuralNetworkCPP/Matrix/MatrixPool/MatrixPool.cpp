@@ -0,0 +1,260 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixPool.cpp
+ */
+
+#include "MatrixPool.hpp"
+#include "../MatrixAllocator/MatrixAllocator.hpp"
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace nn
+{
+    // Smallest size class, heap buffers start above the inline storage of matrices
+    constexpr int MIN_CLASS_SHIFT = 8;
+    constexpr std::size_t MIN_CLASS_BYTES = std::size_t(1) << MIN_CLASS_SHIFT;
+
+    // Number of size classes per power of two
+    constexpr int CLASS_STEPS = 4;
+
+    // Number of size classes up to the largest pooled buffer
+    constexpr int NUM_SIZE_CLASSES = (std::bit_width(MATRIX_POOL_MAX_BUFFER) - 1 - MIN_CLASS_SHIFT) * CLASS_STEPS + 1;
+
+    // Number of buffers per size class a thread keeps for itself
+    constexpr int THREAD_CACHE_SLOTS = 4;
+
+    // Statistics and capacity shared by all threads
+    static std::atomic<std::size_t> poolHits{0};
+    static std::atomic<std::size_t> poolMisses{0};
+    static std::atomic<std::size_t> poolBytesHeld{0};
+    static std::atomic<std::size_t> poolCapacity{std::numeric_limits<std::size_t>::max()};
+
+    // Returns the size class of a buffer, 2^shift < bytes <= 2^(shift + 1) is split into four steps
+    static inline int getSizeClass(const std::size_t bytes)
+    {
+        if (bytes <= MIN_CLASS_BYTES)
+            return 0;
+
+        int shift = std::bit_width(bytes - 1) - 1;
+        std::size_t step = std::size_t(1) << (shift - 2);
+        std::size_t subClass = (bytes - (std::size_t(1) << shift) + step - 1) / step;
+        return (shift - MIN_CLASS_SHIFT) * CLASS_STEPS + static_cast<int>(subClass);
+    }
+
+    // Returns the size of the buffers of a size class
+    static inline std::size_t getClassSize(const int sizeClass)
+    {
+        if (sizeClass == 0)
+            return MIN_CLASS_BYTES;
+
+        int shift = (sizeClass - 1) / CLASS_STEPS + MIN_CLASS_SHIFT;
+        int subClass = (sizeClass - 1) % CLASS_STEPS + 1;
+        return (std::size_t(1) << shift) + subClass * (std::size_t(1) << (shift - 2));
+    }
+
+    static inline void *allocateBuffer(const std::size_t bytes)
+    {
+        return ::operator new(bytes, std::align_val_t(MATRIX_ALIGNMENT));
+    }
+
+    static inline void deallocateBuffer(void *pointer) noexcept
+    {
+        ::operator delete(pointer, std::align_val_t(MATRIX_ALIGNMENT));
+    }
+
+    // Idle buffers shared by all threads
+    struct SharedCache
+    {
+        std::mutex mutex;                               ///< Guards the buffers.
+        std::vector<void *> buffers[NUM_SIZE_CLASSES];  ///< Idle buffers of each size class.
+    };
+
+    // The cache is never destroyed, matrices destroyed during static destruction can still return their buffers
+    static SharedCache &getSharedCache()
+    {
+        static SharedCache *cache = new SharedCache();
+        return *cache;
+    }
+
+    // Moves a buffer into the shared cache, or releases it if the cache cannot grow
+    static void pushShared(SharedCache &shared, const int sizeClass, void *pointer) noexcept
+    {
+        try
+        {
+            shared.buffers[sizeClass].push_back(pointer);
+        }
+        catch (...)
+        {
+            poolBytesHeld.fetch_sub(getClassSize(sizeClass), std::memory_order_relaxed);
+            deallocateBuffer(pointer);
+        }
+    }
+
+    // Idle buffers of one thread, used without locking
+    struct ThreadCache
+    {
+        void *slots[NUM_SIZE_CLASSES][THREAD_CACHE_SLOTS]; ///< Idle buffers of each size class.
+        int counts[NUM_SIZE_CLASSES] = {};                 ///< Number of idle buffers of each size class.
+
+        ThreadCache();
+
+        // Hand the buffers to the shared cache when the thread exits
+        ~ThreadCache();
+
+        // Moves all buffers into the shared cache, whose mutex must be held
+        void flush(SharedCache &shared) noexcept
+        {
+            for (int sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++)
+            {
+                for (int i = 0; i < counts[sizeClass]; i++)
+                    pushShared(shared, sizeClass, slots[sizeClass][i]);
+                counts[sizeClass] = 0;
+            }
+        }
+    };
+
+    // The state is trivially destructible, so it can still be read after the cache of the thread is destroyed
+    enum e_threadCacheState { CACHE_UNUSED, CACHE_ALIVE, CACHE_DESTROYED };
+    static thread_local e_threadCacheState threadCacheState = CACHE_UNUSED;
+    static thread_local ThreadCache threadCache;
+
+    ThreadCache::ThreadCache()
+    {
+        threadCacheState = CACHE_ALIVE;
+    }
+
+    ThreadCache::~ThreadCache()
+    {
+        SharedCache &shared = getSharedCache();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        flush(shared);
+        threadCacheState = CACHE_DESTROYED;
+    }
+
+    // Returns the cache of the current thread, nullptr once the thread is exiting
+    static inline ThreadCache *getThreadCache()
+    {
+        return threadCacheState == CACHE_DESTROYED ? nullptr : &threadCache;
+    }
+
+    void *acquirePooledBuffer(const std::size_t bytes)
+    {
+        // Large buffers bypass the pool
+        if (bytes > MATRIX_POOL_MAX_BUFFER)
+            return allocateBuffer(bytes);
+
+        int sizeClass = getSizeClass(bytes);
+        std::size_t classSize = getClassSize(sizeClass);
+
+        // Reuse a buffer released by this thread without locking
+        ThreadCache *cache = getThreadCache();
+        if (cache && cache->counts[sizeClass] > 0)
+        {
+            poolHits.fetch_add(1, std::memory_order_relaxed);
+            poolBytesHeld.fetch_sub(classSize, std::memory_order_relaxed);
+            return cache->slots[sizeClass][--cache->counts[sizeClass]];
+        }
+
+        // Then a buffer released by another thread
+        {
+            SharedCache &shared = getSharedCache();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            std::vector<void *> &buffers = shared.buffers[sizeClass];
+            if (!buffers.empty())
+            {
+                void *pointer = buffers.back();
+                buffers.pop_back();
+                poolHits.fetch_add(1, std::memory_order_relaxed);
+                poolBytesHeld.fetch_sub(classSize, std::memory_order_relaxed);
+                return pointer;
+            }
+        }
+
+        // Allocate the full class size, so the buffer can serve any size of its class later
+        poolMisses.fetch_add(1, std::memory_order_relaxed);
+        return allocateBuffer(classSize);
+    }
+
+    void releasePooledBuffer(void *pointer, const std::size_t bytes) noexcept
+    {
+        if (!pointer)
+            return;
+
+        int sizeClass = getSizeClass(bytes);
+        std::size_t classSize = getClassSize(sizeClass);
+
+        // Large buffers and buffers beyond the capacity go back to the heap
+        if (bytes > MATRIX_POOL_MAX_BUFFER || poolBytesHeld.load(std::memory_order_relaxed) + classSize > poolCapacity.load(std::memory_order_relaxed))
+        {
+            deallocateBuffer(pointer);
+            return;
+        }
+
+        poolBytesHeld.fetch_add(classSize, std::memory_order_relaxed);
+
+        // Keep the buffer for this thread if it has a free slot
+        ThreadCache *cache = getThreadCache();
+        if (cache && cache->counts[sizeClass] < THREAD_CACHE_SLOTS)
+        {
+            cache->slots[sizeClass][cache->counts[sizeClass]++] = pointer;
+            return;
+        }
+
+        // Otherwise share it with the other threads
+        SharedCache &shared = getSharedCache();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        pushShared(shared, sizeClass, pointer);
+    }
+
+    MatrixPoolStats getMatrixPoolStats()
+    {
+        MatrixPoolStats stats;
+        stats.hits = poolHits.load(std::memory_order_relaxed);
+        stats.misses = poolMisses.load(std::memory_order_relaxed);
+        stats.bytesHeld = poolBytesHeld.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void resetMatrixPoolStats()
+    {
+        poolHits.store(0, std::memory_order_relaxed);
+        poolMisses.store(0, std::memory_order_relaxed);
+    }
+
+    void setMatrixPoolCapacity(const std::size_t bytes)
+    {
+        poolCapacity.store(bytes, std::memory_order_relaxed);
+    }
+
+    void trimMatrixPool(const std::size_t maxBytes)
+    {
+        SharedCache &shared = getSharedCache();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+
+        // Gather the buffers of this thread in the shared cache
+        if (ThreadCache *cache = getThreadCache())
+            cache->flush(shared);
+
+        // Release the largest buffers first
+        for (int sizeClass = NUM_SIZE_CLASSES - 1; sizeClass >= 0; sizeClass--)
+        {
+            std::vector<void *> &buffers = shared.buffers[sizeClass];
+            std::size_t classSize = getClassSize(sizeClass);
+
+            while (!buffers.empty() && poolBytesHeld.load(std::memory_order_relaxed) > maxBytes)
+            {
+                deallocateBuffer(buffers.back());
+                buffers.pop_back();
+                poolBytesHeld.fetch_sub(classSize, std::memory_order_relaxed);
+            }
+
+            // Give the memory of an emptied list back as well
+            if (buffers.empty())
+                std::vector<void *>().swap(buffers);
+        }
+    }
+}
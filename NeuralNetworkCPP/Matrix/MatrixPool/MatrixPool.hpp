@@ -0,0 +1,77 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixPool.hpp
+ */
+
+#ifndef MATRIXPOOL_HPP
+#define MATRIXPOOL_HPP
+
+#include <cstddef>
+
+namespace nn
+{
+    /// Largest buffer recycled by the pool, larger buffers always go to the heap.
+    constexpr std::size_t MATRIX_POOL_MAX_BUFFER = 64 * 1024 * 1024;
+
+    /**
+     * @brief Statistics of the matrix buffer pool.
+     */
+    struct MatrixPoolStats
+    {
+        std::size_t hits = 0;      ///< Allocations served with a cached buffer.
+        std::size_t misses = 0;    ///< Allocations that had to reach the heap.
+        std::size_t bytesHeld = 0; ///< Bytes of the idle buffers cached by the pool.
+    };
+
+    /**
+     * @brief Takes a buffer from the pool or allocates one from the heap.
+     *
+     * Sizes are rounded up to classes of four steps per power of two (at most 25% overhead). A buffer
+     * of the same class released by the current thread is reused first, then one of the shared cache.
+     *
+     * @param bytes Size of the buffer.
+     * @return Pointer to a buffer aligned to `MATRIX_ALIGNMENT`.
+     * @throws std::bad_alloc If the memory cannot be allocated.
+     */
+    void *acquirePooledBuffer(const std::size_t bytes);
+
+    /**
+     * @brief Returns a buffer of `acquirePooledBuffer` to the pool.
+     *
+     * The buffer is cached by the current thread, beyond a few buffers per size class it moves to the
+     * shared cache, and beyond the capacity of the pool it is released to the heap.
+     *
+     * @param pointer Pointer to the buffer.
+     * @param bytes Size the buffer was acquired with.
+     */
+    void releasePooledBuffer(void *pointer, const std::size_t bytes) noexcept;
+
+    /** @brief Returns the statistics of the pool, gathered over all threads. */
+    MatrixPoolStats getMatrixPoolStats();
+
+    /** @brief Resets the hit and miss counters of the pool. */
+    void resetMatrixPoolStats();
+
+    /**
+     * @brief Sets the maximum number of bytes of idle buffers the pool keeps.
+     *
+     * Buffers released while the pool holds that much go back to the heap, the buffers already
+     * cached are kept until `trimMatrixPool` is called.
+     *
+     * @param bytes The capacity (default: unlimited).
+     */
+    void setMatrixPoolCapacity(const std::size_t bytes);
+
+    /**
+     * @brief Releases idle buffers of the pool to the heap.
+     *
+     * The cache of the current thread and the shared cache are trimmed, largest buffers first. The
+     * few buffers cached by other threads are released when those threads exit.
+     *
+     * @param maxBytes Number of bytes the pool may keep holding (default: 0, release everything).
+     */
+    void trimMatrixPool(const std::size_t maxBytes = 0);
+}
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixStorage.cpp
+ */
+
+#include "MatrixStorage.hpp"
+#include <cstring>
+
+namespace nn
+{
+    MatrixStorage::MatrixStorage() noexcept
+        : m_elements(m_inline), m_size(0), m_config(getCurrentMemoryConfig()) {}
+
+    MatrixStorage::MatrixStorage(const std::size_t size, const double value, const MemoryConfig &config)
+        : m_elements(m_inline), m_size(0), m_config(config)
+    {
+        allocate(size);
+        std::fill(m_elements, m_elements + m_size, value);
+    }
+
+    MatrixStorage::MatrixStorage(const MatrixStorage &other)
+        : m_elements(m_inline), m_size(0), m_config(other.m_config)
+    {
+        allocate(other.m_size);
+        std::memcpy(m_elements, other.m_elements, m_size * sizeof(double));
+    }
+
+    MatrixStorage::MatrixStorage(MatrixStorage &&other) noexcept
+        : m_elements(m_inline), m_size(0), m_config(other.m_config)
+    {
+        takeOver(other);
+    }
+
+    MatrixStorage &MatrixStorage::operator=(const MatrixStorage &other)
+    {
+        if (this == &other)
+            return *this;
+
+        // Allocate a new buffer unless the current one fits
+        if (m_size != other.m_size || !(m_config == other.m_config))
+        {
+            release();
+            m_config = other.m_config;
+            allocate(other.m_size);
+        }
+
+        std::memcpy(m_elements, other.m_elements, m_size * sizeof(double));
+        return *this;
+    }
+
+    MatrixStorage &MatrixStorage::operator=(MatrixStorage &&other) noexcept
+    {
+        if (this == &other)
+            return *this;
+
+        release();
+        m_config = other.m_config;
+        takeOver(other);
+        return *this;
+    }
+
+    MatrixStorage::~MatrixStorage()
+    {
+        release();
+    }
+
+    void MatrixStorage::allocate(const std::size_t size)
+    {
+        // Small buffers live inside the object
+        if (size > INLINE_CAPACITY)
+            m_elements = static_cast<double *>(allocateMatrixStorage(size * sizeof(double), m_config));
+
+        m_size = size;
+    }
+
+    void MatrixStorage::release() noexcept
+    {
+        if (!isInline())
+            deallocateMatrixStorage(m_elements, m_size * sizeof(double), m_config);
+
+        m_elements = m_inline;
+        m_size = 0;
+    }
+
+    void MatrixStorage::takeOver(MatrixStorage &other) noexcept
+    {
+        // Steal a heap buffer, copy inline elements
+        if (other.isInline())
+            std::memcpy(m_inline, other.m_inline, other.m_size * sizeof(double));
+        else
+            m_elements = other.m_elements;
+
+        m_size = other.m_size;
+        other.m_elements = other.m_inline;
+        other.m_size = 0;
+    }
+}
@@ -0,0 +1,117 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixStorage.hpp
+ */
+
+#ifndef MATRIXSTORAGE_HPP
+#define MATRIXSTORAGE_HPP
+
+#include "../MatrixAllocator/MatrixAllocator.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+namespace nn
+{
+    /**
+     * @class MatrixStorage
+     * @brief Buffer of matrix elements with inline storage for small matrices.
+     *
+     * Up to `INLINE_CAPACITY` elements are stored inside the object, so small column vectors such as
+     * biases of output layers, per-feature statistics and reduction results never reach the heap.
+     * Larger buffers are allocated with `allocateMatrixStorage` following the memory configuration,
+     * which moves and is assigned along with the elements. Both kinds of buffer are aligned to
+     * `MATRIX_ALIGNMENT`.
+     */
+    class alignas(MATRIX_ALIGNMENT) MatrixStorage
+    {
+    public:
+        static constexpr std::size_t INLINE_CAPACITY = 32; ///< Number of elements stored without a heap allocation (four cache lines).
+
+    private:
+        double m_inline[INLINE_CAPACITY]; ///< Inline buffer of small matrices.
+        double *m_elements;               ///< Elements, either `m_inline` or a heap buffer.
+        std::size_t m_size;               ///< Number of elements.
+        MemoryConfig m_config;            ///< Configuration of the heap buffer.
+
+    public:
+        /** @brief Constructs an empty buffer with the current memory configuration of the thread. */
+        MatrixStorage() noexcept;
+
+        /**
+         * @brief Constructs a buffer with all elements set to a value.
+         *
+         * @param size Number of elements.
+         * @param value Value of the elements (default: 0).
+         * @param config Memory configuration (default: the current configuration of the thread).
+         */
+        explicit MatrixStorage(const std::size_t size, const double value = 0.0, const MemoryConfig &config = getCurrentMemoryConfig());
+
+        /**
+         * @brief Constructs a buffer with the elements of a range.
+         *
+         * @param first Iterator to the first element.
+         * @param last Iterator past the last element.
+         * @param config Memory configuration (default: the current configuration of the thread).
+         */
+        template <std::input_iterator Iterator>
+        MatrixStorage(Iterator first, Iterator last, const MemoryConfig &config = getCurrentMemoryConfig())
+            : m_elements(m_inline), m_size(0), m_config(config)
+        {
+            allocate(std::distance(first, last));
+            std::copy(first, last, m_elements);
+        }
+
+        /** @brief Copy constructor, keeps the memory configuration of the copied buffer. */
+        MatrixStorage(const MatrixStorage &other);
+
+        /** @brief Move constructor, takes over a heap buffer and leaves the other buffer empty. */
+        MatrixStorage(MatrixStorage &&other) noexcept;
+
+        /** @brief Copy assignment, reuses the buffer when the size and the configuration match. */
+        MatrixStorage &operator=(const MatrixStorage &other);
+
+        /** @brief Move assignment, takes over a heap buffer and leaves the other buffer empty. */
+        MatrixStorage &operator=(MatrixStorage &&other) noexcept;
+
+        /** @brief Destructor, releases the heap buffer. */
+        ~MatrixStorage();
+
+        /** @brief Returns the number of elements. */
+        std::size_t size() const { return m_size; }
+
+        /** @brief Checks if the buffer has no elements. */
+        bool empty() const { return m_size == 0; }
+
+        /** @brief Checks if the elements are stored inside the object. */
+        bool isInline() const { return m_elements == m_inline; }
+
+        /** @brief Returns the memory configuration of the buffer. */
+        const MemoryConfig &getConfig() const { return m_config; }
+
+        double *data() { return m_elements; }
+        const double *data() const { return m_elements; }
+
+        double *begin() { return m_elements; }
+        const double *begin() const { return m_elements; }
+
+        double *end() { return m_elements + m_size; }
+        const double *end() const { return m_elements + m_size; }
+
+        double &operator[](const std::size_t index) { return m_elements[index]; }
+        const double &operator[](const std::size_t index) const { return m_elements[index]; }
+
+    private:
+        /** @brief Points the buffer to storage for `size` elements, the buffer must be empty. */
+        void allocate(const std::size_t size);
+
+        /** @brief Releases the heap buffer and leaves the buffer empty. */
+        void release() noexcept;
+
+        /** @brief Takes over the elements of another buffer and leaves it empty, the buffer must be empty. */
+        void takeOver(MatrixStorage &other) noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixView.cpp
+ */
+
+#include "MatrixView.hpp"
+#include "../Matrix.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include "../Transpose/Transpose.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace nn
+{
+    MatrixView::MatrixView(const Matrix &matrix)
+        : m_data(matrix.getDataPtr()), m_rows(matrix.getRows()), m_cols(matrix.getCols()), m_rowStride(matrix.getCols()), m_colStride(1) {}
+
+    MatrixView::MatrixView(const double *data, const int rows, const int cols, const std::ptrdiff_t rowStride, const std::ptrdiff_t colStride)
+        : m_data(data), m_rows(rows), m_cols(cols), m_rowStride(rowStride < 0 ? cols : rowStride), m_colStride(colStride)
+    {
+        if (rows < 0 || cols < 0)
+            throw std::invalid_argument("View dimensions must not be negative.");
+    }
+
+    MatrixView MatrixView::block(const int row, const int col, const int rows, const int cols) const
+    {
+        // Validate that the block lies inside the view
+        if (row < 0 || col < 0 || rows < 0 || cols < 0 || row + rows > m_rows || col + cols > m_cols)
+            throw std::out_of_range("Block exceeds the dimensions of the view.");
+
+        return MatrixView(m_data + row * m_rowStride + col * m_colStride, rows, cols, m_rowStride, m_colStride);
+    }
+
+    MatrixView MatrixView::transpose() const
+    {
+        return MatrixView(m_data, m_cols, m_rows, m_colStride, m_rowStride);
+    }
+
+    Matrix MatrixView::toMatrix() const
+    {
+        // Copy the whole buffer at once if there are no gaps
+        if (isContiguous())
+            return Matrix(m_rows, m_cols, std::vector<double>(m_data, m_data + getSize()));
+
+        // A transposed row-major buffer is copied with the tiled transpose
+        if (m_rowStride == 1 && m_colStride >= m_rows)
+        {
+            Matrix result(m_rows, m_cols);
+            transposeElements(m_data, m_cols, m_rows, m_colStride, result.getDataPtr(), m_cols);
+            return result;
+        }
+
+        return map([](double x) { return x; });
+    }
+
+    double MatrixView::sum() const
+    {
+        // Contiguous views use the parallel reduction of matrices
+        if (isContiguous())
+            return sumElements(m_data, static_cast<std::size_t>(m_rows) * m_cols);
+
+        // Strided views are gathered first, so they get the same pairwise reduction
+        return toMatrix().sum();
+    }
+
+    Matrix MatrixView::rowSums() const
+    {
+        Matrix result(m_rows, 1);
+        double *target = result.getDataPtr();
+
+        // Parallelize over the rows
+        getGlobalThreadPool().parallelFor(0, m_rows, [this, target](int i) {
+            const double *row = m_data + i * m_rowStride;
+            if (m_colStride == 1)
+            {
+                target[i] = sumElementsSerial(row, m_cols);
+                return;
+            }
+
+            double total = 0.0;
+            for (int j = 0; j < m_cols; j++)
+                total += row[j * m_colStride];
+            target[i] = total;
+        });
+
+        return result;
+    }
+
+    Matrix multiply(const MatrixView &left, const MatrixView &right)
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (left.getCols() != right.getRows())
+            throw std::invalid_argument("Invalid matrix multiplication: A(m x k) * B(k x n) requires A.cols == B.rows.");
+
+        int rows = left.getRows();
+        int inner = left.getCols();
+        int cols = right.getCols();
+        Matrix result(rows, cols, 0.0);
+        double *target = result.getDataPtr();
+
+        // Parallelize over the rows of the result, each one accumulates the rows of the right operand in order of k
+        getGlobalThreadPool().parallelFor(0, rows, [&left, &right, target, inner, cols](int i) {
+            double *__restrict resultRow = target + static_cast<std::size_t>(i) * cols;
+            std::ptrdiff_t colStride = right.getColStride();
+
+            for (int k = 0; k < inner; k++)
+            {
+                double factor = left(i, k);
+                const double *__restrict rightRow = &right(k, 0);
+
+                // Separate loop for row-major operands, which vectorises
+                if (colStride == 1)
+                {
+                    for (int j = 0; j < cols; j++)
+                        resultRow[j] += factor * rightRow[j];
+                }
+                else
+                {
+                    for (int j = 0; j < cols; j++)
+                        resultRow[j] += factor * rightRow[j * colStride];
+                }
+            }
+        });
+
+        return result;
+    }
+
+    Matrix multiplyTransposed(const MatrixView &left, const MatrixView &rightTransposed)
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (left.getCols() != rightTransposed.getCols())
+            throw std::invalid_argument("Invalid matrix multiplication: A(m x k) * B^T(n x k) requires A.cols == B.cols.");
+
+        int rows = left.getRows();
+        int inner = left.getCols();
+        int cols = rightTransposed.getRows();
+        Matrix result(rows, cols);
+        double *target = result.getDataPtr();
+
+        // Parallelize over the rows of the result
+        getGlobalThreadPool().parallelFor(0, rows, [&left, &rightTransposed, target, inner, cols](int i) {
+            const double *a = &left(i, 0);
+            std::ptrdiff_t leftStride = left.getColStride();
+            std::ptrdiff_t rightStride = rightTransposed.getColStride();
+
+            for (int j = 0; j < cols; j++)
+            {
+                const double *b = &rightTransposed(j, 0);
+                double sum = 0.0;
+
+                // Four partial sums for row-major operands, so the dot product vectorises
+                if (leftStride == 1 && rightStride == 1)
+                {
+                    double partial[4] = {0.0, 0.0, 0.0, 0.0};
+                    int k = 0;
+                    for (; k + 4 <= inner; k += 4)
+                        for (int lane = 0; lane < 4; lane++)
+                            partial[lane] += a[k + lane] * b[k + lane];
+                    for (; k < inner; k++)
+                        sum += a[k] * b[k];
+                    sum += (partial[0] + partial[1]) + (partial[2] + partial[3]);
+                }
+                else
+                {
+                    for (int k = 0; k < inner; k++)
+                        sum += a[k * leftStride] * b[k * rightStride];
+                }
+
+                target[static_cast<std::size_t>(i) * cols + j] = sum;
+            }
+        });
+
+        return result;
+    }
+}
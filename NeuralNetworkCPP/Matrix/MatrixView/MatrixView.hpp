@@ -0,0 +1,157 @@
+/**
+ * C++ neural network library
+ *
+ * MatrixView.hpp
+ */
+
+#ifndef MATRIXVIEW_HPP
+#define MATRIXVIEW_HPP
+
+#include <cstddef>
+
+namespace nn
+{
+    // Forward declaration of Matrix class, Matrix.hpp includes this header and defines the templates in Matrix.tpp
+    class Matrix;
+
+    /**
+     * @class MatrixView
+     * @brief Non-owning, read-only view of a matrix, a block of it or an external buffer.
+     *
+     * Element (row, col) is found at `data[row * rowStride + col * colStride]`, so a view can
+     * select row and column ranges of a matrix or present a buffer in another layout (e.g. a
+     * sample-major buffer as features x samples through `transpose`) without copying. The viewed
+     * memory must outlive the view and must not be reallocated while it is used.
+     */
+    class MatrixView
+    {
+    private:
+        const double *m_data;       ///< Address of element (0, 0).
+        int m_rows;                 ///< Number of rows.
+        int m_cols;                 ///< Number of columns.
+        std::ptrdiff_t m_rowStride; ///< Distance between two rows in elements.
+        std::ptrdiff_t m_colStride; ///< Distance between two columns in elements.
+
+    public:
+        /**
+         * @brief Constructs a view of a whole matrix.
+         *
+         * @param matrix The viewed matrix.
+         */
+        MatrixView(const Matrix &matrix);
+
+        /**
+         * @brief Constructs a view of an external buffer.
+         *
+         * @param data Address of element (0, 0).
+         * @param rows Number of rows.
+         * @param cols Number of columns.
+         * @param rowStride Distance between two rows in elements (default: `cols`, a row-major buffer).
+         * @param colStride Distance between two columns in elements (default: 1).
+         * @throws std::invalid_argument If a dimension is negative.
+         */
+        MatrixView(const double *data, const int rows, const int cols, const std::ptrdiff_t rowStride = -1, const std::ptrdiff_t colStride = 1);
+
+        /** @brief Returns the number of rows. */
+        int getRows() const { return m_rows; }
+
+        /** @brief Returns the number of columns. */
+        int getCols() const { return m_cols; }
+
+        /** @brief Returns the number of elements. */
+        int getSize() const { return m_rows * m_cols; }
+
+        /** @brief Returns the distance between two rows in elements. */
+        std::ptrdiff_t getRowStride() const { return m_rowStride; }
+
+        /** @brief Returns the distance between two columns in elements. */
+        std::ptrdiff_t getColStride() const { return m_colStride; }
+
+        /** @brief Returns the address of element (0, 0). */
+        const double *getDataPtr() const { return m_data; }
+
+        /** @brief Checks if the elements are stored row-major without gaps. */
+        bool isContiguous() const { return m_colStride == 1 && (m_rowStride == m_cols || m_rows <= 1); }
+
+        /** @brief Accesses elements using (row, column) notation. */
+        const double &operator()(const int row, const int col) const { return m_data[row * m_rowStride + col * m_colStride]; }
+
+        /**
+         * @brief Returns a view of a block of the matrix.
+         *
+         * @param row First row of the block.
+         * @param col First column of the block.
+         * @param rows Number of rows of the block.
+         * @param cols Number of columns of the block.
+         * @return The view of the block.
+         * @throws std::out_of_range If the block does not fit into the view.
+         */
+        MatrixView block(const int row, const int col, const int rows, const int cols) const;
+
+        /** @brief Returns a view of `count` rows starting at `start`, see `block`. */
+        MatrixView rowRange(const int start, const int count) const { return block(start, 0, count, m_cols); }
+
+        /** @brief Returns a view of `count` columns (e.g. samples of a batch) starting at `start`, see `block`. */
+        MatrixView colRange(const int start, const int count) const { return block(0, start, m_rows, count); }
+
+        /** @brief Returns the transposed view, which swaps the strides and copies nothing. */
+        MatrixView transpose() const;
+
+        /** @brief Copies the viewed elements into a new matrix. */
+        Matrix toMatrix() const;
+
+        /** @brief Returns the sum of all elements, with the pairwise reduction of `Matrix::sum`. */
+        double sum() const;
+
+        /** @brief Returns a column vector with the sum of each row. */
+        Matrix rowSums() const;
+
+        /**
+         * @brief Applies a function to every element.
+         *
+         * @param func Callable taking and returning a double.
+         * @return A new matrix with the results.
+         */
+        template <typename Func>
+        Matrix map(Func func) const;
+
+        /**
+         * @brief Applies a function to every pair of elements of two views of the same dimensions.
+         *
+         * @param other The second operand.
+         * @param func Callable taking two doubles and returning a double.
+         * @return A new matrix with the results.
+         * @throws std::invalid_argument If the dimensions do not match.
+         */
+        template <typename Func>
+        Matrix zipMap(const MatrixView &other, Func func) const;
+    };
+
+    /**
+     * @brief Multiplies two views, the kernel behind `Matrix * Matrix`.
+     *
+     * Each result row is accumulated from the rows of `right`, so the inner loop is contiguous and
+     * vectorises when `right` is row-major. Any strides are accepted.
+     *
+     * @param left Left operand (m x k).
+     * @param right Right operand (k x n).
+     * @return The product (m x n).
+     * @throws std::invalid_argument If the inner dimensions do not match.
+     */
+    Matrix multiply(const MatrixView &left, const MatrixView &right);
+
+    /**
+     * @brief Multiplies a view by the transpose of another one without transposing it.
+     *
+     * Each result element is the dot product of a row of `left` and a row of `rightTransposed`,
+     * so both operands are read along contiguous rows when they are row-major.
+     *
+     * @param left Left operand (m x k).
+     * @param rightTransposed Transpose of the right operand (n x k).
+     * @return The product `left * rightTransposed^T` (m x n).
+     * @throws std::invalid_argument If the inner dimensions do not match.
+     */
+    Matrix multiplyTransposed(const MatrixView &left, const MatrixView &rightTransposed);
+}
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ * C++ neural network library
+ *
+ * Reduction.cpp
+ */
+
+#include "Reduction.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace nn
+{
+    // Independent accumulators, one AVX-512 or two AVX2 registers
+    constexpr int REDUCTION_LANES = 8;
+
+    // Size below which a pairwise sum stops splitting
+    constexpr std::size_t PAIRWISE_LEAF_SIZE = 128;
+
+    // Adds a value to a compensated sum (Neumaier's variant of Kahan summation)
+    static inline void addCompensated(double &sum, double &compensation, const double value)
+    {
+        double total = sum + value;
+        compensation += (std::abs(sum) >= std::abs(value)) ? (sum - total) + value : (value - total) + sum;
+        sum = total;
+    }
+
+    // Combines the accumulators in a fixed tree: lane i is added to lane i + width for width 4, 2, 1
+    static inline double combineLanes(double *lanes)
+    {
+        for (int width = REDUCTION_LANES / 2; width > 0; width /= 2)
+            for (int lane = 0; lane < width; lane++)
+                lanes[lane] += lanes[lane + width];
+
+        return lanes[0];
+    }
+
+    // Recursive pairwise sum, the leaves are summed with independent accumulators
+    static double pairwiseSum(const double *data, const std::size_t count)
+    {
+        if (count > PAIRWISE_LEAF_SIZE)
+        {
+            // Split at a multiple of the lane count, so the leaves stay aligned with the accumulators
+            std::size_t half = count / 2 / REDUCTION_LANES * REDUCTION_LANES;
+            return pairwiseSum(data, half) + pairwiseSum(data + half, count - half);
+        }
+
+        double lanes[REDUCTION_LANES] = {};
+        std::size_t i = 0;
+        for (; i + REDUCTION_LANES <= count; i += REDUCTION_LANES)
+            for (int lane = 0; lane < REDUCTION_LANES; lane++)
+                lanes[lane] += data[i + lane];
+
+        for (int lane = 0; i < count; i++, lane++)
+            lanes[lane] += data[i];
+
+        return combineLanes(lanes);
+    }
+
+    // Compensated sum with independent accumulators, the accumulators are combined with compensation too
+    static double kahanSum(const double *data, const std::size_t count)
+    {
+        double sums[REDUCTION_LANES] = {};
+        double compensations[REDUCTION_LANES] = {};
+        std::size_t i = 0;
+        for (; i + REDUCTION_LANES <= count; i += REDUCTION_LANES)
+            for (int lane = 0; lane < REDUCTION_LANES; lane++)
+                addCompensated(sums[lane], compensations[lane], data[i + lane]);
+
+        for (int lane = 0; i < count; i++, lane++)
+            addCompensated(sums[lane], compensations[lane], data[i]);
+
+        double sum = 0.0;
+        double compensation = 0.0;
+        for (int lane = 0; lane < REDUCTION_LANES; lane++)
+        {
+            addCompensated(sum, compensation, sums[lane]);
+            compensation += compensations[lane];
+        }
+
+        return sum + compensation;
+    }
+
+    double sumElementsSerial(const double *data, const std::size_t count, const e_summation summation)
+    {
+        return (summation == KAHAN_SUMMATION) ? kahanSum(data, count) : pairwiseSum(data, count);
+    }
+
+    double sumElements(const double *data, const std::size_t count, const e_summation summation)
+    {
+        if (count <= REDUCTION_BLOCK_SIZE)
+            return sumElementsSerial(data, count, summation);
+
+        // Sum the blocks in parallel, their boundaries only depend on the size
+        int numBlocks = (count + REDUCTION_BLOCK_SIZE - 1) / REDUCTION_BLOCK_SIZE;
+        std::vector<double> blockSums(numBlocks);
+
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            std::size_t start = block * REDUCTION_BLOCK_SIZE;
+            blockSums[block] = sumElementsSerial(data + start, std::min(REDUCTION_BLOCK_SIZE, count - start), summation);
+        });
+
+        // Combine the partial sums with the same algorithm
+        return sumElementsSerial(blockSums.data(), blockSums.size(), summation);
+    }
+
+    // Maximum with independent accumulators, NaNs are skipped like in a comparison loop
+    static double maxSerial(const double *data, const std::size_t count)
+    {
+        double lanes[REDUCTION_LANES];
+        std::fill(lanes, lanes + REDUCTION_LANES, std::numeric_limits<double>::lowest());
+
+        std::size_t i = 0;
+        for (; i + REDUCTION_LANES <= count; i += REDUCTION_LANES)
+            for (int lane = 0; lane < REDUCTION_LANES; lane++)
+                lanes[lane] = (data[i + lane] > lanes[lane]) ? data[i + lane] : lanes[lane];
+
+        for (int lane = 0; i < count; i++, lane++)
+            lanes[lane] = (data[i] > lanes[lane]) ? data[i] : lanes[lane];
+
+        double result = lanes[0];
+        for (int lane = 1; lane < REDUCTION_LANES; lane++)
+            result = (lanes[lane] > result) ? lanes[lane] : result;
+
+        return result;
+    }
+
+    double maxElement(const double *data, const std::size_t count)
+    {
+        if (count <= REDUCTION_BLOCK_SIZE)
+            return maxSerial(data, count);
+
+        int numBlocks = (count + REDUCTION_BLOCK_SIZE - 1) / REDUCTION_BLOCK_SIZE;
+        std::vector<double> blockMax(numBlocks);
+
+        getGlobalThreadPool().parallelFor(0, numBlocks, [&](int block) {
+            std::size_t start = block * REDUCTION_BLOCK_SIZE;
+            blockMax[block] = maxSerial(data + start, std::min(REDUCTION_BLOCK_SIZE, count - start));
+        });
+
+        return maxSerial(blockMax.data(), blockMax.size());
+    }
+}
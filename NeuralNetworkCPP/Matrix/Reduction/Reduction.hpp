@@ -0,0 +1,61 @@
+/**
+ * C++ neural network library
+ *
+ * Reduction.hpp
+ */
+
+#ifndef REDUCTION_HPP
+#define REDUCTION_HPP
+
+#include <cstddef>
+
+namespace nn
+{
+    /// Number of elements reduced by one task. Fixed, so the reduction tree does not depend on the number of threads.
+    constexpr std::size_t REDUCTION_BLOCK_SIZE = 4096;
+
+    /**
+     * @brief Enum with the summation algorithms of reductions.
+     *
+     * PAIRWISE_SUMMATION adds halves recursively with eight independent accumulators at the leaves,
+     * which vectorises and keeps the rounding error growing with the logarithm of the size.
+     * KAHAN_SUMMATION carries a compensation term (Kahan-Babuska-Neumaier) so the error does not
+     * grow with the size, its data-dependent selects do not vectorise and make it several times
+     * slower. Both give bitwise identical results for any number of threads.
+     */
+    enum e_summation { PAIRWISE_SUMMATION, KAHAN_SUMMATION };
+
+    /**
+     * @brief Sums an array with a fixed reduction tree.
+     *
+     * Blocks of `REDUCTION_BLOCK_SIZE` elements are summed in parallel and their partial sums are
+     * combined in a fixed order.
+     *
+     * @param data Address of the first element.
+     * @param count Number of elements.
+     * @param summation Summation algorithm (default: PAIRWISE_SUMMATION).
+     * @return The sum, 0 for an empty array.
+     */
+    double sumElements(const double *data, const std::size_t count, const e_summation summation = PAIRWISE_SUMMATION);
+
+    /**
+     * @brief Sums a short array, e.g. a row, with the algorithm of `sumElements` on a single thread.
+     *
+     * @param data Address of the first element.
+     * @param count Number of elements.
+     * @param summation Summation algorithm (default: PAIRWISE_SUMMATION).
+     * @return The sum, 0 for an empty array.
+     */
+    double sumElementsSerial(const double *data, const std::size_t count, const e_summation summation = PAIRWISE_SUMMATION);
+
+    /**
+     * @brief Returns the largest element of an array, using eight independent maxima and parallel blocks.
+     *
+     * @param data Address of the first element.
+     * @param count Number of elements.
+     * @return The largest element, the lowest double for an empty array.
+     */
+    double maxElement(const double *data, const std::size_t count);
+}
+
+#endif
@@ -17,10 +17,10 @@ namespace nn
         Matrix result(m_matrix.getRows(), 1, 0.0);
         auto &pool = getGlobalThreadPool();
 
-        // Parallelize the row-wise addition
-        pool.parallelFor(0, m_matrix.getRows(), [this, &result](int i) {
-            for (int j = 0; j < m_matrix.getCols(); j++)
-                result[{i, 0}] += m_matrix[{i, j}];
+        // Parallelize over the rows, each contiguous row is summed with the vectorised pairwise kernel
+        int cols = m_matrix.getCols();
+        pool.parallelFor(0, m_matrix.getRows(), [this, &result, cols](int i) {
+            result[{i, 0}] = sumElementsSerial(m_matrix.getDataPtr() + static_cast<std::size_t>(i) * cols, cols);
         });
 
         return result;
@@ -0,0 +1,311 @@
+/**
+ * C++ neural network library
+ *
+ * SparseMatrix.cpp
+ */
+
+#include "SparseMatrix.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace nn
+{
+    // Number of dense columns processed by a single task of the transposed product
+    constexpr int SPARSE_COLUMN_TILE = 64;
+
+    SparseMatrix::SparseMatrix() : m_rows(0), m_cols(0), m_rowOffsets({0}), m_values(0, 1) {}
+
+    SparseMatrix::SparseMatrix(const Matrix &matrix)
+        : m_rows(matrix.getRows()), m_cols(matrix.getCols())
+    {
+        std::vector<double> values;
+        m_rowOffsets.reserve(m_rows + 1);
+        m_rowOffsets.push_back(0);
+
+        // Collect the non-zero elements row by row
+        for (int i = 0; i < m_rows; i++)
+        {
+            for (int j = 0; j < m_cols; j++)
+            {
+                if (matrix(i, j) != 0.0)
+                {
+                    m_colIndices.push_back(j);
+                    values.push_back(matrix(i, j));
+                }
+            }
+            m_rowOffsets.push_back(m_colIndices.size());
+        }
+
+        m_values = Matrix(values.size(), 1, values);
+    }
+
+    SparseMatrix::SparseMatrix(const int rows, const int cols, std::vector<int> rowOffsets, std::vector<int> colIndices, const std::vector<double> &values)
+        : m_rows(rows), m_cols(cols), m_rowOffsets(std::move(rowOffsets)), m_colIndices(std::move(colIndices))
+    {
+        // Validate the dimensions and the sizes of the arrays
+        if (rows < 0 || cols < 0 || m_rowOffsets.size() != static_cast<std::size_t>(rows) + 1 || m_colIndices.size() != values.size())
+            throw std::invalid_argument("Invalid sparse matrix dimensions.");
+
+        if (m_rowOffsets.front() != 0 || m_rowOffsets.back() != static_cast<int>(m_colIndices.size()))
+            throw std::invalid_argument("Invalid sparse matrix row offsets.");
+
+        // Validate the structure of each row
+        for (int i = 0; i < rows; i++)
+        {
+            if (m_rowOffsets[i] > m_rowOffsets[i + 1])
+                throw std::invalid_argument("Invalid sparse matrix row offsets.");
+
+            for (int p = m_rowOffsets[i]; p < m_rowOffsets[i + 1]; p++)
+            {
+                if (m_colIndices[p] < 0 || m_colIndices[p] >= cols)
+                    throw std::invalid_argument("Sparse matrix column index out of range.");
+            }
+        }
+
+        m_values = Matrix(values.size(), 1, values);
+    }
+
+    SparseMatrix::SparseMatrix(std::istream &file)
+    {
+        // Check if the stream is readable
+        if (!file.good())
+            throw std::runtime_error("File is not open for reading");
+
+        // Read the dimensions and the number of stored elements
+        int rows, cols, nonZeros;
+        file.read(reinterpret_cast<char *>(&rows), sizeof(rows));
+        file.read(reinterpret_cast<char *>(&cols), sizeof(cols));
+        file.read(reinterpret_cast<char *>(&nonZeros), sizeof(nonZeros));
+
+        if (!file.good() || rows <= 0 || cols <= 0 || nonZeros < 0 || nonZeros > static_cast<long long>(rows) * cols)
+            throw std::runtime_error("Invalid sparse matrix dimensions in file.");
+
+        // Read the structure and the values
+        std::vector<int> rowOffsets(rows + 1);
+        std::vector<int> colIndices(nonZeros);
+        std::vector<double> values(nonZeros);
+        file.read(reinterpret_cast<char *>(rowOffsets.data()), sizeof(int) * rowOffsets.size());
+        file.read(reinterpret_cast<char *>(colIndices.data()), sizeof(int) * nonZeros);
+        file.read(reinterpret_cast<char *>(values.data()), sizeof(double) * nonZeros);
+
+        if (!file.good())
+            throw std::runtime_error("Failed to read sparse matrix from the file.");
+
+        // Validate the structure like arrays passed by the caller, a corrupt file is a read error
+        try
+        {
+            *this = SparseMatrix(rows, cols, std::move(rowOffsets), std::move(colIndices), values);
+        }
+        catch (const std::invalid_argument &error)
+        {
+            throw std::runtime_error(std::string("Failed to read sparse matrix from the file: ") + error.what());
+        }
+    }
+
+    void SparseMatrix::save(std::ostream &file) const
+    {
+        int nonZeros = getNonZeros();
+
+        // Write the dimensions, the structure and the values
+        file.write(reinterpret_cast<const char *>(&m_rows), sizeof(m_rows));
+        file.write(reinterpret_cast<const char *>(&m_cols), sizeof(m_cols));
+        file.write(reinterpret_cast<const char *>(&nonZeros), sizeof(nonZeros));
+        file.write(reinterpret_cast<const char *>(m_rowOffsets.data()), sizeof(int) * m_rowOffsets.size());
+        file.write(reinterpret_cast<const char *>(m_colIndices.data()), sizeof(int) * nonZeros);
+        file.write(reinterpret_cast<const char *>(m_values.getDataPtr()), sizeof(double) * nonZeros);
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write sparse matrix to the file.");
+    }
+
+    Matrix SparseMatrix::toMatrix() const
+    {
+        Matrix result(m_rows, m_cols, 0.0);
+        const double *values = m_values.getDataPtr();
+
+        for (int i = 0; i < m_rows; i++)
+        {
+            for (int p = m_rowOffsets[i]; p < m_rowOffsets[i + 1]; p++)
+                result(i, m_colIndices[p]) = values[p];
+        }
+
+        return result;
+    }
+
+    Matrix SparseMatrix::operator*(const Matrix &dense) const
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (m_cols != dense.getRows())
+            throw std::invalid_argument("Invalid matrix multiplication: A(m x k) * B(k x n) requires A.cols == B.rows.");
+
+        int n = dense.getCols();
+        Matrix result(m_rows, n, 0.0);
+        const double *source = dense.getDataPtr();
+        const double *values = m_values.getDataPtr();
+        double *target = result.getDataPtr();
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize over the rows, each stored element scales a contiguous row of the dense matrix
+        pool.parallelFor(0, m_rows, [this, source, values, target, n](int i) {
+            double *row = target + i * n;
+            for (int p = m_rowOffsets[i]; p < m_rowOffsets[i + 1]; p++)
+            {
+                const double *denseRow = source + m_colIndices[p] * n;
+                double value = values[p];
+                for (int j = 0; j < n; j++)
+                    row[j] += value * denseRow[j];
+            }
+        });
+
+        return result;
+    }
+
+    Matrix SparseMatrix::transposeMultiply(const Matrix &dense) const
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (m_rows != dense.getRows())
+            throw std::invalid_argument("Invalid matrix multiplication: A^T(k x m) * B(m x n) requires A.rows == B.rows.");
+
+        int n = dense.getCols();
+        Matrix result(m_cols, n, 0.0);
+        const double *source = dense.getDataPtr();
+        const double *values = m_values.getDataPtr();
+        double *target = result.getDataPtr();
+        auto &pool = getGlobalThreadPool();
+
+        // Rows of the result are scattered to, so parallelize over tiles of columns instead
+        int numTiles = (n + SPARSE_COLUMN_TILE - 1) / SPARSE_COLUMN_TILE;
+        pool.parallelFor(0, numTiles, [this, source, values, target, n](int tile) {
+            int start = tile * SPARSE_COLUMN_TILE;
+            int end = std::min(n, start + SPARSE_COLUMN_TILE);
+
+            for (int i = 0; i < m_rows; i++)
+            {
+                const double *denseRow = source + i * n;
+                for (int p = m_rowOffsets[i]; p < m_rowOffsets[i + 1]; p++)
+                {
+                    double *row = target + m_colIndices[p] * n;
+                    double value = values[p];
+                    for (int j = start; j < end; j++)
+                        row[j] += value * denseRow[j];
+                }
+            }
+        });
+
+        return result;
+    }
+
+    Matrix SparseMatrix::sampledProduct(const Matrix &left, const Matrix &right) const
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (left.getRows() != m_rows || right.getRows() != m_cols || left.getCols() != right.getCols())
+            throw std::invalid_argument("Sampled product requires left(rows x n) and right(cols x n).");
+
+        int n = left.getCols();
+        Matrix result(getNonZeros(), 1, 0.0);
+        const double *leftData = left.getDataPtr();
+        const double *rightData = right.getDataPtr();
+        double *target = result.getDataPtr();
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize over the rows, each stored element is a dot product of two contiguous rows
+        pool.parallelFor(0, m_rows, [this, leftData, rightData, target, n](int i) {
+            const double *leftRow = leftData + i * n;
+            for (int p = m_rowOffsets[i]; p < m_rowOffsets[i + 1]; p++)
+            {
+                const double *rightRow = rightData + m_colIndices[p] * n;
+                double sum = 0.0;
+                for (int j = 0; j < n; j++)
+                    sum += leftRow[j] * rightRow[j];
+                target[p] = sum;
+            }
+        });
+
+        return result;
+    }
+
+    SparseMatrix SparseMatrix::selectRows(const std::vector<int> &indices) const
+    {
+        SparseMatrix result;
+        result.m_rows = indices.size();
+        result.m_cols = m_cols;
+        result.m_rowOffsets.reserve(indices.size() + 1);
+
+        // Copy the stored elements of each selected row
+        std::vector<double> values;
+        const double *source = m_values.getDataPtr();
+        for (int index : indices)
+        {
+            if (index < 0 || index >= m_rows)
+                throw std::out_of_range("Row index out of range.");
+
+            int start = m_rowOffsets[index];
+            int end = m_rowOffsets[index + 1];
+            result.m_colIndices.insert(result.m_colIndices.end(), m_colIndices.begin() + start, m_colIndices.begin() + end);
+            values.insert(values.end(), source + start, source + end);
+            result.m_rowOffsets.push_back(result.m_colIndices.size());
+        }
+
+        result.m_values = Matrix(values.size(), 1, values);
+        return result;
+    }
+
+    Matrix multiplyTransposed(const Matrix &left, const SparseMatrix &rightTransposed)
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (left.getCols() != rightTransposed.m_cols)
+            throw std::invalid_argument("Invalid matrix multiplication: A(m x k) * B^T(k x n) requires A.cols == B.cols.");
+
+        int k = left.getCols();
+        int n = rightTransposed.m_rows;
+        Matrix result(left.getRows(), n, 0.0);
+        const double *source = left.getDataPtr();
+        double *target = result.getDataPtr();
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize over the rows of the result, each element gathers the stored columns of a row of `left`
+        pool.parallelFor(0, left.getRows(), [&rightTransposed, source, target, k, n](int i) {
+            const double *leftRow = source + static_cast<std::size_t>(i) * k;
+            const double *values = rightTransposed.m_values.getDataPtr();
+            for (int j = 0; j < n; j++)
+            {
+                double sum = 0.0;
+                for (int p = rightTransposed.m_rowOffsets[j]; p < rightTransposed.m_rowOffsets[j + 1]; p++)
+                    sum += leftRow[rightTransposed.m_colIndices[p]] * values[p];
+                target[i * n + j] = sum;
+            }
+        });
+
+        return result;
+    }
+
+    void addProduct(Matrix &target, const Matrix &left, const SparseMatrix &right)
+    {
+        // Validate that the matrices have compatible dimensions.
+        if (left.getCols() != right.m_rows || target.getRows() != left.getRows() || target.getCols() != right.m_cols)
+            throw std::invalid_argument("Invalid matrix multiplication: C(m x k) += A(m x n) * B(n x k) requires matching dimensions.");
+
+        int n = left.getCols();
+        int k = right.m_cols;
+        const double *source = left.getDataPtr();
+        double *destination = target.getDataPtr();
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize over the rows of the target, only the stored columns of `right` are scattered to
+        pool.parallelFor(0, left.getRows(), [&right, source, destination, n, k](int i) {
+            const double *leftRow = source + i * n;
+            double *targetRow = destination + static_cast<std::size_t>(i) * k;
+            const double *values = right.m_values.getDataPtr();
+            for (int j = 0; j < n; j++)
+            {
+                double scale = leftRow[j];
+                for (int p = right.m_rowOffsets[j]; p < right.m_rowOffsets[j + 1]; p++)
+                    targetRow[right.m_colIndices[p]] += scale * values[p];
+            }
+        });
+    }
+}
@@ -0,0 +1,185 @@
+/**
+ * C++ neural network library
+ *
+ * SparseMatrix.hpp
+ */
+
+#ifndef SPARSEMATRIX_HPP
+#define SPARSEMATRIX_HPP
+
+#include "../Matrix.hpp"
+#include <vector>
+
+namespace nn
+{
+    /**
+     * @class SparseMatrix
+     * @brief Matrix in compressed sparse row (CSR) format.
+     *
+     * Only the non-zero elements are stored, row by row. The sparsity pattern is fixed once the
+     * matrix is built, the values are kept in an (nnz x 1) Matrix so they can be updated in place
+     * like any other parameter. Products with dense matrices only touch the stored elements.
+     */
+    class SparseMatrix
+    {
+    private:
+        int m_rows;                     ///< Number of rows in the matrix.
+        int m_cols;                     ///< Number of columns in the matrix.
+        std::vector<int> m_rowOffsets;  ///< Index of the first stored element of each row, followed by the number of stored elements.
+        std::vector<int> m_colIndices;  ///< Column of each stored element.
+        Matrix m_values;                ///< Values of the stored elements (nnz x 1).
+
+    public:
+        /**
+         * @brief Constructs an empty matrix.
+         */
+        SparseMatrix();
+
+        /**
+         * @brief Compresses a dense matrix, every non-zero element is stored.
+         *
+         * @param matrix The dense matrix.
+         */
+        SparseMatrix(const Matrix &matrix);
+
+        /**
+         * @brief Constructs a sparse matrix from its CSR arrays.
+         *
+         * @param rows Number of rows.
+         * @param cols Number of columns.
+         * @param rowOffsets Index of the first stored element of each row, followed by the number of stored elements.
+         * @param colIndices Column of each stored element.
+         * @param values Value of each stored element.
+         * @throws std::invalid_argument If the arrays do not describe a valid (rows x cols) matrix.
+         */
+        SparseMatrix(const int rows, const int cols, std::vector<int> rowOffsets, std::vector<int> colIndices, const std::vector<double> &values);
+
+        /**
+         * @brief Constructs a sparse matrix from a binary stream.
+         *
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the stream is not usable, reading fails or the stored structure is invalid.
+         */
+        SparseMatrix(std::istream &file);
+
+        /**
+         * @brief Saves the matrix to a binary stream.
+         *
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If writing fails.
+         */
+        void save(std::ostream &file) const;
+
+        /**
+         * @brief Expands the matrix to a dense matrix.
+         *
+         * @return The dense matrix.
+         */
+        Matrix toMatrix() const;
+
+        /**
+         * @brief Multiplies the matrix with a dense matrix.
+         *
+         * @param dense Right operand (cols x n).
+         * @return The product (rows x n).
+         * @throws std::invalid_argument If the dimensions do not match.
+         */
+        Matrix operator*(const Matrix &dense) const;
+
+        /**
+         * @brief Multiplies the transpose of the matrix with a dense matrix.
+         *
+         * @param dense Right operand (rows x n).
+         * @return The product (cols x n).
+         * @throws std::invalid_argument If the dimensions do not match.
+         */
+        Matrix transposeMultiply(const Matrix &dense) const;
+
+        /**
+         * @brief Computes `left * right^T` only at the stored positions.
+         *
+         * This is the gradient of the stored values when the matrix multiplies `right`
+         * and `left` is the gradient of the product.
+         *
+         * @param left Left operand (rows x n).
+         * @param right Right operand (cols x n).
+         * @return The products at the stored positions (nnz x 1), in storage order.
+         * @throws std::invalid_argument If the dimensions do not match.
+         */
+        Matrix sampledProduct(const Matrix &left, const Matrix &right) const;
+
+        /**
+         * @brief Gathers rows into a new sparse matrix.
+         *
+         * @param indices Indices of the rows, in the order of the result.
+         * @return The matrix of the selected rows.
+         * @throws std::out_of_range If an index is out of bounds.
+         */
+        SparseMatrix selectRows(const std::vector<int> &indices) const;
+
+        /**
+         * @brief Multiplies a dense matrix with the transpose of a sparse matrix.
+         *
+         * With the samples of a batch stored as sparse rows this is the product of a weight matrix
+         * with the batch, only the weight columns of the stored features are read.
+         *
+         * @param left Left operand (m x k).
+         * @param rightTransposed Right operand stored transposed (n x k).
+         * @return The product (m x n).
+         * @throws std::invalid_argument If the dimensions do not match.
+         */
+        friend Matrix multiplyTransposed(const Matrix &left, const SparseMatrix &rightTransposed);
+
+        /**
+         * @brief Adds the product of a dense and a sparse matrix to a dense matrix.
+         *
+         * Only the columns of `target` with stored elements in `right` are touched.
+         *
+         * @param target Matrix to add the product to (m x k).
+         * @param left Left operand (m x n).
+         * @param right Right operand (n x k).
+         * @throws std::invalid_argument If the dimensions do not match.
+         */
+        friend void addProduct(Matrix &target, const Matrix &left, const SparseMatrix &right);
+
+        /**
+         * @brief Returns the number of rows.
+         *
+         * @return The number of rows.
+         */
+        int getRows() const { return m_rows; }
+
+        /**
+         * @brief Returns the number of columns.
+         *
+         * @return The number of columns.
+         */
+        int getCols() const { return m_cols; }
+
+        /**
+         * @brief Returns the number of stored elements.
+         *
+         * @return The number of non-zeros.
+         */
+        int getNonZeros() const { return m_colIndices.size(); }
+
+        /**
+         * @brief Returns the values of the stored elements.
+         *
+         * @return The (nnz x 1) matrix of values.
+         */
+        Matrix &getValues() { return m_values; }
+
+        /**
+         * @brief Returns the values of the stored elements.
+         *
+         * @return The (nnz x 1) matrix of values.
+         */
+        const Matrix &getValues() const { return m_values; }
+    };
+
+    Matrix multiplyTransposed(const Matrix &left, const SparseMatrix &rightTransposed);
+    void addProduct(Matrix &target, const Matrix &left, const SparseMatrix &right);
+}
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * C++ neural network library
+ *
+ * Transpose.cpp
+ */
+
+#include "Transpose.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace nn
+{
+#if defined(__AVX512F__)
+    // Side of the register blocks, one AVX-512 register holds a row of 8 doubles
+    constexpr int MICRO_BLOCK_SIZE = 8;
+
+    // Transposes an 8x8 block in registers: pairs of rows are interleaved, then 128-bit lanes are gathered twice
+    static inline void transposeMicroBlock(const double *source, const std::ptrdiff_t sourceStride, double *destination, const std::ptrdiff_t destinationStride)
+    {
+        __m512d rows[8];
+        for (int i = 0; i < 8; i++)
+            rows[i] = _mm512_loadu_pd(source + i * sourceStride);
+
+        // t[2k] holds the even, t[2k + 1] the odd columns of rows 2k and 2k + 1
+        __m512d t[8];
+        for (int i = 0; i < 8; i += 2)
+        {
+            t[i] = _mm512_unpacklo_pd(rows[i], rows[i + 1]);
+            t[i + 1] = _mm512_unpackhi_pd(rows[i], rows[i + 1]);
+        }
+
+        // u holds columns {0, 4}, {2, 6}, {1, 5} and {3, 7} of rows 0-3, then of rows 4-7
+        __m512d u[8];
+        for (int half = 0; half < 8; half += 4)
+        {
+            u[half] = _mm512_shuffle_f64x2(t[half], t[half + 2], 0x88);
+            u[half + 1] = _mm512_shuffle_f64x2(t[half], t[half + 2], 0xDD);
+            u[half + 2] = _mm512_shuffle_f64x2(t[half + 1], t[half + 3], 0x88);
+            u[half + 3] = _mm512_shuffle_f64x2(t[half + 1], t[half + 3], 0xDD);
+        }
+
+        // Join the halves of each column, u[0] holds columns 0 and 4, u[2] columns 1 and 5 and so on
+        static constexpr int COLUMN_SOURCE[4] = {0, 2, 1, 3};
+        for (int col = 0; col < 4; col++)
+        {
+            int k = COLUMN_SOURCE[col];
+            _mm512_storeu_pd(destination + col * destinationStride, _mm512_shuffle_f64x2(u[k], u[k + 4], 0x88));
+            _mm512_storeu_pd(destination + (col + 4) * destinationStride, _mm512_shuffle_f64x2(u[k], u[k + 4], 0xDD));
+        }
+    }
+#elif defined(__AVX__)
+    // Side of the register blocks, one AVX register holds a row of 4 doubles
+    constexpr int MICRO_BLOCK_SIZE = 4;
+
+    // Transposes a 4x4 block in registers: pairs of rows are interleaved, then 128-bit lanes are swapped
+    static inline void transposeMicroBlock(const double *source, const std::ptrdiff_t sourceStride, double *destination, const std::ptrdiff_t destinationStride)
+    {
+        __m256d row0 = _mm256_loadu_pd(source);
+        __m256d row1 = _mm256_loadu_pd(source + sourceStride);
+        __m256d row2 = _mm256_loadu_pd(source + 2 * sourceStride);
+        __m256d row3 = _mm256_loadu_pd(source + 3 * sourceStride);
+
+        __m256d t0 = _mm256_unpacklo_pd(row0, row1);
+        __m256d t1 = _mm256_unpackhi_pd(row0, row1);
+        __m256d t2 = _mm256_unpacklo_pd(row2, row3);
+        __m256d t3 = _mm256_unpackhi_pd(row2, row3);
+
+        _mm256_storeu_pd(destination, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(destination + destinationStride, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(destination + 2 * destinationStride, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(destination + 3 * destinationStride, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+#else
+    constexpr int MICRO_BLOCK_SIZE = 4;
+
+    // Transposes a 4x4 block through locals, so all loads are issued before the stores
+    static inline void transposeMicroBlock(const double *source, const std::ptrdiff_t sourceStride, double *destination, const std::ptrdiff_t destinationStride)
+    {
+        double block[4][4];
+        for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 4; j++)
+                block[i][j] = source[i * sourceStride + j];
+
+        for (int j = 0; j < 4; j++)
+            for (int i = 0; i < 4; i++)
+                destination[j * destinationStride + i] = block[i][j];
+    }
+#endif
+
+    // Transposes one tile of at most TRANSPOSE_BLOCK_SIZE x TRANSPOSE_BLOCK_SIZE elements
+    static void transposeTile(const double *source, const int rows, const int cols, const std::ptrdiff_t sourceStride,
+                              double *destination, const std::ptrdiff_t destinationStride)
+    {
+        int fullRows = rows / MICRO_BLOCK_SIZE * MICRO_BLOCK_SIZE;
+        int fullCols = cols / MICRO_BLOCK_SIZE * MICRO_BLOCK_SIZE;
+
+        // Register blocks cover the largest part of the tile
+        for (int i = 0; i < fullRows; i += MICRO_BLOCK_SIZE)
+            for (int j = 0; j < fullCols; j += MICRO_BLOCK_SIZE)
+                transposeMicroBlock(source + i * sourceStride + j, sourceStride, destination + j * destinationStride + i, destinationStride);
+
+        // Columns right of the register blocks
+        for (int i = 0; i < fullRows; i++)
+            for (int j = fullCols; j < cols; j++)
+                destination[j * destinationStride + i] = source[i * sourceStride + j];
+
+        // Rows below the register blocks
+        for (int i = fullRows; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                destination[j * destinationStride + i] = source[i * sourceStride + j];
+    }
+
+    void transposeElements(const double *source, const int rows, const int cols, const std::ptrdiff_t sourceStride,
+                           double *destination, const std::ptrdiff_t destinationStride)
+    {
+        int numBands = (rows + TRANSPOSE_BLOCK_SIZE - 1) / TRANSPOSE_BLOCK_SIZE;
+
+        // Each task transposes a band of source rows into a band of destination columns
+        getGlobalThreadPool().parallelFor(0, numBands, [&](int band) {
+            int row = band * TRANSPOSE_BLOCK_SIZE;
+            int bandRows = std::min(TRANSPOSE_BLOCK_SIZE, rows - row);
+
+            for (int col = 0; col < cols; col += TRANSPOSE_BLOCK_SIZE)
+                transposeTile(source + row * sourceStride + col, bandRows, std::min(TRANSPOSE_BLOCK_SIZE, cols - col), sourceStride,
+                              destination + col * destinationStride + row, destinationStride);
+        });
+    }
+
+    void transposeElementsInPlace(double *data, const int size)
+    {
+        int numBands = (size + TRANSPOSE_BLOCK_SIZE - 1) / TRANSPOSE_BLOCK_SIZE;
+
+        // Task i swaps the tiles (i, j) and (j, i) for j >= i, the pairs of different tasks never overlap
+        getGlobalThreadPool().parallelFor(0, numBands, [&](int band) {
+            alignas(64) double buffer[TRANSPOSE_BLOCK_SIZE * TRANSPOSE_BLOCK_SIZE];
+            int row = band * TRANSPOSE_BLOCK_SIZE;
+            int tileRows = std::min(TRANSPOSE_BLOCK_SIZE, size - row);
+
+            for (int col = row; col < size; col += TRANSPOSE_BLOCK_SIZE)
+            {
+                int tileCols = std::min(TRANSPOSE_BLOCK_SIZE, size - col);
+                double *upper = data + static_cast<std::ptrdiff_t>(row) * size + col;
+                double *lower = data + static_cast<std::ptrdiff_t>(col) * size + row;
+
+                // Park the transpose of the upper tile, move the transpose of the lower tile up, then store the parked one
+                transposeTile(upper, tileRows, tileCols, size, buffer, TRANSPOSE_BLOCK_SIZE);
+                if (col != row)
+                    transposeTile(lower, tileCols, tileRows, size, upper, size);
+
+                for (int i = 0; i < tileCols; i++)
+                    std::memcpy(lower + i * size, buffer + i * TRANSPOSE_BLOCK_SIZE, tileRows * sizeof(double));
+            }
+        });
+    }
+}
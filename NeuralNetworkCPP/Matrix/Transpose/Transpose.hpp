@@ -0,0 +1,46 @@
+/**
+ * C++ neural network library
+ *
+ * Transpose.hpp
+ */
+
+#ifndef TRANSPOSE_HPP
+#define TRANSPOSE_HPP
+
+#include <cstddef>
+
+namespace nn
+{
+    /// Side of the square tiles a transpose works on, a source and a destination tile fit into L1 together.
+    constexpr int TRANSPOSE_BLOCK_SIZE = 32;
+
+    /**
+     * @brief Transposes a row-major array into another one, the kernel behind `Matrix::transpose`.
+     *
+     * The array is cut into `TRANSPOSE_BLOCK_SIZE` tiles, so reads and writes both stay within a
+     * few cache lines and pages, and every tile is transposed in 8x8 (AVX-512) or 4x4 (AVX)
+     * register blocks. Bands of tile rows are processed in parallel.
+     *
+     * @param source Address of element (0, 0) of the source.
+     * @param rows Number of rows of the source.
+     * @param cols Number of columns of the source.
+     * @param sourceStride Distance between two source rows in elements.
+     * @param destination Address of element (0, 0) of the destination (cols x rows), must not overlap the source.
+     * @param destinationStride Distance between two destination rows in elements.
+     */
+    void transposeElements(const double *source, const int rows, const int cols, const std::ptrdiff_t sourceStride,
+                           double *destination, const std::ptrdiff_t destinationStride);
+
+    /**
+     * @brief Transposes a square row-major array in place.
+     *
+     * Pairs of tiles mirrored across the diagonal are swapped through a buffer on the stack, so no
+     * second array is allocated.
+     *
+     * @param data Address of element (0, 0).
+     * @param size Number of rows and columns.
+     */
+    void transposeElementsInPlace(double *data, const int size);
+}
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * C++ neural network library
+ *
+ * AlignedAllocator.hpp
+ */
+
+#ifndef ALIGNEDALLOCATOR_HPP
+#define ALIGNEDALLOCATOR_HPP
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace nn
+{
+    /**
+     * @brief Alignment (in bytes) of the buffers used by vectorised kernels, one cache line.
+     */
+    constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * @class AlignedAllocator
+     * @brief Standard library compatible allocator returning cache line aligned memory.
+     *
+     * Aligned buffers never split a SIMD load across two cache lines.
+     *
+     * @tparam T Type of the allocated elements.
+     */
+    template <typename T>
+    class AlignedAllocator
+    {
+    public:
+        using value_type = T; ///< Type of the allocated elements.
+
+        /** @brief Default constructor. */
+        AlignedAllocator() noexcept = default;
+
+        /** @brief Converting constructor required by the standard containers. */
+        template <typename U>
+        AlignedAllocator(const AlignedAllocator<U> &) noexcept {}
+
+        /**
+         * @brief Allocates aligned storage for `count` elements.
+         *
+         * @param count Number of elements.
+         * @return Pointer to the allocated storage.
+         */
+        T *allocate(std::size_t count)
+        {
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(CACHE_LINE_SIZE)));
+        }
+
+        /**
+         * @brief Releases storage obtained from `allocate`.
+         *
+         * @param ptr Pointer to the storage.
+         */
+        void deallocate(T *ptr, std::size_t) noexcept
+        {
+            ::operator delete(ptr, std::align_val_t(CACHE_LINE_SIZE));
+        }
+
+        /** @brief All aligned allocators are interchangeable. */
+        template <typename U>
+        bool operator==(const AlignedAllocator<U> &) const noexcept { return true; }
+
+        template <typename U>
+        bool operator!=(const AlignedAllocator<U> &) const noexcept { return false; }
+    };
+
+    /**
+     * @brief Vector with cache line aligned storage.
+     */
+    template <typename T>
+    using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+}
+
+#endif
@@ -7,47 +7,160 @@
 #include "ModelEvaluator.hpp"
 #include <cmath>
 #include <algorithm>
+#include <iterator>
 
 namespace nn
 {
+    // Activations between the layers of single-sample predictions, kept by each thread for its next call
+    static thread_local std::vector<double> sampleScratch[2];
+
+    ModelEvaluator::InferenceModeScope::InferenceModeScope(ModelEvaluator &model)
+    {
+        for (const auto &layer : model.m_layers)
+        {
+            if (layer->getType() != BATCH_NORM)
+                continue;
+
+            // Remember the mode of the layer before switching it
+            BatchNormalization *bnLayer = dynamic_cast<BatchNormalization *>(layer.get());
+            if (bnLayer)
+            {
+                m_previous.emplace_back(bnLayer, bnLayer->isTrainingMode());
+                bnLayer->setTrainingMode(false);
+            }
+        }
+    }
+
+    ModelEvaluator::InferenceModeScope::~InferenceModeScope()
+    {
+        for (auto [bnLayer, isTraining] : m_previous)
+            bnLayer->setTrainingMode(isTraining);
+    }
+
     std::vector<double> ModelEvaluator::predict(const std::vector<double> &input)
     {
+        // Use the low-latency path if all layers support it
+        std::vector<double> output;
+        if (predictSample(input, output))
+            return output;
+
         // Set all BatchNormalization layers to inference mode
-        setBatchTrainingMode(false);
+        InferenceModeScope inferenceScope(*this);
 
-        // Convert the input vector to a matrix
-        Matrix output = Matrix(input.size(), 1, input);
+        // Perform forward propagation on the input vector as a single sample
+        int size = input.size();
+        Matrix batch = (m_layout == SAMPLE_MAJOR) ? forward(MatrixView(input.data(), 1, size)) : forward(MatrixView(input.data(), size, 1));
 
-        // Perform forward propagation
-        output = forward(output);
+        // Return the output as a vector
+        return batch.getData();
+    }
 
-        // Set all BatchNormalization layers back to training mode
-        setBatchTrainingMode(true);
+    bool ModelEvaluator::predictSample(const std::vector<double> &input, std::vector<double> &output) const
+    {
+        if (m_layers.empty())
+            return false;
 
-        // Return the output as a vector
-        return output.getData();
+        // Check that every layer has a single-sample path and find the largest intermediate output
+        int size = input.size();
+        std::size_t scratchSize = 0;
+        for (const auto &layer : m_layers)
+        {
+            size = layer->getSampleOutputSize(size);
+            if (size <= 0)
+                return false;
+            scratchSize = std::max(scratchSize, static_cast<std::size_t>(size));
+        }
+
+        // The scratch buffers only grow, so repeated calls of a thread do not allocate
+        for (std::vector<double> &buffer : sampleScratch)
+            if (buffer.size() < scratchSize)
+                buffer.resize(scratchSize);
+
+        // Alternate between the two buffers, the last layer writes into the result
+        output.resize(size);
+        const double *layerInput = input.data();
+        for (std::size_t i = 0; i < m_layers.size(); i++)
+        {
+            double *layerOutput = (i + 1 == m_layers.size()) ? output.data() : sampleScratch[i % 2].data();
+            m_layers[i]->predictSample(layerInput, layerOutput);
+            layerInput = layerOutput;
+        }
+
+        return true;
     }
 
     std::vector<std::vector<double>> ModelEvaluator::predict(const std::vector<std::vector<double>> &input)
     {
         // Set all BatchNormalization layers to inference mode
-        setBatchTrainingMode(false);
+        InferenceModeScope inferenceScope(*this);
 
-        // Perform forward propagation
-        Matrix forwardOutput = forward(Matrix(input).transpose()).transpose();
+        // Stream micro-batches through the pipeline stages if the model is split into stages
         std::vector<std::vector<double>> result;
+        Pipeline *pipeline = getPipeline();
+        int step = pipeline ? getPipelineMicroBatchSize(input.size()) : input.size();
 
-        // Convert the output matrix to a vector of vectors
-        for (int i = 0; i < forwardOutput.getRows(); i++)
+        if (pipeline && step < static_cast<int>(input.size()))
         {
-            std::vector<double> row;
-            for (int j = 0; j < forwardOutput.getCols(); j++)
-                row.push_back(forwardOutput[{i, j}]);
-            result.push_back(row);
+            result = predictPipelined(*pipeline, input, step);
         }
+        else
+        {
+            // Perform forward propagation, the samples are already the rows of a sample-major batch
+            Matrix batch = (m_layout == SAMPLE_MAJOR) ? Matrix(input) : Matrix(input).transpose();
+            result = toSamples(forward(batch));
+        }
+
+        // Return the output vector
+        return result;
+    }
+
+    std::vector<std::vector<double>> ModelEvaluator::predictPipelined(
+        Pipeline &pipeline,
+        const std::vector<std::vector<double>> &input,
+        const int microBatchSize
+    )
+    {
+        // Create the micro-batches with the memory configuration of the model
+        MemoryConfigScope memoryScope(m_memoryConfig);
+
+        // Split the samples into micro-batches in the layout of the model
+        std::vector<Matrix> microBatches;
+        for (std::size_t i = 0; i < input.size(); i += microBatchSize)
+        {
+            std::vector<std::vector<double>> samples(input.begin() + i, input.begin() + std::min(input.size(), i + microBatchSize));
+            microBatches.push_back((m_layout == SAMPLE_MAJOR) ? Matrix(samples) : Matrix(samples).transpose());
+        }
+
+        // Pass them through the stages and gather the outputs in the order of the samples
+        std::vector<std::vector<double>> result;
+        for (Matrix &output : pipeline.forward(std::move(microBatches), false))
+        {
+            std::vector<std::vector<double>> samples = toSamples(std::move(output));
+            result.insert(result.end(), std::make_move_iterator(samples.begin()), std::make_move_iterator(samples.end()));
+        }
+
+        return result;
+    }
+
+    std::vector<std::vector<double>> ModelEvaluator::predict(const SparseMatrix &input)
+    {
+        // Set all BatchNormalization layers to inference mode
+        InferenceModeScope inferenceScope(*this);
+
+        // Perform forward propagation
+        std::vector<std::vector<double>> result = toSamples(forward(input));
+
+        // Return the output vector
+        return result;
+    }
+
+    std::vector<std::vector<double>> ModelEvaluator::predict(const MatrixView &input)
+    {
+        // Set all BatchNormalization layers to inference mode
+        InferenceModeScope inferenceScope(*this);
 
-        // Set all BatchNormalization layers back to training mode
-        setBatchTrainingMode(true);
+        // Perform forward propagation
+        std::vector<std::vector<double>> result = toSamples(forward(input));
 
         // Return the output vector
         return result;
@@ -70,13 +183,71 @@ namespace nn
         return computeMetric(predictions, yTest, metric);
     }
 
+    double ModelEvaluator::evaluate(
+        const SparseMatrix &xTest,
+        const std::vector<std::vector<double>> &yTest,
+        const e_metric metric
+    )
+    {
+        // Check if the test data is empty
+        if (xTest.getRows() == 0 || yTest.empty())
+            return 0.0;
+
+        // Get predictions for the test data and compute the specified metric
+        return computeMetric(predict(xTest), yTest, metric);
+    }
+
     Matrix ModelEvaluator::forward(const Matrix &input)
     {
+        if (m_layers.empty())
+            return input;
+
+        // Create the activations with the memory configuration of the model
+        MemoryConfigScope memoryScope(m_memoryConfig);
+
+        // Propagate the input forward through the layers, each output is moved into the next input
+        Matrix output = m_layers.front()->forward(input);
+
+        for (auto it = m_layers.begin() + 1; it != m_layers.end(); it++)
+            output = (*it)->forward(output);
+
+        return output;
+    }
+
+    Matrix ModelEvaluator::forward(const SparseMatrix &input)
+    {
+        // Only a dense layer can take sparse input
+        DenseLayer *firstLayer = m_layers.empty() ? nullptr : dynamic_cast<DenseLayer *>(m_layers.front().get());
+        if (!firstLayer)
+            throw std::invalid_argument("The first layer must be a DenseLayer to take sparse input.");
+
+        // Create the activations with the memory configuration of the model
+        MemoryConfigScope memoryScope(m_memoryConfig);
+
         // Propagate the input forward through the layers
-        Matrix output = input;
+        Matrix output = firstLayer->forward(input);
 
-        for (const auto &layer : m_layers)
-            output = layer->forward(output);
+        for (auto it = m_layers.begin() + 1; it != m_layers.end(); it++)
+            output = (*it)->forward(output);
+
+        return output;
+    }
+
+    Matrix ModelEvaluator::forward(const MatrixView &input)
+    {
+        // Only a dense layer reads a view directly, others get a copy
+        DenseLayer *firstLayer = m_layers.empty() ? nullptr : dynamic_cast<DenseLayer *>(m_layers.front().get());
+        if (!firstLayer)
+            return forward(input.toMatrix());
+
+        // Create the activations with the memory configuration of the model
+        MemoryConfigScope memoryScope(m_memoryConfig);
+
+        // Propagate the input forward through the layers
+        Matrix output = firstLayer->forward(input);
+
+        for (auto it = m_layers.begin() + 1; it != m_layers.end(); it++)
+            output = (*it)->forward(output);
 
         return output;
     }
@@ -105,6 +276,27 @@ namespace nn
         return result;
     }
 
+    std::vector<double> ModelEvaluator::evaluate(
+        const SparseMatrix &xTest,
+        const std::vector<std::vector<double>> &yTest,
+        const std::vector<e_metric> &metrics
+    )
+    {
+        std::vector<double> result(2, 0.0);
+
+        // Check if the test data is empty
+        if (xTest.getRows() == 0 || yTest.empty())
+            return result;
+
+        std::vector<std::vector<double>> predictions = predict(xTest);
+
+        // Compute each metric
+        for (auto const metric : metrics)
+            result[static_cast<int>(metric)] = computeMetric(predictions, yTest, metric);
+
+        return result;
+    }
+
     void ModelEvaluator::setBatchTrainingMode(const bool isTraining)
     {
         for (const auto &layer : m_layers)
@@ -119,6 +311,23 @@ namespace nn
         }
     }
 
+    std::vector<std::vector<double>> ModelEvaluator::toSamples(Matrix output) const
+    {
+        Matrix samples = (m_layout == SAMPLE_MAJOR) ? std::move(output) : output.transpose();
+        std::vector<std::vector<double>> result;
+
+        // Convert the output matrix to a vector of vectors
+        for (int i = 0; i < samples.getRows(); i++)
+        {
+            std::vector<double> row;
+            for (int j = 0; j < samples.getCols(); j++)
+                row.push_back(samples[{i, j}]);
+            result.push_back(row);
+        }
+
+        return result;
+    }
+
     double ModelEvaluator::computeMetric(
         const std::vector<std::vector<double>> &predictions,
         const std::vector<std::vector<double>> &targets,
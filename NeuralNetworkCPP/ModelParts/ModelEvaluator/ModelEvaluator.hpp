@@ -22,6 +22,11 @@ namespace nn
         /**
          * @brief Predicts the output for a given input.
          *
+         * If every layer has a single-sample path (dense layers in double precision and batch
+         * normalization), the sample is passed through matrix-vector kernels and per-thread scratch
+         * buffers without building matrices or switching the batch normalization mode. Other
+         * models run the sample as a batch of one.
+         *
          * @param input The input vector.
          * @return The predicted output vector.
          */
@@ -30,11 +35,36 @@ namespace nn
         /**
          * @brief Predicts the output for a given vector of inputs.
          *
+         * With pipeline stages (see `setPipelineStages`) the inputs are streamed through the stages
+         * in micro-batches.
+         *
          * @param input The vector of vector of inputs.
          * @return The predicted vector of vector of outputs.
          */
         std::vector<std::vector<double>> predict(const std::vector<std::vector<double>> &input);
 
+        /**
+         * @brief Predicts the outputs for sparse inputs.
+         *
+         * @param input The sparse inputs, one sample per row. The first layer must be a DenseLayer.
+         * @return The predicted vector of vector of outputs.
+         * @throws std::invalid_argument If the first layer cannot take sparse input.
+         */
+        std::vector<std::vector<double>> predict(const SparseMatrix &input);
+
+        /**
+         * @brief Predicts the outputs for inputs in existing memory without copying them.
+         *
+         * In the feature-major layout a sample-major buffer is passed as
+         * `MatrixView(data, numSamples, numFeatures).transpose()`, in the sample-major layout as
+         * `MatrixView(data, numSamples, numFeatures)`. The view is read directly if the first layer
+         * is a DenseLayer, otherwise it is copied.
+         *
+         * @param input The inputs in the layout of the model (see `setLayout`).
+         * @return The predicted vector of vector of outputs.
+         */
+        std::vector<std::vector<double>> predict(const MatrixView &input);
+
         /**
          * @brief Evaluates the model on the provided test data.
          *
@@ -49,6 +79,20 @@ namespace nn
             const e_metric metric = ACCURACY_LOG
         );
 
+        /**
+         * @brief Evaluates the model on the provided sparse test data.
+         *
+         * @param xTest Sparse test data, one sample per row.
+         * @param yTest Test labels (vector of output vectors).
+         * @param metric The metric to compute (default: ACCURACY_LOG).
+         * @return The computed metric.
+         */
+        double evaluate(
+            const SparseMatrix &xTest,
+            const std::vector<std::vector<double>> &yTest,
+            const e_metric metric = ACCURACY_LOG
+        );
+
     protected:
         /**
          * @brief Performs forward propagation through the network.
@@ -58,6 +102,23 @@ namespace nn
          */
         Matrix forward(const Matrix &input);
 
+        /**
+         * @brief Performs forward propagation of sparse input through the network.
+         *
+         * @param input The sparse input, one sample per row.
+         * @return The output matrix, one sample per column.
+         * @throws std::invalid_argument If the first layer cannot take sparse input.
+         */
+        Matrix forward(const SparseMatrix &input);
+
+        /**
+         * @brief Performs forward propagation of a view in inference mode.
+         *
+         * @param input The input in the layout of the model.
+         * @return The output matrix in the layout of the model.
+         */
+        Matrix forward(const MatrixView &input);
+
         /**
          * @brief Evaluates the model on the provided test data.
          *
@@ -72,7 +133,20 @@ namespace nn
             const std::vector<e_metric> &metrics
         );
 
-    private:
+        /**
+         * @brief Evaluates the model on the provided sparse test data.
+         *
+         * @param xTest Sparse test data, one sample per row.
+         * @param yTest Test labels (vector of output vectors).
+         * @param metrics The vector of metrics to compute.
+         * @return The vector of computed metrics.
+         */
+        std::vector<double> evaluate(
+            const SparseMatrix &xTest,
+            const std::vector<std::vector<double>> &yTest,
+            const std::vector<e_metric> &metrics
+        );
+
         /**
          * @brief Set the training flag for all BatchNormalization layers.
          *
@@ -80,6 +154,65 @@ namespace nn
          */
         void setBatchTrainingMode(const bool isTraining);
 
+        /**
+         * @class InferenceModeScope
+         * @brief Sets all BatchNormalization layers to inference mode until the end of its scope.
+         *
+         * The previous mode of each layer is restored when the scope is left, also by an exception.
+         */
+        class InferenceModeScope
+        {
+        private:
+            std::vector<std::pair<BatchNormalization *, bool>> m_previous; ///< Switched layers and their previous mode.
+
+        public:
+            /**
+             * @brief Switches the BatchNormalization layers of a model to inference mode.
+             *
+             * @param model The model, its BatchNormalization layers must outlive the scope.
+             */
+            explicit InferenceModeScope(ModelEvaluator &model);
+
+            /** @brief Restores the previous mode of each switched layer. */
+            ~InferenceModeScope();
+
+            InferenceModeScope(const InferenceModeScope &) = delete;
+            InferenceModeScope &operator=(const InferenceModeScope &) = delete;
+        };
+
+    private:
+
+        /**
+         * @brief Passes a single sample through the single-sample paths of the layers.
+         *
+         * @param input The input vector.
+         * @param output Receives the output vector.
+         * @return False without touching the output if a layer has no single-sample path.
+         */
+        bool predictSample(const std::vector<double> &input, std::vector<double> &output) const;
+
+        /**
+         * @brief Passes inputs through the pipeline stages in micro-batches.
+         *
+         * @param pipeline The pipeline over the layers.
+         * @param input The vector of vector of inputs.
+         * @param microBatchSize Number of samples per micro-batch.
+         * @return The predicted vector of vector of outputs.
+         */
+        std::vector<std::vector<double>> predictPipelined(
+            Pipeline &pipeline,
+            const std::vector<std::vector<double>> &input,
+            const int microBatchSize
+        );
+
+        /**
+         * @brief Converts the output matrix of the network to one vector per sample.
+         *
+         * @param output The output matrix in the layout of the model.
+         * @return The vector of vector of outputs.
+         */
+        std::vector<std::vector<double>> toSamples(Matrix output) const;
+
         /**
          * @brief Computes the provided metric.
          *
@@ -5,16 +5,122 @@
  */
 
 #include "ModelLayers.hpp"
+#include <algorithm>
 
 namespace nn
 {
     void ModelLayers::addLayer(std::unique_ptr<Layer> layer)
     {
         // Add the layer to the network
+        configureLayer(*layer);
         m_layers.push_back(std::move(layer));
     }
 
-    void ModelLayers::initLayer(e_layerType layerType, std::ifstream &file)
+    void ModelLayers::configureLayer(Layer &layer)
+    {
+        // The stages hold pointers to the layers, they are split again on next use
+        m_pipeline.reset();
+
+        layer.setMathPolicy(m_mathPolicy);
+        layer.setLayout(m_layout);
+
+        // Move the parameters and their gradients into buffers with the memory configuration of the model
+        ParameterRegistry registry;
+        layer.registerParameters(registry);
+
+        for (int slot = 0; slot < registry.getCount(); slot++)
+        {
+            registry.getValue(slot).setMemoryConfig(m_memoryConfig);
+            if (Matrix *gradient = registry.getGradient(slot))
+                gradient->setMemoryConfig(m_memoryConfig);
+        }
+    }
+
+    void ModelLayers::setMathPolicy(const e_mathPolicy policy)
+    {
+        // Apply the policy to the existing layers and remember it for new ones
+        m_mathPolicy = policy;
+
+        for (const auto &layer : m_layers)
+            layer->setMathPolicy(policy);
+    }
+
+    void ModelLayers::setMemoryConfig(const MemoryConfig &config)
+    {
+        // Apply the configuration to the existing layers and remember it for new ones
+        m_memoryConfig = config;
+
+        for (const auto &layer : m_layers)
+            configureLayer(*layer);
+    }
+
+    void ModelLayers::setLayout(const e_layout layout)
+    {
+        // Apply the layout to the existing layers, restore the previous one if a layer rejects it
+        std::size_t configured = 0;
+        try
+        {
+            for (; configured < m_layers.size(); configured++)
+                m_layers[configured]->setLayout(layout);
+        }
+        catch (...)
+        {
+            for (std::size_t i = 0; i < configured; i++)
+                m_layers[i]->setLayout(m_layout);
+            throw;
+        }
+
+        m_layout = layout;
+        m_pipeline.reset();
+    }
+
+    void ModelLayers::setPipelineStages(const int numStages, const int microBatchSize)
+    {
+        if (numStages < 1)
+            throw std::invalid_argument("The number of pipeline stages must be at least 1.");
+        if (microBatchSize < 0)
+            throw std::invalid_argument("The micro-batch size must not be negative.");
+
+        m_pipelineStages = numStages;
+        m_pipelineMicroBatchSize = microBatchSize;
+        m_pipeline.reset();
+    }
+
+    std::vector<PipelineStageStats> ModelLayers::getPipelineStats() const
+    {
+        return m_pipeline ? m_pipeline->getStats() : std::vector<PipelineStageStats>();
+    }
+
+    Pipeline *ModelLayers::getPipeline()
+    {
+        if (m_pipelineStages <= 1 || m_layers.size() < 2)
+            return nullptr;
+
+        // Build the stages with the current layers and configuration
+        if (!m_pipeline)
+        {
+            std::vector<Layer *> layers;
+            for (const auto &layer : m_layers)
+                layers.push_back(layer.get());
+
+            int numStages = std::min(m_pipelineStages, static_cast<int>(layers.size()));
+            m_pipeline = std::make_unique<Pipeline>(layers, numStages, m_layout, m_memoryConfig);
+        }
+
+        return m_pipeline.get();
+    }
+
+    int ModelLayers::getPipelineMicroBatchSize(const int batchSize) const
+    {
+        if (m_pipelineMicroBatchSize > 0)
+            return m_pipelineMicroBatchSize;
+
+        // Enough micro-batches to keep the stages busy most of the batch
+        int numMicroBatches = std::min(m_pipelineStages, static_cast<int>(m_layers.size())) * PIPELINE_MICRO_BATCHES_PER_STAGE;
+        return std::max(1, (batchSize + numMicroBatches - 1) / numMicroBatches);
+    }
+
+    void ModelLayers::initLayer(e_layerType layerType, std::istream &file)
     {
         // Initialize the layer based on the type
         switch (layerType)
@@ -26,9 +132,87 @@ namespace nn
         case BATCH_NORM:
             addLayer(std::make_unique<BatchNormalization>(file));
             break;
+
+        case QUANTIZED_DENSE:
+            addLayer(std::make_unique<QuantizedDenseLayer>(file));
+            break;
+
+        case SPARSE_DENSE:
+            addLayer(std::make_unique<SparseDenseLayer>(file));
+            break;
+
+        case EMBEDDING:
+            addLayer(std::make_unique<Embedding>(file));
+            break;
         
         default:
             throw std::runtime_error("Invalid layer type.");
         }
     }
+
+    void ModelLayers::saveLayers(std::ostream &file) const
+    {
+        // Save the number of network layers
+        int numLayers = m_layers.size();
+        file.write(reinterpret_cast<const char *>(&numLayers), sizeof(numLayers));
+
+        // Save each layer
+        for (const auto &layer : m_layers)
+        {
+            // Save the layer type
+            e_layerType layerType = layer->getType();
+            file.write(reinterpret_cast<const char *>(&layerType), sizeof(layerType));
+
+            // Save the layer
+            layer->save(file);
+        }
+    }
+
+    std::function<void(std::ostream &)> ModelLayers::snapshotLayers() const
+    {
+        // Copy the type and the state of each layer
+        std::vector<e_layerType> types;
+        std::vector<std::function<void(std::ostream &)>> snapshots;
+        for (const auto &layer : m_layers)
+        {
+            types.push_back(layer->getType());
+            snapshots.push_back(layer->snapshot());
+        }
+
+        return [types = std::move(types), snapshots = std::move(snapshots)](std::ostream &file) {
+            // Save the number of network layers
+            int numLayers = types.size();
+            file.write(reinterpret_cast<const char *>(&numLayers), sizeof(numLayers));
+
+            // Save the type and the state of each layer
+            for (int i = 0; i < numLayers; i++)
+            {
+                file.write(reinterpret_cast<const char *>(&types[i]), sizeof(types[i]));
+                snapshots[i](file);
+            }
+        };
+    }
+
+    void ModelLayers::loadLayers(std::istream &file)
+    {
+        // Read the number of layers
+        int numLayers;
+        file.read(reinterpret_cast<char *>(&numLayers), sizeof(numLayers));
+
+        if (!file.good() || numLayers < 0)
+            throw std::runtime_error("Failed to read model from the file.");
+
+        // Read each layer
+        m_pipeline.reset();
+        m_layers.clear();
+        for (int i = 0; i < numLayers; i++)
+        {
+            // Read the layer type
+            e_layerType layerType;
+            file.read(reinterpret_cast<char *>(&layerType), sizeof(layerType));
+
+            // Instantiate the correct layer type
+            initLayer(layerType, file);
+        }
+    }
 }
\ No newline at end of file
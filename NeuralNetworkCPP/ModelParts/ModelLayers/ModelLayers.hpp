@@ -5,6 +5,7 @@
  */
 
 #include "../../Layers/Layers.hpp"
+#include "../../Pipeline/Pipeline.hpp"
 
 namespace nn
 {
@@ -18,6 +19,12 @@ namespace nn
     {
     protected:
         std::vector<std::unique_ptr<Layer>> m_layers; ///< Vector of layers in the network.
+        e_mathPolicy m_mathPolicy = STANDARD_MATH;    ///< Implementation of the transcendental functions of the activations.
+        MemoryConfig m_memoryConfig;                  ///< Memory backing the parameters and the matrices created during training and inference.
+        e_layout m_layout = FEATURE_MAJOR;            ///< Layout of the samples in the batches passed through the layers.
+        int m_pipelineStages = 1;                     ///< Number of pipeline stages the layers are split into (1: no pipeline).
+        int m_pipelineMicroBatchSize = 0;             ///< Size of the micro-batches streamed through the pipeline (0: automatic).
+        std::unique_ptr<Pipeline> m_pipeline;         ///< Pipeline over the layers, built on first use and destroyed before them.
 
     public:
         /**
@@ -27,14 +34,117 @@ namespace nn
          */
         void addLayer(std::unique_ptr<Layer> layer);
 
+        /**
+         * @brief Selects the implementation of exp used by the activations of all layers.
+         *
+         * FAST_MATH evaluates Sigmoid and Softmax with vectorised polynomial approximations
+         * accurate to about 1e-14. The policy also applies to layers added or loaded later.
+         *
+         * @param policy STANDARD_MATH or FAST_MATH.
+         */
+        void setMathPolicy(const e_mathPolicy policy);
+
+        /**
+         * @brief Selects the memory backing the matrices of the model.
+         *
+         * The parameters of all layers are moved into buffers with the configuration, and the
+         * matrices created by forward passes and training use it as well. E.g. TRANSPARENT_HUGE_PAGES
+         * reduces TLB misses on large weight and activation buffers. The configuration also applies to
+         * layers added or loaded later.
+         *
+         * @param config The memory configuration.
+         */
+        void setMemoryConfig(const MemoryConfig &config);
+
+        /**
+         * @brief Selects the layout of the batches passed through the layers.
+         *
+         * FEATURE_MAJOR (the default) stores one sample per column. SAMPLE_MAJOR stores one sample
+         * per row, so batch-first data from loaders and other frameworks is used without transposes
+         * and matrices given to `predict` are read as batch size x features. The layout also applies
+         * to layers added or loaded later.
+         *
+         * @param layout FEATURE_MAJOR or SAMPLE_MAJOR.
+         * @throws std::invalid_argument If a layer does not support the layout, the previous layout is kept.
+         */
+        void setLayout(const e_layout layout);
+
+        /**
+         * @brief Splits the layers into pipeline stages running on separate groups of cores.
+         *
+         * Batches of dense training data and of `predict` are split into micro-batches which stream
+         * through the stages, so the stages work on different micro-batches at the same time. Training
+         * accumulates the gradients of all micro-batches and updates the parameters once per batch
+         * with the same result as sequential training with these micro-batches. Pays off for deep
+         * models on machines with many cores, where the parallel loops of a single layer do not scale.
+         *
+         * @param numStages Number of stages, capped at the number of layers (1 disables the pipeline).
+         * @param microBatchSize Size of the micro-batches, a `microBatchSize` given to `train` takes
+         *                       precedence (default: 0, four micro-batches per stage).
+         * @throws std::invalid_argument If the number of stages is lower than 1 or the micro-batch size negative.
+         */
+        void setPipelineStages(const int numStages, const int microBatchSize = 0);
+
+        /**
+         * @brief Returns the work done by each pipeline stage since it was built.
+         *
+         * @return The statistics of each stage, empty if no pipeline ran yet.
+         */
+        std::vector<PipelineStageStats> getPipelineStats() const;
+
     protected:
+        /**
+         * @brief Applies the math policy, the layout and the memory configuration of the model to a layer.
+         *
+         * @param layer The layer to configure.
+         */
+        void configureLayer(Layer &layer);
+
+        /**
+         * @brief Returns the pipeline over the layers, built with the current configuration on first use.
+         *
+         * @return The pipeline, or nullptr if pipelining is disabled or the model has fewer than two layers.
+         */
+        Pipeline *getPipeline();
+
+        /**
+         * @brief Returns the size of the micro-batches a batch is split into for the pipeline.
+         *
+         * @param batchSize Number of samples of the batch.
+         * @return The configured micro-batch size, or the size giving four micro-batches per stage.
+         */
+        int getPipelineMicroBatchSize(const int batchSize) const;
+
         /**
          * @brief Initializes a layer based on the provided layer type.
          *
          * @param layerType Enum value of the layer type.
-         * @param file Input file stream (must be opened in binary mode).
+         * @param file Input binary stream (a file or an in-memory buffer).
          * @throws std::runtime_error If the layer type is invalid.
          */
-        void initLayer(e_layerType layerType, std::ifstream &file);
+        void initLayer(e_layerType layerType, std::istream &file);
+
+        /**
+         * @brief Writes the number of layers followed by the type and state of each layer.
+         *
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If writing fails.
+         */
+        void saveLayers(std::ostream &file) const;
+
+        /**
+         * @brief Copies the state of all layers, so they can be saved later on another thread.
+         *
+         * @return Function writing the copied layers in the format of `saveLayers`.
+         */
+        std::function<void(std::ostream &)> snapshotLayers() const;
+
+        /**
+         * @brief Replaces the layers of the network with the layers read from a stream.
+         *
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If a layer type is invalid or reading fails.
+         */
+        void loadLayers(std::istream &file);
     };
 }
\ No newline at end of file
@@ -7,18 +7,185 @@
 #include "ModelTrainer.hpp"
 #include "../../Utils/Utils.hpp"
 #include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
 
 namespace nn
 {
+    // Initial loss scale of FLOAT16 training
+    constexpr double INITIAL_LOSS_SCALE = 65536.0;
+
+    // Number of updates without overflow after which the loss scale is doubled
+    constexpr int LOSS_SCALE_GROWTH_INTERVAL = 2000;
+
+    // Number of samples of a dense or sparse dataset
+    static int countSamples(const std::vector<std::vector<double>> &data) { return data.size(); }
+    static int countSamples(const SparseMatrix &data) { return data.getRows(); }
+
+    // Gathers the given samples of a dense dataset
+    static std::vector<std::vector<double>> selectSamples(const std::vector<std::vector<double>> &data, const std::vector<int> &indices)
+    {
+        std::vector<std::vector<double>> result;
+        result.reserve(indices.size());
+        for (int index : indices)
+            result.push_back(data[index]);
+        return result;
+    }
+
+    // Gathers the given samples of a sparse dataset
+    static SparseMatrix selectSamples(const SparseMatrix &data, const std::vector<int> &indices)
+    {
+        return data.selectRows(indices);
+    }
+
+    // Dense samples become the columns of a feature-major batch or the rows of a sample-major one, sparse samples stay rows
+    static Matrix toInputBatch(const std::vector<std::vector<double>> &samples, const e_layout layout)
+    {
+        return (layout == SAMPLE_MAJOR) ? Matrix(samples) : Matrix(samples).transpose();
+    }
+    static SparseMatrix toInputBatch(SparseMatrix samples, const e_layout) { return samples; }
+
+    // Makes the fused output layer return logits until the end of the scope, also when an exception leaves it
+    class OutputLogitsScope
+    {
+    private:
+        DenseLayer *m_layer; // Fused output layer, or nullptr
+
+    public:
+        explicit OutputLogitsScope(DenseLayer *layer) : m_layer(layer)
+        {
+            if (m_layer)
+                m_layer->setOutputLogits(true);
+        }
+
+        // Predictions outside of training apply the activation again
+        ~OutputLogitsScope()
+        {
+            if (m_layer)
+                m_layer->setOutputLogits(false);
+        }
+
+        OutputLogitsScope(const OutputLogitsScope &) = delete;
+        OutputLogitsScope &operator=(const OutputLogitsScope &) = delete;
+    };
+
     void ModelTrainer::backward(const Matrix &gradient)
     {
-        // Propagate the gradient backward through the layers
-        Matrix grad = gradient;
+        if (m_layers.empty())
+            return;
 
-        for (auto it = m_layers.rbegin(); it != m_layers.rend(); it++)
+        // Propagate the gradient backward through the layers, each gradient is moved into the next one
+        Matrix grad = m_layers.back()->backward(gradient, *m_optimizer);
+
+        for (auto it = m_layers.rbegin() + 1; it != m_layers.rend(); it++)
             grad = (*it)->backward(grad, *m_optimizer);
     }
 
+    void ModelTrainer::accumulateGradients(const Matrix &gradient)
+    {
+        if (m_layers.empty())
+            return;
+
+        // Propagate the gradient backward through the layers, each gradient is moved into the next one
+        Matrix grad = m_layers.back()->accumulateGradients(gradient);
+
+        for (auto it = m_layers.rbegin() + 1; it != m_layers.rend(); it++)
+            grad = (*it)->accumulateGradients(grad);
+    }
+
+    void ModelTrainer::bindParameters()
+    {
+        // Lay out the parameters of all layers in one registry
+        m_parameters = ParameterRegistry();
+
+        for (const auto &layer : m_layers)
+        {
+            layer->setPrecision(m_precision);
+            layer->registerParameters(m_parameters);
+        }
+
+        m_optimizer->bindParameters(m_parameters);
+    }
+
+    void ModelTrainer::applyGradients()
+    {
+        // Skip the update if the scaled gradients overflowed
+        if (m_precision == FLOAT16 && !unscaleGradients())
+            return;
+
+        // Update the parameters of all layers in a single step
+        m_optimizer->step();
+    }
+
+    bool ModelTrainer::unscaleGradients()
+    {
+        // Check all gradients for overflow
+        bool isFinite = true;
+        for (int slot = 0; slot < m_parameters.getCount() && isFinite; slot++)
+        {
+            const Matrix *gradient = m_parameters.getGradient(slot);
+            if (gradient)
+                isFinite = std::all_of(gradient->getDataPtr(), gradient->getDataPtr() + gradient->getSize(), [](double value) { return std::isfinite(value); });
+        }
+
+        for (int slot = 0; slot < m_parameters.getCount(); slot++)
+        {
+            Matrix *gradient = m_parameters.getGradient(slot);
+            if (!gradient)
+                continue;
+
+            // Discard overflowed gradients, otherwise undo the scaling
+            if (isFinite)
+                *gradient /= m_lossScale;
+            else
+                std::fill(gradient->getDataPtr(), gradient->getDataPtr() + gradient->getSize(), 0.0);
+        }
+
+        // Back off on overflow, grow the scale again after a run of stable updates
+        if (!isFinite)
+        {
+            m_lossScale = std::max(1.0, m_lossScale / 2.0);
+            m_stableSteps = 0;
+        }
+        else if (++m_stableSteps >= LOSS_SCALE_GROWTH_INTERVAL)
+        {
+            m_lossScale *= 2.0;
+            m_stableSteps = 0;
+        }
+
+        return isFinite;
+    }
+
+    void ModelTrainer::setPrecision(const e_precision precision)
+    {
+        m_precision = precision;
+        m_lossScale = (precision == FLOAT16) ? INITIAL_LOSS_SCALE : 1.0;
+        m_stableSteps = 0;
+
+        for (const auto &layer : m_layers)
+            layer->setPrecision(precision);
+    }
+
+    DenseLayer *ModelTrainer::getFusedOutputLayer() const
+    {
+        DenseLayer *outputLayer = m_layers.empty() ? nullptr : dynamic_cast<DenseLayer *>(m_layers.back().get());
+        if (!outputLayer)
+            return nullptr;
+
+        // Check if the loss has a fused kernel for the activation of the output layer
+        e_activation activation = outputLayer->getActivationID();
+        if (activation == SOFTMAX && dynamic_cast<CategoricalCrossEntropy *>(m_loss.get()))
+            return outputLayer;
+        if (activation == SIGMOID && dynamic_cast<BinaryCrossEntropy *>(m_loss.get()))
+            return outputLayer;
+
+        return nullptr;
+    }
+
     void ModelTrainer::compile(
         std::unique_ptr<Optimizer> optimizer,
         std::unique_ptr<Loss> lossFunc,
@@ -40,118 +207,433 @@ namespace nn
         const double validationSplit,
         const int patience,
         const double minDelta,
-        const bool verbose
+        const bool verbose,
+        const int microBatchSize
+    )
+    {
+        return trainLoop(xTrain, yTrain, epochs, batchSize, validationSplit, patience, minDelta, verbose, microBatchSize);
+    }
+
+    bool ModelTrainer::train(
+        const SparseMatrix &xTrain,
+        const std::vector<std::vector<double>> &yTrain,
+        const int epochs,
+        const int batchSize,
+        const double validationSplit,
+        const int patience,
+        const double minDelta,
+        const bool verbose,
+        const int microBatchSize
     )
     {
-        double bestLoss = std::numeric_limits<double>::max();
-        int waitCounter = 0;
+        return trainLoop(xTrain, yTrain, epochs, batchSize, validationSplit, patience, minDelta, verbose, microBatchSize);
+    }
 
-        // Copy the dataset
-        std::vector<std::vector<double>> xTrainCopy = xTrain;
-        std::vector<std::vector<double>> yTrainCopy = yTrain;
+    template <typename Input>
+    bool ModelTrainer::trainLoop(
+        const Input &xTrain,
+        const std::vector<std::vector<double>> &yTrain,
+        const int epochs,
+        const int batchSize,
+        const double validationSplit,
+        const int patience,
+        const double minDelta,
+        const bool verbose,
+        const int microBatchSize
+    )
+    {
+        // Start from scratch or from the progress restored from a checkpoint
+        bool isResumed = m_isResuming;
+        TrainingProgress progress = isResumed ? m_resumeProgress : TrainingProgress();
+        m_isResuming = false;
+
+        // Create the batches, activations and gradients with the memory configuration of the model
+        MemoryConfigScope memoryScope(m_memoryConfig);
 
-        // Shuffle the dataset
-        shuffleDataset(xTrainCopy, yTrainCopy);
+        // Check if data and labels have the same number of samples
+        int numSamples = countSamples(xTrain);
+        if (numSamples != static_cast<int>(yTrain.size()))
+            throw std::runtime_error("Data vector and labels vector must have the same amount of rows.");
+
+        // Shuffle the sample indices, a resumed training replays the shuffle of the interrupted one
+        if (isResumed)
+            m_generator = progress.splitGenerator;
+        else
+            progress.splitGenerator = m_generator;
+
+        std::vector<int> order(numSamples);
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), m_generator);
 
         // Split data into training and validation sets
-        int numValidation = xTrainCopy.size() * validationSplit;
-        std::vector<std::vector<double>> xValSplit = slice(xTrainCopy, 0, numValidation);
-        std::vector<std::vector<double>> yValSplit = slice(yTrainCopy, 0, numValidation);
-        std::vector<std::vector<double>> xTrainSplit = slice(xTrainCopy, numValidation, xTrainCopy.size());
-        std::vector<std::vector<double>> yTrainSplit = slice(yTrainCopy, numValidation, yTrainCopy.size());
+        int numValidation = numSamples * validationSplit;
+        std::vector<int> validationIndices(order.begin(), order.begin() + numValidation);
+        std::vector<int> trainIndices(order.begin() + numValidation, order.end());
+        auto xValSplit = selectSamples(xTrain, validationIndices);
+        auto yValSplit = selectSamples(yTrain, validationIndices);
 
         // Compute total number of batches
-        double totalBatches = static_cast<double>(xTrainSplit.size()) / static_cast<double>(batchSize);
+        double totalBatches = static_cast<double>(trainIndices.size()) / static_cast<double>(batchSize);
+        int numBatches = std::ceil(totalBatches);
+
+        // Register the parameters of the layers in the optimizer, the loss reads batches in the layout of the model
+        bindParameters();
+        m_loss->setLayout(m_layout);
+
+        // Report the work of the pipeline stages during this training only
+        if (m_pipeline)
+            m_pipeline->resetStats();
 
         // Log training start
         if (verbose)
             m_logger->logTrainingStart();
 
         // Training loop
-        for (int epoch = 0; epoch < epochs; epoch++)
+        for (int epoch = progress.epoch; epoch < epochs; epoch++)
         {
             // Log epoch start
             if (verbose)
                 m_logger->logEpochStart(epoch + 1, epochs);
-            
-            int batchIndex = 0;
-            double loss = 0.0;
 
-            // Shuffle training data before each epoch
-            shuffleDataset(xTrainSplit, yTrainSplit);
+            // Shuffle training data before each epoch, a resumed epoch replays its shuffle
+            if (progress.batch > 0)
+                m_generator = progress.epochGenerator;
+            else
+                progress.epochGenerator = m_generator;
+
+            std::vector<int> epochIndices = trainIndices;
+            std::shuffle(epochIndices.begin(), epochIndices.end(), m_generator);
+
+            int numSamples = epochIndices.size();
+            int batchIndex = progress.batch;
+            double loss = progress.loss;
 
             // Process batches
-            for (int i = 0; i < xTrainSplit.size(); i += batchSize)
+            for (int i = batchIndex * batchSize; i < numSamples; i += batchSize)
             {
                 batchIndex++;
 
                 // Log batch progress
                 if (verbose)
-                    m_logger->logBatch(batchIndex, std::ceil(totalBatches));
+                    m_logger->logBatch(batchIndex, numBatches);
 
                 // Make sure batch doesn't overflow
-                int end = std::min(static_cast<int>(xTrainSplit.size()), i + batchSize);
-
-                // Get the current batch
-                std::vector<std::vector<double>> xBatch = slice(xTrainSplit, i, end);
-                std::vector<std::vector<double>> yBatch = slice(yTrainSplit, i, end);
+                int end = std::min(numSamples, i + batchSize);
 
                 // Train on the current batch
-                trainOnBatch(xBatch, yBatch, loss);
+                std::vector<int> batch(epochIndices.begin() + i, epochIndices.begin() + end);
+                trainOnBatch(xTrain, yTrain, batch, loss, microBatchSize);
+
+                // Checkpoint every `m_checkpointFrequency` batches
+                progress.batch = batchIndex;
+                progress.loss = loss;
+                if (m_checkpointFrequency > 0 && (epoch * numBatches + batchIndex) % m_checkpointFrequency == 0)
+                    saveCheckpoint(progress);
             }
 
             // Compute average loss and other metrics
-            loss /= xTrainSplit.size();
+            loss /= epochIndices.size();
             std::vector<double> computedMetrics = evaluate(xValSplit, yValSplit, m_metrics);
 
             // Log epoch end
             if (verbose)
-                m_logger->logEpochEnd(std::ceil(totalBatches), loss, computedMetrics, m_metrics);
-            
+                m_logger->logEpochEnd(numBatches, loss, computedMetrics, m_metrics);
+
+            // Move on to the next epoch
+            progress.epoch = epoch + 1;
+            progress.batch = 0;
+            progress.loss = 0.0;
+
             // Early stopping check
-            if (loss < bestLoss - minDelta)
+            if (loss < progress.bestLoss - minDelta)
             {
-                bestLoss = loss;
-                waitCounter = 0;
+                progress.bestLoss = loss;
+                progress.waitCounter = 0;
             }
             else
             {
-                waitCounter++;
-                if (waitCounter >= patience)
+                progress.waitCounter++;
+                if (progress.waitCounter >= patience)
                 {
+                    waitForCheckpoints();
+
                     // Log early stop
                     if (verbose)
+                    {
                         m_logger->logTrainingEnd(true);
+                        if (m_pipeline)
+                            m_logger->logPipelineStats(m_pipeline->getStats());
+                    }
                     return false; // Stop training
                 }
             }
         }
 
+        waitForCheckpoints();
+
         // Log training end
         if (verbose)
+        {
             m_logger->logTrainingEnd(false);
+            if (m_pipeline)
+                m_logger->logPipelineStats(m_pipeline->getStats());
+        }
         
         return true;
     }
 
+    void ModelTrainer::setSeed(const unsigned int seed)
+    {
+        m_generator.seed(seed);
+    }
+
+    void ModelTrainer::enableCheckpoints(const std::string &filename, const int frequency)
+    {
+        if (frequency < 0)
+            throw std::invalid_argument("Checkpoint frequency must be non-negative.");
+
+        m_checkpointFilename = filename;
+        m_checkpointFrequency = frequency;
+
+        // The background writer is only started when checkpoints are used
+        if (frequency > 0 && !m_checkpointWriter)
+            m_checkpointWriter = std::make_unique<CheckpointWriter>();
+    }
+
+    void ModelTrainer::loadCheckpoint(const std::string &filename)
+    {
+        if (!m_optimizer)
+            throw std::runtime_error("Model must be compiled before loading a checkpoint.");
+
+        // Make sure a checkpoint still being written is complete
+        waitForCheckpoints();
+
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open checkpoint file for reading.");
+
+        // Restore the layers and the optimizer state for their parameters
+        loadLayers(file);
+        bindParameters();
+        m_optimizer->loadState(file);
+
+        // Restore the position of the training loop and the loss scale
+        m_resumeProgress = readProgress(file);
+        file.read(reinterpret_cast<char *>(&m_lossScale), sizeof(m_lossScale));
+        file.read(reinterpret_cast<char *>(&m_stableSteps), sizeof(m_stableSteps));
+
+        if (!file.good())
+            throw std::runtime_error("Failed to read training progress from the checkpoint.");
+
+        m_isResuming = true;
+    }
+
+    void ModelTrainer::saveCheckpoint(const TrainingProgress &progress)
+    {
+        // Deep copies of the state, the writer thread serializes them and does the file I/O
+        auto layers = snapshotLayers();
+        auto optimizerState = m_optimizer->snapshotState();
+
+        m_checkpointWriter->write(m_checkpointFilename, [layers = std::move(layers), optimizerState = std::move(optimizerState), progress,
+                                                         lossScale = m_lossScale, stableSteps = m_stableSteps](std::ostream &file) {
+            layers(file);
+            optimizerState(file);
+            writeProgress(file, progress);
+            file.write(reinterpret_cast<const char *>(&lossScale), sizeof(lossScale));
+            file.write(reinterpret_cast<const char *>(&stableSteps), sizeof(stableSteps));
+        });
+    }
+
+    void ModelTrainer::waitForCheckpoints()
+    {
+        if (m_checkpointWriter)
+            m_checkpointWriter->wait();
+    }
+
+    void ModelTrainer::writeProgress(std::ostream &file, const TrainingProgress &progress)
+    {
+        // Write the position in the training loop and the early stopping state
+        file.write(reinterpret_cast<const char *>(&progress.epoch), sizeof(progress.epoch));
+        file.write(reinterpret_cast<const char *>(&progress.batch), sizeof(progress.batch));
+        file.write(reinterpret_cast<const char *>(&progress.loss), sizeof(progress.loss));
+        file.write(reinterpret_cast<const char *>(&progress.bestLoss), sizeof(progress.bestLoss));
+        file.write(reinterpret_cast<const char *>(&progress.waitCounter), sizeof(progress.waitCounter));
+
+        // Write the states of the generator in their portable text form
+        for (const std::mt19937 *generator : {&progress.splitGenerator, &progress.epochGenerator})
+        {
+            std::ostringstream state;
+            state << *generator;
+            std::string text = state.str();
+            std::size_t length = text.size();
+            file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+            file.write(text.data(), length);
+        }
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write training progress.");
+    }
+
+    ModelTrainer::TrainingProgress ModelTrainer::readProgress(std::istream &file)
+    {
+        TrainingProgress progress;
+
+        // Read the position in the training loop and the early stopping state
+        file.read(reinterpret_cast<char *>(&progress.epoch), sizeof(progress.epoch));
+        file.read(reinterpret_cast<char *>(&progress.batch), sizeof(progress.batch));
+        file.read(reinterpret_cast<char *>(&progress.loss), sizeof(progress.loss));
+        file.read(reinterpret_cast<char *>(&progress.bestLoss), sizeof(progress.bestLoss));
+        file.read(reinterpret_cast<char *>(&progress.waitCounter), sizeof(progress.waitCounter));
+
+        // Read the states of the generator
+        for (std::mt19937 *generator : {&progress.splitGenerator, &progress.epochGenerator})
+        {
+            std::size_t length = 0;
+            file.read(reinterpret_cast<char *>(&length), sizeof(length));
+            if (!file.good())
+                break;
+
+            std::string text(length, '\0');
+            file.read(text.data(), length);
+            std::istringstream state(text);
+            state >> *generator;
+        }
+
+        // Check if reading was successful
+        if (!file.good() || progress.epoch < 0 || progress.batch < 0)
+            throw std::runtime_error("Failed to read training progress from the checkpoint.");
+
+        return progress;
+    }
+
+    template <typename Input>
     void ModelTrainer::trainOnBatch(
-        const std::vector<std::vector<double>> &xBatch,
-        const std::vector<std::vector<double>> &yBatch,
-        double &loss
+        const Input &xTrain,
+        const std::vector<std::vector<double>> &yTrain,
+        const std::vector<int> &batch,
+        double &loss,
+        const int microBatchSize
     )
     {
-        // Convert the batch of inputs and targets into matrices
-        Matrix inputBatch = nn::Matrix(xBatch).transpose(); // Each column is a sample
-        Matrix targetBatch = nn::Matrix(yBatch).transpose(); // Each column is a target
+        int batchSize = batch.size();
+
+        // Dense batches stream through the pipeline stages if the model is split into stages
+        if constexpr (std::is_same_v<Input, std::vector<std::vector<double>>>)
+        {
+            if (Pipeline *pipeline = getPipeline())
+            {
+                int pipelineStep = (microBatchSize > 0) ? microBatchSize : getPipelineMicroBatchSize(batchSize);
+                if (pipelineStep < batchSize)
+                {
+                    trainOnBatchPipelined(*pipeline, xTrain, yTrain, batch, loss, pipelineStep);
+                    return;
+                }
+            }
+        }
+
+        int step = (microBatchSize > 0) ? std::min(microBatchSize, batchSize) : batchSize;
+
+        // The output layer returns logits while its activation is fused into the loss
+        DenseLayer *fusedOutputLayer = getFusedOutputLayer();
+        OutputLogitsScope logitsScope(fusedOutputLayer);
+
+        // Process the batch in micro-batches, only one of them is materialised at a time
+        for (int i = 0; i < batchSize; i += step)
+        {
+            int end = std::min(batchSize, i + step);
+
+            // Share of the whole batch processed in this micro-batch
+            double weight = static_cast<double>(end - i) / batchSize;
+
+            // Gather the inputs and targets of the micro-batch in the layout of the model
+            std::vector<int> samples(batch.begin() + i, batch.begin() + end);
+            auto inputBatch = toInputBatch(selectSamples(xTrain, samples), m_layout);
+            Matrix targetBatch = toInputBatch(selectSamples(yTrain, samples), m_layout);
+
+            // Forward pass for the micro-batch
+            Matrix outputBatch = forward(inputBatch);
+
+            // Compute the loss for the micro-batch, weighted to match the loss of the whole batch
+            Matrix gradBatch;
+            if (fusedOutputLayer)
+            {
+                loss += m_loss->computeFromLogits(outputBatch, targetBatch, gradBatch) * weight;
+            }
+            else
+            {
+                loss += m_loss->computeLoss(outputBatch, targetBatch) * weight;
+                gradBatch = m_loss->computeGradient(outputBatch, targetBatch);
+            }
 
-        // Forward pass for the entire batch
-        Matrix outputBatch = forward(inputBatch);
+            // Backward pass for the micro-batch, gradients of averaged losses are weighted the same way
+            if (m_loss->isGradientAveraged())
+                gradBatch *= weight;
+            if (m_precision == FLOAT16)
+                gradBatch *= m_lossScale;
+            accumulateGradients(gradBatch);
+        }
+
+        // Single parameters update for the whole batch
+        applyGradients();
+    }
+
+    void ModelTrainer::trainOnBatchPipelined(
+        Pipeline &pipeline,
+        const std::vector<std::vector<double>> &xTrain,
+        const std::vector<std::vector<double>> &yTrain,
+        const std::vector<int> &batch,
+        double &loss,
+        const int microBatchSize
+    )
+    {
+        int batchSize = batch.size();
+
+        // The output layer returns logits while its activation is fused into the loss
+        DenseLayer *fusedOutputLayer = getFusedOutputLayer();
+        OutputLogitsScope logitsScope(fusedOutputLayer);
+
+        // Gather the inputs and targets of all micro-batches in the layout of the model
+        std::vector<Matrix> inputBatches;
+        std::vector<Matrix> targetBatches;
+        std::vector<double> weights;
+        for (int i = 0; i < batchSize; i += microBatchSize)
+        {
+            int end = std::min(batchSize, i + microBatchSize);
+            std::vector<int> samples(batch.begin() + i, batch.begin() + end);
+            inputBatches.push_back(toInputBatch(selectSamples(xTrain, samples), m_layout));
+            targetBatches.push_back(toInputBatch(selectSamples(yTrain, samples), m_layout));
+            weights.push_back(static_cast<double>(end - i) / batchSize);
+        }
+
+        // Forward pass of all micro-batches, the stages work on consecutive micro-batches at the same time
+        std::vector<Matrix> outputBatches = pipeline.forward(std::move(inputBatches), true);
+
+        // Compute the loss of each micro-batch, weighted to match the loss of the whole batch
+        std::vector<Matrix> gradBatches(outputBatches.size());
+        for (std::size_t j = 0; j < outputBatches.size(); j++)
+        {
+            if (fusedOutputLayer)
+            {
+                loss += m_loss->computeFromLogits(outputBatches[j], targetBatches[j], gradBatches[j]) * weights[j];
+            }
+            else
+            {
+                loss += m_loss->computeLoss(outputBatches[j], targetBatches[j]) * weights[j];
+                gradBatches[j] = m_loss->computeGradient(outputBatches[j], targetBatches[j]);
+            }
+
+            // Gradients of averaged losses are weighted the same way
+            if (m_loss->isGradientAveraged())
+                gradBatches[j] *= weights[j];
+            if (m_precision == FLOAT16)
+                gradBatches[j] *= m_lossScale;
+        }
 
-        // Compute the loss for the entire batch
-        loss += m_loss->computeLoss(outputBatch, targetBatch);
+        // Backward pass of all micro-batches in reverse order, the gradients are accumulated in the layers
+        pipeline.backward(std::move(gradBatches));
 
-        // Backward pass for the entire batch
-        Matrix gradBatch = m_loss->computeGradient(outputBatch, targetBatch);
-        backward(gradBatch);
+        // Single parameters update for the whole batch
+        applyGradients();
     }
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include "../ModelEvaluator/ModelEvaluator.hpp"
 #include "../../Losses/Losses.hpp"
 #include "../../Optimizers/Optimizers.hpp"
+#include "../../CheckpointWriter/CheckpointWriter.hpp"
+#include <random>
+#include <limits>
 
 namespace nn
 {
@@ -20,15 +23,44 @@ namespace nn
     class ModelTrainer : public ModelEvaluator
     {
     private:
+        /**
+         * @brief Position of the training loop, saved in checkpoints to resume training exactly.
+         */
+        struct TrainingProgress
+        {
+            int epoch = 0;                 ///< Current epoch.
+            int batch = 0;                 ///< Number of batches of the current epoch already trained on.
+            double loss = 0.0;             ///< Loss accumulated over these batches.
+            double bestLoss = std::numeric_limits<double>::max(); ///< Best epoch loss for early stopping.
+            int waitCounter = 0;           ///< Epochs without improvement.
+            std::mt19937 splitGenerator;   ///< Generator state before the validation split was shuffled.
+            std::mt19937 epochGenerator;   ///< Generator state before the current epoch was shuffled.
+        };
+
         std::unique_ptr<Optimizer> m_optimizer; ///< Optimizer for training.
         std::unique_ptr<Loss> m_loss;           ///< Loss function for training.
         std::unique_ptr<Logger> m_logger;       ///< Logger for logging training progress.
         std::vector<e_metric> m_metrics;        ///< Metrics to compute
+        std::mt19937 m_generator{std::random_device{}()}; ///< Generator used to shuffle the training data.
+
+        ParameterRegistry m_parameters;    ///< Parameters and gradients of all layers.
+        e_precision m_precision = FLOAT64; ///< Precision of the layers' weight copies and activations.
+        double m_lossScale = 1.0;          ///< Factor the loss gradient is scaled by in FLOAT16 training.
+        int m_stableSteps = 0;             ///< Updates since the loss scale last changed.
+
+        std::unique_ptr<CheckpointWriter> m_checkpointWriter; ///< Background writer of checkpoints.
+        std::string m_checkpointFilename;                     ///< Path to the checkpoint file.
+        int m_checkpointFrequency = 0;                        ///< Number of batches between two checkpoints (0: disabled).
+        TrainingProgress m_resumeProgress;                    ///< Progress restored from a checkpoint.
+        bool m_isResuming = false;                            ///< True if the next training resumes from `m_resumeProgress`.
 
     public:
         /**
          * @brief Performs backward propagation through the network.
          *
+         * Each layer updates its parameters on its own, through the slots it got from the optimizer,
+         * so this does not rely on the parameters bound for training.
+         *
          * @param gradient The gradient of the loss with respect to the output.
          */
         void backward(const Matrix &gradient);
@@ -57,6 +89,11 @@ namespace nn
          * @param patience Number of epochs to wait for improvement (default: 10).
          * @param minDelta Minimum improvement to reset patience (default: 0.0001).
          * @param verbose If true, logs will be displayed (default: true).
+         * @param microBatchSize Size of the micro-batches the batch is split into. Gradients of all
+         *                       micro-batches are accumulated and applied once per batch, which bounds
+         *                       the activation memory (default: 0, the batch is processed at once, or
+         *                       split as configured by `setPipelineStages`).
+         * @note After `loadCheckpoint()` the training continues from the restored epoch and batch.
          * @return True if the training has been completed, false if stopped early
          */
         bool train(
@@ -67,21 +104,213 @@ namespace nn
             const double validationSplit = 0.0,
             const int patience = 10,
             const double minDelta = 0.0001,
-            const bool verbose = true
+            const bool verbose = true,
+            const int microBatchSize = 0
         );
 
+        /**
+         * @brief Trains the model on sparse data.
+         *
+         * Only the active features of each batch are materialised, the first layer must be a
+         * DenseLayer with one input per feature.
+         *
+         * @param xTrain Sparse training data, one sample per row.
+         * @param yTrain Training labels (vector of output vectors).
+         * @param epochs Number of training epochs.
+         * @param batchSize Size of each training batch (default: 1).
+         * @param validationSplit Fraction of the data to use for validation (default: 0.0).
+         * @param patience Number of epochs to wait for improvement (default: 10).
+         * @param minDelta Minimum improvement to reset patience (default: 0.0001).
+         * @param verbose If true, logs will be displayed (default: true).
+         * @param microBatchSize Size of the micro-batches the batch is split into (default: 0, the batch is processed at once).
+         * @return True if the training has been completed, false if stopped early
+         */
+        bool train(
+            const SparseMatrix &xTrain,
+            const std::vector<std::vector<double>> &yTrain,
+            const int epochs,
+            const int batchSize = 1,
+            const double validationSplit = 0.0,
+            const int patience = 10,
+            const double minDelta = 0.0001,
+            const bool verbose = true,
+            const int microBatchSize = 0
+        );
+
+        /**
+         * @brief Enables mixed-precision training.
+         *
+         * The layers keep their master weights in double precision and run the products on
+         * BFLOAT16 or FLOAT16 copies of weights and activations with float accumulation.
+         * FLOAT16 has a narrow exponent range, so the loss gradient is scaled up before the
+         * backward pass and the gradients are scaled back before the update. The scale is halved
+         * and the update skipped when gradients overflow, and it grows again after a run of
+         * stable updates.
+         *
+         * @param precision The storage precision (FLOAT64 disables mixed precision).
+         */
+        void setPrecision(const e_precision precision);
+
+        /**
+         * @brief Seeds the generator used to shuffle the training data.
+         *
+         * @param seed The seed.
+         */
+        void setSeed(const unsigned int seed);
+
+        /**
+         * @brief Enables periodic checkpoints during training.
+         *
+         * Every `frequency` batches the weights, the optimizer state, the position in the training
+         * loop and the state of the shuffling generator are snapshotted in memory and written to
+         * `filename` by a background thread while training continues.
+         *
+         * The snapshot is a full copy taken on the training thread, so every checkpoint costs one
+         * copy of all parameters and optimizer state; only the serialization and the file I/O run
+         * in the background. The copies are not deferred (copy-on-write) because matrices hand out
+         * raw pointers to their elements, so writes to them cannot be detected.
+         *
+         * @param filename Path to the checkpoint file, overwritten by every checkpoint.
+         * @param frequency Number of batches between two checkpoints (0 disables checkpoints).
+         * @throws std::invalid_argument If the frequency is negative.
+         */
+        void enableCheckpoints(const std::string &filename, const int frequency);
+
+        /**
+         * @brief Restores the model, the optimizer state and the training progress from a checkpoint.
+         *
+         * The next call to `train()` with the same data and batch size resumes exactly where the
+         * checkpoint was taken. The model must be compiled with the same optimizer beforehand.
+         *
+         * @param filename Path to the checkpoint file.
+         * @throws std::runtime_error If the model is not compiled, the file cannot be opened or is invalid.
+         */
+        void loadCheckpoint(const std::string &filename);
+
     private:
+        /**
+         * @brief Snapshots the model and the training progress and hands it to the checkpoint writer.
+         *
+         * @param progress The current training progress.
+         */
+        void saveCheckpoint(const TrainingProgress &progress);
+
+        /**
+         * @brief Blocks until all scheduled checkpoints have been written.
+         */
+        void waitForCheckpoints();
+
+        /**
+         * @brief Writes the training progress to a binary stream.
+         *
+         * @param file Output binary stream.
+         * @param progress The training progress to write.
+         */
+        static void writeProgress(std::ostream &file, const TrainingProgress &progress);
+
+        /**
+         * @brief Reads the training progress from a binary stream.
+         *
+         * @param file Input binary stream.
+         * @return The training progress.
+         * @throws std::runtime_error If reading fails.
+         */
+        static TrainingProgress readProgress(std::istream &file);
+
+        /**
+         * @brief Propagates the gradient backward through the network without updating the parameters.
+         *
+         * @param gradient The gradient of the loss with respect to the output.
+         */
+        void accumulateGradients(const Matrix &gradient);
+
+        /**
+         * @brief Registers the parameters of all layers in the optimizer.
+         */
+        void bindParameters();
+
+        /**
+         * @brief Updates the parameters of all layers with the accumulated gradients.
+         */
+        void applyGradients();
+
+        /**
+         * @brief Divides the accumulated gradients by the loss scale and adapts the scale.
+         *
+         * @return False if the gradients overflowed, they are discarded and the update must be skipped.
+         */
+        bool unscaleGradients();
+
+        /**
+         * @brief Returns the output layer if its activation can be fused into the loss.
+         *
+         * Softmax is fused into CategoricalCrossEntropy and Sigmoid into BinaryCrossEntropy.
+         *
+         * @return The last dense layer, or nullptr if the loss must be computed on the activations.
+         */
+        DenseLayer *getFusedOutputLayer() const;
+
+        /**
+         * @brief Runs the training loop on dense or sparse data.
+         *
+         * The dataset is shuffled and batched through sample indices, only the samples of the
+         * current batch are copied.
+         *
+         * @tparam Input Dense (`std::vector<std::vector<double>>`) or sparse (`SparseMatrix`) inputs.
+         * @return True if the training has been completed, false if stopped early
+         * @throws std::runtime_error If data and labels have a different number of samples.
+         */
+        template <typename Input>
+        bool trainLoop(
+            const Input &xTrain,
+            const std::vector<std::vector<double>> &yTrain,
+            const int epochs,
+            const int batchSize,
+            const double validationSplit,
+            const int patience,
+            const double minDelta,
+            const bool verbose,
+            const int microBatchSize
+        );
+
         /**
          * @brief Trains the model on a single batch.
          *
-         * @param xBatch Batch of input data.
-         * @param yBatch Batch of target data.
+         * @param xTrain Training data.
+         * @param yTrain Training labels.
+         * @param batch Indices of the samples of the batch.
          * @param loss Accumulated loss for the batch.
+         * @param microBatchSize Size of the micro-batches (0 to process the batch at once).
          */
+        template <typename Input>
         void trainOnBatch(
-            const std::vector<std::vector<double>> &xBatch,
-            const std::vector<std::vector<double>> &yBatch,
-            double &loss
+            const Input &xTrain,
+            const std::vector<std::vector<double>> &yTrain,
+            const std::vector<int> &batch,
+            double &loss,
+            const int microBatchSize
+        );
+
+        /**
+         * @brief Trains the model on a single batch of dense data streamed through the pipeline stages.
+         *
+         * All micro-batches are passed forward, then their gradients backward in reverse order, and
+         * the parameters are updated once, like `trainOnBatch` with the same micro-batches.
+         *
+         * @param pipeline The pipeline over the layers.
+         * @param xTrain Training data.
+         * @param yTrain Training labels.
+         * @param batch Indices of the samples of the batch.
+         * @param loss Accumulated loss for the batch.
+         * @param microBatchSize Size of the micro-batches.
+         */
+        void trainOnBatchPipelined(
+            Pipeline &pipeline,
+            const std::vector<std::vector<double>> &xTrain,
+            const std::vector<std::vector<double>> &yTrain,
+            const std::vector<int> &batch,
+            double &loss,
+            const int microBatchSize
         );
     };
 }
\ No newline at end of file
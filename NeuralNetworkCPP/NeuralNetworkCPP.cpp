@@ -6,6 +6,8 @@
 
 #include "NeuralNetworkCPP.hpp"
 #include "GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
 
 namespace nn
 {
@@ -22,20 +24,8 @@ namespace nn
         if (!file.is_open())
             throw std::runtime_error("Failed to open file for reading.");
         
-        // Read the number of layers
-        int numLayers;
-        file.read(reinterpret_cast<char *>(&numLayers), sizeof(numLayers));
-
-        // Read each layer
-        for (int i = 0; i < numLayers; i++)
-        {
-            // Read the layer type
-            e_layerType layerType;
-            file.read(reinterpret_cast<char *>(&layerType), sizeof(layerType));
-
-            // Instantiate the correct layer type
-            initLayer(layerType, file);
-        }
+        // Read the layers
+        loadLayers(file);
 
         // Check if reading was successful
         if (!file.good())
@@ -52,23 +42,60 @@ namespace nn
         if (!file.is_open())
             throw std::runtime_error("Failed to open file for writing.");
         
-        // Save the number of network layers
-        int numLayers = m_layers.size();
-        file.write(reinterpret_cast<const char *>(&numLayers), sizeof(numLayers));
+        // Save the layers
+        saveLayers(file);
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write model to the file.");
+    }
+
+    void NeuralNetworkCPP::quantize(const std::vector<std::vector<double>> &calibrationData)
+    {
+        if (calibrationData.empty())
+            throw std::invalid_argument("Calibration data must not be empty.");
+        if (m_layout != FEATURE_MAJOR)
+            throw std::invalid_argument("Quantization requires the feature-major layout.");
+
+        // Calibrate in inference mode, the previous mode is restored even if a layer throws
+        InferenceModeScope inferenceScope(*this);
 
-        // Save each layer
-        for (const auto &layer : m_layers)
+        Matrix activations = Matrix(calibrationData).transpose(); // Each column is a sample
+
+        for (auto &layer : m_layers)
         {
-            // Save the layer type
-            e_layerType layerType = layer->getType();
-            file.write(reinterpret_cast<const char *>(&layerType), sizeof(layerType));
+            Matrix output = layer->forward(activations);
+
+            // Replace dense layers, their input range is the range of the incoming activations
+            if (layer->getType() == DENSE)
+            {
+                const double *data = activations.getDataPtr();
+                auto [inputMin, inputMax] = std::minmax_element(data, data + activations.getSize());
+
+                layer = std::make_unique<QuantizedDenseLayer>(static_cast<const DenseLayer &>(*layer), *inputMin, *inputMax);
+                configureLayer(*layer);
+            }
 
-            // Save the layer
-            layer->save(file);
+            activations = std::move(output);
         }
+    }
 
-        // Check if writing was successful
-        if (!file.good())
-            throw std::runtime_error("Failed to write model to the file.");
+    void NeuralNetworkCPP::prune(const double sparsity, const double sparseThreshold)
+    {
+        for (auto &layer : m_layers)
+        {
+            if (layer->getType() != DENSE)
+                continue;
+
+            // Prune the layer and switch to the sparse format if it pays off, sparse layers are feature-major only
+            DenseLayer &denseLayer = static_cast<DenseLayer &>(*layer);
+            denseLayer.prune(sparsity);
+
+            if (denseLayer.getSparsity() >= sparseThreshold && m_layout == FEATURE_MAJOR)
+            {
+                layer = std::make_unique<SparseDenseLayer>(denseLayer);
+                configureLayer(*layer);
+            }
+        }
     }
-}
+}
\ No newline at end of file
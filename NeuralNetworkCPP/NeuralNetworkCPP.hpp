@@ -44,6 +44,31 @@ namespace nn
          * @throws std::runtime_error If the file cannot be opened or writing fails.
          */
         void save(const std::string &filename) const;
+
+        /**
+         * @brief Converts the dense layers of the trained model to int8 inference layers.
+         *
+         * The calibration samples are propagated through the model to find the input range of
+         * every dense layer, the weights are quantized per output channel. The quantized model can
+         * be saved and loaded like any other model but it can no longer be trained.
+         *
+         * @param calibrationData Representative input samples (e.g. a few hundred training samples).
+         * @throws std::invalid_argument If the calibration data is empty or the model uses the sample-major layout.
+         */
+        void quantize(const std::vector<std::vector<double>> &calibrationData);
+
+        /**
+         * @brief Prunes the dense layers by weight magnitude.
+         *
+         * Layers whose weights end up at least `sparseThreshold` zero are converted to
+         * SparseDenseLayer, which stores the remaining weights in CSR format and only trains those.
+         * Models in the sample-major layout keep their pruned layers dense.
+         *
+         * @param sparsity Fraction of the weights of each dense layer to prune, in [0, 1).
+         * @param sparseThreshold Sparsity from which a layer switches to the sparse format (default: 0.8).
+         * @throws std::invalid_argument If the sparsity is out of range.
+         */
+        void prune(const double sparsity, const double sparseThreshold = 0.8);
     };
 }
 
@@ -12,47 +12,77 @@ namespace nn
     Adam::Adam(double learningRate, double beta1, double beta2, double epsilon)
         : Optimizer(learningRate), m_beta1(beta1), m_beta2(beta2), m_epsilon(epsilon) {}
 
-    void Adam::update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases)
+    void Adam::resizeState(const std::size_t size, const int count)
     {
-        // Initialize moment estimates if they don't exist
-        if (m_m.find(&weights) == m_m.end())
-        {
-            m_m[&weights] = Matrix(weights.getRows(), weights.getCols(), 0.0);
-            m_v[&weights] = Matrix(weights.getRows(), weights.getCols(), 0.0);
-        }
-        if (m_m.find(&biases) == m_m.end())
-        {
-            m_m[&biases] = Matrix(biases.getRows(), biases.getCols(), 0.0);
-            m_v[&biases] = Matrix(biases.getRows(), biases.getCols(), 0.0);
-        }
+        // New parameters start with zero moment estimates and time step
+        m_m.resize(size, 0.0);
+        m_v.resize(size, 0.0);
+        m_t.resize(count, 0);
+        m_stepSizes.resize(count, 0.0);
+        m_epsilonHat.resize(count, 0.0);
+    }
+
+    void Adam::resetState()
+    {
+        m_m.clear();
+        m_v.clear();
+        m_t.clear();
+        m_stepSizes.clear();
+        m_epsilonHat.clear();
+    }
+
+    void Adam::writeState(std::ostream &file) const
+    {
+        writeBuffer(file, m_m);
+        writeBuffer(file, m_v);
+        writeBuffer(file, m_t);
+    }
 
-        // Initialize time step if it doesn't exist
-        if (m_t.find(&weights) == m_t.end())
-            m_t[&weights] = 0;
-        
+    void Adam::readState(std::istream &file)
+    {
+        readBuffer(file, m_m);
+        readBuffer(file, m_v);
+        readBuffer(file, m_t);
+    }
+
+    void Adam::prepareSlot(const int slot)
+    {
         // Increase time step
-        m_t[&weights]++;
+        m_t[slot]++;
 
-        // Update first moment estimates: m_t = beta1 * m_{t-1} + (1 - beta1) * grad
-        m_m[&weights] = m_beta1 * m_m[&weights] + (1.0 - m_beta1) * gradWeights;
-        m_m[&biases] = m_beta1 * m_m[&biases] + (1.0 - m_beta1) * gradBiases;
+        // Bias corrections: mHat = m / (1 - beta1^t), vHat = v / (1 - beta2^t)
+        double mCorrection = 1.0 - std::pow(m_beta1, m_t[slot]);
+        double vCorrectionSqrt = std::sqrt(1.0 - std::pow(m_beta2, m_t[slot]));
 
-        // Update second moment estimates: v_t = beta2 * v_{t-1} + (1 - beta2) * grad^2
-        m_v[&weights] = m_beta2 * m_v[&weights] + (1.0 - m_beta2) * gradWeights.cwiseProduct(gradWeights);
-        m_v[&biases] = m_beta2 * m_v[&biases] + (1.0 - m_beta2) * gradBiases.cwiseProduct(gradBiases);
+        // lr * mHat / (sqrt(vHat) + eps) == stepSize * m / (sqrt(v) + epsilonHat)
+        m_stepSizes[slot] = m_learningRate * vCorrectionSqrt / mCorrection;
+        m_epsilonHat[slot] = m_epsilon * vCorrectionSqrt;
+    }
 
-        // Bias-corrected first moment estimates
-        double mHat = 1.0 / (1.0 - std::pow(m_beta1, m_t[&weights]));
-        Matrix mHatWeights = m_m[&weights] * mHat;
-        Matrix mHatBiases = m_m[&biases] * mHat;
+    void Adam::updateRange(const int slot, double *values, const double *gradients, const std::size_t offset, const std::size_t count)
+    {
+        // The bias correction of the slot was folded into the step size and epsilon by prepareSlot
+        double *__restrict w = values;
+        const double *__restrict g = gradients;
+        double *__restrict m = m_m.data() + offset;
+        double *__restrict v = m_v.data() + offset;
+        const double beta1 = m_beta1, oneMinusBeta1 = 1.0 - m_beta1;
+        const double beta2 = m_beta2, oneMinusBeta2 = 1.0 - m_beta2;
+        const double stepSize = m_stepSizes[slot];
+        const double epsilonHat = m_epsilonHat[slot];
 
-        // Bias-corrected second moment estimates
-        double vHat = 1.0 / (1.0 - std::pow(m_beta2, m_t[&weights]));
-        Matrix vHatWeights = m_v[&weights] * vHat;
-        Matrix vHatBiases = m_v[&biases] * vHat;
+        // Single in-place pass over moments and parameters
+        for (std::size_t i = 0; i < count; i++)
+        {
+            // m_t = beta1 * m_{t-1} + (1 - beta1) * grad
+            double mi = beta1 * m[i] + oneMinusBeta1 * g[i];
 
-        // Update weights and biases
-        weights -= m_learningRate * mHatWeights / (vHatWeights.map([](double x) { return std::sqrt(x); }) + m_epsilon);
-        biases -= m_learningRate * mHatBiases / (vHatBiases.map([](double x) { return std::sqrt(x); }) + m_epsilon);
+            // v_t = beta2 * v_{t-1} + (1 - beta2) * grad^2
+            double vi = beta2 * v[i] + oneMinusBeta2 * g[i] * g[i];
+
+            m[i] = mi;
+            v[i] = vi;
+            w[i] -= stepSize * mi / (std::sqrt(vi) + epsilonHat);
+        }
     }
-}
\ No newline at end of file
+}
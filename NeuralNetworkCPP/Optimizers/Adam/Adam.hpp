@@ -8,7 +8,7 @@
 #define ADAM_HPP
 
 #include "../Common/Optimizer.hpp"
-#include <unordered_map>
+#include "../../Memory/AlignedAllocator/AlignedAllocator.hpp"
 
 namespace nn
 {
@@ -26,10 +26,12 @@ namespace nn
         double m_beta2;   ///< Exponential decay rate for the second moment estimates.
         double m_epsilon; ///< Small constant for numerical stability.
 
-        // Maps for first and second moment estimates
-        std::unordered_map<Matrix *, Matrix> m_m; ///< First moment estimates for weights and biases
-        std::unordered_map<Matrix *, Matrix> m_v; ///< Second moment estimates for weights and biases
-        std::unordered_map<Matrix *, int> m_t;    ///< Time step (for bias correction).
+        // Flat buffers for first and second moment estimates
+        AlignedVector<double> m_m;         ///< First moment estimates of all parameters, at their registry offsets.
+        AlignedVector<double> m_v;         ///< Second moment estimates of all parameters, at their registry offsets.
+        std::vector<int> m_t;             ///< Time step of each parameter (for bias correction).
+        std::vector<double> m_stepSizes;  ///< Bias-corrected learning rate of each parameter for the current step.
+        std::vector<double> m_epsilonHat; ///< Bias-corrected epsilon of each parameter for the current step.
 
     public:
         /**
@@ -42,15 +44,57 @@ namespace nn
          */
         Adam(double learningRate = 0.001, double beta1 = 0.9, double beta2 = 0.999, double epsilon = 1e-8);
 
+    protected:
         /**
-         * @brief Updates the weights and biases using Adam.
+         * @brief Resizes the flat state buffers, keeping the state of the parameters which still fit.
          *
-         * @param weights The weight matrix to update.
-         * @param biases The bias vector to update.
-         * @param gradWeights The gradient of the loss with respect to the weights.
-         * @param gradBiases The gradient of the loss with respect to the biases.
+         * @param size Total number of elements of all parameters with state.
+         * @param count Number of parameters with state.
          */
-        void update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases) override;
+        void resizeState(const std::size_t size, const int count) override;
+
+        /**
+         * @brief Clears the whole optimizer state.
+         */
+        void resetState() override;
+
+        /**
+         * @brief Returns a copy of the optimizer with its state buffers.
+         */
+        std::unique_ptr<Optimizer> clone() const override { return std::make_unique<Adam>(*this); }
+
+        /**
+         * @brief Writes the moment estimates and time steps.
+         *
+         * @param file Output binary stream.
+         */
+        void writeState(std::ostream &file) const override;
+
+        /**
+         * @brief Reads the moment estimates and time steps.
+         *
+         * @param file Input binary stream.
+         */
+        void readState(std::istream &file) override;
+
+        /**
+         * @brief Advances the time step of the parameter and folds the bias corrections into
+         *        the step size and epsilon used by the update kernel.
+         *
+         * @param slot Slot of the parameter.
+         */
+        void prepareSlot(const int slot) override;
+
+        /**
+         * @brief Updates a contiguous range of a parameter using Adam.
+         *
+         * @param slot Slot of the parameter.
+         * @param values Parameter values of the range.
+         * @param gradients Gradients of the range.
+         * @param offset Offset of the range in the flat index space.
+         * @param count Number of elements in the range.
+         */
+        void updateRange(const int slot, double *values, const double *gradients, const std::size_t offset, const std::size_t count) override;
     };
 }
 
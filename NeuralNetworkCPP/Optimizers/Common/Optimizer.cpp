@@ -0,0 +1,228 @@
+/**
+ * C++ neural network library
+ *
+ * Optimizer.cpp
+ */
+
+#include "Optimizer.hpp"
+#include "../../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace nn
+{
+    // Number of elements updated by a single task of the parallel step
+    constexpr std::size_t STEP_CHUNK_SIZE = 4096;
+
+    // Returns a registration which no optimizer used before (never 0)
+    static std::uint64_t nextRegistration()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    Optimizer::Optimizer(double learningRate)
+        : m_learningRate(learningRate), m_registration(nextRegistration()), m_standaloneOffsets({0}) {}
+
+    void Optimizer::bindParameters(const ParameterRegistry &registry)
+    {
+        // Keep the state only if it is laid out exactly the same way
+        bool sameLayout = m_registry.hasSameLayout(registry);
+        m_registry = registry;
+
+        // Slots returned for the previous registry are no longer valid, their state is dropped
+        m_registration = nextRegistration();
+        m_standaloneOffsets = {m_registry.getSize()};
+
+        if (!sameLayout)
+            resetState();
+        resizeState(m_registry.getSize(), m_registry.getCount());
+    }
+
+    void Optimizer::step()
+    {
+        // Prepare each parameter once per step
+        for (int slot = 0; slot < m_registry.getCount(); slot++)
+            prepareSlot(slot);
+
+        int numChunks = (m_registry.getSize() + STEP_CHUNK_SIZE - 1) / STEP_CHUNK_SIZE;
+        auto &pool = getGlobalThreadPool();
+
+        // Single parallel pass over the flat index space of all parameters
+        pool.parallelFor(0, numChunks, [this](int chunk) {
+            std::size_t start = chunk * STEP_CHUNK_SIZE;
+            std::size_t end = std::min(start + STEP_CHUNK_SIZE, m_registry.getSize());
+
+            // A chunk may span several parameters
+            for (int slot = m_registry.getSlotAt(start); start < end; slot++)
+            {
+                std::size_t slotOffset = m_registry.getOffset(slot);
+                std::size_t rangeEnd = std::min(end, m_registry.getOffset(slot + 1));
+                Matrix *gradient = m_registry.getGradient(slot);
+
+                // Row-sparse parameters are updated row by row below
+                if (gradient && rangeEnd > start && !m_registry.getTouchedRows(slot))
+                {
+                    // Update the range and reset its gradient while it is still in cache
+                    double *values = m_registry.getValue(slot).getDataPtr() + (start - slotOffset);
+                    double *gradients = gradient->getDataPtr() + (start - slotOffset);
+                    updateRange(slot, values, gradients, start, rangeEnd - start);
+                    std::fill(gradients, gradients + (rangeEnd - start), 0.0);
+                }
+
+                start = rangeEnd;
+            }
+        });
+
+        // Only update the rows of row-sparse parameters which received gradients
+        for (int slot = 0; slot < m_registry.getCount(); slot++)
+        {
+            std::vector<int> *rows = m_registry.getTouchedRows(slot);
+            if (rows && m_registry.getGradient(slot))
+                updateSlotRows(slot, m_registry.getValue(slot), *m_registry.getGradient(slot), *rows);
+        }
+    }
+
+    void Optimizer::update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases, ParameterSlots &slots)
+    {
+        // Resolve the slots of both parameters
+        resolveSlots(slots, {&weights, &biases});
+
+        // Update both parameters
+        updateSlot(slots.slots[0], weights, gradWeights);
+        updateSlot(slots.slots[1], biases, gradBiases);
+    }
+
+    void Optimizer::updateRows(Matrix &value, Matrix &gradient, std::vector<int> &rows, ParameterSlots &slots)
+    {
+        // Validate that the gradient matches the parameter
+        if (gradient.getRows() != value.getRows() || gradient.getCols() != value.getCols())
+            throw std::invalid_argument("Gradient dimensions must match the parameter dimensions.");
+
+        resolveSlots(slots, {&value});
+        prepareSlot(slots.slots[0]);
+        updateSlotRows(slots.slots[0], value, gradient, rows);
+    }
+
+    void Optimizer::saveState(std::ostream &file) const
+    {
+        // Write the layout of the state
+        std::size_t size = getStateOffset(getStateCount());
+        int count = getStateCount();
+        file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+
+        // Write the state buffers
+        writeState(file);
+
+        // Check if writing was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to write optimizer state.");
+    }
+
+    std::function<void(std::ostream &)> Optimizer::snapshotState() const
+    {
+        std::shared_ptr<const Optimizer> copy = clone();
+        return [copy](std::ostream &file) { copy->saveState(file); };
+    }
+
+    void Optimizer::loadState(std::istream &file)
+    {
+        // Read the layout the state was saved for
+        std::size_t size;
+        int count;
+        file.read(reinterpret_cast<char *>(&size), sizeof(size));
+        file.read(reinterpret_cast<char *>(&count), sizeof(count));
+
+        if (!file.good() || size != getStateOffset(getStateCount()) || count != getStateCount())
+            throw std::runtime_error("Optimizer state does not match the bound parameters.");
+
+        // Read the state buffers
+        readState(file);
+
+        // Check if reading was successful
+        if (!file.good())
+            throw std::runtime_error("Failed to read optimizer state.");
+    }
+
+    std::size_t Optimizer::getStateOffset(const int slot) const
+    {
+        // Parameters updated on their own follow the bound ones
+        int count = m_registry.getCount();
+        return (slot < count) ? m_registry.getOffset(slot) : m_standaloneOffsets[slot - count];
+    }
+
+    void Optimizer::resolveSlots(ParameterSlots &slots, std::initializer_list<const Matrix *> values)
+    {
+        if (slots.registration == m_registration && slots.slots.size() == values.size())
+        {
+            // A layer which replaced a parameter by one of another size must not use the old state
+            int i = 0;
+            for (const Matrix *value : values)
+            {
+                int slot = slots.slots[i++];
+                if (static_cast<std::size_t>(value->getSize()) != getStateOffset(slot + 1) - getStateOffset(slot))
+                    throw std::invalid_argument("Parameter size does not match its slot in the optimizer.");
+            }
+            return;
+        }
+
+        // Append the state of the parameters, only their sizes are kept
+        slots.slots.clear();
+        for (const Matrix *value : values)
+        {
+            slots.slots.push_back(getStateCount());
+            m_standaloneOffsets.push_back(m_standaloneOffsets.back() + value->getSize());
+        }
+
+        resizeState(getStateOffset(getStateCount()), getStateCount());
+        slots.registration = m_registration;
+    }
+
+    void Optimizer::updateSlot(const int slot, Matrix &value, const Matrix &gradient)
+    {
+        // Validate that the gradient matches the parameter
+        if (gradient.getRows() != value.getRows() || gradient.getCols() != value.getCols())
+            throw std::invalid_argument("Gradient dimensions must match the parameter dimensions.");
+
+        prepareSlot(slot);
+
+        std::size_t offset = getStateOffset(slot);
+        std::size_t size = value.getSize();
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize the update over chunks of the parameter
+        int numChunks = (size + STEP_CHUNK_SIZE - 1) / STEP_CHUNK_SIZE;
+        pool.parallelFor(0, numChunks, [this, slot, offset, size, &value, &gradient](int chunk) {
+            std::size_t start = chunk * STEP_CHUNK_SIZE;
+            std::size_t count = std::min(STEP_CHUNK_SIZE, size - start);
+            updateRange(slot, value.getDataPtr() + start, gradient.getDataPtr() + start, offset + start, count);
+        });
+    }
+
+    void Optimizer::updateSlotRows(const int slot, Matrix &value, Matrix &gradient, std::vector<int> &rows)
+    {
+        int cols = value.getCols();
+
+        // Each row is updated once, in memory order
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+        if (!rows.empty() && (rows.front() < 0 || rows.back() >= value.getRows()))
+            throw std::out_of_range("Row index out of range.");
+
+        std::size_t offset = getStateOffset(slot);
+        auto &pool = getGlobalThreadPool();
+
+        // Parallelize the update over the rows, each row is a contiguous range
+        pool.parallelFor(0, rows.size(), [this, slot, offset, cols, &value, &gradient, &rows](int i) {
+            std::size_t start = static_cast<std::size_t>(rows[i]) * cols;
+            double *gradients = gradient.getDataPtr() + start;
+            updateRange(slot, value.getDataPtr() + start, gradients, offset + start, cols);
+            std::fill(gradients, gradients + cols, 0.0);
+        });
+
+        rows.clear();
+    }
+}
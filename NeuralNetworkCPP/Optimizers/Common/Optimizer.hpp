@@ -8,17 +8,59 @@
 #define OPTIMIZER_HPP
 
 #include "../../Matrix/Matrix.hpp"
+#include "ParameterRegistry.hpp"
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
 
 namespace nn
 {
+    /**
+     * @brief Slots of the parameters a layer updates on its own with `Optimizer::update` or `Optimizer::updateRows`.
+     *
+     * The slots are returned when the optimizer makes room for the state of the parameters on their
+     * first update. They belong to one registration of the optimizer and the parameters get new
+     * slots once the optimizer is bound to another registry. A copy starts empty, so a copied layer
+     * never shares the optimizer state of the original.
+     */
+    struct ParameterSlots
+    {
+        std::uint64_t registration = 0; ///< Registration of the optimizer the slots were returned by (0: none).
+        std::vector<int> slots;         ///< Slots of the parameters in the order they are passed.
+
+        ParameterSlots() = default;
+        ParameterSlots(const ParameterSlots &) {}
+        ParameterSlots &operator=(const ParameterSlots &)
+        {
+            registration = 0;
+            slots.clear();
+            return *this;
+        }
+    };
+
     /**
      * @class Optimizer
      * @brief Abstract base class for optimizers.
+     *
+     * The optimizer state of every parameter is kept in flat buffers at the offset of the parameter
+     * in one flat index space, the bound parameters at their registry offsets. A whole model is updated with `step()` in one parallel pass over the flat
+     * index space, a single layer can still be updated on its own with `update()`. Row-sparse
+     * parameters such as embedding tables only get the rows touched by the batch updated.
+     *
+     * The parameters themselves stay in the matrices of the layers. Bound parameters are addressed
+     * through the registry, which has to be bound again once a layer replaces a matrix. Parameters
+     * updated on their own are not registered: their state follows the state of the bound
+     * parameters and is addressed through the slots returned on their first update, the optimizer
+     * never keeps their matrices.
      */
     class Optimizer
     {
     protected:
-        double m_learningRate; ///< Learning rate for parameter updates.
+        double m_learningRate;        ///< Learning rate for parameter updates.
+        ParameterRegistry m_registry; ///< Parameters the optimizer keeps state for.
+        std::uint64_t m_registration; ///< Identifies the registry, changes whenever another registry is bound.
+        std::vector<std::size_t> m_standaloneOffsets; ///< State offset of each parameter updated on its own, followed by the total state size.
 
     public:
         /**
@@ -26,18 +68,194 @@ namespace nn
          *
          * @param learningRate The learning rate.
          */
-        Optimizer(double learningRate) : m_learningRate(learningRate) {}
+        Optimizer(double learningRate);
+
+        /** @brief Virtual destructor. */
+        virtual ~Optimizer() = default;
+
+        /**
+         * @brief Binds the parameters of a model to the optimizer.
+         *
+         * The optimizer state is kept if the layout of the registry did not change
+         * (e.g. the same model is trained again), otherwise it is reset.
+         *
+         * @param registry The registry with all parameters and gradients of the model.
+         */
+        void bindParameters(const ParameterRegistry &registry);
+
+        /**
+         * @brief Updates all bound parameters with their gradients and resets the gradients to zero.
+         */
+        void step();
 
         /**
          * @brief Updates the weights and biases of a layer.
          *
+         * The state of the parameters is created on their first update and addressed by the returned
+         * slots afterwards, so it follows the slots and not the addresses of the matrices.
+         *
          * @param weights The weight matrix to update.
          * @param biases The bias vector to update.
          * @param gradWeights The gradient of the loss with respect to the weights.
          * @param gradBiases The gradient of the loss with respect to the biases.
+         * @param slots Slots of the weights and biases, filled on the first update.
+         * @throws std::invalid_argument If a gradient or a parameter does not match its slot.
          */
-        virtual void update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases) = 0;
+        void update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases, ParameterSlots &slots);
+
+        /**
+         * @brief Updates only the listed rows of a parameter (e.g. the embeddings used by a batch).
+         *
+         * Updates are lazy: the state of rows which are not listed (momentum, moment estimates)
+         * is left untouched instead of being decayed. The gradients of the listed rows are reset
+         * to zero and the list is cleared.
+         *
+         * @param value The parameter matrix to update.
+         * @param gradient The gradient of the loss with respect to the parameter.
+         * @param rows Rows with non-zero gradients, duplicates are allowed.
+         * @param slots Slot of the parameter, filled on the first update.
+         * @throws std::invalid_argument If the gradient or the parameter does not match the slot.
+         * @throws std::out_of_range If a row is out of bounds.
+         */
+        void updateRows(Matrix &value, Matrix &gradient, std::vector<int> &rows, ParameterSlots &slots);
+
+        /**
+         * @brief Saves the state of the bound parameters and of the parameters updated on their own
+         *        (e.g. moment estimates) to a binary stream.
+         *
+         * @param file Output binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If writing fails.
+         */
+        void saveState(std::ostream &file) const;
+
+        /**
+         * @brief Copies the state of all parameters, so it can be saved later on another thread.
+         *
+         * @return Function writing the copied state in the format of `saveState()`.
+         */
+        std::function<void(std::ostream &)> snapshotState() const;
+
+        /**
+         * @brief Restores the state saved by `saveState()`, the same parameters must be bound and updated on their own.
+         *
+         * @param file Input binary stream (a file or an in-memory buffer).
+         * @throws std::runtime_error If the state does not match the parameters or reading fails.
+         */
+        void loadState(std::istream &file);
+
+    protected:
+        /**
+         * @brief Returns a copy of the optimizer with its state buffers.
+         */
+        virtual std::unique_ptr<Optimizer> clone() const = 0;
+
+        /**
+         * @brief Writes the state buffers of the optimizer.
+         *
+         * @param file Output binary stream.
+         */
+        virtual void writeState(std::ostream &file) const = 0;
+
+        /**
+         * @brief Reads the state buffers of the optimizer, they are already sized for the bound parameters.
+         *
+         * @param file Input binary stream.
+         */
+        virtual void readState(std::istream &file) = 0;
+
+        /**
+         * @brief Writes the size and the elements of a state buffer.
+         *
+         * @param file Output binary stream.
+         * @param buffer The buffer to write.
+         */
+        template <typename T, typename Allocator>
+        static void writeBuffer(std::ostream &file, const std::vector<T, Allocator> &buffer);
+
+        /**
+         * @brief Reads a state buffer written by `writeBuffer()` into a buffer of the same size.
+         *
+         * @param file Input binary stream.
+         * @param buffer The buffer to fill.
+         * @throws std::runtime_error If the stored size differs from the size of the buffer.
+         */
+        template <typename T, typename Allocator>
+        static void readBuffer(std::istream &file, std::vector<T, Allocator> &buffer);
+
+        /**
+         * @brief Resizes the flat state buffers, keeping the state of the parameters which still fit.
+         *
+         * @param size Total number of elements of all parameters with state.
+         * @param count Number of parameters with state.
+         */
+        virtual void resizeState(const std::size_t size, const int count) = 0;
+
+        /**
+         * @brief Clears the whole optimizer state.
+         */
+        virtual void resetState() = 0;
+
+        /**
+         * @brief Prepares the update of a parameter, called once per update of the slot.
+         *
+         * @param slot Slot of the parameter.
+         */
+        virtual void prepareSlot(const int) {}
+
+        /**
+         * @brief Updates a contiguous range of a parameter.
+         *
+         * The values, the gradients and the state of the range never overlap. Implementations copy
+         * the pointers into `__restrict` locals and the hyperparameters into constants, so the
+         * compiler can vectorise the loop without reloading members after every store.
+         *
+         * @param slot Slot of the parameter.
+         * @param values Parameter values of the range.
+         * @param gradients Gradients of the range.
+         * @param offset Offset of the range in the flat index space.
+         * @param count Number of elements in the range.
+         */
+        virtual void updateRange(const int slot, double *values, const double *gradients, const std::size_t offset, const std::size_t count) = 0;
+
+    private:
+        /** @brief Returns the number of parameters with state, bound ones first. */
+        int getStateCount() const { return m_registry.getCount() + static_cast<int>(m_standaloneOffsets.size()) - 1; }
+
+        /** @brief Returns the offset of the state of a slot in the flat index space, or the total size for the slot after the last one. */
+        std::size_t getStateOffset(const int slot) const;
+
+        /**
+         * @brief Creates the state of parameters updated on their own unless their slots belong to the current registry.
+         *
+         * The state is appended after the state of the bound parameters, the registry is not changed.
+         *
+         * @param slots Slots of the parameters, replaced by the new slots.
+         * @param values The parameter matrices in the order of the slots, only their sizes are used.
+         * @throws std::invalid_argument If a parameter does not have the size of its slot.
+         */
+        void resolveSlots(ParameterSlots &slots, std::initializer_list<const Matrix *> values);
+
+        /**
+         * @brief Updates a whole parameter with the given gradient.
+         *
+         * @param slot Slot of the parameter.
+         * @param value The parameter matrix.
+         * @param gradient Gradient of the parameter.
+         */
+        void updateSlot(const int slot, Matrix &value, const Matrix &gradient);
+
+        /**
+         * @brief Updates the listed rows of a parameter, resets their gradients and clears the list.
+         *
+         * @param slot Slot of the parameter.
+         * @param value The parameter matrix.
+         * @param gradient Gradient of the parameter.
+         * @param rows Rows to update.
+         */
+        void updateSlotRows(const int slot, Matrix &value, Matrix &gradient, std::vector<int> &rows);
     };
 }
 
-#endif
\ No newline at end of file
+#include "Optimizer.tpp"
+
+#endif
@@ -0,0 +1,38 @@
+/**
+ * C++ neural network library
+ *
+ * Optimizer.tpp
+ */
+
+#ifndef OPTIMIZER_TPP
+#define OPTIMIZER_TPP
+
+#include "Optimizer.hpp"
+#include <stdexcept>
+
+namespace nn
+{
+    template <typename T, typename Allocator>
+    void Optimizer::writeBuffer(std::ostream &file, const std::vector<T, Allocator> &buffer)
+    {
+        // Write the number of elements followed by the raw elements
+        std::size_t size = buffer.size();
+        file.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        file.write(reinterpret_cast<const char *>(buffer.data()), sizeof(T) * size);
+    }
+
+    template <typename T, typename Allocator>
+    void Optimizer::readBuffer(std::istream &file, std::vector<T, Allocator> &buffer)
+    {
+        // The buffer must have been saved for the same parameters
+        std::size_t size;
+        file.read(reinterpret_cast<char *>(&size), sizeof(size));
+
+        if (!file.good() || size != buffer.size())
+            throw std::runtime_error("Optimizer state does not match the bound parameters.");
+
+        file.read(reinterpret_cast<char *>(buffer.data()), sizeof(T) * size);
+    }
+}
+
+#endif
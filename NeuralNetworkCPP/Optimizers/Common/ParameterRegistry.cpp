@@ -0,0 +1,41 @@
+/**
+ * C++ neural network library
+ *
+ * ParameterRegistry.cpp
+ */
+
+#include "ParameterRegistry.hpp"
+#include <algorithm>
+
+namespace nn
+{
+    ParameterRegistry::ParameterRegistry()
+        : m_offsets({0}) {}
+
+    int ParameterRegistry::add(Matrix &value, Matrix *gradient, std::vector<int> *touchedRows)
+    {
+        // Validate that the gradient matches the parameter
+        if (gradient && (gradient->getRows() != value.getRows() || gradient->getCols() != value.getCols()))
+            throw std::invalid_argument("Gradient dimensions must match the parameter dimensions.");
+
+        // Append the parameter right after the last registered one
+        m_values.push_back(&value);
+        m_gradients.push_back(gradient);
+        m_touchedRows.push_back(touchedRows);
+        m_offsets.push_back(m_offsets.back() + value.getSize());
+
+        return m_values.size() - 1;
+    }
+
+    bool ParameterRegistry::hasSameLayout(const ParameterRegistry &other) const
+    {
+        return m_offsets == other.m_offsets;
+    }
+
+    int ParameterRegistry::getSlotAt(const std::size_t offset) const
+    {
+        // Find the first slot starting after the offset, the previous one contains it
+        auto it = std::upper_bound(m_offsets.begin(), m_offsets.end(), offset);
+        return (it - m_offsets.begin()) - 1;
+    }
+}
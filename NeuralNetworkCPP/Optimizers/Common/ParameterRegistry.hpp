@@ -0,0 +1,87 @@
+/**
+ * C++ neural network library
+ *
+ * ParameterRegistry.hpp
+ */
+
+#ifndef PARAMETERREGISTRY_HPP
+#define PARAMETERREGISTRY_HPP
+
+#include "../../Matrix/Matrix.hpp"
+#include <cstddef>
+
+namespace nn
+{
+    /**
+     * @class ParameterRegistry
+     * @brief Ordered list of trainable parameters laid out in one flat index space.
+     *
+     * Each registered parameter (and its gradient) gets a slot and a stable offset in the
+     * flat space. Optimizers keep their state in contiguous buffers indexed by these offsets,
+     * so the state does not depend on the addresses of the parameter matrices.
+     *
+     * Only the optimizer state is flat: the parameters and gradients stay in the matrices of the
+     * layers and the registry refers to these matrices. A registry is therefore only valid while
+     * the layers keep their matrices, it has to be built and bound again once a layer replaces
+     * one (e.g. after loading, quantizing or pruning).
+     */
+    class ParameterRegistry
+    {
+    private:
+        std::vector<Matrix *> m_values;     ///< Registered parameters.
+        std::vector<Matrix *> m_gradients;  ///< Gradients of the registered parameters (may be null).
+        std::vector<std::vector<int> *> m_touchedRows; ///< Rows with non-zero gradients of row-sparse parameters (null for dense ones).
+        std::vector<std::size_t> m_offsets; ///< Offset of each slot, followed by the total size.
+
+    public:
+        /** @brief Constructs an empty registry. */
+        ParameterRegistry();
+
+        /**
+         * @brief Registers a parameter at the end of the flat index space.
+         *
+         * @param value The parameter matrix.
+         * @param gradient The matrix holding the gradient of the parameter (nullptr if none).
+         * @param touchedRows List of the gradient rows written since the last update, only these rows
+         *                    are updated (nullptr: the whole parameter is updated).
+         * @return Slot of the registered parameter.
+         */
+        int add(Matrix &value, Matrix *gradient, std::vector<int> *touchedRows = nullptr);
+
+        /**
+         * @brief Checks if both registries have the same number of slots with the same sizes.
+         *
+         * @param other The registry to compare with.
+         * @return True if optimizer state laid out for one registry fits the other.
+         */
+        bool hasSameLayout(const ParameterRegistry &other) const;
+
+        /** @brief Returns the number of registered parameters. */
+        int getCount() const { return m_values.size(); }
+
+        /** @brief Returns the total number of elements of all registered parameters. */
+        std::size_t getSize() const { return m_offsets.back(); }
+
+        /** @brief Returns the offset of the slot in the flat index space. */
+        std::size_t getOffset(const int slot) const { return m_offsets[slot]; }
+
+        /** @brief Returns the parameter registered in the slot. */
+        Matrix &getValue(const int slot) const { return *m_values[slot]; }
+
+        /** @brief Returns the gradient registered in the slot (nullptr if none). */
+        Matrix *getGradient(const int slot) const { return m_gradients[slot]; }
+
+        /** @brief Returns the list of touched rows of a row-sparse parameter (nullptr for dense parameters). */
+        std::vector<int> *getTouchedRows(const int slot) const { return m_touchedRows[slot]; }
+
+        /**
+         * @brief Returns the slot containing the given flat offset.
+         *
+         * @param offset Offset in the flat index space (must be lower than `getSize()`).
+         * @return Slot containing the offset.
+         */
+        int getSlotAt(const std::size_t offset) const;
+    };
+}
+
+#endif
@@ -11,21 +11,47 @@ namespace nn
 {
     RMSprop::RMSprop(double learningRate, double gamma, double epsilon)
         : Optimizer(learningRate), m_gamma(gamma), m_epsilon(epsilon) {}
-    
-    void RMSprop::update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases)
+
+    void RMSprop::resizeState(const std::size_t size, [[maybe_unused]] const int count)
+    {
+        // New parameters start with zero moving averages
+        m_v.resize(size, 0.0);
+    }
+
+    void RMSprop::resetState()
     {
-        // Initialize moving averages if they don't exist
-        if (m_v.find(&weights) == m_v.end())
-            m_v[&weights] = Matrix(weights.getRows(), weights.getCols(), 0.0);
-        if (m_v.find(&biases) == m_v.end())
-            m_v[&biases] = Matrix(biases.getRows(), biases.getCols(), 0.0);
-
-        // Update moving averages: v_t = gamma * v_{t-1} + (1 - gamma) * grad^2
-        m_v[&weights] = m_gamma * m_v[&weights] + (1 - m_gamma) * gradWeights.cwiseProduct(gradWeights);
-        m_v[&biases] = m_gamma * m_v[&biases] + (1 - m_gamma) * gradBiases.cwiseProduct(gradBiases);
-
-        // Update weights and biases: w -= learing_rate * grad / (sqrt(v_t) + epsilon)
-        weights -= m_learningRate * gradWeights / (m_v[&weights].map([](double x) { return std::sqrt(x); }) + m_epsilon);
-        biases -= m_learningRate * gradBiases / (m_v[&biases].map([](double x) { return std::sqrt(x); }) + m_epsilon);
+        m_v.clear();
+    }
+
+    void RMSprop::writeState(std::ostream &file) const
+    {
+        writeBuffer(file, m_v);
+    }
+
+    void RMSprop::readState(std::istream &file)
+    {
+        readBuffer(file, m_v);
+    }
+
+    void RMSprop::updateRange([[maybe_unused]] const int slot, double *values, const double *gradients, const std::size_t offset, const std::size_t count)
+    {
+        // No per-slot preparation, the moving averages are the only state
+        double *__restrict w = values;
+        const double *__restrict g = gradients;
+        double *__restrict v = m_v.data() + offset;
+        const double gamma = m_gamma, oneMinusGamma = 1.0 - m_gamma;
+        const double learningRate = m_learningRate;
+        const double epsilon = m_epsilon;
+
+        // Single in-place pass over moving averages and parameters
+        for (std::size_t i = 0; i < count; i++)
+        {
+            // v_t = gamma * v_{t-1} + (1 - gamma) * grad^2
+            double vi = gamma * v[i] + oneMinusGamma * g[i] * g[i];
+
+            // w -= learing_rate * grad / (sqrt(v_t) + epsilon)
+            v[i] = vi;
+            w[i] -= learningRate * g[i] / (std::sqrt(vi) + epsilon);
+        }
     }
-}
\ No newline at end of file
+}
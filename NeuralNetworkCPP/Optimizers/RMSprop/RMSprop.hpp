@@ -8,7 +8,7 @@
 #define RMSPROP_HPP
 
 #include "../Common/Optimizer.hpp"
-#include <unordered_map>
+#include "../../Memory/AlignedAllocator/AlignedAllocator.hpp"
 
 namespace nn
 {
@@ -22,9 +22,9 @@ namespace nn
     class RMSprop : public Optimizer
     {
     private:
-        double m_gamma;                           ///< Decay rate for the moving average of squared gradients.
-        double m_epsilon;                         ///< Small constant for numerical stability.
-        std::unordered_map<Matrix *, Matrix> m_v; ///< Moving average for weights and biases.
+        double m_gamma;            ///< Decay rate for the moving average of squared gradients.
+        double m_epsilon;          ///< Small constant for numerical stability.
+        AlignedVector<double> m_v; ///< Moving averages of all parameters, at their registry offsets.
 
     public:
         /**
@@ -36,15 +36,49 @@ namespace nn
          */
         RMSprop(double learningRate = 0.001, double gamma = 0.9, double epsilon = 1e-8);
 
+    protected:
         /**
-         * @brief Updates the weights and biases using RMSprop.
+         * @brief Resizes the flat state buffers, keeping the state of the parameters which still fit.
          *
-         * @param weights The weight matrix to update.
-         * @param biases The bias vector to update.
-         * @param gradWeights The gradient of the loss with respect to the weights.
-         * @param gradBiases The gradient of the loss with respect to the biases.
+         * @param size Total number of elements of all parameters with state.
+         * @param count Number of parameters with state.
          */
-        void update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases) override;
+        void resizeState(const std::size_t size, const int count) override;
+
+        /**
+         * @brief Clears the whole optimizer state.
+         */
+        void resetState() override;
+
+        /**
+         * @brief Returns a copy of the optimizer with its state buffers.
+         */
+        std::unique_ptr<Optimizer> clone() const override { return std::make_unique<RMSprop>(*this); }
+
+        /**
+         * @brief Writes the moving averages of the squared gradients.
+         *
+         * @param file Output binary stream.
+         */
+        void writeState(std::ostream &file) const override;
+
+        /**
+         * @brief Reads the moving averages of the squared gradients.
+         *
+         * @param file Input binary stream.
+         */
+        void readState(std::istream &file) override;
+
+        /**
+         * @brief Updates a contiguous range of a parameter using RMSprop.
+         *
+         * @param slot Slot of the parameter.
+         * @param values Parameter values of the range.
+         * @param gradients Gradients of the range.
+         * @param offset Offset of the range in the flat index space.
+         * @param count Number of elements in the range.
+         */
+        void updateRange(const int slot, double *values, const double *gradients, const std::size_t offset, const std::size_t count) override;
     };
 }
 
@@ -11,22 +11,44 @@ namespace nn
     SGD::SGD(double learningRate, double momentum)
         : Optimizer(learningRate), m_momentum(momentum) {}
 
-    void SGD::update(Matrix &weights, Matrix &biases, const Matrix &gradWeights, const Matrix &gradBiases)
+    void SGD::resizeState(const std::size_t size, [[maybe_unused]] const int count)
     {
-        // Initialize velocity matrices if they don't exist
-        if (m_velocities.find(&weights) == m_velocities.end())
-            m_velocities[&weights] = Matrix(weights.getRows(), weights.getCols(), 0.0);
-        if (m_velocities.find(&biases) == m_velocities.end())
-            m_velocities[&biases] = Matrix(biases.getRows(), biases.getCols(), 0.0);
+        // New parameters start with zero velocity
+        m_velocities.resize(size, 0.0);
+    }
+
+    void SGD::resetState()
+    {
+        m_velocities.clear();
+    }
 
-        // Update velocity for weights: v_t = momentum * v_{t-1} + learingRate * gradWeights
-        m_velocities[&weights] = (m_momentum * m_velocities[&weights]) + (m_learningRate * gradWeights);
+    void SGD::writeState(std::ostream &file) const
+    {
+        writeBuffer(file, m_velocities);
+    }
+
+    void SGD::readState(std::istream &file)
+    {
+        readBuffer(file, m_velocities);
+    }
+
+    void SGD::updateRange([[maybe_unused]] const int slot, double *values, const double *gradients, const std::size_t offset, const std::size_t count)
+    {
+        // The learning rate is folded into the velocities, the parameters only subtract them
+        double *__restrict w = values;
+        const double *__restrict g = gradients;
+        double *__restrict velocities = m_velocities.data() + offset;
+        const double momentum = m_momentum;
+        const double learningRate = m_learningRate;
 
-        // Update velocity for biases: v_t = momentum * v_{t-1} + learingRate * gradBiases
-        m_velocities[&biases] = (m_momentum * m_velocities[&biases]) + (m_learningRate * gradBiases);
+        // Single in-place pass over velocities and parameters
+        for (std::size_t i = 0; i < count; i++)
+        {
+            // v_t = momentum * v_{t-1} + learingRate * grad
+            double vi = momentum * velocities[i] + learningRate * g[i];
 
-        // Update weights and biases
-        weights -= m_velocities[&weights];
-        biases -= m_velocities[&biases];
+            velocities[i] = vi;
+            w[i] -= vi;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,367 @@
+/**
+ * C++ neural network library
+ *
+ * Pipeline.cpp
+ */
+
+#include "Pipeline.hpp"
+#include "../GlobalThreadPool/GlobalThreadPool.hpp"
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace nn
+{
+    // Seconds elapsed since a point in time
+    static double secondsSince(const std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Marks layers as recomputing a forward pass until the end of the scope, also when an exception leaves it
+    class RecomputingScope
+    {
+    private:
+        const std::vector<Layer *> &m_layers; // Layers of the stage
+
+    public:
+        explicit RecomputingScope(const std::vector<Layer *> &layers) : m_layers(layers)
+        {
+            for (Layer *layer : m_layers)
+                layer->setRecomputing(true);
+        }
+
+        ~RecomputingScope()
+        {
+            for (Layer *layer : m_layers)
+                layer->setRecomputing(false);
+        }
+
+        RecomputingScope(const RecomputingScope &) = delete;
+        RecomputingScope &operator=(const RecomputingScope &) = delete;
+    };
+
+    struct Pipeline::Stage
+    {
+        int index;                   ///< Position of the stage in the pipeline.
+        std::vector<Layer *> layers; ///< Layers of the stage in model order.
+        TaskQueue queue{PIPELINE_QUEUE_CAPACITY}; ///< Tasks waiting for the stage.
+        std::vector<Matrix> stash;   ///< Inputs of the micro-batches of the training forward pass.
+        int current = -1;            ///< Micro-batch whose state the layers hold for the backward pass (-1: none).
+        PipelineStageStats stats;    ///< Work done by the stage.
+        std::thread thread;          ///< Thread running the stage.
+    };
+
+    void Pipeline::TaskQueue::push(Task task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notFull.wait(lock, [this] { return m_capacity == 0 || m_tasks.size() < m_capacity; });
+            m_tasks.push_back(std::move(task));
+        }
+        m_notEmpty.notify_one();
+    }
+
+    Pipeline::Task Pipeline::TaskQueue::pop()
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_notEmpty.wait(lock, [this] { return !m_tasks.empty(); });
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        m_notFull.notify_one();
+        return task;
+    }
+
+    Pipeline::Pipeline(const std::vector<Layer *> &layers, const int numStages, const e_layout layout, const MemoryConfig &memoryConfig)
+        : m_layout(layout), m_memoryConfig(memoryConfig), m_results(0)
+    {
+        int numLayers = layers.size();
+        if (numStages < 1 || numStages > numLayers)
+            throw std::invalid_argument("A pipeline needs between one stage and one stage per layer.");
+
+        // Weigh each layer by its number of parameters, which grows with its work per sample
+        std::vector<double> prefixCost(numLayers + 1, 0.0);
+        for (int i = 0; i < numLayers; i++)
+        {
+            ParameterRegistry registry;
+            layers[i]->registerParameters(registry);
+            prefixCost[i + 1] = prefixCost[i] + registry.getSize() + 1.0;
+        }
+
+        // Split the available cores into one group per stage, stages share cores if there are fewer
+        std::vector<int> cores = getAvailableCores();
+        int numCores = cores.size();
+
+        int first = 0;
+        for (int s = 0; s < numStages; s++)
+        {
+            // End the stage where the cost is closest to its share, leaving a layer for each following stage
+            int end = numLayers;
+            if (s + 1 < numStages)
+            {
+                double target = prefixCost[numLayers] * (s + 1) / numStages;
+                end = first + 1;
+                while (end < numLayers - (numStages - s - 1) && std::abs(prefixCost[end + 1] - target) < std::abs(prefixCost[end] - target))
+                    end++;
+            }
+
+            auto stage = std::make_unique<Stage>();
+            stage->index = s;
+            stage->layers.assign(layers.begin() + first, layers.begin() + end);
+            stage->stats.firstLayer = first;
+            stage->stats.numLayers = end - first;
+
+            if (numCores >= numStages)
+            {
+                // The first `numCores % numStages` groups get one more core
+                int groupStart = s * (numCores / numStages) + std::min(s, numCores % numStages);
+                int groupSize = numCores / numStages + (s < numCores % numStages ? 1 : 0);
+                stage->stats.cores.assign(cores.begin() + groupStart, cores.begin() + groupStart + groupSize);
+            }
+            else
+                stage->stats.cores = {cores[s % numCores]};
+
+            m_stages.push_back(std::move(stage));
+            first = end;
+        }
+
+        // Start the stages, those already running are stopped if a thread cannot be created
+        try
+        {
+            for (auto &stage : m_stages)
+                stage->thread = std::thread(&Pipeline::runStage, this, std::ref(*stage));
+        }
+        catch (...)
+        {
+            stop();
+            throw;
+        }
+    }
+
+    Pipeline::~Pipeline()
+    {
+        stop();
+    }
+
+    void Pipeline::stop()
+    {
+        for (auto &stage : m_stages)
+        {
+            if (!stage->thread.joinable())
+                continue;
+
+            stage->queue.push(Task());
+            stage->thread.join();
+        }
+    }
+
+    std::vector<Matrix> Pipeline::forward(std::vector<Matrix> microBatches, const bool isTraining)
+    {
+        int numMicroBatches = microBatches.size();
+
+        // The stages are idle, so their state can be prepared without locking
+        for (auto &stage : m_stages)
+        {
+            stage->stash.clear();
+            if (isTraining)
+                stage->stash.resize(numMicroBatches);
+            stage->current = -1;
+        }
+        m_trainingMicroBatches = isTraining ? numMicroBatches : 0;
+
+        // Feed the micro-batches into the first stage
+        std::vector<Task> tasks(numMicroBatches);
+        for (int i = 0; i < numMicroBatches; i++)
+        {
+            tasks[i].type = isTraining ? TRAINING_FORWARD_TASK : FORWARD_TASK;
+            tasks[i].index = i;
+            tasks[i].data = std::move(microBatches[i]);
+        }
+
+        try
+        {
+            return run(0, std::move(tasks));
+        }
+        catch (...)
+        {
+            m_trainingMicroBatches = 0;
+            throw;
+        }
+    }
+
+    void Pipeline::backward(std::vector<Matrix> gradients)
+    {
+        if (static_cast<int>(gradients.size()) != m_trainingMicroBatches)
+            throw std::invalid_argument("The number of gradients does not match the micro-batches of the last training forward pass.");
+
+        // Feed the gradients into the last stage in reverse order, its layers still hold the last micro-batch
+        std::vector<Task> tasks(gradients.size());
+        for (int i = 0; i < static_cast<int>(gradients.size()); i++)
+        {
+            int index = gradients.size() - 1 - i;
+            tasks[i].type = BACKWARD_TASK;
+            tasks[i].index = index;
+            tasks[i].data = std::move(gradients[index]);
+        }
+
+        m_trainingMicroBatches = 0;
+        run(m_stages.size() - 1, std::move(tasks));
+    }
+
+    std::vector<PipelineStageStats> Pipeline::getStats() const
+    {
+        std::vector<PipelineStageStats> stats;
+        for (const auto &stage : m_stages)
+            stats.push_back(stage->stats);
+        return stats;
+    }
+
+    void Pipeline::resetStats()
+    {
+        for (auto &stage : m_stages)
+        {
+            PipelineStageStats &stats = stage->stats;
+            stats = PipelineStageStats{stats.firstLayer, stats.numLayers, stats.cores};
+        }
+    }
+
+    std::vector<Matrix> Pipeline::run(const int stage, std::vector<Task> tasks)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int numTasks = tasks.size();
+
+        // The results go to an unbounded queue, so the stages never block on the caller while it feeds them
+        for (Task &task : tasks)
+            m_stages[stage]->queue.push(std::move(task));
+
+        std::vector<Matrix> results(numTasks);
+        for (int i = 0; i < numTasks; i++)
+        {
+            Task task = m_results.pop();
+            results[task.index] = std::move(task.data);
+        }
+
+        // All stages are idle again, account the elapsed time to each of them
+        double elapsed = secondsSince(start);
+        for (auto &s : m_stages)
+            s->stats.activeSeconds += elapsed;
+
+        // Report the first error once all tasks left the pipeline
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(m_errorMutex);
+            std::swap(error, m_error);
+        }
+        if (error)
+            std::rethrow_exception(error);
+
+        return results;
+    }
+
+    void Pipeline::runStage(Stage &stage)
+    {
+        // Run the parallel loops of the layers on the cores of the stage only
+        pinCurrentThread(stage.stats.cores);
+        ThreadPool pool(stage.stats.cores.size(), stage.stats.cores);
+        ThreadPoolScope poolScope(pool);
+        MemoryConfigScope memoryScope(m_memoryConfig);
+
+        int lastStage = m_stages.size() - 1;
+
+        while (true)
+        {
+            Task task = stage.queue.pop();
+            if (task.type == STOP_TASK)
+                return;
+
+            if (!task.isFailed)
+            {
+                auto start = std::chrono::steady_clock::now();
+
+                try
+                {
+                    if (task.type == BACKWARD_TASK)
+                    {
+                        task.data = backwardStage(stage, task.index, task.data);
+                    }
+                    else
+                    {
+                        stage.stats.microBatches++;
+                        stage.stats.samples += (m_layout == SAMPLE_MAJOR) ? task.data.getRows() : task.data.getCols();
+
+                        // Keep the input of a training micro-batch to recompute its forward pass later
+                        if (task.type == TRAINING_FORWARD_TASK)
+                        {
+                            stage.stash[task.index] = task.data;
+                            stage.current = task.index;
+                        }
+
+                        task.data = forwardStage(stage, task.data);
+                        stage.stats.forwardSeconds += secondsSince(start);
+                    }
+                }
+                catch (...)
+                {
+                    // Keep the first error and let the task travel on, so the caller still receives all of them
+                    std::lock_guard<std::mutex> lock(m_errorMutex);
+                    if (!m_error)
+                        m_error = std::current_exception();
+                    task.isFailed = true;
+                    task.data = Matrix();
+                    stage.current = -1;
+                }
+            }
+
+            // Forward passes go towards the last stage, backward passes towards the first one
+            bool isBackward = task.type == BACKWARD_TASK;
+            bool isLeaving = isBackward ? stage.index == 0 : stage.index == lastStage;
+            TaskQueue &next = isLeaving ? m_results : m_stages[stage.index + (isBackward ? -1 : 1)]->queue;
+            next.push(std::move(task));
+        }
+    }
+
+    Matrix Pipeline::forwardStage(Stage &stage, const Matrix &input)
+    {
+        Matrix output = stage.layers.front()->forward(input);
+
+        for (auto it = stage.layers.begin() + 1; it != stage.layers.end(); it++)
+            output = (*it)->forward(output);
+
+        return output;
+    }
+
+    Matrix Pipeline::backwardStage(Stage &stage, const int index, const Matrix &gradient)
+    {
+        // Restore the state of the micro-batch if the layers hold another one
+        if (stage.current != index)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            {
+                RecomputingScope recomputingScope(stage.layers);
+                forwardStage(stage, stage.stash[index]);
+            }
+
+            stage.current = index;
+            stage.stats.recomputeSeconds += secondsSince(start);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        // Accumulate the gradients of the parameters, the update is left to the caller
+        Matrix grad = stage.layers.back()->accumulateGradients(gradient);
+
+        for (auto it = stage.layers.rbegin() + 1; it != stage.layers.rend(); it++)
+            grad = (*it)->accumulateGradients(grad);
+
+        // The input of the micro-batch is no longer needed
+        stage.stash[index] = Matrix();
+        stage.stats.backwardSeconds += secondsSince(start);
+
+        return grad;
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * C++ neural network library
+ *
+ * Pipeline.hpp
+ */
+
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "../Layers/Common/Layer.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nn
+{
+    /// Number of micro-batches that can wait in front of a stage before the previous stage blocks.
+    constexpr std::size_t PIPELINE_QUEUE_CAPACITY = 2;
+
+    /// Default number of micro-batches per stage, enough to keep the idle time at the start and end of a batch small.
+    constexpr int PIPELINE_MICRO_BATCHES_PER_STAGE = 4;
+
+    /**
+     * @brief Work done by one stage of a pipeline since it was built or its statistics were reset.
+     */
+    struct PipelineStageStats
+    {
+        int firstLayer = 0;           ///< Index of the first layer of the stage in the model.
+        int numLayers = 0;            ///< Number of layers of the stage.
+        std::vector<int> cores;       ///< CPU cores of the stage.
+        std::size_t microBatches = 0; ///< Number of micro-batches passed forward through the stage.
+        std::size_t samples = 0;      ///< Number of samples passed forward through the stage.
+        double forwardSeconds = 0.0;  ///< Time spent in forward passes, excluding recomputation.
+        double recomputeSeconds = 0.0;///< Time spent recomputing forward passes before backward passes.
+        double backwardSeconds = 0.0; ///< Time spent in backward passes.
+        double activeSeconds = 0.0;   ///< Wall-clock time the pipeline was running.
+
+        /** @brief Returns the time the stage spent computing. */
+        double getBusySeconds() const { return forwardSeconds + recomputeSeconds + backwardSeconds; }
+
+        /** @brief Returns the samples per second of the stage while the pipeline was running, 0 before any work. */
+        double getThroughput() const { return (activeSeconds > 0.0) ? samples / activeSeconds : 0.0; }
+
+        /** @brief Returns the fraction of the running time the stage was busy, the rest it waited for other stages. */
+        double getUtilization() const { return (activeSeconds > 0.0) ? getBusySeconds() / activeSeconds : 0.0; }
+    };
+
+    /**
+     * @class Pipeline
+     * @brief Runs consecutive groups of layers (stages) on their own threads and cores.
+     *
+     * Each stage owns a thread and a thread pool pinned to a group of cores, which replaces the
+     * global pool for the parallel loops of its layers. Micro-batches stream from stage to stage
+     * through bounded queues, so while one stage works on a micro-batch the previous stage already
+     * works on the next one.
+     *
+     * Training follows the GPipe schedule: all micro-batches of a batch are passed forward, then
+     * their gradients are passed backward in reverse order and the caller updates the parameters
+     * once. Stages keep only the inputs of the micro-batches and recompute the forward pass of a
+     * micro-batch before its backward pass (re-materialisation), except for the last one whose
+     * state the layers still hold.
+     */
+    class Pipeline
+    {
+    private:
+        /// Kinds of work passed between the stages.
+        enum e_taskType { FORWARD_TASK, TRAINING_FORWARD_TASK, BACKWARD_TASK, STOP_TASK };
+
+        /// Micro-batch or gradient travelling through the pipeline.
+        struct Task
+        {
+            e_taskType type = STOP_TASK; ///< Kind of work.
+            int index = 0;               ///< Index of the micro-batch.
+            Matrix data;                 ///< Input of the next stage, or gradient of its output.
+            bool isFailed = false;       ///< True if a stage threw, later stages pass the task on.
+        };
+
+        /// Queue of tasks, blocking when empty or when it holds `capacity` tasks.
+        class TaskQueue
+        {
+        private:
+            std::mutex m_mutex;                  ///< Guards the tasks.
+            std::condition_variable m_notEmpty;  ///< Signals a new task.
+            std::condition_variable m_notFull;   ///< Signals a removed task.
+            std::deque<Task> m_tasks;            ///< Waiting tasks.
+            std::size_t m_capacity;              ///< Maximum number of waiting tasks, 0 for no limit.
+
+        public:
+            explicit TaskQueue(const std::size_t capacity) : m_capacity(capacity) {}
+
+            void push(Task task);
+            Task pop();
+        };
+
+        struct Stage;
+
+        e_layout m_layout;                            ///< Layout of the samples in the micro-batches.
+        MemoryConfig m_memoryConfig;                  ///< Memory configuration of the matrices created by the stages.
+        std::vector<std::unique_ptr<Stage>> m_stages; ///< Stages in model order.
+        TaskQueue m_results;                          ///< Outputs of the last stage and gradients leaving the first stage.
+        int m_trainingMicroBatches = 0;               ///< Number of micro-batches of the training forward pass awaiting `backward`.
+        std::mutex m_errorMutex;                      ///< Guards the error.
+        std::exception_ptr m_error;                   ///< First error raised by a stage since the last run.
+
+    public:
+        /**
+         * @brief Splits the layers into stages and starts their threads.
+         *
+         * The layers are split into contiguous stages with about the same number of parameters, the
+         * available cores into groups of the same size. With fewer cores than stages, stages share cores.
+         *
+         * @param layers Layers of the model in order, must outlive the pipeline.
+         * @param numStages Number of stages, at most the number of layers.
+         * @param layout Layout of the samples in the micro-batches.
+         * @param memoryConfig Memory configuration of the matrices created by the stages.
+         * @throws std::invalid_argument If there are fewer layers than stages or fewer than one stage.
+         */
+        Pipeline(const std::vector<Layer *> &layers, const int numStages, const e_layout layout, const MemoryConfig &memoryConfig);
+
+        /** @brief Stops and joins the stage threads. */
+        ~Pipeline();
+
+        Pipeline(const Pipeline &) = delete;
+        Pipeline &operator=(const Pipeline &) = delete;
+
+        /** @brief Returns the number of stages. */
+        int getStageCount() const { return static_cast<int>(m_stages.size()); }
+
+        /**
+         * @brief Passes micro-batches forward through all stages.
+         *
+         * @param microBatches Inputs of the first layer, in the layout of the model.
+         * @param isTraining True to keep the inputs of every stage for `backward`.
+         * @return The outputs of the last layer in the order of the inputs.
+         * @throws Any exception thrown by a layer, after all micro-batches left the pipeline.
+         */
+        std::vector<Matrix> forward(std::vector<Matrix> microBatches, const bool isTraining);
+
+        /**
+         * @brief Passes the gradients of the micro-batches of the last training `forward` backward through all stages.
+         *
+         * The gradients of the parameters are accumulated in the layers, the caller applies them.
+         *
+         * @param gradients Gradients of the loss with respect to the outputs, in the order of the micro-batches.
+         * @throws std::invalid_argument If the number of gradients does not match the last forward pass.
+         * @throws Any exception thrown by a layer, after all gradients left the pipeline.
+         */
+        void backward(std::vector<Matrix> gradients);
+
+        /** @brief Returns the statistics of each stage, only valid between two calls of `forward` or `backward`. */
+        std::vector<PipelineStageStats> getStats() const;
+
+        /** @brief Resets the counters and timers of all stages. */
+        void resetStats();
+
+    private:
+        /** @brief Stops and joins the threads of the stages started so far. */
+        void stop();
+
+        /** @brief Main loop of the thread of a stage. */
+        void runStage(Stage &stage);
+
+        /** @brief Passes a micro-batch forward through the layers of a stage. */
+        static Matrix forwardStage(Stage &stage, const Matrix &input);
+
+        /** @brief Passes a gradient backward through the layers of a stage, recomputing the forward pass if needed. */
+        static Matrix backwardStage(Stage &stage, const int index, const Matrix &gradient);
+
+        /** @brief Feeds tasks into a stage and collects as many results, then rethrows the first error of the stages. */
+        std::vector<Matrix> run(const int stage, std::vector<Task> tasks);
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * C++ neural network library
+ *
+ * Quantization.cpp
+ */
+
+#include "Quantization.hpp"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+namespace nn
+{
+    QuantizationReport compareQuantized(
+        NeuralNetworkCPP &reference,
+        NeuralNetworkCPP &quantized,
+        const std::vector<std::vector<double>> &xTest,
+        const std::vector<std::vector<double>> &yTest,
+        const e_metric metric,
+        const int repetitions
+    )
+    {
+        if (xTest.empty() || yTest.empty())
+            throw std::invalid_argument("Test data must not be empty.");
+        if (repetitions <= 0)
+            throw std::invalid_argument("Number of repetitions must be greater than zero.");
+
+        QuantizationReport report;
+
+        // Accuracy of both models
+        report.referenceMetric = reference.evaluate(xTest, yTest, metric);
+        report.quantizedMetric = quantized.evaluate(xTest, yTest, metric);
+
+        // Average time of a full inference pass over the test data
+        auto timePredictions = [&xTest, repetitions](NeuralNetworkCPP &model, std::vector<std::vector<double>> &predictions) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repetitions; i++)
+                predictions = model.predict(xTest);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() / repetitions;
+        };
+
+        std::vector<std::vector<double>> referencePredictions, quantizedPredictions;
+        report.referenceSeconds = timePredictions(reference, referencePredictions);
+        report.quantizedSeconds = timePredictions(quantized, quantizedPredictions);
+
+        // Largest deviation of the quantized outputs
+        report.maxDifference = 0.0;
+        for (std::size_t i = 0; i < referencePredictions.size(); i++)
+        {
+            for (std::size_t j = 0; j < referencePredictions[i].size(); j++)
+                report.maxDifference = std::max(report.maxDifference, std::abs(referencePredictions[i][j] - quantizedPredictions[i][j]));
+        }
+
+        return report;
+    }
+
+    std::ostream &operator<<(std::ostream &stream, const QuantizationReport &report)
+    {
+        stream << "Metric: " << report.referenceMetric << " (double) / " << report.quantizedMetric << " (int8)\n";
+        stream << "Inference time: " << report.referenceSeconds * 1000.0 << " ms (double) / " << report.quantizedSeconds * 1000.0 << " ms (int8), ";
+        stream << "speedup x" << (report.quantizedSeconds > 0.0 ? report.referenceSeconds / report.quantizedSeconds : 0.0) << "\n";
+        stream << "Max output difference: " << report.maxDifference << "\n";
+        return stream;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * C++ neural network library
+ *
+ * Quantization.hpp
+ */
+
+#ifndef QUANTIZATION_HPP
+#define QUANTIZATION_HPP
+
+/**
+ * @file Quantization.hpp
+ * @brief This file contains tools to assess int8 quantized models.
+ */
+
+#include "../NeuralNetworkCPP.hpp"
+#include <ostream>
+
+namespace nn
+{
+    /**
+     * @brief Accuracy and speed of a quantized model compared with the double precision model.
+     */
+    struct QuantizationReport
+    {
+        double referenceMetric;  ///< Metric of the double precision model.
+        double quantizedMetric;  ///< Metric of the quantized model.
+        double referenceSeconds; ///< Average inference time of the double precision model.
+        double quantizedSeconds; ///< Average inference time of the quantized model.
+        double maxDifference;    ///< Largest absolute difference between the outputs of the models.
+    };
+
+    /**
+     * @brief Compares a quantized model with the model it was quantized from.
+     *
+     * @param reference The double precision model.
+     * @param quantized The quantized model.
+     * @param xTest Test data (vector of input vectors).
+     * @param yTest Test labels (vector of output vectors).
+     * @param metric Metric to compare (default: accuracy).
+     * @param repetitions Number of timed inference passes over the test data (default: 5).
+     * @return The report.
+     * @throws std::invalid_argument If the test data is empty or repetitions is not positive.
+     */
+    QuantizationReport compareQuantized(
+        NeuralNetworkCPP &reference,
+        NeuralNetworkCPP &quantized,
+        const std::vector<std::vector<double>> &xTest,
+        const std::vector<std::vector<double>> &yTest,
+        const e_metric metric = ACCURACY_LOG,
+        const int repetitions = 5
+    );
+
+    /**
+     * @brief Prints a quantization report.
+     *
+     * @param stream The output stream.
+     * @param report The report to print.
+     * @return The output stream.
+     */
+    std::ostream &operator<<(std::ostream &stream, const QuantizationReport &report);
+}
+
+#endif
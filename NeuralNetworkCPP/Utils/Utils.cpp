@@ -45,6 +45,12 @@ namespace nn
     }
 
     void shuffleDataset(std::vector<std::vector<double>> &data, std::vector<std::vector<double>> &labels)
+    {
+        std::mt19937 generator(std::random_device{}());
+        shuffleDataset(data, labels, generator);
+    }
+
+    void shuffleDataset(std::vector<std::vector<double>> &data, std::vector<std::vector<double>> &labels, std::mt19937 &generator)
     {
         // Check if data and labels have the same number of rows
         if (data.size() != labels.size())
@@ -55,7 +61,7 @@ namespace nn
         std::iota(indices.begin(), indices.end(), 0);
         
         // Shuffle the indices vector
-        std::shuffle(indices.begin(), indices.end(), std::mt19937(std::random_device{}()));
+        std::shuffle(indices.begin(), indices.end(), generator);
 
         // Reorder the rows of data and labels
         reorderRows(data, indices);
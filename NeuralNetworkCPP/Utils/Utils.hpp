@@ -13,6 +13,7 @@
  */
 
 #include <vector>
+#include <random>
 
 namespace nn
 {
@@ -45,6 +46,18 @@ namespace nn
      */
     void shuffleDataset(std::vector<std::vector<double>> &data, std::vector<std::vector<double>> &labels);
 
+    /**
+     * @brief Shuffles the rows of the provided data and labels with the given generator.
+     *
+     * The same generator state always yields the same order, which makes the shuffle reproducible.
+     *
+     * @param data A 2D data vector to shuffle.
+     * @param labels A 2D labels vector to shuffle.
+     * @param generator The random number generator to draw the permutation from.
+     * @throws std::runtime_error If data and labels have different amount of rows.
+     */
+    void shuffleDataset(std::vector<std::vector<double>> &data, std::vector<std::vector<double>> &labels, std::mt19937 &generator);
+
     /**
      * @brief Converts a vector of class labels into one-hot encoded vectors.
      *
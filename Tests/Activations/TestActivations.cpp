@@ -6,6 +6,9 @@
 
 #include <gtest/gtest.h>
 #include <NeuralNetworkCPP/Activations/Activations.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 TEST(ActivationsTests, ReLU)
 {
@@ -70,4 +73,123 @@ TEST(ActivationsTests, Softmax)
     EXPECT_NEAR(gradInput(0, 0), 0.19215, 1e-5);
     EXPECT_NEAR(gradInput(1, 0), 0.20781, 1e-5);
     EXPECT_NEAR(gradInput(2, 0), 0.03388, 1e-5);
-}
\ No newline at end of file
+}
+
+TEST(ActivationsTests, FastMathKernels)
+{
+    // Cover the whole exp range, including clamped arguments
+    std::vector<double> expInput;
+    for (double x = -720.0; x <= 720.0; x += 0.37)
+        expInput.push_back(x);
+
+    std::vector<double> expOutput(expInput.size());
+    nn::fastExp(expInput.data(), expOutput.data(), expInput.size());
+
+    for (std::size_t i = 0; i < expInput.size(); i++)
+    {
+        double expected = std::exp(std::max(-708.0, std::min(expInput[i], 709.0)));
+        EXPECT_NEAR(expOutput[i], expected, expected * 1e-14);
+    }
+
+    // Cover tiny, unit and huge arguments, evaluated in place
+    std::vector<double> logInput;
+    for (double x = 1e-300; x < 1e300; x *= 1.7)
+        logInput.push_back(x);
+
+    std::vector<double> logOutput = logInput;
+    nn::fastLog(logOutput.data(), logOutput.data(), logOutput.size());
+
+    for (std::size_t i = 0; i < logInput.size(); i++)
+    {
+        double expected = std::log(logInput[i]);
+        EXPECT_NEAR(logOutput[i], expected, 1e-15 + 1e-15 * std::abs(expected));
+    }
+
+    // Sigmoid saturates without overflow
+    std::vector<double> sigmoidInput = {-1000.0, -5.0, 0.0, 0.5, 5.0, 1000.0};
+    std::vector<double> sigmoidOutput(sigmoidInput.size());
+    nn::fastSigmoid(sigmoidInput.data(), sigmoidOutput.data(), sigmoidInput.size());
+
+    for (std::size_t i = 0; i < sigmoidInput.size(); i++)
+    {
+        double expected = 1.0 / (1.0 + std::exp(-sigmoidInput[i]));
+        EXPECT_NEAR(sigmoidOutput[i], expected, expected * 1e-14 + 1e-300);
+    }
+
+    // The parallel path gives the same values as the serial kernel
+    std::vector<double> parallelOutput(expInput.size());
+    nn::applyInParallel(nn::fastExp, expInput.data(), parallelOutput.data(), expInput.size());
+    EXPECT_EQ(parallelOutput, expOutput);
+}
+
+TEST(ActivationsTests, FastMathPolicy)
+{
+    nn::Matrix input(4, 3, {1.0, -2.0, 30.0, 0.0, 4.5, -700.0, 0.25, -0.5, 12.0, 3.0, -8.0, 1e-3});
+
+    // Sigmoid and Softmax with the fast kernels match the standard library
+    nn::Sigmoid sigmoid;
+    nn::Sigmoid fastSigmoid;
+    fastSigmoid.setMathPolicy(nn::FAST_MATH);
+
+    nn::Softmax softmax;
+    nn::Softmax fastSoftmax;
+    fastSoftmax.setMathPolicy(nn::FAST_MATH);
+
+    nn::Matrix expectedSigmoid = sigmoid.forward(input);
+    nn::Matrix outputSigmoid = fastSigmoid.forward(input);
+    nn::Matrix expectedSoftmax = softmax.forward(input);
+    nn::Matrix outputSoftmax = fastSoftmax.forward(input);
+
+    for (int i = 0; i < input.getRows(); i++)
+    {
+        for (int j = 0; j < input.getCols(); j++)
+        {
+            EXPECT_NEAR(outputSigmoid(i, j), expectedSigmoid(i, j), 1e-14);
+            EXPECT_NEAR(outputSoftmax(i, j), expectedSoftmax(i, j), 1e-14);
+        }
+    }
+}
+
+TEST(ActivationsTests, SoftmaxWideBatch)
+{
+    // More samples than a single block, with large values that overflow a naive exp
+    nn::Matrix input(5, 150);
+    for (int i = 0; i < input.getRows(); i++)
+        for (int j = 0; j < input.getCols(); j++)
+            input(i, j) = (((i * 150 + j) * 37) % 101) * 10.0 - 500.0;
+
+    nn::Softmax softmax;
+    nn::Matrix output = softmax.forward(input);
+
+    for (int j = 0; j < input.getCols(); j++)
+    {
+        double maxValue = input(0, j);
+        for (int i = 1; i < input.getRows(); i++)
+            maxValue = std::max(maxValue, input(i, j));
+
+        double sum = 0.0;
+        for (int i = 0; i < input.getRows(); i++)
+            sum += std::exp(input(i, j) - maxValue);
+
+        for (int i = 0; i < input.getRows(); i++)
+            EXPECT_NEAR(output(i, j), std::exp(input(i, j) - maxValue) / sum, 1e-15);
+    }
+}
+
+TEST(ActivationsTests, SoftmaxSampleMajor)
+{
+    nn::Softmax featureMajor;
+    nn::Softmax sampleMajor;
+    sampleMajor.setLayout(nn::SAMPLE_MAJOR);
+
+    // Each row of a sample-major batch is normalised like the matching column
+    nn::Matrix input(3, 4, {1.0, 2.0, -1.0, 0.5, 3.0, 0.0, -2.0, 1.5, 700.0, 699.0, -700.0, 0.0});
+    nn::Matrix expected = featureMajor.forward(input);
+    nn::Matrix output = sampleMajor.forward(input.transpose());
+
+    ASSERT_EQ(output.getRows(), 4);
+    ASSERT_EQ(output.getCols(), 3);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 3; j++)
+            EXPECT_NEAR(output(i, j), expected(j, i), 1e-15);
+}
@@ -0,0 +1,85 @@
+/**
+ * C++ neural network library
+ *
+ * TestInitializer.cpp
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <NeuralNetworkCPP/Initializers/Initializers.hpp>
+#include <NeuralNetworkCPP/GlobalThreadPool/GlobalThreadPool.hpp>
+#include <NeuralNetworkCPP/Layers/DenseLayer/DenseLayer.hpp>
+#include <NeuralNetworkCPP/Matrix/Matrix.hpp>
+
+// Test the generator against the known-answer vectors of the Philox4x32-10 reference implementation
+TEST(InitializerTests, PhiloxKnownAnswers)
+{
+    EXPECT_EQ(nn::philox4x32({0, 0, 0, 0}, {0, 0}), (nn::PhiloxBlock{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(nn::philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              (nn::PhiloxBlock{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(nn::philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+              (nn::PhiloxBlock{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+// Test that the values only depend on the seed and the index
+TEST(InitializerTests, SeedReproducibility)
+{
+    nn::HeNormal init1(100, 50, 42);
+    nn::HeNormal init2(100, 50, 42);
+    nn::HeNormal init3(100, 50, 43);
+
+    for (int i = 0; i < 100; i++)
+    {
+        double value = init1.getRandomNum();
+        EXPECT_EQ(value, init2.getValue(i));
+        EXPECT_NE(value, init3.getValue(i));
+    }
+}
+
+// Test that a parallel fill gives the same matrix for any number of threads
+TEST(InitializerTests, ParallelFillIndependentOfThreads)
+{
+    nn::XavierUniform init(64, 32, 7);
+
+    std::unique_ptr<nn::ThreadPool> original = std::move(nn::globalThreadPool);
+    std::vector<nn::Matrix> matrices;
+    for (int threads : {1, 3, 8})
+    {
+        nn::globalThreadPool = std::make_unique<nn::ThreadPool>(threads);
+        matrices.push_back(nn::Matrix(97, 61, [&init](std::size_t index) { return init.getValue(index); }));
+    }
+    nn::globalThreadPool = std::move(original);
+
+    EXPECT_EQ(matrices[1], matrices[0]);
+    EXPECT_EQ(matrices[2], matrices[0]);
+
+    // Element (i, j) holds the value of its row-major index
+    EXPECT_EQ(matrices[0](5, 3), init.getValue(5 * 61 + 3));
+}
+
+// Test that the global seed makes the weights of layers reproducible
+TEST(InitializerTests, GlobalSeed)
+{
+    auto createWeights = []() {
+        nn::DenseLayer first(8, 16, nn::HE_NORMAL, nn::RELU);
+        nn::DenseLayer second(16, 4, nn::XAVIER_UNIFORM, nn::SIGMOID);
+        std::stringstream stream;
+        first.save(stream);
+        second.save(stream);
+        return stream.str();
+    };
+
+    nn::setInitializerSeed(1234);
+    std::string weights1 = createWeights();
+    nn::setInitializerSeed(1234);
+    std::string weights2 = createWeights();
+    nn::setInitializerSeed(1235);
+    std::string weights3 = createWeights();
+    nn::clearInitializerSeed();
+    std::string weights4 = createWeights();
+
+    EXPECT_EQ(weights1, weights2);
+    EXPECT_NE(weights1, weights3);
+    EXPECT_NE(weights1, weights4);
+}
@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <numeric>
 #include <NeuralNetworkCPP/Initializers/HeUniform/HeUniform.hpp>
 #include "../../TestUtils/TestUtils.hpp"
 
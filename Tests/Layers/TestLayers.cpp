@@ -7,8 +7,11 @@
 #include <gtest/gtest.h>
 #include <NeuralNetworkCPP/Layers/Layers.hpp>
 #include <NeuralNetworkCPP/Optimizers/Adam/Adam.hpp>
+#include <NeuralNetworkCPP/Optimizers/SGD/SGD.hpp>
 #include <filesystem>
+#include <sstream>
 #include <cmath>
+#include <algorithm>
 
 TEST(DenseLayerTests, ForwardPass)
 {
@@ -71,6 +74,63 @@ TEST(DenseLayerTests, SaveAndLoad)
     std::filesystem::remove("layer.bin");
 }
 
+TEST(DenseLayerTests, SnapshotKeepsState)
+{
+    nn::DenseLayer layer(3, 1, nn::HE_NORMAL, nn::RELU);
+    nn::Adam optimizer{};
+
+    std::stringstream saved;
+    layer.save(saved);
+    auto snapshot = layer.snapshot();
+
+    // Update the layer after the snapshot was taken
+    layer.forward(nn::Matrix(3, 1, {1.0, 2.0, 3.0}));
+    layer.backward(nn::Matrix(1, 1, {0.5}), optimizer);
+
+    // The snapshot writes the state it copied, in the format of save
+    std::stringstream written;
+    snapshot(written);
+    EXPECT_EQ(written.str(), saved.str());
+}
+
+TEST(DenseLayerTests, SparseInputMatchesDenseInput)
+{
+    nn::DenseLayer layer(4, 3, nn::HE_NORMAL, nn::SIGMOID);
+    nn::SGD optimizer(0.1);
+
+    // Two samples, the sparse batch stores one sample per row
+    nn::SparseMatrix sparseInput(2, 4, {0, 2, 3}, {0, 3, 2}, {1.0, -2.0, 0.5});
+    nn::Matrix denseInput = sparseInput.toMatrix().transpose();
+    nn::Matrix gradient(3, 2, {0.5, -1.0, 1.0, 0.25, -0.5, 2.0});
+
+    // Same output as the dense input
+    nn::Matrix sparseOutput = layer.forward(sparseInput);
+    nn::Matrix denseOutput = layer.forward(denseInput);
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 2; j++)
+            EXPECT_NEAR(sparseOutput(i, j), denseOutput(i, j), 1e-12);
+    }
+
+    // Same update, the column of the missing feature is left untouched
+    std::stringstream stream;
+    layer.save(stream);
+    nn::DenseLayer denseLayer(stream);
+    std::vector<double> initialWeights = layer.getWeights().getData();
+
+    layer.forward(sparseInput);
+    EXPECT_EQ(layer.backward(gradient, optimizer).getSize(), 0);
+    denseLayer.forward(denseInput);
+    denseLayer.backward(gradient, optimizer);
+
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(layer.getWeights()(i, 1), initialWeights[i * 4 + 1]);
+        for (int j = 0; j < 4; j++)
+            EXPECT_NEAR(layer.getWeights()(i, j), denseLayer.getWeights()(i, j), 1e-12);
+    }
+}
+
 TEST(BatchNormalizationTests, ForwardPass)
 {
     nn::BatchNormalization bnLayer(3, 0.99, 1e-15);
@@ -130,6 +190,66 @@ TEST(BatchNormalizationTests, BackwardPass)
             EXPECT_NEAR(output(i, j), inputGrad(i, j), 1e-6);
 }
 
+TEST(BatchNormalizationTests, LargeBatchStatistics)
+{
+    nn::BatchNormalization bnLayer(2, 0.9, 1e-12);
+    bnLayer.setTrainingMode(true);
+
+    // Many blocks and a large offset, which a sum of squares would cancel
+    const int batchSize = 1000;
+    nn::Matrix input(2, batchSize);
+    for (int j = 0; j < batchSize; j++)
+    {
+        input(0, j) = 1e8 + (j % 7);
+        input(1, j) = -3.0 + 0.01 * j;
+    }
+
+    nn::Matrix output = bnLayer.forward(input);
+
+    // Each normalized feature has zero mean and unit variance
+    for (int i = 0; i < 2; i++)
+    {
+        double mean = 0.0;
+        double variance = 0.0;
+        for (int j = 0; j < batchSize; j++)
+            mean += output(i, j) / batchSize;
+        for (int j = 0; j < batchSize; j++)
+            variance += (output(i, j) - mean) * (output(i, j) - mean) / batchSize;
+
+        EXPECT_NEAR(mean, 0.0, 1e-7);
+        EXPECT_NEAR(variance, 1.0, 1e-7);
+    }
+}
+
+TEST(BatchNormalizationTests, GradientMatchesFiniteDifferences)
+{
+    nn::Matrix input(2, 5, {0.5, -1.0, 2.0, 0.3, 1.1, 4.0, 3.5, -2.0, 0.0, 1.0});
+    nn::Matrix weights(2, 5, {0.3, -0.7, 0.2, 0.9, -0.1, 0.5, 0.4, -0.6, 0.8, 0.05});
+
+    // Scalar loss sum(weights * output), its gradient with respect to the output is the weights
+    auto loss = [&weights](const nn::Matrix &x) {
+        nn::BatchNormalization bnLayer(2, 0.99, 1e-12);
+        return bnLayer.forward(x).cwiseProduct(weights).sum();
+    };
+
+    nn::BatchNormalization bnLayer(2, 0.99, 1e-12);
+    bnLayer.forward(input);
+    nn::Matrix gradInput = bnLayer.accumulateGradients(weights);
+
+    const double step = 1e-6;
+    for (int i = 0; i < input.getRows(); i++)
+    {
+        for (int j = 0; j < input.getCols(); j++)
+        {
+            nn::Matrix plus = input;
+            nn::Matrix minus = input;
+            plus(i, j) += step;
+            minus(i, j) -= step;
+            EXPECT_NEAR(gradInput(i, j), (loss(plus) - loss(minus)) / (2 * step), 1e-6);
+        }
+    }
+}
+
 TEST(BatchNormalizationTests, SaveAndLoad)
 {
     nn::BatchNormalization bnLayer(3, 0.99, 1e-15);
@@ -161,4 +281,255 @@ TEST(BatchNormalizationTests, SaveAndLoad)
             EXPECT_NEAR(output(i, j), output2(i, j), 1e-6);
 
     std::filesystem::remove("layer.bin");
-}
\ No newline at end of file
+}
+
+TEST(QuantizedDenseLayerTests, ForwardPassMatchesDenseLayer)
+{
+    nn::DenseLayer denseLayer(70, 5, nn::XAVIER_UNIFORM, nn::NONE);
+    nn::Matrix input(70, 3, []() { return 0.5; });
+    input(3, 1) = -1.0;
+
+    nn::QuantizedDenseLayer quantizedLayer(denseLayer, -1.0, 0.5);
+    nn::Matrix expected = denseLayer.forward(input);
+    nn::Matrix output = quantizedLayer.forward(input);
+
+    ASSERT_EQ(output.getRows(), 5);
+    ASSERT_EQ(output.getCols(), 3);
+
+    // Each product of an input step and a weight step is off by at most half a step of either
+    for (int i = 0; i < 5; i++)
+    {
+        for (int j = 0; j < 3; j++)
+            EXPECT_NEAR(output(i, j), expected(i, j), 0.05);
+    }
+
+    // Quantized layers cannot be trained
+    nn::Adam optimizer{};
+    EXPECT_THROW(quantizedLayer.backward(output, optimizer), std::runtime_error);
+}
+
+TEST(QuantizedDenseLayerTests, NonNegativeInputsUseAllLevels)
+{
+    nn::DenseLayer denseLayer(64, 4, nn::XAVIER_UNIFORM, nn::NONE);
+    nn::Matrix input(64, 8);
+    for (int k = 0; k < 64; k++)
+    {
+        for (int b = 0; b < 8; b++)
+            input(k, b) = ((k * 37 + b * 11) % 100) / 100.0;
+    }
+
+    // Inputs after a ReLU, the calibrated range [0, 1] maps to all 128 levels
+    nn::QuantizedDenseLayer quantizedLayer(denseLayer, 0.0, 1.0);
+    nn::Matrix expected = denseLayer.forward(input);
+    nn::Matrix output = quantizedLayer.forward(input);
+
+    const nn::Matrix &weights = denseLayer.getWeights();
+    double inputStep = 1.0 / 127.0;
+
+    for (int o = 0; o < 4; o++)
+    {
+        double maxWeight = 0.0;
+        for (int k = 0; k < 64; k++)
+            maxWeight = std::max(maxWeight, std::abs(weights(o, k)));
+        double weightStep = maxWeight / 127.0;
+
+        for (int b = 0; b < 8; b++)
+        {
+            // Each product is off by at most half an input step times the weight plus half a weight step times the input
+            double bound = 0.0;
+            for (int k = 0; k < 64; k++)
+                bound += 0.5 * inputStep * std::abs(weights(o, k)) + 0.5 * weightStep * input(k, b) + 0.25 * inputStep * weightStep;
+
+            EXPECT_LE(std::abs(output(o, b) - expected(o, b)), bound);
+        }
+    }
+}
+
+TEST(QuantizedDenseLayerTests, SaveAndLoad)
+{
+    nn::DenseLayer denseLayer(10, 4, nn::HE_NORMAL, nn::RELU);
+    nn::QuantizedDenseLayer layer(denseLayer, 0.0, 2.0);
+
+    std::ofstream outFile("layer.bin", std::ios::binary);
+    layer.save(outFile);
+    outFile.close();
+
+    std::ifstream inFile("layer.bin", std::ios::binary);
+    nn::QuantizedDenseLayer loadedLayer(inFile);
+    inFile.close();
+    std::filesystem::remove("layer.bin");
+
+    // The int8 representation is restored exactly
+    nn::Matrix input(10, 2, []() { return 1.5; });
+    nn::Matrix output = layer.forward(input);
+    nn::Matrix loadedOutput = loadedLayer.forward(input);
+
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 2; j++)
+            EXPECT_EQ(output(i, j), loadedOutput(i, j));
+    }
+}
+
+TEST(SparseDenseLayerTests, MatchesPrunedDenseLayer)
+{
+    nn::DenseLayer denseLayer(6, 4, nn::HE_NORMAL, nn::RELU);
+    denseLayer.prune(0.75);
+    EXPECT_NEAR(denseLayer.getSparsity(), 0.75, 1e-12);
+
+    nn::SparseDenseLayer sparseLayer(denseLayer);
+    EXPECT_EQ(sparseLayer.getWeights().getNonZeros(), 6);
+
+    nn::Matrix input(6, 2, {1.0, -1.0, 2.0, 0.5, -0.5, 3.0, 1.5, 1.0, -2.0, 0.0, 0.25, 2.0});
+    nn::Matrix gradient(4, 2, {0.5, -1.0, 1.0, 0.25, -0.5, 2.0, 1.5, -1.5});
+
+    // Same output and input gradient as the pruned dense layer
+    EXPECT_EQ(sparseLayer.forward(input).getData(), denseLayer.forward(input).getData());
+
+    nn::Matrix sparseGradInput = sparseLayer.accumulateGradients(gradient);
+    nn::Matrix denseGradInput = denseLayer.accumulateGradients(gradient);
+    for (int i = 0; i < 6; i++)
+    {
+        for (int j = 0; j < 2; j++)
+            EXPECT_NEAR(sparseGradInput(i, j), denseGradInput(i, j), 1e-12);
+    }
+}
+
+TEST(SparseDenseLayerTests, SaveAndLoad)
+{
+    nn::DenseLayer denseLayer(5, 3, nn::XAVIER_NORMAL, nn::SIGMOID);
+    denseLayer.prune(0.9);
+    nn::SparseDenseLayer layer(denseLayer);
+
+    std::ofstream outFile("layer.bin", std::ios::binary);
+    layer.save(outFile);
+    outFile.close();
+
+    std::ifstream inFile("layer.bin", std::ios::binary);
+    nn::SparseDenseLayer loadedLayer(inFile);
+    inFile.close();
+    std::filesystem::remove("layer.bin");
+
+    EXPECT_EQ(loadedLayer.getWeights().toMatrix().getData(), layer.getWeights().toMatrix().getData());
+
+    nn::Matrix input(5, 1, {1.0, 2.0, 3.0, 4.0, 5.0});
+    EXPECT_EQ(loadedLayer.forward(input).getData(), layer.forward(input).getData());
+}
+
+TEST(EmbeddingTests, ForwardAndBackwardPass)
+{
+    nn::Embedding layer(5, 3, 2);
+    nn::SGD optimizer(0.1, 0.0);
+    nn::Matrix table = layer.getTable();
+
+    // Two fields for two samples
+    nn::Matrix ids(2, 2, {4.0, 1.0, 0.0, 4.0});
+    nn::Matrix output = layer.forward(ids);
+
+    // Each column stacks the embeddings of the fields of the sample
+    ASSERT_EQ(output.getRows(), 6);
+    ASSERT_EQ(output.getCols(), 2);
+    for (int k = 0; k < 3; k++)
+    {
+        EXPECT_EQ(output(k, 0), table(4, k));
+        EXPECT_EQ(output(k, 1), table(1, k));
+        EXPECT_EQ(output(3 + k, 0), table(0, k));
+        EXPECT_EQ(output(3 + k, 1), table(4, k));
+    }
+
+    // Only the rows of the IDs in the batch are updated, repeated IDs sum their gradients
+    layer.backward(nn::Matrix(6, 2, 1.0), optimizer);
+    for (int k = 0; k < 3; k++)
+    {
+        EXPECT_NEAR(layer.getTable()(4, k), table(4, k) - 0.2, 1e-12);
+        EXPECT_NEAR(layer.getTable()(1, k), table(1, k) - 0.1, 1e-12);
+        EXPECT_EQ(layer.getTable()(2, k), table(2, k));
+    }
+
+    EXPECT_THROW(layer.forward(nn::Matrix(2, 1, {5.0, 0.0})), std::invalid_argument);
+}
+
+TEST(EmbeddingTests, SaveAndLoad)
+{
+    nn::Embedding layer(10, 4, 3);
+
+    std::ofstream outFile("layer.bin", std::ios::binary);
+    layer.save(outFile);
+    outFile.close();
+
+    std::ifstream inFile("layer.bin", std::ios::binary);
+    nn::Embedding loadedLayer(inFile);
+    inFile.close();
+    std::filesystem::remove("layer.bin");
+
+    nn::Matrix ids(3, 1, {9.0, 0.0, 5.0});
+    EXPECT_EQ(loadedLayer.forward(ids).getData(), layer.forward(ids).getData());
+}
+
+
+TEST(DenseLayerTests, SampleMajorMatchesFeatureMajor)
+{
+    nn::DenseLayer featureMajor(4, 3, nn::HE_NORMAL, nn::SIGMOID);
+    std::stringstream buffer;
+    featureMajor.save(buffer);
+    nn::DenseLayer sampleMajor(buffer);
+    sampleMajor.setLayout(nn::SAMPLE_MAJOR);
+    nn::SGD optimizer(0.1);
+
+    // One sample per row gives the transposed outputs and input gradients
+    nn::Matrix input(4, 5, {0.1, -0.2, 0.3, 0.4, 0.5, 1.0, 0.0, -1.0, 2.0, 0.5, -0.5, 0.25, 0.75, 0.0, 1.5, 0.2, 0.4, 0.6, 0.8, 1.0});
+    nn::Matrix gradient(3, 5, {0.1, 0.2, -0.3, 0.4, 0.5, -0.1, 0.0, 0.2, 0.3, -0.4, 0.6, -0.5, 0.1, 0.2, 0.0});
+
+    nn::Matrix expected = featureMajor.forward(input);
+    nn::Matrix output = sampleMajor.forward(input.transpose());
+    nn::Matrix expectedGrad = featureMajor.backward(gradient, optimizer);
+    nn::Matrix inputGrad = sampleMajor.backward(gradient.transpose(), optimizer);
+
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 5; j++)
+            EXPECT_NEAR(output(j, i), expected(i, j), 1e-14);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 5; j++)
+            EXPECT_NEAR(inputGrad(j, i), expectedGrad(i, j), 1e-14);
+
+    // Both layouts apply the same update
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            EXPECT_NEAR(sampleMajor.getWeights()(i, j), featureMajor.getWeights()(i, j), 1e-14);
+
+    // Sparse input and mixed precision stay feature-major
+    EXPECT_THROW(sampleMajor.forward(nn::SparseMatrix(input.transpose())), std::invalid_argument);
+    EXPECT_THROW(sampleMajor.setPrecision(nn::FLOAT16), std::invalid_argument);
+}
+
+TEST(BatchNormalizationTests, SampleMajorMatchesFeatureMajor)
+{
+    nn::BatchNormalization featureMajor(70, 0.9, 1e-12);
+    nn::BatchNormalization sampleMajor(70, 0.9, 1e-12);
+    sampleMajor.setLayout(nn::SAMPLE_MAJOR);
+    nn::SGD optimizer(0.1);
+
+    // More features than one block and more samples than one block of the statistics
+    nn::Matrix input(70, 300);
+    nn::Matrix gradient(70, 300);
+    for (int i = 0; i < 70; i++)
+        for (int j = 0; j < 300; j++)
+        {
+            input(i, j) = std::sin(0.37 * i + 0.11 * j) * (i + 1) + 0.01 * j;
+            gradient(i, j) = std::cos(0.21 * i - 0.05 * j);
+        }
+
+    nn::Matrix expected = featureMajor.forward(input);
+    nn::Matrix output = sampleMajor.forward(input.transpose());
+    nn::Matrix expectedGrad = featureMajor.backward(gradient, optimizer);
+    nn::Matrix inputGrad = sampleMajor.backward(gradient.transpose(), optimizer);
+
+    // The kernels use the same arithmetic per feature
+    EXPECT_EQ(output, expected.transpose());
+    EXPECT_EQ(inputGrad, expectedGrad.transpose());
+
+    featureMajor.setTrainingMode(false);
+    sampleMajor.setTrainingMode(false);
+    EXPECT_EQ(sampleMajor.forward(input.transpose()), featureMajor.forward(input).transpose());
+    EXPECT_THROW(sampleMajor.forward(input), std::invalid_argument);
+}
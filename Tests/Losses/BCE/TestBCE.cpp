@@ -7,6 +7,7 @@
 #include <gtest/gtest.h>
 #include <cmath>
 #include <NeuralNetworkCPP/Losses/BinaryCrossEntropy/BinaryCrossEntropy.hpp>
+#include <NeuralNetworkCPP/Activations/Sigmoid/Sigmoid.hpp>
 
 // Test if BCE computes loss correctly
 TEST(BCETests, ComputeLoss)
@@ -53,4 +54,52 @@ TEST(BCETests, ComputeGradient)
     nn::Matrix predictions3(2, 2);
     nn::Matrix targets3(1, 2);
     EXPECT_THROW(bce.computeGradient(predictions3, targets3), std::invalid_argument);
-}
\ No newline at end of file
+}
+
+// Test if BCE with the fast log matches the standard library
+TEST(BCETests, FastMathLoss)
+{
+    nn::BinaryCrossEntropy bce;
+    nn::BinaryCrossEntropy fastBce(nn::FAST_MATH);
+
+    nn::Matrix predictions(2, 3, {0.1, 0.7, 1e-12, 0.4, 0.5, 1.0});
+    nn::Matrix targets(2, 3, {0.0, 1.0, 0.0, 1.0, 0.0, 1.0});
+    EXPECT_NEAR(fastBce.computeLoss(predictions, targets), bce.computeLoss(predictions, targets), 1e-13);
+}
+
+// Test if the fused sigmoid head matches sigmoid followed by BCE
+TEST(BCETests, ComputeFromLogits)
+{
+    nn::BinaryCrossEntropy bce;
+    nn::BinaryCrossEntropy fastBce(nn::FAST_MATH);
+    nn::Sigmoid sigmoid;
+
+    nn::Matrix logits(2, 3, {1.0, -2.0, 0.5, 3.0, 0.0, -0.25});
+    nn::Matrix targets(2, 3, {1.0, 0.0, 0.0, 1.0, 1.0, 0.0});
+    nn::Matrix probabilities = sigmoid.forward(logits);
+
+    nn::Matrix gradient;
+    nn::Matrix fastGradient;
+    EXPECT_NEAR(bce.computeFromLogits(logits, targets, gradient), bce.computeLoss(probabilities, targets), 1e-12);
+    EXPECT_NEAR(fastBce.computeFromLogits(logits, targets, fastGradient), bce.computeLoss(probabilities, targets), 1e-12);
+
+    // The gradient with respect to the logits is sigmoid - targets
+    for (int i = 0; i < logits.getRows(); i++)
+    {
+        for (int j = 0; j < logits.getCols(); j++)
+        {
+            EXPECT_NEAR(gradient(i, j), probabilities(i, j) - targets(i, j), 1e-15);
+            EXPECT_NEAR(fastGradient(i, j), probabilities(i, j) - targets(i, j), 1e-14);
+        }
+    }
+
+    // Saturated logits keep the loss finite
+    nn::Matrix saturated(1, 2, {-1000.0, 1000.0});
+    nn::Matrix labels(1, 2, {1.0, 0.0});
+    EXPECT_NEAR(bce.computeFromLogits(saturated, labels, gradient), 1000.0, 1e-9);
+    EXPECT_DOUBLE_EQ(gradient(0, 0), -1.0);
+    EXPECT_DOUBLE_EQ(gradient(0, 1), 1.0);
+
+    // Invalid dimensions
+    EXPECT_THROW(bce.computeFromLogits(nn::Matrix(2, 2), nn::Matrix(1, 2), gradient), std::invalid_argument);
+}
@@ -7,6 +7,7 @@
 #include <gtest/gtest.h>
 #include <cmath>
 #include <NeuralNetworkCPP/Losses/CategoricalCrossEntropy/CategoricalCrossEntropy.hpp>
+#include <NeuralNetworkCPP/Activations/Softmax/Softmax.hpp>
 
 // Test if CCE computes loss correctly
 TEST(CCETests, ComputeLoss)
@@ -55,4 +56,74 @@ TEST(CCETests, ComputeGradient)
     nn::Matrix predictions3(2, 2);
     nn::Matrix targets3(1, 2);
     EXPECT_THROW(cce.computeGradient(predictions3, targets3), std::invalid_argument);
-}
\ No newline at end of file
+}
+
+// Test if CCE with the fast log matches the standard library
+TEST(CCETests, FastMathLoss)
+{
+    nn::CategoricalCrossEntropy cce;
+    nn::CategoricalCrossEntropy fastCce(nn::FAST_MATH);
+
+    nn::Matrix predictions(3, 2, {0.1, 0.7, 0.2, 1e-12, 0.7, 0.299999999999});
+    nn::Matrix targets(3, 2, {0.0, 1.0, 0.0, 1.0, 1.0, 0.0});
+    EXPECT_NEAR(fastCce.computeLoss(predictions, targets), cce.computeLoss(predictions, targets), 1e-13);
+}
+
+// Test if the fused softmax head matches softmax followed by CCE
+TEST(CCETests, ComputeFromLogits)
+{
+    nn::CategoricalCrossEntropy cce;
+    nn::CategoricalCrossEntropy fastCce(nn::FAST_MATH);
+    nn::Softmax softmax;
+
+    nn::Matrix logits(3, 4, {1.0, -2.0, 0.5, 3.0, 2.0, 0.0, 0.5, -1.0, -1.0, 4.0, 0.5, 0.0});
+    nn::Matrix targets(3, 4, {0.0, 0.0, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0});
+    nn::Matrix probabilities = softmax.forward(logits);
+
+    nn::Matrix gradient;
+    nn::Matrix fastGradient;
+    EXPECT_NEAR(cce.computeFromLogits(logits, targets, gradient), cce.computeLoss(probabilities, targets), 1e-12);
+    EXPECT_NEAR(fastCce.computeFromLogits(logits, targets, fastGradient), cce.computeLoss(probabilities, targets), 1e-12);
+
+    // The gradient with respect to the logits is softmax - targets
+    for (int i = 0; i < logits.getRows(); i++)
+    {
+        for (int j = 0; j < logits.getCols(); j++)
+        {
+            EXPECT_NEAR(gradient(i, j), probabilities(i, j) - targets(i, j), 1e-15);
+            EXPECT_NEAR(fastGradient(i, j), probabilities(i, j) - targets(i, j), 1e-14);
+        }
+    }
+
+    // Saturated logits keep the loss finite
+    nn::Matrix saturated(2, 1, {-1000.0, 1000.0});
+    nn::Matrix oneHot(2, 1, {1.0, 0.0});
+    EXPECT_NEAR(cce.computeFromLogits(saturated, oneHot, gradient), 2000.0, 1e-9);
+    EXPECT_DOUBLE_EQ(gradient(0, 0), -1.0);
+    EXPECT_DOUBLE_EQ(gradient(1, 0), 1.0);
+
+    // Invalid dimensions
+    EXPECT_THROW(cce.computeFromLogits(nn::Matrix(2, 2), nn::Matrix(1, 2), gradient), std::invalid_argument);
+}
+
+TEST(CCETests, SampleMajorLayout)
+{
+    nn::CategoricalCrossEntropy cce;
+    nn::CategoricalCrossEntropy sampleMajorCce;
+    sampleMajorCce.setLayout(nn::SAMPLE_MAJOR);
+
+    nn::Matrix logits(3, 4, {1.0, -2.0, 0.5, 3.0, 2.0, 0.0, 0.5, -1.0, -1.0, 4.0, 0.5, 0.0});
+    nn::Matrix targets(3, 4, {0.0, 0.0, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0});
+
+    // The same batch with one sample per row gives the same loss and the transposed gradient
+    nn::Matrix gradient;
+    nn::Matrix sampleMajorGradient;
+    double loss = cce.computeFromLogits(logits, targets, gradient);
+    EXPECT_NEAR(sampleMajorCce.computeFromLogits(logits.transpose(), targets.transpose(), sampleMajorGradient), loss, 1e-14);
+    EXPECT_NEAR(sampleMajorCce.computeLoss(nn::Softmax().forward(logits).transpose(), targets.transpose()), loss, 1e-12);
+
+    ASSERT_EQ(sampleMajorGradient.getRows(), 4);
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 3; j++)
+            EXPECT_NEAR(sampleMajorGradient(i, j), gradient(j, i), 1e-15);
+}
@@ -7,7 +7,19 @@
 #include <gtest/gtest.h>
 #include <filesystem>
 #include <NeuralNetworkCPP/Matrix/Matrix.hpp>
+#include <NeuralNetworkCPP/Matrix/HalfMatrix/HalfMatrix.hpp>
+#include <NeuralNetworkCPP/Matrix/SparseMatrix/SparseMatrix.hpp>
 #include <NeuralNetworkCPP/Initializers/Initializers.hpp>
+#include <NeuralNetworkCPP/GlobalThreadPool/GlobalThreadPool.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
 
 // Test constructor with default values
 TEST(MatrixTests, DefaultConstructor)
@@ -68,6 +80,16 @@ TEST(MatrixTests, ConstructFromVectorOfVectors)
     EXPECT_DOUBLE_EQ(mat(2, 2), 9.0);
 }
 
+// Test that a stateful generator is called in element order
+TEST(MatrixTests, ConstructFromGenerator)
+{
+    double next = 0.0;
+    nn::Matrix mat(300, 200, [&next]() { return next++; });
+
+    for (int i = 0; i < mat.getSize(); i++)
+        ASSERT_EQ(mat.getDataPtr()[i], static_cast<double>(i));
+}
+
 // Test max coeff
 TEST(MatrixTests, MaxCoeff)
 {
@@ -406,6 +428,33 @@ TEST(MatrixTests, MapFunction)
     EXPECT_EQ(C(1, 1), 16);
 }
 
+// Test in-place mapping and mapping of two operands across several chunks
+TEST(MatrixTests, MapInPlaceAndZipMap)
+{
+    const int rows = 3;
+    const int cols = 5000;
+    std::vector<double> values(rows * cols);
+    std::iota(values.begin(), values.end(), 0.0);
+    nn::Matrix A(rows, cols, values);
+    nn::Matrix B(rows, cols, 2.0);
+
+    nn::Matrix C = A.zipMap(B, [](double a, double b) { return a * b + 1.0; });
+    A.mapInPlace([](double x) { return -x; });
+
+    for (int i = 0; i < rows; i++)
+    {
+        for (int j = 0; j < cols; j++)
+        {
+            double value = i * cols + j;
+            EXPECT_EQ(A(i, j), -value);
+            EXPECT_EQ(C(i, j), 2.0 * value + 1.0);
+        }
+    }
+
+    // Operands must have the same dimensions
+    EXPECT_THROW(A.zipMap(nn::Matrix(rows, 2), [](double a, double b) { return a + b; }), std::invalid_argument);
+}
+
 // Test large matrix creation and basic access
 TEST(MatrixTests, LargeMatrixCreation)
 {
@@ -456,6 +505,39 @@ TEST(MatrixTests, LargeMatrixTranspose)
     EXPECT_EQ(T(999, 500), A(500, 999));
 }
 
+// Test the tiled transpose on shapes with partial tiles and register blocks, and the in-place variant
+TEST(MatrixTests, BlockedTranspose)
+{
+    for (auto [rows, cols] : {std::pair{1, 1}, {3, 5}, {31, 33}, {64, 64}, {67, 130}, {130, 67}})
+    {
+        nn::Matrix A(rows, cols);
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                A(i, j) = i * 1000 + j;
+
+        nn::Matrix T = A.transpose();
+        ASSERT_EQ(T.getRows(), cols);
+        ASSERT_EQ(T.getCols(), rows);
+        for (int i = 0; i < rows; i++)
+            for (int j = 0; j < cols; j++)
+                ASSERT_EQ(T(j, i), A(i, j));
+
+        // Transposed views of a block are copied by the same kernel
+        if (rows > 2 && cols > 2)
+        {
+            nn::MatrixView view = nn::MatrixView(A).block(1, 2, rows - 2, cols - 2);
+            EXPECT_EQ(view.transpose().toMatrix(), view.toMatrix().transpose());
+        }
+
+        // Transposing twice in place restores the matrix
+        nn::Matrix B = A;
+        B.transposeInPlace();
+        EXPECT_EQ(B, T);
+        B.transposeInPlace();
+        EXPECT_EQ(B, A);
+    }
+}
+
 // Test numerical stability (small floating-point values)
 TEST(MatrixTests, NumericalStabilitySmallValues)
 {
@@ -717,4 +799,358 @@ TEST(MatrixTests, IdentityMatrix)
 TEST(MatrixTests, IdentityMatrixInvalidSize)
 {
     EXPECT_THROW(nn::Matrix::identity(0), std::invalid_argument);
-}
\ No newline at end of file
+}
+
+TEST(MatrixTests, HalfPrecisionConversions)
+{
+    // Exactly representable values survive the round trip
+    for (float value : {0.0f, 1.0f, -2.5f, 0.15625f, 1024.0f})
+    {
+        EXPECT_EQ(nn::fromBFloat16(nn::toBFloat16(value)), value);
+        EXPECT_EQ(nn::fromFloat16(nn::toFloat16(value)), value);
+    }
+
+    // Round to nearest even, overflow and subnormals
+    EXPECT_EQ(nn::toFloat16(1.0f + 1.0f / 2048.0f), 0x3C00);
+    EXPECT_EQ(nn::toFloat16(1.0f + 3.0f / 2048.0f), 0x3C02);
+    EXPECT_EQ(nn::toFloat16(70000.0f), 0x7C00);
+    EXPECT_EQ(nn::fromFloat16(nn::toFloat16(5.9604645e-8f)), 5.9604645e-8f);
+    EXPECT_EQ(nn::toBFloat16(1.0f + 1.0f / 256.0f), 0x3F80);
+    EXPECT_TRUE(std::isnan(nn::fromBFloat16(nn::toBFloat16(std::nanf("")))));
+}
+
+TEST(MatrixTests, HalfPrecisionMultiplication)
+{
+    nn::Matrix left(3, 40, []() { return 0.25; });
+    nn::Matrix right(40, 2, []() { return -0.5; });
+    nn::Matrix expected = left * right;
+
+    for (nn::e_precision precision : {nn::BFLOAT16, nn::FLOAT16})
+    {
+        nn::Matrix result = nn::multiplyTransposed(nn::HalfMatrix(left, precision), nn::HalfMatrix(right, precision, true));
+
+        ASSERT_EQ(result.getRows(), 3);
+        ASSERT_EQ(result.getCols(), 2);
+        for (int i = 0; i < 3; i++)
+        {
+            for (int j = 0; j < 2; j++)
+                EXPECT_DOUBLE_EQ(result(i, j), expected(i, j));
+        }
+    }
+
+    EXPECT_THROW(nn::multiplyTransposed(nn::HalfMatrix(left, nn::BFLOAT16), nn::HalfMatrix(right, nn::BFLOAT16)), std::invalid_argument);
+}
+
+TEST(MatrixTests, SparseMatrixProducts)
+{
+    nn::Matrix dense(3, 4, {1.0, 0.0, 0.0, 2.0,
+                            0.0, 0.0, 0.0, 0.0,
+                            0.0, -3.0, 4.0, 0.0});
+    nn::Matrix right(4, 2, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+    nn::Matrix other(3, 2, {1.0, -1.0, 2.0, 0.5, -2.0, 3.0});
+
+    nn::SparseMatrix sparse(dense);
+    EXPECT_EQ(sparse.getNonZeros(), 4);
+    EXPECT_EQ(sparse.toMatrix().getData(), dense.getData());
+
+    // Products only use the stored elements but match the dense products
+    EXPECT_EQ((sparse * right).getData(), (dense * right).getData());
+    EXPECT_EQ(sparse.transposeMultiply(other).getData(), (dense.transpose() * other).getData());
+
+    // Sampled product picks the stored positions of gradient * input^T
+    nn::Matrix gradient(3, 2, {1.0, -1.0, 2.0, 0.5, -2.0, 3.0});
+    nn::Matrix input(4, 2, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 8.0});
+    nn::Matrix full = gradient * input.transpose();
+    std::vector<double> expected = {full(0, 0), full(0, 3), full(2, 1), full(2, 2)};
+    EXPECT_EQ(sparse.sampledProduct(gradient, input).getData(), expected);
+}
+
+TEST(MatrixTests, SparseInputProducts)
+{
+    // Two samples with three features, stored as sparse rows
+    nn::SparseMatrix samples(2, 3, {0, 2, 3}, {0, 2, 1}, {1.0, 2.0, -1.0});
+    nn::Matrix dense = samples.toMatrix();
+    nn::Matrix weights(2, 3, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+
+    // Weights times the batch, each sample is a column of the result
+    EXPECT_EQ(nn::multiplyTransposed(weights, samples).getData(), (weights * dense.transpose()).getData());
+
+    // Gradient accumulation only touches the columns of the stored features
+    nn::Matrix gradient(2, 2, {1.0, -1.0, 0.5, 2.0});
+    nn::Matrix target(2, 3, 1.0);
+    nn::addProduct(target, gradient, samples);
+    EXPECT_EQ(target.getData(), (nn::Matrix(2, 3, 1.0) + gradient * dense).getData());
+
+    // Selected rows keep their stored elements
+    EXPECT_EQ(samples.selectRows({1, 0, 1}).toMatrix().getData(), std::vector<double>({0.0, -1.0, 0.0, 1.0, 0.0, 2.0, 0.0, -1.0, 0.0}));
+    EXPECT_THROW(samples.selectRows({2}), std::out_of_range);
+    EXPECT_THROW(nn::SparseMatrix(2, 3, {0, 1, 2}, {0, 3}, {1.0, 1.0}), std::invalid_argument);
+}
+
+TEST(MatrixTests, SparseMatrixLoadValidatesStructure)
+{
+    nn::SparseMatrix samples(2, 3, {0, 2, 3}, {0, 2, 1}, {1.0, 2.0, -1.0});
+    std::stringstream stream;
+    samples.save(stream);
+    const std::string saved = stream.str();
+
+    std::stringstream valid(saved);
+    EXPECT_EQ(nn::SparseMatrix(valid).toMatrix().getData(), samples.toMatrix().getData());
+
+    // Replaces one int of the saved data: rows, cols, non-zeros, row offsets, column indices
+    auto corrupt = [&saved](const int position, const int value) {
+        std::string data = saved;
+        std::memcpy(data.data() + position * sizeof(int), &value, sizeof(int));
+        return std::stringstream(data);
+    };
+
+    std::stringstream decreasingOffsets = corrupt(4, 4);
+    std::stringstream wrongLastOffset = corrupt(5, 2);
+    std::stringstream columnOutOfRange = corrupt(7, 3);
+    std::stringstream negativeColumn = corrupt(6, -1);
+    EXPECT_THROW(nn::SparseMatrix{decreasingOffsets}, std::runtime_error);
+    EXPECT_THROW(nn::SparseMatrix{wrongLastOffset}, std::runtime_error);
+    EXPECT_THROW(nn::SparseMatrix{columnOutOfRange}, std::runtime_error);
+    EXPECT_THROW(nn::SparseMatrix{negativeColumn}, std::runtime_error);
+}
+
+TEST(MatrixTests, MoveAssignment)
+{
+    nn::Matrix A(3, 4, 2.0);
+    nn::Matrix B;
+
+    nn::Matrix::resetAllocationStats();
+    B = std::move(A);
+    nn::Matrix C = std::move(B) * 2.0 + 1.0;
+    nn::MatrixAllocationStats stats = nn::Matrix::getAllocationStats();
+
+    // Moving takes over the buffer and leaves the source empty
+    EXPECT_EQ(stats.copies, 0u);
+    EXPECT_EQ(A.getRows(), 0);
+    EXPECT_EQ(A.getCols(), 0);
+    EXPECT_TRUE(A.getData().empty());
+    ASSERT_EQ(C.getRows(), 3);
+    ASSERT_EQ(C.getCols(), 4);
+    for (double value : C.getData())
+        EXPECT_EQ(value, 5.0);
+}
+
+TEST(MatrixTests, AlignedAndHugePageStorage)
+{
+    // Buffers of any size start on a cache line
+    for (int cols : {1, 3, 17, 1000})
+    {
+        nn::Matrix matrix(3, cols, 1.0);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(matrix.getDataPtr()) % nn::MATRIX_ALIGNMENT, 0u);
+    }
+
+    // Buffers above the threshold are mapped, the explicit pool falls back to transparent huge pages
+    for (nn::e_pagePolicy policy : {nn::TRANSPARENT_HUGE_PAGES, nn::EXPLICIT_HUGE_PAGES})
+    {
+        nn::MemoryConfig config{policy, 4096};
+        nn::Matrix small(2, 2, 1.0);
+        nn::Matrix large;
+        {
+            nn::MemoryConfigScope scope(config);
+            large = nn::Matrix(600, 700, 2.0);
+            small.setMemoryConfig(config);
+        }
+
+        EXPECT_EQ(large.getMemoryConfig(), config);
+        EXPECT_EQ(nn::Matrix(1, 1).getMemoryConfig(), nn::MemoryConfig());
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large.getDataPtr()) % nn::MATRIX_ALIGNMENT, 0u);
+        EXPECT_EQ(large.sum(), 2.0 * 600 * 700);
+
+        // Copies and moves keep the configuration, switching it keeps the elements
+        nn::Matrix copy = large;
+        EXPECT_EQ(copy.getMemoryConfig(), config);
+        copy.setMemoryConfig(nn::MemoryConfig());
+        EXPECT_EQ(copy.getMemoryConfig(), nn::MemoryConfig());
+        EXPECT_TRUE(copy == large);
+        EXPECT_EQ(small.getMemoryConfig(), config);
+        EXPECT_EQ(small.sum(), 4.0);
+    }
+}
+
+TEST(MatrixTests, InlineStorage)
+{
+    nn::Matrix activations(10, 256, 1.0);
+
+    // Small matrices and reductions to at most 32 elements do not allocate
+    nn::Matrix::resetAllocationStats();
+    nn::Matrix bias(10, 1, 0.5);
+    nn::Matrix sums = activations.rowWise().sum();
+    nn::Matrix moved = std::move(sums);
+    nn::Matrix copy = moved;
+    nn::Matrix sum = moved + bias;
+    EXPECT_EQ(nn::Matrix::getAllocationStats().allocations, 0u);
+
+    ASSERT_EQ(sum.getRows(), 10);
+    for (int i = 0; i < 10; i++)
+        EXPECT_EQ(sum(i, 0), 256.5);
+    EXPECT_EQ(copy, moved);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(sum.getDataPtr()) % nn::MATRIX_ALIGNMENT, 0u);
+
+    // Larger matrices still use the heap
+    nn::Matrix large(33, 1);
+    nn::Matrix largeMoved = std::move(large);
+    EXPECT_EQ(nn::Matrix::getAllocationStats().allocations, 1u);
+}
+
+TEST(MatrixTests, MatrixViews)
+{
+    std::vector<double> values(4 * 6);
+    std::iota(values.begin(), values.end(), 0.0);
+    nn::Matrix A(4, 6, values);
+
+    // Blocks and ranges reference the elements of the matrix
+    nn::MatrixView block = nn::MatrixView(A).block(1, 2, 2, 3);
+    EXPECT_EQ(block.getRows(), 2);
+    EXPECT_EQ(block.getCols(), 3);
+    EXPECT_EQ(block.getDataPtr(), &A(1, 2));
+    EXPECT_FALSE(block.isContiguous());
+    EXPECT_EQ(block.toMatrix(), nn::Matrix(2, 3, {8.0, 9.0, 10.0, 14.0, 15.0, 16.0}));
+    EXPECT_EQ(nn::MatrixView(A).rowRange(1, 2).toMatrix(), nn::Matrix(2, 6, std::vector<double>(values.begin() + 6, values.begin() + 18)));
+    EXPECT_EQ(nn::MatrixView(A).colRange(5, 1).toMatrix(), nn::Matrix(4, 1, {5.0, 11.0, 17.0, 23.0}));
+    EXPECT_THROW(nn::MatrixView(A).block(3, 0, 2, 1), std::out_of_range);
+
+    // Reductions and element-wise kernels follow the strides, strided sums are pairwise as well
+    nn::Matrix large(300, 200);
+    for (int i = 0; i < large.getSize(); i++)
+        large.getDataPtr()[i] = 1.0 / (i + 1);
+    nn::MatrixView transposedLarge = nn::MatrixView(large).transpose();
+    EXPECT_EQ(block.sum(), 72.0);
+    EXPECT_EQ(transposedLarge.sum(), transposedLarge.toMatrix().sum());
+    EXPECT_EQ(block.rowSums(), nn::Matrix(2, 1, {27.0, 45.0}));
+    EXPECT_EQ(block.map([](double x) { return 2.0 * x; }), 2.0 * block.toMatrix());
+    EXPECT_EQ(block.zipMap(block.transpose().transpose(), [](double a, double b) { return a - b; }), nn::Matrix(2, 3, 0.0));
+
+    // Products of views match the products of copies, including transposed and external buffers
+    nn::MatrixView transposed = nn::MatrixView(A).transpose();
+    nn::Matrix transposedCopy = A.transpose();
+    EXPECT_EQ(nn::multiply(block, transposed.block(2, 0, 3, 4)), block.toMatrix() * nn::MatrixView(transposedCopy).block(2, 0, 3, 4).toMatrix());
+
+    nn::MatrixView external(values.data(), 6, 4);
+    EXPECT_EQ(nn::multiply(A, external), A * nn::Matrix(6, 4, values));
+    EXPECT_EQ(nn::multiply(external.transpose(), transposed), nn::Matrix(6, 4, values).transpose() * transposedCopy);
+}
+
+TEST(MatrixTests, MultiplyTransposed)
+{
+    std::vector<double> values(5 * 7);
+    std::iota(values.begin(), values.end(), -10.0);
+    nn::Matrix A(5, 7, values);
+    nn::Matrix B(3, 7, std::vector<double>(values.begin(), values.begin() + 21));
+
+    // Dot products of rows match the product with the transposed copy
+    EXPECT_EQ(nn::multiplyTransposed(A, B), A * B.transpose());
+
+    // Strided operands take the generic path
+    nn::MatrixView transposed = nn::MatrixView(A).transpose();
+    EXPECT_EQ(nn::multiplyTransposed(transposed, transposed), A.transpose() * A);
+    EXPECT_THROW(nn::multiplyTransposed(A, transposed), std::invalid_argument);
+}
+
+TEST(MatrixTests, BufferPool)
+{
+    nn::MemoryConfig config;
+    config.usePool = true;
+    nn::MemoryConfigScope scope(config);
+    nn::trimMatrixPool();
+    nn::resetMatrixPoolStats();
+
+    // The first buffer of a size class comes from the heap, the following ones are recycled
+    {
+        nn::Matrix A(10, 10, 1.0);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(A.getDataPtr()) % nn::MATRIX_ALIGNMENT, 0u);
+    }
+    EXPECT_EQ(nn::getMatrixPoolStats().bytesHeld, 896u);
+    for (int i = 0; i < 10; i++)
+    {
+        nn::Matrix B(10, 10, 2.0);
+        nn::Matrix C(9, 11, 3.0); // Same size class of 896 bytes
+        EXPECT_EQ(B + B, 2.0 * B);
+    }
+
+    nn::MatrixPoolStats stats = nn::getMatrixPoolStats();
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_EQ(stats.hits, 37u);
+    EXPECT_EQ(stats.bytesHeld, 4u * 896u);
+
+    // Buffers released by other threads are shared
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&config]() {
+            nn::MemoryConfigScope threadScope(config);
+            for (int i = 0; i < 100; i++)
+                nn::Matrix D(20, 20 + i % 3, 1.0);
+        });
+    for (std::thread &thread : threads)
+        thread.join();
+    EXPECT_GT(nn::getMatrixPoolStats().bytesHeld, 4u * 896u);
+
+    // Trimming releases the idle buffers
+    nn::trimMatrixPool(896);
+    EXPECT_LE(nn::getMatrixPoolStats().bytesHeld, 896u);
+    nn::trimMatrixPool();
+    EXPECT_EQ(nn::getMatrixPoolStats().bytesHeld, 0u);
+
+    // Beyond the capacity buffers go back to the heap
+    nn::setMatrixPoolCapacity(0);
+    {
+        nn::Matrix E(10, 10);
+    }
+    EXPECT_EQ(nn::getMatrixPoolStats().bytesHeld, 0u);
+    nn::setMatrixPoolCapacity(std::numeric_limits<std::size_t>::max());
+}
+
+TEST(MatrixTests, DeterministicReductions)
+{
+    nn::Matrix A(317, 331);
+    for (int i = 0; i < A.getRows(); i++)
+        for (int j = 0; j < A.getCols(); j++)
+            A(i, j) = std::sin(0.7 * i + 1.3 * j) * std::pow(10.0, (i * 7 + j) % 9 - 4);
+
+    // The reduction tree does not depend on the number of threads
+    std::unique_ptr<nn::ThreadPool> original = std::move(nn::globalThreadPool);
+    std::vector<double> sums;
+    std::vector<double> kahanSums;
+    for (int threads : {1, 3, 8})
+    {
+        nn::globalThreadPool = std::make_unique<nn::ThreadPool>(threads);
+        sums.push_back(A.sum());
+        kahanSums.push_back(A.sum(nn::KAHAN_SUMMATION));
+        EXPECT_EQ(A.maxCoeff(), *std::max_element(A.getDataPtr(), A.getDataPtr() + A.getSize()));
+    }
+    nn::globalThreadPool = std::move(original);
+
+    EXPECT_EQ(sums[1], sums[0]);
+    EXPECT_EQ(sums[2], sums[0]);
+    EXPECT_EQ(kahanSums[1], kahanSums[0]);
+    EXPECT_EQ(kahanSums[2], kahanSums[0]);
+    EXPECT_NEAR(sums[0], kahanSums[0], 1e-9 * std::abs(kahanSums[0]) + 1e-9);
+
+    // Compensated summation recovers terms lost to cancellation
+    nn::Matrix cancelling(1, 4, {1.0, 1e100, 1.0, -1e100});
+    EXPECT_EQ(cancelling.sum(nn::KAHAN_SUMMATION), 2.0);
+
+    // Column-wise reductions stream the rows and sum every column in row order
+    nn::Matrix colSums = A.colWise().sum();
+    nn::Matrix colMax = A.colWise().maxCoeff();
+    for (int j = 0; j < A.getCols(); j++)
+    {
+        double total = 0.0;
+        double maxValue = std::numeric_limits<double>::lowest();
+        for (int i = 0; i < A.getRows(); i++)
+        {
+            total += A(i, j);
+            maxValue = std::max(maxValue, A(i, j));
+        }
+        EXPECT_EQ(colSums(0, j), total);
+        EXPECT_EQ(colMax(0, j), maxValue);
+    }
+
+    // Row sums use the serial kernel of the whole-matrix sum
+    nn::Matrix rowSums = A.rowWise().sum();
+    EXPECT_EQ(rowSums(5, 0), nn::Matrix(1, A.getCols(), std::vector<double>(&A(5, 0), &A(5, 0) + A.getCols())).sum());
+}
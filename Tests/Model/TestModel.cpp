@@ -6,8 +6,12 @@
 
 #include <gtest/gtest.h>
 #include <NeuralNetworkCPP/NeuralNetworkCPP.hpp>
+#include <NeuralNetworkCPP/Initializers/Initializers.hpp>
+#include <NeuralNetworkCPP/Quantization/Quantization.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <cmath>
+#include <random>
 
 TEST(ModelTests, Predict)
 {
@@ -94,4 +98,632 @@ TEST(ModelTests, Train)
     EXPECT_EQ(std::round(model.predict({0.0, 1.0})[0]), 1);
     EXPECT_EQ(std::round(model.predict({1.0, 0.0})[0]), 1);
     EXPECT_EQ(std::round(model.predict({1.0, 1.0})[0]), 0);
-}
\ No newline at end of file
+}
+
+TEST(ModelTests, TrainWithMicroBatches)
+{
+    std::vector<std::vector<double>> xData = {
+        {0.0, 0.0},
+        {0.0, 1.0},
+        {1.0, 0.0},
+        {1.0, 1.0}
+    };
+
+    std::vector<std::vector<double>> yData = {
+        {0.0},
+        {1.0},
+        {1.0},
+        {0.0}
+    };
+
+    // Gradients averaged (MSE) and summed (BCE) over the batch must both match the full batch update
+    for (bool useMSE : {true, false})
+    {
+        nn::NeuralNetworkCPP model;
+        model.addLayer(std::make_unique<nn::DenseLayer>(2, 4, nn::HE_NORMAL, nn::RELU));
+        model.addLayer(std::make_unique<nn::DenseLayer>(4, 1, nn::XAVIER_UNIFORM, nn::SIGMOID));
+        model.save("test_model.bin");
+
+        nn::NeuralNetworkCPP microModel("test_model.bin");
+        std::filesystem::remove("test_model.bin");
+
+        auto makeLoss = [useMSE]() -> std::unique_ptr<nn::Loss> {
+            if (useMSE)
+                return std::make_unique<nn::MeanSquaredError>();
+            return std::make_unique<nn::BinaryCrossEntropy>();
+        };
+
+        model.compile(std::make_unique<nn::SGD>(0.1), makeLoss());
+        microModel.compile(std::make_unique<nn::SGD>(0.1), makeLoss());
+
+        // One batch with the whole dataset vs the same batch split into micro-batches of one sample
+        model.train(xData, yData, 5, 4, 0.0, 10, 0.0, false);
+        microModel.train(xData, yData, 5, 4, 0.0, 10, 0.0, false, 1);
+
+        for (const auto &x : xData)
+            EXPECT_NEAR(model.predict(x)[0], microModel.predict(x)[0], 1e-9);
+    }
+}
+
+TEST(ModelTests, ResumeFromCheckpoint)
+{
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int i = 0; i < 10; i++)
+    {
+        xData.push_back({i * 0.1, 1.0 - i * 0.05});
+        yData.push_back({static_cast<double>(i % 2)});
+    }
+
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(2, 4, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::BatchNormalization>(4));
+    model.addLayer(std::make_unique<nn::DenseLayer>(4, 1, nn::XAVIER_UNIFORM, nn::SIGMOID));
+    model.save("test_model.bin");
+
+    // Reference training without interruption
+    nn::NeuralNetworkCPP reference("test_model.bin");
+    reference.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::BinaryCrossEntropy>());
+    reference.setSeed(42);
+    reference.train(xData, yData, 3, 2, 0.2, 10, 0.0, false);
+
+    // Interrupted training, 4 batches per epoch so the last checkpoint is taken in the middle of the first epoch
+    nn::NeuralNetworkCPP interrupted("test_model.bin");
+    std::filesystem::remove("test_model.bin");
+    interrupted.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::BinaryCrossEntropy>());
+    interrupted.setSeed(42);
+    interrupted.enableCheckpoints("test_checkpoint.bin", 3);
+    interrupted.train(xData, yData, 1, 2, 0.2, 10, 0.0, false);
+    ASSERT_TRUE(std::filesystem::exists("test_checkpoint.bin"));
+
+    // Resume in a fresh model, weights, optimizer moments and shuffling come from the checkpoint
+    nn::NeuralNetworkCPP resumed;
+    resumed.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::BinaryCrossEntropy>());
+    resumed.loadCheckpoint("test_checkpoint.bin");
+    std::filesystem::remove("test_checkpoint.bin");
+    resumed.train(xData, yData, 3, 2, 0.2, 10, 0.0, false);
+
+    for (const auto &x : xData)
+        EXPECT_NEAR(reference.predict(x)[0], resumed.predict(x)[0], 1e-12);
+}
+
+TEST(ModelTests, TrainMixedPrecision)
+{
+    std::vector<std::vector<double>> xData = {
+        {0.0, 0.0},
+        {0.0, 1.0},
+        {1.0, 0.0},
+        {1.0, 1.0}
+    };
+
+    std::vector<std::vector<double>> yData = {
+        {0.0},
+        {0.0},
+        {0.0},
+        {1.0}
+    };
+
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(2, 8, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(8, 1, nn::XAVIER_UNIFORM, nn::SIGMOID));
+    model.save("test_model.bin");
+    model.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::BinaryCrossEntropy>());
+    model.setSeed(7);
+    model.train(xData, yData, 50, 4, 0.0, 50, 0.0, false);
+
+    // Training on 16-bit copies follows the double precision training closely
+    for (nn::e_precision precision : {nn::BFLOAT16, nn::FLOAT16})
+    {
+        nn::NeuralNetworkCPP mixedModel("test_model.bin");
+        mixedModel.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::BinaryCrossEntropy>());
+        mixedModel.setPrecision(precision);
+        mixedModel.setSeed(7);
+        mixedModel.train(xData, yData, 50, 4, 0.0, 50, 0.0, false);
+
+        for (const auto &x : xData)
+            EXPECT_NEAR(model.predict(x)[0], mixedModel.predict(x)[0], 0.1);
+    }
+
+    std::filesystem::remove("test_model.bin");
+}
+
+TEST(ModelTests, QuantizeAndSave)
+{
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int i = 0; i < 20; i++)
+    {
+        double x = std::sin(i * 0.9);
+        xData.push_back({x, std::cos(i * 0.7), i * 0.05});
+        yData.push_back({(x > 0.0) ? 1.0 : 0.0, (x > 0.0) ? 0.0 : 1.0});
+    }
+
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(3, 16, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(16, 2, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    model.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::CategoricalCrossEntropy>());
+    model.train(xData, yData, 50, 4, 0.0, 50, 0.0, false);
+    model.save("test_model.bin");
+
+    // Quantize a copy and compare it with the double model
+    nn::NeuralNetworkCPP quantized("test_model.bin");
+    quantized.quantize(xData);
+    nn::QuantizationReport report = nn::compareQuantized(model, quantized, xData, yData, nn::ACCURACY_LOG, 1);
+
+    EXPECT_LT(report.maxDifference, 0.1);
+    EXPECT_NEAR(report.quantizedMetric, report.referenceMetric, 0.1);
+
+    // The quantized model has its own file representation
+    quantized.save("test_model.bin");
+    nn::NeuralNetworkCPP loaded("test_model.bin");
+    std::filesystem::remove("test_model.bin");
+
+    for (const auto &x : xData)
+        EXPECT_EQ(quantized.predict(x), loaded.predict(x));
+
+    // Calibration restores the previous mode of batch normalization, also when it fails
+    nn::NeuralNetworkCPP withBatchNorm;
+    auto batchNorm = std::make_unique<nn::BatchNormalization>(4);
+    nn::BatchNormalization *batchNormLayer = batchNorm.get();
+    withBatchNorm.addLayer(std::make_unique<nn::DenseLayer>(3, 4, nn::HE_NORMAL, nn::RELU));
+    withBatchNorm.addLayer(std::move(batchNorm));
+    withBatchNorm.addLayer(std::make_unique<nn::DenseLayer>(4, 2, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+
+    EXPECT_THROW(withBatchNorm.quantize({{1.0, 2.0}}), std::invalid_argument);
+    EXPECT_TRUE(batchNormLayer->isTrainingMode());
+
+    batchNormLayer->setTrainingMode(false);
+    withBatchNorm.quantize(xData);
+    EXPECT_FALSE(batchNormLayer->isTrainingMode());
+}
+
+TEST(ModelTests, PruneToSparseLayers)
+{
+    std::vector<std::vector<double>> xData = {
+        {0.0, 0.0},
+        {0.0, 1.0},
+        {1.0, 0.0},
+        {1.0, 1.0}
+    };
+
+    std::vector<std::vector<double>> yData = {
+        {0.0},
+        {1.0},
+        {1.0},
+        {1.0}
+    };
+
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(2, 32, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(32, 1, nn::XAVIER_UNIFORM, nn::SIGMOID));
+    model.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::BinaryCrossEntropy>());
+
+    // Both layers cross the threshold and switch to CSR, fine-tuning keeps the sparsity
+    model.prune(0.85);
+    model.train(xData, yData, 5, 2, 0.0, 10, 0.0, false);
+    model.save("test_model.bin");
+
+    std::ifstream file("test_model.bin", std::ios::binary);
+    int numLayers;
+    nn::e_layerType layerType;
+    file.read(reinterpret_cast<char *>(&numLayers), sizeof(numLayers));
+    file.read(reinterpret_cast<char *>(&layerType), sizeof(layerType));
+    file.close();
+    EXPECT_EQ(layerType, nn::SPARSE_DENSE);
+
+    // The sparse layers are restored from the model file
+    nn::NeuralNetworkCPP loaded("test_model.bin");
+    std::filesystem::remove("test_model.bin");
+
+    for (const auto &x : xData)
+        EXPECT_EQ(model.predict(x), loaded.predict(x));
+}
+
+TEST(ModelTests, TrainOnSparseInput)
+{
+    // High-dimensional samples with a single active feature, the label depends on its parity
+    const int numFeatures = 10000;
+    std::vector<int> rowOffsets = {0};
+    std::vector<int> colIndices;
+    std::vector<double> values;
+    std::vector<std::vector<double>> labels;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> feature(0, 19);
+
+    for (int i = 0; i < 200; i++)
+    {
+        int index = feature(generator) * 500;
+        colIndices.push_back(index);
+        values.push_back(1.0);
+        rowOffsets.push_back(colIndices.size());
+        labels.push_back({static_cast<double>((index / 500) % 2)});
+    }
+    nn::SparseMatrix data(200, numFeatures, rowOffsets, colIndices, values);
+
+    nn::NeuralNetworkCPP model;
+    model.setSeed(42);
+    model.addLayer(std::make_unique<nn::DenseLayer>(numFeatures, 8, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(8, 1, nn::XAVIER_UNIFORM, nn::SIGMOID));
+    model.compile(std::make_unique<nn::Adam>(0.05), std::make_unique<nn::BinaryCrossEntropy>());
+    model.train(data, labels, 30, 16, 0.0, 30, 0.0, false);
+
+    EXPECT_EQ(model.evaluate(data, labels), 1.0);
+
+    // Sparse and dense predictions agree
+    std::vector<std::vector<double>> dense = {std::vector<double>(numFeatures, 0.0)};
+    dense[0][colIndices[0]] = 1.0;
+    EXPECT_NEAR(model.predict(data.selectRows({0}))[0][0], model.predict(dense)[0][0], 1e-12);
+}
+
+TEST(ModelTests, TrainWithEmbedding)
+{
+    // The label of a (user, item) pair depends on the parity of the item
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int user = 0; user < 10; user++)
+    {
+        for (int item = 10; item < 30; item++)
+        {
+            xData.push_back({static_cast<double>(user), static_cast<double>(item)});
+            yData.push_back({static_cast<double>(item % 2)});
+        }
+    }
+
+    nn::NeuralNetworkCPP model;
+    model.setSeed(42);
+    model.addLayer(std::make_unique<nn::Embedding>(30, 4, 2));
+    model.addLayer(std::make_unique<nn::DenseLayer>(8, 1, nn::XAVIER_UNIFORM, nn::SIGMOID));
+    model.compile(std::make_unique<nn::Adam>(0.05), std::make_unique<nn::BinaryCrossEntropy>());
+    model.train(xData, yData, 30, 16, 0.0, 30, 0.0, false);
+
+    EXPECT_EQ(model.evaluate(xData, yData), 1.0);
+
+    // The embedding table is restored from the model file
+    model.save("test_model.bin");
+    nn::NeuralNetworkCPP loaded("test_model.bin");
+    std::filesystem::remove("test_model.bin");
+
+    EXPECT_EQ(loaded.predict(xData), model.predict(xData));
+}
+
+
+TEST(ModelTests, FastMathPolicy)
+{
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(3, 8, nn::HE_NORMAL, nn::SIGMOID));
+    model.addLayer(std::make_unique<nn::DenseLayer>(8, 4, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+
+    std::vector<double> input = {0.5, -1.5, 2.0};
+    std::vector<double> expected = model.predict(input);
+
+    // The fast kernels change the predictions only by rounding
+    model.setMathPolicy(nn::FAST_MATH);
+    std::vector<double> output = model.predict(input);
+
+    ASSERT_EQ(output.size(), expected.size());
+    for (std::size_t i = 0; i < output.size(); i++)
+        EXPECT_NEAR(output[i], expected[i], 1e-13);
+}
+
+TEST(ModelTests, TrainWithFusedSoftmaxHead)
+{
+    // Three separable classes, one-hot labels
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int i = 0; i < 30; i++)
+    {
+        int label = i % 3;
+        xData.push_back({label == 0 ? 1.0 : 0.0, label == 1 ? 1.0 : 0.0, 0.1 * (i % 5)});
+        yData.push_back({label == 0 ? 1.0 : 0.0, label == 1 ? 1.0 : 0.0, label == 2 ? 1.0 : 0.0});
+    }
+
+    nn::NeuralNetworkCPP model;
+    model.setSeed(7);
+    model.addLayer(std::make_unique<nn::DenseLayer>(3, 16, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(16, 3, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    model.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::CategoricalCrossEntropy>());
+    model.train(xData, yData, 50, 10, 0.0, 50, 0.0, false);
+
+    // The loss is computed from the logits, predictions still apply softmax
+    for (std::size_t i = 0; i < xData.size(); i++)
+    {
+        std::vector<double> output = model.predict(xData[i]);
+        double sum = output[0] + output[1] + output[2];
+        EXPECT_NEAR(sum, 1.0, 1e-12);
+
+        int predicted = std::max_element(output.begin(), output.end()) - output.begin();
+        EXPECT_EQ(predicted, static_cast<int>(i % 3));
+    }
+
+    // A loss that throws on mismatched targets still leaves softmax applied to predictions
+    std::vector<std::vector<double>> yWrong(xData.size(), std::vector<double>{1.0, 0.0});
+    EXPECT_THROW(model.train(xData, yWrong, 1, 10, 0.0, 1, 0.0, false), std::invalid_argument);
+
+    std::vector<double> output = model.predict(xData[0]);
+    EXPECT_NEAR(output[0] + output[1] + output[2], 1.0, 1e-12);
+}
+
+TEST(ModelTests, TrainingStepCopies)
+{
+    std::vector<std::vector<double>> xData(64, std::vector<double>(32, 0.5));
+    std::vector<std::vector<double>> yData(64, std::vector<double>(4, 0.25));
+
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(32, 64, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::BatchNormalization>(64));
+    model.addLayer(std::make_unique<nn::DenseLayer>(64, 4, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    model.compile(std::make_unique<nn::Adam>(), std::make_unique<nn::CategoricalCrossEntropy>());
+
+    nn::Matrix::resetAllocationStats();
+    model.train(xData, yData, 1, 64, 0.0, 1, 0.0, false);
+    nn::MatrixAllocationStats stats = nn::Matrix::getAllocationStats();
+
+    // Intermediate results are moved between the layers, only the inputs kept for the backward pass are copied
+    EXPECT_LE(stats.copies, 5u);
+    EXPECT_LE(stats.copiedBytes, 86016u);
+}
+
+TEST(ModelTests, MemoryConfig)
+{
+    std::vector<std::vector<double>> xData(64, std::vector<double>(32, 0.5));
+    std::vector<std::vector<double>> yData(64, std::vector<double>(4, 0.25));
+    nn::MemoryConfig config{nn::TRANSPARENT_HUGE_PAGES, 4096};
+
+    auto hidden = std::make_unique<nn::DenseLayer>(32, 64, nn::HE_NORMAL, nn::RELU);
+    auto output = std::make_unique<nn::DenseLayer>(64, 4, nn::XAVIER_UNIFORM, nn::SOFTMAX);
+    std::vector<const nn::DenseLayer *> layers = {hidden.get(), output.get()};
+
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::move(hidden));
+    model.setMemoryConfig(config);
+    model.addLayer(std::move(output));
+    model.compile(std::make_unique<nn::Adam>(), std::make_unique<nn::CategoricalCrossEntropy>());
+    model.train(xData, yData, 2, 64, 0.0, 1, 0.0, false);
+
+    // Parameters of layers added before and after the configuration use it
+    for (const nn::DenseLayer *layer : layers)
+        EXPECT_EQ(layer->getWeights().getMemoryConfig(), config);
+
+    // Outside of the model new matrices keep the default configuration
+    EXPECT_EQ(nn::Matrix(2, 2).getMemoryConfig(), nn::MemoryConfig());
+    EXPECT_EQ(model.predict(std::vector<double>(32, 0.5)).size(), 4u);
+}
+
+TEST(ModelTests, PredictFromView)
+{
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(3, 5, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(5, 2, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+
+    // Sample-major buffer as a server would receive it, read without copying
+    std::vector<std::vector<double>> samples = {{0.1, 0.2, 0.3}, {-1.0, 0.5, 2.0}, {0.0, 0.0, 1.0}, {3.0, -2.0, 0.5}};
+    std::vector<double> buffer;
+    for (const auto &sample : samples)
+        buffer.insert(buffer.end(), sample.begin(), sample.end());
+
+    std::vector<std::vector<double>> expected = model.predict(samples);
+    std::vector<std::vector<double>> predicted = model.predict(nn::MatrixView(buffer.data(), 4, 3).transpose());
+
+    ASSERT_EQ(predicted.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        ASSERT_EQ(predicted[i].size(), 2);
+        for (size_t j = 0; j < 2; j++)
+            EXPECT_NEAR(predicted[i][j], expected[i][j], 1e-12);
+    }
+
+    // A range of samples of the buffer
+    std::vector<std::vector<double>> range = model.predict(nn::MatrixView(buffer.data(), 4, 3).rowRange(1, 2).transpose());
+    ASSERT_EQ(range.size(), 2);
+    EXPECT_NEAR(range[1][0], expected[2][0], 1e-12);
+}
+
+TEST(ModelTests, SampleMajorLayout)
+{
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int i = 0; i < 40; i++)
+    {
+        int label = i % 3;
+        xData.push_back({std::sin(0.3 * i), label == 1 ? 1.0 : -0.5, 0.1 * (i % 7), std::cos(0.2 * i)});
+        yData.push_back({label == 0 ? 1.0 : 0.0, label == 1 ? 1.0 : 0.0, label == 2 ? 1.0 : 0.0});
+    }
+
+    nn::NeuralNetworkCPP model;
+    // Fixed initial weights, some random ones amplify the rounding differences of the layouts
+    nn::setInitializerSeed(1);
+    model.addLayer(std::make_unique<nn::DenseLayer>(4, 8, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::BatchNormalization>(8));
+    model.addLayer(std::make_unique<nn::DenseLayer>(8, 3, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    nn::clearInitializerSeed();
+    model.save("test_layout_model.bin");
+
+    // Two copies with the same weights, one of them trained batch-first
+    nn::NeuralNetworkCPP featureMajor("test_layout_model.bin");
+    nn::NeuralNetworkCPP sampleMajor("test_layout_model.bin");
+    sampleMajor.setLayout(nn::SAMPLE_MAJOR);
+    std::filesystem::remove("test_layout_model.bin");
+
+    for (nn::NeuralNetworkCPP *network : {&featureMajor, &sampleMajor})
+    {
+        network->setSeed(11);
+        network->compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::CategoricalCrossEntropy>());
+        network->train(xData, yData, 5, 8, 0.2, 5, 0.0, false);
+    }
+
+    // Both layouts compute the same model
+    std::vector<std::vector<double>> expected = featureMajor.predict(xData);
+    std::vector<std::vector<double>> predicted = sampleMajor.predict(xData);
+    ASSERT_EQ(predicted.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); i++)
+    {
+        ASSERT_EQ(predicted[i].size(), 3u);
+        for (std::size_t j = 0; j < 3; j++)
+            EXPECT_NEAR(predicted[i][j], expected[i][j], 1e-9);
+    }
+
+    // A batch-first buffer is read as it is, single samples are rows
+    std::vector<double> buffer;
+    for (const auto &sample : xData)
+        buffer.insert(buffer.end(), sample.begin(), sample.end());
+    std::vector<std::vector<double>> fromView = sampleMajor.predict(nn::MatrixView(buffer.data(), 40, 4));
+    std::vector<double> single = sampleMajor.predict(xData[5]);
+    for (std::size_t j = 0; j < 3; j++)
+    {
+        EXPECT_NEAR(fromView[17][j], expected[17][j], 1e-9);
+        EXPECT_NEAR(single[j], expected[5][j], 1e-9);
+    }
+
+    // Int8 layers only support the feature-major layout
+    EXPECT_THROW(sampleMajor.quantize(xData), std::invalid_argument);
+}
+
+TEST(ModelTests, TrainWithBufferPool)
+{
+    std::vector<std::vector<double>> xData(64, std::vector<double>(32, 0.5));
+    std::vector<std::vector<double>> yData(64, std::vector<double>(4, 0.25));
+    nn::MemoryConfig config;
+    config.usePool = true;
+
+    nn::NeuralNetworkCPP model;
+    model.setMemoryConfig(config);
+    model.addLayer(std::make_unique<nn::DenseLayer>(32, 64, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(64, 4, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    model.compile(std::make_unique<nn::Adam>(), std::make_unique<nn::CategoricalCrossEntropy>());
+    model.train(xData, yData, 1, 16, 0.0, 1, 0.0, false);
+
+    // After the first batches the temporaries of a step are recycled
+    nn::resetMatrixPoolStats();
+    model.train(xData, yData, 2, 16, 0.0, 2, 0.0, false);
+    nn::MatrixPoolStats stats = nn::getMatrixPoolStats();
+    EXPECT_GT(stats.hits, 10 * stats.misses);
+
+    nn::trimMatrixPool();
+}
+
+// Test that single samples take the matrix-vector path with the results of a batch
+TEST(ModelTests, SingleSamplePredict)
+{
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int i = 0; i < 40; i++)
+    {
+        int label = i % 2;
+        std::vector<double> sample(300);
+        for (int j = 0; j < 300; j++)
+            sample[j] = std::sin(0.01 * i * j + label);
+        xData.push_back(sample);
+        yData.push_back({label == 0 ? 1.0 : 0.0, label == 1 ? 1.0 : 0.0});
+    }
+
+    // The first layer is large enough to be split between threads
+    nn::NeuralNetworkCPP model;
+    model.addLayer(std::make_unique<nn::DenseLayer>(300, 501, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::BatchNormalization>(501));
+    model.addLayer(std::make_unique<nn::DenseLayer>(501, 7, nn::XAVIER_NORMAL, nn::SIGMOID));
+    model.addLayer(std::make_unique<nn::DenseLayer>(7, 2, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    model.compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::CategoricalCrossEntropy>());
+    model.train(xData, yData, 2, 8, 0.0, 5, 0.0, false);
+
+    std::vector<std::vector<double>> expected = model.predict(xData);
+
+    std::unique_ptr<nn::ThreadPool> original = std::move(nn::globalThreadPool);
+    for (int threads : {1, 3})
+    {
+        nn::globalThreadPool = std::make_unique<nn::ThreadPool>(threads);
+        for (std::size_t i = 0; i < xData.size(); i++)
+        {
+            std::vector<double> predicted = model.predict(xData[i]);
+            ASSERT_EQ(predicted.size(), 2u);
+            for (std::size_t j = 0; j < 2; j++)
+                EXPECT_NEAR(predicted[j], expected[i][j], 1e-9);
+        }
+    }
+    nn::globalThreadPool = std::move(original);
+
+    // A sample of the wrong size is rejected
+    EXPECT_THROW(model.predict(std::vector<double>(299, 0.0)), std::invalid_argument);
+}
+
+// Test that pipelined training and prediction match the sequential model with the same micro-batches
+TEST(ModelTests, PipelineStages)
+{
+    std::vector<std::vector<double>> xData;
+    std::vector<std::vector<double>> yData;
+    for (int i = 0; i < 48; i++)
+    {
+        int label = i % 3;
+        xData.push_back({std::sin(0.3 * i), label == 1 ? 1.0 : -0.5, 0.1 * (i % 7), std::cos(0.2 * i)});
+        yData.push_back({label == 0 ? 1.0 : 0.0, label == 1 ? 1.0 : 0.0, label == 2 ? 1.0 : 0.0});
+    }
+
+    nn::NeuralNetworkCPP model;
+    nn::setInitializerSeed(1);
+    model.addLayer(std::make_unique<nn::DenseLayer>(4, 16, nn::HE_NORMAL, nn::RELU));
+    model.addLayer(std::make_unique<nn::BatchNormalization>(16));
+    model.addLayer(std::make_unique<nn::DenseLayer>(16, 8, nn::HE_UNIFORM, nn::RELU));
+    model.addLayer(std::make_unique<nn::DenseLayer>(8, 3, nn::XAVIER_UNIFORM, nn::SOFTMAX));
+    nn::clearInitializerSeed();
+    model.save("test_pipeline_model.bin");
+
+    for (nn::e_layout layout : {nn::FEATURE_MAJOR, nn::SAMPLE_MAJOR})
+    {
+        // Two copies with the same weights, one of them split into three stages
+        nn::NeuralNetworkCPP sequential("test_pipeline_model.bin");
+        nn::NeuralNetworkCPP pipelined("test_pipeline_model.bin");
+        pipelined.setPipelineStages(3);
+
+        for (nn::NeuralNetworkCPP *network : {&sequential, &pipelined})
+        {
+            network->setLayout(layout);
+            network->setSeed(7);
+            network->compile(std::make_unique<nn::Adam>(0.01), std::make_unique<nn::CategoricalCrossEntropy>());
+            network->train(xData, yData, 3, 16, 0.0, 5, 0.0, false, 4);
+        }
+
+        // Recomputed micro-batches leave the running statistics alone, so both models are the same
+        std::vector<std::vector<double>> expected = sequential.predict(xData);
+        std::vector<std::vector<double>> predicted = pipelined.predict(xData);
+        ASSERT_EQ(predicted.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); i++)
+            for (std::size_t j = 0; j < 3; j++)
+                EXPECT_NEAR(predicted[i][j], expected[i][j], 1e-9);
+
+        // The stages cover all layers in order and all of them worked
+        std::vector<nn::PipelineStageStats> stats = pipelined.getPipelineStats();
+        ASSERT_EQ(stats.size(), 3u);
+        int nextLayer = 0;
+        for (const nn::PipelineStageStats &stage : stats)
+        {
+            EXPECT_EQ(stage.firstLayer, nextLayer);
+            EXPECT_GE(stage.numLayers, 1);
+            EXPECT_FALSE(stage.cores.empty());
+            EXPECT_EQ(stage.samples, 3u * 48u + 48u);
+            EXPECT_GT(stage.getThroughput(), 0.0);
+            nextLayer += stage.numLayers;
+        }
+        EXPECT_EQ(nextLayer, 4);
+        EXPECT_GT(stats.back().backwardSeconds, 0.0);
+
+        // An error in a stage reaches the caller and the pipeline keeps working
+        std::vector<std::vector<double>> wrongSize(20, std::vector<double>(5, 0.0));
+        EXPECT_THROW(pipelined.predict(wrongSize), std::invalid_argument);
+        EXPECT_NEAR(pipelined.predict(xData)[11][2], expected[11][2], 1e-9);
+
+        // Training after the error still uses the batch statistics, like the model that never failed
+        EXPECT_THROW(pipelined.predict(wrongSize), std::invalid_argument);
+        for (nn::NeuralNetworkCPP *network : {&sequential, &pipelined})
+            network->train(xData, yData, 1, 16, 0.0, 5, 0.0, false, 4);
+
+        expected = sequential.predict(xData);
+        predicted = pipelined.predict(xData);
+        for (std::size_t i = 0; i < expected.size(); i++)
+            for (std::size_t j = 0; j < 3; j++)
+                EXPECT_NEAR(predicted[i][j], expected[i][j], 1e-9);
+    }
+
+    std::filesystem::remove("test_pipeline_model.bin");
+
+    EXPECT_THROW(model.setPipelineStages(0), std::invalid_argument);
+    EXPECT_THROW(model.setPipelineStages(2, -1), std::invalid_argument);
+}
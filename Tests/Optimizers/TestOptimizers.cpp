@@ -16,7 +16,8 @@ TEST(OptimizerTests, SGDWithMomentum)
     nn::Matrix gradWeights(2, 2, {0.1, 0.2, 0.3, 0.4});
     nn::Matrix gradBiases(2, 1, {0.05, 0.05});
 
-    sgd.update(weights, biases, gradWeights, gradBiases);
+    nn::ParameterSlots slots;
+    sgd.update(weights, biases, gradWeights, gradBiases, slots);
 
     // Verify updated weights and biases
     EXPECT_NEAR(weights(0, 0), 0.999, 1e-3);
@@ -36,7 +37,8 @@ TEST(OptimizerTests, RMSprop)
     nn::Matrix gradWeights(2, 2, {0.1, 0.2, 0.3, 0.4});
     nn::Matrix gradBiases(2, 1, {0.05, 0.05});
 
-    rmsprop.update(weights, biases, gradWeights, gradBiases);
+    nn::ParameterSlots slots;
+    rmsprop.update(weights, biases, gradWeights, gradBiases, slots);
 
     // Verify updated weights and biases
     EXPECT_NEAR(weights(0, 0), 0.96837, 1e-5);
@@ -56,7 +58,8 @@ TEST(OptimizerTests, Adam)
     nn::Matrix gradWeights(2, 2, {0.1, 0.2, 0.3, 0.4});
     nn::Matrix gradBiases(2, 1, {0.05, 0.05});
 
-    adam.update(weights, biases, gradWeights, gradBiases);
+    nn::ParameterSlots slots;
+    adam.update(weights, biases, gradWeights, gradBiases, slots);
 
     // Verify updated weights and biases
     EXPECT_NEAR(weights(0, 0), 0.99, 1e-2);
@@ -65,4 +68,144 @@ TEST(OptimizerTests, Adam)
     EXPECT_NEAR(weights(1, 1), 3.99, 1e-2);
     EXPECT_NEAR(biases(0, 0), 0.49, 1e-2);
     EXPECT_NEAR(biases(0, 1), 0.49, 1e-2);
-}
\ No newline at end of file
+}
+
+TEST(OptimizerTests, StepMatchesUpdate)
+{
+    nn::Adam updated(0.01);
+    nn::Adam stepped(0.01);
+
+    nn::Matrix weights1(2, 2, {1.0, 2.0, 3.0, 4.0});
+    nn::Matrix biases1(2, 1, {0.5, 0.5});
+    nn::Matrix weights2 = weights1;
+    nn::Matrix biases2 = biases1;
+    nn::Matrix gradWeights(2, 2, {0.1, 0.2, 0.3, 0.4});
+    nn::Matrix gradBiases(2, 1, {0.05, 0.05});
+
+    // Register the parameters of the second copy in one flat registry
+    nn::Matrix accWeights(2, 2, 0.0);
+    nn::Matrix accBiases(2, 1, 0.0);
+    nn::ParameterRegistry registry;
+    registry.add(weights2, &accWeights);
+    registry.add(biases2, &accBiases);
+    stepped.bindParameters(registry);
+
+    EXPECT_EQ(registry.getCount(), 2);
+    EXPECT_EQ(registry.getSize(), 6);
+    EXPECT_EQ(registry.getOffset(1), 4);
+
+    nn::ParameterSlots slots;
+    for (int i = 0; i < 3; i++)
+    {
+        updated.update(weights1, biases1, gradWeights, gradBiases, slots);
+
+        accWeights = gradWeights;
+        accBiases = gradBiases;
+        stepped.step();
+
+        // Gradients are consumed by the step
+        EXPECT_EQ(accWeights, nn::Matrix(2, 2, 0.0));
+        EXPECT_EQ(accBiases, nn::Matrix(2, 1, 0.0));
+    }
+
+    // Both paths share the same state layout and kernels
+    EXPECT_EQ(weights1, weights2);
+    EXPECT_EQ(biases1, biases2);
+}
+
+TEST(OptimizerTests, UpdateRowsIsLazy)
+{
+    nn::Adam adam(0.01);
+
+    nn::Matrix table(3, 2, {1.0, 2.0, 3.0, 4.0, 5.0, 6.0});
+    nn::Matrix gradient(3, 2, {0.1, 0.2, 0.0, 0.0, 0.3, 0.4});
+    std::vector<int> rows = {2, 0, 2};
+
+    nn::ParameterSlots slots;
+    adam.updateRows(table, gradient, rows, slots);
+
+    // Listed rows are updated once and their gradients reset, the other row is untouched
+    EXPECT_NEAR(table(0, 0), 0.99, 1e-6);
+    EXPECT_NEAR(table(2, 1), 5.99, 1e-6);
+    EXPECT_EQ(table(1, 0), 3.0);
+    EXPECT_EQ(table(1, 1), 4.0);
+    EXPECT_EQ(gradient.getData(), std::vector<double>(6, 0.0));
+    EXPECT_TRUE(rows.empty());
+
+    std::vector<int> invalidRows = {3};
+    EXPECT_THROW(adam.updateRows(table, gradient, invalidRows, slots), std::out_of_range);
+}
+
+TEST(OptimizerTests, StateFollowsSlots)
+{
+    nn::Adam reference(0.01);
+    nn::Adam adam(0.01);
+
+    nn::Matrix weights1(2, 2, {1.0, 2.0, 3.0, 4.0});
+    nn::Matrix biases1(2, 1, {0.5, 0.5});
+    nn::Matrix weights2 = weights1;
+    nn::Matrix biases2 = biases1;
+    nn::Matrix gradWeights(2, 2, {0.1, 0.2, 0.3, 0.4});
+    nn::Matrix gradBiases(2, 1, {0.05, 0.05});
+    nn::ParameterSlots referenceSlots;
+    nn::ParameterSlots slots;
+
+    for (int i = 0; i < 3; i++)
+    {
+        reference.update(weights1, biases1, gradWeights, gradBiases, referenceSlots);
+
+        // Replace the parameters by other matrices, as layers do when they change their memory
+        nn::Matrix weights = weights2;
+        nn::Matrix biases = biases2;
+        adam.update(weights, biases, gradWeights, gradBiases, slots);
+        weights2 = weights;
+        biases2 = biases;
+    }
+
+    // The moments were found through the slots and not lost with the old matrices
+    EXPECT_EQ(weights1, weights2);
+    EXPECT_EQ(biases1, biases2);
+
+    // Parameters of another size do not match their slots
+    nn::Matrix wrongWeights(3, 2, 0.0);
+    nn::Matrix wrongGradWeights(3, 2, 0.0);
+    EXPECT_THROW(adam.update(wrongWeights, biases2, wrongGradWeights, gradBiases, slots), std::invalid_argument);
+
+    // Binding another registry invalidates the slots, the parameters are registered again
+    adam.bindParameters(nn::ParameterRegistry());
+    adam.update(wrongWeights, biases2, wrongGradWeights, gradBiases, slots);
+    EXPECT_EQ(slots.slots, std::vector<int>({0, 1}));
+
+    // Copies of the slots start empty
+    nn::ParameterSlots copy = slots;
+    EXPECT_EQ(copy.registration, 0);
+    EXPECT_TRUE(copy.slots.empty());
+
+    // Parameters updated on their own leave the bound registry alone, binding it again keeps its state
+    nn::Adam boundOnly(0.01);
+    nn::Adam mixed(0.01);
+    nn::Matrix bound1(2, 1, {1.0, 2.0});
+    nn::Matrix bound2 = bound1;
+    nn::Matrix boundGrad1(2, 1, {0.1, 0.2});
+    nn::Matrix boundGrad2 = boundGrad1;
+    nn::ParameterRegistry registry1;
+    nn::ParameterRegistry registry2;
+    registry1.add(bound1, &boundGrad1);
+    registry2.add(bound2, &boundGrad2);
+    boundOnly.bindParameters(registry1);
+    mixed.bindParameters(registry2);
+    boundOnly.step();
+    mixed.step();
+
+    nn::ParameterSlots mixedSlots;
+    mixed.update(weights1, biases1, gradWeights, gradBiases, mixedSlots);
+    EXPECT_EQ(mixedSlots.slots, std::vector<int>({1, 2}));
+    mixed.bindParameters(registry2);
+
+    boundGrad1 = nn::Matrix(2, 1, {0.1, 0.2});
+    boundGrad2 = nn::Matrix(2, 1, {0.1, 0.2});
+    boundOnly.step();
+    mixed.step();
+    EXPECT_EQ(bound1, bound2);
+}
+
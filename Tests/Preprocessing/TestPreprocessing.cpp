@@ -8,6 +8,7 @@
 #include <filesystem>
 #include <fstream>
 #include <NeuralNetworkCPP/DataPreprocessing/CSVReader/CSVReader.hpp>
+#include <NeuralNetworkCPP/DataPreprocessing/LibSVMReader/LibSVMReader.hpp>
 #include <NeuralNetworkCPP/DataPreprocessing/Scalers/Scalers.hpp>
 
 TEST(CSVReaderTests, ReadCSVWithLabelsAtEnd)
@@ -139,6 +140,43 @@ TEST(CSVReaderTests, ReadCSVWithInvalidToken)
     std::filesystem::remove(filename);
 }
 
+TEST(LibSVMReaderTests, ReadLibSVM)
+{
+    // Create a temporary libsvm file with unsorted indices, a comment and a query id
+    std::string filename = "test_libsvm.txt";
+    std::ofstream file(filename);
+    file << "1 3:0.5 1:2.0\n";
+    file << "\n";
+    file << "0 qid:4 2:-1.0 # comment\n";
+    file << "1\n";
+    file.close();
+
+    nn::LibSVMReader reader(filename, 5);
+    reader.read();
+
+    // Check the data, indices are one-based in the file
+    std::vector<double> expectedData = {
+        2.0, 0.0, 0.5, 0.0, 0.0,
+        0.0, -1.0, 0.0, 0.0, 0.0,
+        0.0, 0.0, 0.0, 0.0, 0.0
+    };
+    EXPECT_EQ(reader.getData().getRows(), 3);
+    EXPECT_EQ(reader.getData().getCols(), 5);
+    EXPECT_EQ(reader.getData().getNonZeros(), 3);
+    EXPECT_EQ(reader.getData().toMatrix().getData(), expectedData);
+
+    // Check the labels
+    std::vector<std::vector<double>> expectedLabels = {{1.0}, {0.0}, {1.0}};
+    EXPECT_EQ(reader.getLabels(), expectedLabels);
+
+    // Indices beyond the number of features are rejected
+    nn::LibSVMReader smallReader(filename, 2);
+    EXPECT_THROW(smallReader.read(), std::runtime_error);
+
+    // Clean up the temporary file
+    std::filesystem::remove(filename);
+}
+
 TEST(ScalersTests, StandardScalerFitTransform)
 {
     // Create a StandardScaler object